@@ -0,0 +1,52 @@
+# tale_embed_story(<target> <file.tale>... [NAME <identifier>] [OPTIMIZE] [ENTRY <scene>...])
+#
+# Compiles story content into <target> as a constexpr
+# tale_engine::runtime::EmbeddedStory named tale_embedded::<NAME> (default:
+# the first file's stem). Include "<NAME>.h" and run it with
+# tale_engine::runtime::Interpreter(tale_embedded::<NAME>, ...), which reads
+# the tables in place (tests/ has an example). Content is validated
+# at build time; errors and warnings are reported like tale_build's, and
+# errors fail the build.
+function(tale_embed_story target)
+  cmake_parse_arguments(PARSE_ARGV 1 ARG "OPTIMIZE" "NAME" "ENTRY")
+  set(inputs ${ARG_UNPARSED_ARGUMENTS})
+  if (NOT inputs)
+    message(FATAL_ERROR "tale_embed_story(${target}): no .tale files given")
+  endif()
+
+  set(name ${ARG_NAME})
+  if (NOT name)
+    list(GET inputs 0 first)
+    get_filename_component(name "${first}" NAME_WE)
+  endif()
+
+  set(abs_inputs "")
+  foreach (input IN LISTS inputs)
+    get_filename_component(abs "${input}" ABSOLUTE BASE_DIR "${CMAKE_CURRENT_SOURCE_DIR}")
+    list(APPEND abs_inputs "${abs}")
+  endforeach()
+
+  set(out_dir "${CMAKE_CURRENT_BINARY_DIR}/tale_embed/${target}")
+  set(header "${out_dir}/${name}.h")
+  set(source "${out_dir}/${name}.cpp")
+
+  set(extra "")
+  if (ARG_OPTIMIZE)
+    list(APPEND extra -O)
+    foreach (entry IN LISTS ARG_ENTRY)
+      list(APPEND extra --entry ${entry})
+    endforeach()
+  endif()
+
+  add_custom_command(
+    OUTPUT "${header}" "${source}"
+    COMMAND ${CMAKE_COMMAND} -E make_directory "${out_dir}"
+    COMMAND tale_embed --name ${name} --header "${header}" --source "${source}" ${extra} ${abs_inputs}
+    DEPENDS tale_embed ${abs_inputs}
+    COMMENT "Embedding story ${name}"
+    VERBATIM)
+
+  target_sources(${target} PRIVATE "${header}" "${source}")
+  target_include_directories(${target} PRIVATE "${out_dir}")
+  target_link_libraries(${target} PRIVATE tale_engine)
+endfunction()
@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::analysis {
+
+	enum class SymbolKind : std::uint8_t {
+		Scene,
+		Flag,
+		Item,
+		Stat
+	};
+
+	enum class RefRole : std::uint8_t {
+		Definition, // scene declaration
+		Goto,       // goto <scene>
+		SetFlag,    // set_flag(flag, ...)
+		GiveItem,   // give_item(item, ...)
+		TakeItem,   // take_item(item, ...)
+		TestFlag,   // has_flag(flag) / flag_is(flag, ...) in a choice condition
+		TestItem,   // has_item(item, ...) in a choice condition
+		ReadFlag,   // {flag} in text (site = text block)
+		ReadItem,   // {#item} in text (site = text block)
+		EffectArg,  // flag, item or stat argument of a native effect (may read or write it)
+		TestStat    // stat_at_least(stat, ...) in a choice condition
+	};
+
+	struct ReferenceSite {
+		std::uint32_t file = 0; // ReferenceIndex::file_name()
+		int line = 1;
+		int column = 1;
+		RefRole role = RefRole::Definition;
+	};
+
+	// Transparent hasher so lookups by string_view never allocate.
+	struct StringHash {
+		using is_transparent = void;
+		std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+	};
+
+	// Inverted index from scene ids, flag, item and stat names to every site that
+	// defines or uses them, across all files of a project.
+	//
+	// Files are indexed independently: update_file() replaces everything a file
+	// contributed, touching only the symbols that file referenced, so editors
+	// can re-index on every change. Lookups are one hash probe.
+	class ReferenceIndex {
+	public:
+		void update_file(std::string_view file, const dsl::FileAst& ast);
+		void remove_file(std::string_view file);
+
+		// All sites of a symbol, grouped by file in indexing order.
+		std::span<const ReferenceSite> find(SymbolKind kind, std::string_view name) const;
+		bool has_role(SymbolKind kind, std::string_view name, RefRole role) const;
+
+		std::string_view file_name(std::uint32_t file) const { return files_[file]; }
+		SourcePos to_pos(const ReferenceSite& site) const;
+
+		// Visits (name, sites) for every symbol of `kind` in first-indexed order.
+		template <typename Fn>
+		void for_each_symbol(SymbolKind kind, Fn&& fn) const {
+			for (const auto& sym : symbols_) {
+				if (sym.kind == kind && !sym.sites.empty()) {
+					fn(std::string_view(sym.name), std::span<const ReferenceSite>(sym.sites));
+				}
+			}
+		}
+
+	private:
+		using SymbolId = std::uint32_t;
+
+		struct Symbol {
+			SymbolKind kind;
+			std::string name;
+			std::vector<ReferenceSite> sites;
+		};
+
+		using NameMap = std::unordered_map<std::string, std::uint32_t, StringHash, std::equal_to<>>;
+
+		std::uint32_t intern_file(std::string_view file);
+		void add(SymbolKind kind, std::string_view name, std::uint32_t file, const SourcePos& pos, RefRole role);
+
+	private:
+		std::vector<Symbol> symbols_;
+		std::array<NameMap, 4> by_name_;
+
+		std::vector<std::string> files_;
+		NameMap file_ids_;
+		// Symbols each file contributed to; drives incremental removal.
+		std::vector<std::vector<SymbolId>> file_symbols_;
+	};
+
+	// Cross-file lints that need the whole project, e.g. items taken but never
+	// given or flags read but never set.
+	void lint_references(const ReferenceIndex& index, Diagnostics& diagnostics);
+
+} // namespace tale_engine::analysis
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::analysis {
+
+	using SceneIndex = std::uint32_t;
+	inline constexpr SceneIndex kNoScene = UINT32_MAX;
+
+	// Directed scene graph in CSR form over dense scene indices.
+	//
+	// Scene i is ast.scenes[i]; edges come from top-level and choice gotos
+	// (conservatively: every goto present in the body, in source order).
+	// The graph keeps views into the AST, which must outlive it.
+	// Every analysis below runs in O(V + E) without recursion, so it is safe
+	// on graphs with millions of scenes.
+	class SceneGraph {
+	public:
+		struct GotoRef {
+			SceneIndex from;
+			const dsl::GotoStmtAst* stmt;
+		};
+
+		struct ChoiceRef {
+			SceneIndex scene;
+			const dsl::ChoiceAst* choice;
+		};
+
+		struct Components {
+			// Component id per scene. Ids are in reverse topological order of the
+			// condensation: edges only go from higher to lower or equal ids.
+			std::vector<std::uint32_t> component_of;
+			std::vector<std::uint32_t> component_size;
+			std::size_t count() const { return component_size.size(); }
+		};
+
+		explicit SceneGraph(const dsl::FileAst& ast);
+
+		std::size_t scene_count() const { return ids_.size(); }
+		std::size_t edge_count() const { return targets_.size(); }
+
+		// Index of the first scene declared with `id`, or kNoScene.
+		SceneIndex index_of(std::string_view id) const;
+		std::string_view id_of(SceneIndex scene) const { return ids_[scene]; }
+
+		std::span<const SceneIndex> successors(SceneIndex scene) const {
+			return { targets_.data() + offsets_[scene], targets_.data() + offsets_[scene + 1] };
+		}
+
+		// Scenes whose id was already taken by an earlier scene (never indexed by id).
+		const std::vector<SceneIndex>& duplicate_scenes() const { return duplicates_; }
+		// Gotos whose target scene does not exist, in source order.
+		const std::vector<GotoRef>& unresolved_gotos() const { return unresolved_; }
+		const std::vector<ChoiceRef>& choices_without_goto() const { return choices_without_goto_; }
+
+		// Scenes reachable from `start` (inclusive), by breadth-first search.
+		std::vector<bool> reachable_from(SceneIndex start) const;
+
+		// Scenes with no outgoing edges.
+		std::vector<SceneIndex> dead_ends() const;
+
+		// Strongly connected components (iterative Tarjan).
+		Components strongly_connected_components() const;
+
+	private:
+		// Open-addressing id table (linear probing, load <= 0.5). Slots hold the
+		// id hash next to the scene index so most probes never touch the string.
+		struct Slot {
+			std::uint64_t hash = 0;
+			SceneIndex scene = kNoScene;
+		};
+
+		SceneIndex find_slot(std::string_view id, std::uint64_t hash) const;
+
+	private:
+		std::vector<std::string_view> ids_;
+		std::vector<Slot> slots_;
+		std::uint64_t slot_mask_ = 0;
+
+		std::vector<std::uint32_t> offsets_;
+		std::vector<SceneIndex> targets_;
+
+		std::vector<SceneIndex> duplicates_;
+		std::vector<GotoRef> unresolved_;
+		std::vector<ChoiceRef> choices_without_goto_;
+	};
+
+} // namespace tale_engine::analysis
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+#include "tale_engine/analysis/scene_graph.h"
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::analysis {
+
+	struct ValidateOptions {
+		// Entry scene for reachability. Empty = first scene in the file.
+		std::string start_scene;
+
+		bool warn_unreachable = true;
+		bool warn_choice_without_goto = true;
+		// Terminal scenes are legitimate endings, so this is opt-in.
+		bool warn_dead_ends = false;
+	};
+
+	// Structural, reference and graph validation of a parsed file.
+	// Returns true if no errors were reported by this call.
+	bool validate(const dsl::FileAst& ast,
+		const SceneGraph& graph,
+		Diagnostics& diagnostics,
+		const ValidateOptions& options = {});
+
+	// The checks validate() makes, as building blocks for front ends that
+	// keep their own scene graph (compile::Workspace), so every front end
+	// reports the same problems with the same severity, position and message.
+
+	// Which checks run. Scene id and goto checks need scenes; graph checks
+	// also need the start scene to exist.
+	struct ValidateChecks {
+		bool scene_ids = false; // duplicate ids, goto targets
+		bool unreachable = false;
+		bool choices_without_goto = false;
+		bool dead_ends = false;
+	};
+	ValidateChecks enabled_checks(const ValidateOptions& options, bool has_scenes, bool start_exists);
+
+	// Duplicates are already errors and can never be targeted by id, so
+	// they are never reported unreachable.
+	inline bool reports_unreachable(bool reached, bool duplicate) { return !reached && !duplicate; }
+
+	Diagnostic no_scenes_error();
+	Diagnostic missing_start_error(std::string_view start_scene);
+	Diagnostic duplicate_scene_error(const dsl::SceneAst& scene);
+	Diagnostic unresolved_goto_error(const dsl::GotoStmtAst& stmt);
+	Diagnostic unreachable_scene_warning(const dsl::SceneAst& scene, std::string_view start_scene);
+	Diagnostic choice_without_goto_warning(const dsl::ChoiceAst& choice, std::string_view scene);
+	Diagnostic dead_end_warning(const dsl::SceneAst& scene);
+
+} // namespace tale_engine::analysis
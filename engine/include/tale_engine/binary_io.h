@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace tale_engine {
+
+	// Little-endian byte writer used by every on-disk format of the engine.
+	// Output is identical on every platform for identical input.
+	class ByteWriter {
+	public:
+		void u8(std::uint8_t v) { out_.push_back(static_cast<char>(v)); }
+
+		void u32(std::uint32_t v) {
+			for (int i = 0; i < 4; ++i) u8(static_cast<std::uint8_t>(v >> (8 * i)));
+		}
+
+		void u64(std::uint64_t v) {
+			for (int i = 0; i < 8; ++i) u8(static_cast<std::uint8_t>(v >> (8 * i)));
+		}
+
+		void i32(std::int32_t v) { u32(static_cast<std::uint32_t>(v)); }
+
+		// LEB128 varint; most counts and indices fit in one byte.
+		void varint(std::uint64_t v) {
+			while (v >= 0x80) {
+				u8(static_cast<std::uint8_t>(v | 0x80));
+				v >>= 7;
+			}
+			u8(static_cast<std::uint8_t>(v));
+		}
+
+		void str(std::string_view s) {
+			varint(s.size());
+			out_.append(s.data(), s.size());
+		}
+
+		void raw(std::string_view bytes) { out_.append(bytes.data(), bytes.size()); }
+
+		std::size_t size() const { return out_.size(); }
+		const std::string& bytes() const { return out_; }
+		std::string take() { return std::move(out_); }
+
+	private:
+		std::string out_;
+	};
+
+	// Bounds-checked reader for ByteWriter output.
+	// Any read past the end sets the failure bit and yields zero values,
+	// so callers check ok() once after decoding instead of after every field.
+	class ByteReader {
+	public:
+		explicit ByteReader(std::string_view bytes) : in_(bytes) {}
+
+		std::uint8_t u8() {
+			if (pos_ >= in_.size()) {
+				failed_ = true;
+				return 0;
+			}
+			return static_cast<std::uint8_t>(in_[pos_++]);
+		}
+
+		std::uint32_t u32() {
+			std::uint32_t v = 0;
+			for (int i = 0; i < 4; ++i) v |= static_cast<std::uint32_t>(u8()) << (8 * i);
+			return v;
+		}
+
+		std::uint64_t u64() {
+			std::uint64_t v = 0;
+			for (int i = 0; i < 8; ++i) v |= static_cast<std::uint64_t>(u8()) << (8 * i);
+			return v;
+		}
+
+		std::int32_t i32() { return static_cast<std::int32_t>(u32()); }
+
+		std::uint64_t varint() {
+			std::uint64_t v = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				const std::uint8_t b = u8();
+				v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+				if ((b & 0x80) == 0) return v;
+			}
+			failed_ = true;
+			return 0;
+		}
+
+		std::string_view str_view() {
+			const std::uint64_t n = varint();
+			if (failed_ || n > in_.size() - pos_) {
+				failed_ = true;
+				return {};
+			}
+			const std::string_view s = in_.substr(pos_, static_cast<std::size_t>(n));
+			pos_ += static_cast<std::size_t>(n);
+			return s;
+		}
+
+		std::string str() { return std::string(str_view()); }
+
+		std::string_view raw(std::size_t n) {
+			if (failed_ || n > in_.size() - pos_) {
+				failed_ = true;
+				return {};
+			}
+			const std::string_view s = in_.substr(pos_, n);
+			pos_ += n;
+			return s;
+		}
+
+		bool ok() const { return !failed_; }
+		bool at_end() const { return pos_ >= in_.size(); }
+		std::size_t position() const { return pos_; }
+
+	private:
+		std::string_view in_;
+		std::size_t pos_ = 0;
+		bool failed_ = false;
+	};
+
+} // namespace tale_engine
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::compile {
+
+	// Compiled content format ("talec").
+	// Bump kFormatVersion whenever the encoding of any AST node changes;
+	// build caches and compiled files with a different version are rejected.
+	inline constexpr std::uint32_t kFormatVersion = 8; // 2: choice conditions, 3: scene table, 4: native effects, 5: compression, 6: stats, 7: enemy packs, 8: full 8-byte magic
+	inline constexpr std::string_view kCompiledMagic{ "TALEC\0\0\1", 8 };
+
+	// One row of the scene table that precedes the scene records.
+	struct SceneTableEntry {
+		std::string id;
+		std::uint32_t source_index = 0; // position of the scene in the source AST
+		std::uint64_t offset = 0;       // record start, relative to records_offset
+		std::uint64_t length = 0;
+		std::uint64_t raw_length = 0;   // decompressed record size; == length unless compressed
+	};
+
+	struct SceneTable {
+		std::vector<std::string> files;
+		std::vector<SceneTableEntry> scenes; // stored order
+		std::uint64_t records_offset = 0;
+
+		// Compressed files: each record is an lz block (see lz.h) against
+		// the shared dictionary at bytes[dictionary_offset, + dictionary_length).
+		bool compressed = false;
+		std::uint64_t dictionary_offset = 0;
+		std::uint64_t dictionary_length = 0;
+	};
+
+	struct EncodeOptions {
+		// Compress each scene record independently, so any scene still
+		// decodes on its own (a few microseconds each).
+		bool compress = false;
+		// Upper bound for the dictionary trained from the records; 0 compresses
+		// without one. Small records share little with themselves, so most of
+		// the gain comes from the dictionary.
+		std::size_t dictionary_size = 32 * 1024;
+	};
+
+	// Encodes a file AST into the compiled binary format.
+	// Encoding is deterministic: equal ASTs always produce identical bytes.
+	//
+	// `layout` (a permutation of scene indices, see compile/layout.h) sets the
+	// order the scene records are stored in; empty keeps source order. It only
+	// changes where records sit in the file: the scene table maps each back to
+	// its source index. Returns an empty string if `layout` has the wrong size.
+	std::string encode_file(const dsl::FileAst& ast, std::span<const std::uint32_t> layout = {},
+		const EncodeOptions& options = {});
+
+	// Decodes bytes produced by encode_file, scenes back in source order
+	// whatever the layout. Returns false on corrupt, truncated or
+	// version-mismatched input; `out` is unspecified then.
+	bool decode_file(std::string_view bytes, dsl::FileAst& out);
+
+	// Reads only the header and scene table, so a host can decode scenes on
+	// demand with decode_scene instead of touching the whole file.
+	bool read_scene_table(std::string_view bytes, SceneTable& out);
+	bool decode_scene(std::string_view bytes, const SceneTable& table, std::size_t stored_index, dsl::SceneAst& out);
+
+	// The two halves of decode_scene, for hosts that cache decompressed
+	// records (see compile/scene_reader.h). read_record copies or
+	// decompresses record `stored_index` into `out`; decode_record decodes
+	// such bytes.
+	bool read_record(std::string_view bytes, const SceneTable& table, std::size_t stored_index, std::string& out);
+	bool decode_record(std::string_view record, const SceneTable& table, std::size_t stored_index, dsl::SceneAst& out);
+
+	// True if `bytes` starts with the compiled content magic.
+	bool is_compiled(std::string_view bytes);
+
+	std::string encode_diagnostics(const std::vector<Diagnostic>& diags);
+	bool decode_diagnostics(std::string_view bytes, std::vector<Diagnostic>& out);
+
+} // namespace tale_engine::compile
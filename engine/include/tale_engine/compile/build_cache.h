@@ -0,0 +1,52 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::compile {
+
+	// Result of compiling one source file in isolation.
+	struct CompiledUnit {
+		std::string path;
+		dsl::FileAst ast;
+		std::vector<Diagnostic> diagnostics;
+		bool from_cache = false;
+	};
+
+	// Lexes and parses one source file, checking effect calls against
+	// `effects`. Diagnostics are kept on the unit instead of a shared sink so
+	// units can be compiled on any thread.
+	CompiledUnit compile_source(std::string path, std::string_view source,
+		const dsl::EffectTable& effects = dsl::EffectTable::builtins());
+
+	// Content-addressed on-disk cache of compiled units.
+	//
+	// Keys hash the source bytes, the path (it is embedded in every SourcePos),
+	// the effect signatures, the engine version and the compiled format
+	// version, so stale entries are never reused after an engine upgrade. Entries are written to a temporary
+	// file and renamed into place, which keeps concurrent builds safe.
+	class BuildCache {
+	public:
+		explicit BuildCache(std::filesystem::path dir);
+
+		static std::string key_for(std::string_view path, std::string_view source,
+			const dsl::EffectTable& effects = dsl::EffectTable::builtins());
+
+		// Returns false on miss or on a corrupt entry (treated as a miss).
+		bool load(const std::string& key, CompiledUnit& out) const;
+		bool store(const std::string& key, const CompiledUnit& unit) const;
+
+		const std::filesystem::path& dir() const { return dir_; }
+
+	private:
+		std::filesystem::path entry_path(const std::string& key) const;
+
+	private:
+		std::filesystem::path dir_;
+	};
+
+} // namespace tale_engine::compile
@@ -0,0 +1,18 @@
+#pragma once
+#include <ostream>
+#include <string_view>
+
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::compile {
+
+	// Writes C++ sources that hold `ast` as a constexpr
+	// runtime::EmbeddedStory named `tale_embedded::<name>`.
+	//
+	// `header` declares the story; `source` defines its tables and includes
+	// the header as "<header_name>". `name` must be a C++ identifier. Output
+	// is deterministic, so regenerating unchanged content rebuilds nothing.
+	void write_embedded_story(std::ostream& header, std::ostream& source, const dsl::FileAst& ast,
+		std::string_view name, std::string_view header_name);
+
+} // namespace tale_engine::compile
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "tale_engine/analysis/scene_graph.h"
+
+namespace tale_engine::compile {
+
+	inline constexpr std::size_t kLayoutPageSize = 4096;
+
+	// Order in which encode_file should store scene records so that scenes
+	// played together sit next to each other in the compiled file.
+	//
+	// Returns a permutation of scene indices (stored position -> source
+	// index). Scene 0, the default start, always comes first. From there the layout chains into the hottest successor not yet placed;
+	// when a chain ends it resumes at the hottest scene seen so far as a
+	// successor of a placed one. Unreachable and duplicate scenes go last, in
+	// source order.
+	//
+	// `visits` holds a per-scene visit count (e.g. from replayed sessions).
+	// Without it every scene weighs the same and the order degrades to a
+	// depth-first chain along first gotos with breadth-first fallback.
+	std::vector<std::uint32_t> plan_layout(const analysis::SceneGraph& graph,
+		std::span<const std::uint64_t> visits = {});
+
+	// Distinct kLayoutPageSize pages of `bytes` (a compiled file) touched when
+	// decoding the header and then the scenes in `trace` (source indices, see
+	// SceneTableEntry::source_index) on demand. Returns 0 for invalid input.
+	std::size_t pages_touched(std::string_view bytes, std::span<const std::uint32_t> trace);
+
+} // namespace tale_engine::compile
@@ -0,0 +1,46 @@
+#pragma once
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::compile {
+
+	// One translatable string of a story, keyed as runtime/string_table.h
+	// describes.
+	struct LocalizedString {
+		std::string key;
+		std::string text;
+		SourcePos pos{}; // the text block or choice; for catalog entries, the catalog
+	};
+
+	// Every text line and choice label of `ast`, in story order. Scenes that
+	// duplicate an earlier id are skipped, as the runtime never plays them.
+	std::vector<LocalizedString> extract_strings(const dsl::FileAst& ast);
+
+	// String catalog: the JSON form translators edit.
+	//
+	//   {"locale":"<name>","strings":[
+	//   {"key":"intro.t0","text":"...","file":"a.tale","line":3},
+	//   ...]}
+	//
+	// `file` and `line` locate the text block or choice and are only there
+	// for translators.
+	void write_catalog(std::ostream& out, std::string_view locale, std::span<const LocalizedString> strings);
+
+	// Reports malformed catalogs and entries (missing key or text, repeated
+	// key) against `path` and returns false if any were found.
+	bool read_catalog(std::string_view json, const std::string& path, std::string& locale,
+		std::vector<LocalizedString>& out, Diagnostics& diagnostics);
+
+	// Encodes a runtime::StringTable. Deterministic: entries are stored by key
+	// hash whatever their order. Reports repeated keys and key hash
+	// collisions and returns an empty string if there were any.
+	std::string encode_string_table(std::string_view locale, std::span<const LocalizedString> strings,
+		Diagnostics& diagnostics);
+
+} // namespace tale_engine::compile
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::compile {
+
+	struct OptimizeOptions {
+		// Scenes a host may start at besides the first scene. They (and what
+		// they reach) survive dead-scene elimination.
+		std::vector<std::string> entry_scenes;
+
+		bool collapse_gotos = true;
+		bool merge_text = true;
+		bool coalesce_effects = true;
+		bool eliminate_dead_scenes = true;
+	};
+
+	struct OptimizeReport {
+		std::size_t scenes_before = 0;
+		std::size_t scenes_after = 0;
+		// Scene body statements plus choice body statements.
+		std::size_t statements_before = 0;
+		std::size_t statements_after = 0;
+
+		std::size_t gotos_redirected = 0;
+		// Transfer steps no longer taken when every redirected goto runs once.
+		std::size_t goto_hops_removed = 0;
+		std::size_t text_blocks_merged = 0;
+		std::size_t effects_removed = 0;
+		std::size_t scenes_removed = 0;
+	};
+
+	// Rewrites `ast` in place without changing what a player can observe: the
+	// same text, choices and final State after every choice.
+	//
+	//  - goto chains: a goto into a scene whose body is only `goto X` jumps
+	//    straight to the end of the chain (cycles are left alone);
+	//  - consecutive text blocks merge, empty ones are dropped;
+	//  - effects: no-op give/take (qty <= 0) are dropped, a set_flag
+	//    overwritten later in the same effect run is dropped, and gives of the
+	//    same item in a run are summed unless a take of it sits in between
+	//    (takes can fail, so they are never merged); native effects may read
+	//    State, so they end a run;
+	//  - scenes unreachable from the first scene and `entry_scenes` are removed.
+	//
+	// Run it on a linked, validated AST; diagnostics should come from the
+	// original. The first scene stays first, so the default start is unchanged.
+	OptimizeReport optimize(dsl::FileAst& ast, const OptimizeOptions& options = {});
+
+	void write_report(std::ostream& out, const OptimizeReport& report);
+
+} // namespace tale_engine::compile
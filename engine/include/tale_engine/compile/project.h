@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "tale_engine/analysis/reference_index.h"
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::compile {
+
+	struct ProjectOptions {
+		// Build cache directory. Empty disables caching.
+		std::filesystem::path cache_dir;
+
+		// Worker threads for compiling cache misses. 0 = hardware concurrency.
+		unsigned jobs = 0;
+
+		// If set, each unit is (re)indexed into it while linking.
+		analysis::ReferenceIndex* references = nullptr;
+
+		// Effect signatures to parse against (e.g. runtime::EffectRegistry::
+		// signatures()). Null means the built-in effects only.
+		const dsl::EffectTable* effects = nullptr;
+	};
+
+	struct ProjectBuild {
+		// All scenes of all files, in input file order.
+		dsl::FileAst linked;
+
+		std::size_t cache_hits = 0;
+		std::size_t compiled = 0;
+	};
+
+	// Compiles every file (reusing cached units where the content is unchanged),
+	// then links them into a single FileAst.
+	//
+	// Output and diagnostic order depend only on the order of `paths`, never on
+	// thread scheduling or cache state, so a warm build is byte-identical to a
+	// clean one.
+	ProjectBuild build_project(const std::vector<std::string>& paths,
+		const ProjectOptions& options,
+		Diagnostics& diagnostics);
+
+	// Reads a whole file as bytes. Returns an empty string if it cannot be read.
+	std::string read_file(const std::filesystem::path& path);
+
+} // namespace tale_engine::compile
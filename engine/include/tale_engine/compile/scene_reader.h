@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tale_engine/compile/ast_codec.h"
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::compile {
+
+	inline constexpr std::size_t kDefaultRecordCacheBytes = 64 * 1024;
+
+	// On-demand access to the scenes of a compiled file kept in memory (or
+	// mapped), without decoding the rest.
+	//
+	// For compressed files a small cache of decompressed records sits in
+	// front of the codec: hub scenes a player keeps returning to are
+	// decompressed once, and the least recently used records are dropped
+	// when the cache outgrows its byte budget. Uncompressed records are
+	// decoded in place and never cached.
+	class SceneReader {
+	public:
+		explicit SceneReader(std::size_t cache_bytes = kDefaultRecordCacheBytes);
+
+		// `bytes` must outlive the reader. Returns false on invalid input.
+		bool open(std::string_view bytes);
+
+		const SceneTable& table() const { return table_; }
+
+		// Stored index of the first scene with `id`, or table().scenes.size().
+		std::size_t find(std::string_view id) const;
+
+		bool decode(std::size_t stored_index, dsl::SceneAst& out);
+
+		struct CacheStats {
+			std::uint64_t hits = 0;
+			std::uint64_t misses = 0;
+			std::size_t bytes = 0; // decompressed bytes held
+		};
+		const CacheStats& cache_stats() const { return stats_; }
+
+	private:
+		struct Block {
+			std::string data;
+			std::uint64_t last_use = 0;
+		};
+
+		const Block* fetch(std::size_t stored_index);
+
+	private:
+		std::string_view bytes_;
+		SceneTable table_;
+		std::unordered_map<std::string_view, std::size_t> by_id_;
+
+		std::size_t cache_bytes_;
+		std::unordered_map<std::size_t, Block> blocks_; // by stored index
+		std::uint64_t clock_ = 0;
+		CacheStats stats_;
+	};
+
+} // namespace tale_engine::compile
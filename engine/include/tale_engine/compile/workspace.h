@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tale_engine/analysis/reference_index.h"
+#include "tale_engine/analysis/validator.h"
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/ast.h"
+#include "tale_engine/dsl/effect_signature.h"
+
+namespace tale_engine::compile {
+
+	// A project kept in memory across edits, for editors and daemons (see
+	// tools/lsp).
+	//
+	// Documents form one project, linked in the order they were first added
+	// (as build_project links its inputs), and get the same checks as
+	// analysis::validate() and analysis::lint_references() on the linked
+	// project, with the same messages.
+	//
+	// update() re-parses and re-indexes only documents whose text changed.
+	// The project-wide checks then run on a compact scene graph the workspace
+	// maintains incrementally (scene names interned to ids, gotos stored as
+	// id pairs), so they never walk the AST of unchanged documents. When no
+	// edited document changed its scene names or goto targets, reachability
+	// is reused and only the edited documents are checked again. Only
+	// documents whose results changed get their diagnostics rebuilt.
+	class Workspace {
+	public:
+		// `effects` must outlive the workspace.
+		explicit Workspace(analysis::ValidateOptions options = {},
+			const dsl::EffectTable& effects = dsl::EffectTable::builtins());
+		~Workspace();
+
+		Workspace(const Workspace&) = delete;
+		Workspace& operator=(const Workspace&) = delete;
+
+		// Adds a document or replaces its text. Returns false if the text is
+		// unchanged. Takes effect at the next update().
+		bool set_document(const std::string& path, std::string text);
+		bool remove_document(const std::string& path);
+
+		const std::string* text(std::string_view path) const;
+		std::size_t document_count() const { return documents_.size(); }
+		std::size_t scene_count() const;
+
+		// Brings parse results, the reference index and all diagnostics up to
+		// date. Returns the paths whose diagnostics changed, including
+		// documents removed since the last update (which now have none).
+		std::vector<std::string> update();
+
+		// Diagnostics of one document as of the last update(): its parse
+		// diagnostics, then project checks and reference lints located in it.
+		std::span<const Diagnostic> diagnostics(std::string_view path) const;
+
+		const analysis::ReferenceIndex& references() const { return references_; }
+
+		struct Symbol {
+			analysis::SymbolKind kind;
+			std::string name;
+		};
+
+		// The scene id, flag or item named at `line`:`column` (1-based) of a
+		// document. A name counts when the index has a site of it on that
+		// line, or when it is a {flag} / {#item} placeholder.
+		std::optional<Symbol> symbol_at(std::string_view path, int line, int column) const;
+
+	private:
+		using NameId = std::uint32_t;
+		static constexpr NameId kNoName = UINT32_MAX;
+		struct Document;
+
+		struct SceneNode {
+			NameId name;
+			std::uint32_t first_edge; // Document::edges[first_edge, first_edge + edge_count)
+			std::uint32_t edge_count;
+		};
+
+		struct Edge {
+			NameId target;
+			const dsl::GotoStmtAst* stmt;
+		};
+
+		// A declaration of a scene name; the first in link order wins.
+		struct Definition {
+			const Document* doc;
+			std::uint32_t scene;
+		};
+
+		// Result of a project check, compared across updates before any
+		// message is built.
+		enum class IssueKind : std::uint8_t { Duplicate, Unresolved, Unreachable, NoGoto, DeadEnd };
+		struct Issue {
+			IssueKind kind;
+			std::uint32_t at; // scene, edge or choice index within the document
+			bool operator==(const Issue&) const = default;
+		};
+
+		NameId intern(std::string_view name);
+		Document* find(std::string_view path);
+		const Document* find(std::string_view path) const;
+		void parse(Document& doc);
+		void unregister(Document& doc);
+		void check_project(bool reshaped);
+		void build_diagnostics(Document& doc) const;
+
+	private:
+		analysis::ValidateOptions options_;
+		const dsl::EffectTable* effects_;
+
+		std::vector<std::unique_ptr<Document>> documents_; // link order
+		std::unordered_map<std::string, Document*, analysis::StringHash, std::equal_to<>> by_path_;
+		std::uint64_t next_serial_ = 0;
+
+		std::unordered_map<std::string, NameId, analysis::StringHash, std::equal_to<>> name_ids_;
+		std::vector<std::string_view> names_;              // by NameId; views of name_ids_ keys
+		std::vector<std::vector<Definition>> definitions_; // by NameId, in link order
+		std::vector<Definition> first_;                    // by NameId; front of definitions_, doc null if none
+
+		// Results of the last check that saw the scene graph change. Project
+		// diagnostics (no scenes, missing start scene) go to the first document.
+		std::vector<Diagnostic> project_diagnostics_;
+		const Document* project_doc_ = nullptr;
+		analysis::ValidateChecks checks_;
+		NameId start_ = kNoName;
+		std::vector<std::uint8_t> reached_; // by NameId; empty unless checks_.unreachable
+
+		analysis::ReferenceIndex references_;
+	};
+
+} // namespace tale_engine::compile
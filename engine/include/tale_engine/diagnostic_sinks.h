@@ -0,0 +1,56 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "tale_engine/diagnostics.h"
+
+namespace tale_engine {
+
+	// "file:line:col severity: message" lines, the classic tool format.
+	class TextSink final : public DiagnosticSink {
+	public:
+		explicit TextSink(std::ostream& out) : out_(out) {}
+		void write(const Diagnostic& d) override;
+
+	private:
+		std::ostream& out_;
+	};
+
+	// One JSON object per line:
+	// {"severity":"error","file":"...","line":1,"column":1,"message":"..."}
+	class JsonLinesSink final : public DiagnosticSink {
+	public:
+		explicit JsonLinesSink(std::ostream& out) : out_(out) {}
+		void write(const Diagnostic& d) override;
+
+	private:
+		std::ostream& out_;
+	};
+
+	// SARIF 2.1.0 log with a single run. Results are streamed as they arrive;
+	// finish() closes the document.
+	class SarifSink final : public DiagnosticSink {
+	public:
+		SarifSink(std::ostream& out, std::string tool_name);
+		~SarifSink() override;
+
+		void write(const Diagnostic& d) override;
+		void finish() override;
+
+	private:
+		void begin();
+
+	private:
+		std::ostream& out_;
+		std::string tool_name_;
+		bool started_ = false;
+		bool first_ = true;
+		bool finished_ = false;
+	};
+
+	// "text", "jsonl" or "sarif"; nullptr for anything else.
+	std::unique_ptr<DiagnosticSink> make_sink(std::string_view format, std::ostream& out, std::string tool_name);
+
+} // namespace tale_engine
@@ -1,6 +1,9 @@
 #pragma once
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace tale_engine {
@@ -11,6 +14,8 @@ namespace tale_engine {
 		Info
 	};
 
+	inline constexpr std::size_t kSeverityCount = 3;
+
 	struct SourcePos {
 		std::string file;
 		int line = 1;   // 1-based
@@ -23,16 +28,85 @@ namespace tale_engine {
 		std::string message;
 	};
 
+	// Receives diagnostics as they are accepted (see diagnostic_sinks.h).
+	class DiagnosticSink {
+	public:
+		virtual ~DiagnosticSink() = default;
+		virtual void write(const Diagnostic& d) = 0;
+		// Called once when no more diagnostics will arrive.
+		virtual void finish() {}
+	};
+
+	struct DiagnosticsOptions {
+		// Keep accepted diagnostics in memory for all(). Tools that stream to a
+		// sink can turn this off.
+		bool retain = true;
+
+		// Drop exact repeats (same severity, position and message).
+		bool deduplicate = false;
+
+		// Max diagnostics kept/forwarded per severity. 0 = unlimited.
+		// Dropped diagnostics are still counted, so has_errors() stays exact.
+		std::size_t max_per_severity = 0;
+	};
+
+	// Collects diagnostics for one thread of work.
+	//
+	// A Diagnostics object is not synchronized. Parallel phases give each task
+	// its own instance (see child()) and merge() them into the parent in task
+	// order afterwards, which keeps output deterministic without a shared lock.
 	class Diagnostics {
 	public:
+		Diagnostics() = default;
+		explicit Diagnostics(DiagnosticsOptions options);
+
 		void error(SourcePos pos, std::string message);
 		void warning(SourcePos pos, std::string message);
+		void info(SourcePos pos, std::string message);
+		void add(Diagnostic diagnostic);
+
+		// O(1); counts include diagnostics dropped by caps.
+		bool has_errors() const { return counts_[static_cast<std::size_t>(Severity::Error)] != 0; }
+		std::size_t count(Severity s) const { return counts_[static_cast<std::size_t>(s)]; }
+		std::size_t suppressed() const { return suppressed_; }
 
-		bool has_errors() const;
 		const std::vector<Diagnostic>& all() const;
 
+		// Every accepted diagnostic is forwarded to `sink` immediately.
+		// The sink is not owned and must outlive this object (or be reset).
+		void set_sink(DiagnosticSink* sink) { sink_ = sink; }
+
+		// A fresh buffer with the same filtering options but no sink,
+		// for use by one worker thread.
+		Diagnostics child() const;
+
+		// Appends another buffer's diagnostics in their original order,
+		// applying this object's filters and forwarding to its sink.
+		void merge(Diagnostics&& other);
+
+	private:
+		// What deduplicate compares; the hash only picks the bucket.
+		struct SeenKey {
+			Severity severity;
+			std::string file;
+			int line;
+			int column;
+			std::string message;
+
+			bool operator==(const SeenKey&) const = default;
+		};
+		struct SeenKeyHash {
+			std::size_t operator()(const SeenKey& key) const;
+		};
+
 	private:
+		DiagnosticsOptions options_{};
 		std::vector<Diagnostic> diags_;
+		std::array<std::size_t, kSeverityCount> counts_{};
+		std::array<std::size_t, kSeverityCount> kept_{};
+		std::size_t suppressed_ = 0;
+		std::unordered_set<SeenKey, SeenKeyHash> seen_;
+		DiagnosticSink* sink_ = nullptr;
 	};
 
 	std::string to_string(Severity s);
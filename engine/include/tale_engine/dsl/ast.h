@@ -1,9 +1,12 @@
 #pragma once
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <variant>
 #include <vector>
 
 #include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/effect_signature.h"
 
 namespace tale_engine::dsl {
 
@@ -30,7 +33,17 @@ namespace tale_engine::dsl {
 		int qty = 0;
 	};
 
-	using EffectCallAst = std::variant<EffectSetFlagAst, EffectGiveItemAst, EffectTakeItemAst>;
+	// Call of an effect beyond the built-ins, declared by the host in the
+	// EffectTable the content was parsed with. `arg_kinds` mirror its
+	// signature; Flag and Item arguments hold the identifier as a string.
+	struct EffectNativeAst {
+		SourcePos pos;
+		std::string name;
+		std::vector<EffectArg> arg_kinds;
+		std::vector<ValueAst> args;
+	};
+
+	using EffectCallAst = std::variant<EffectSetFlagAst, EffectGiveItemAst, EffectTakeItemAst, EffectNativeAst>;
 
 	struct EffectStmtAst {
 		SourcePos pos;
@@ -47,9 +60,33 @@ namespace tale_engine::dsl {
 		std::vector<std::string> lines;
 	};
 
+	enum class ConditionOp : std::uint8_t {
+		HasFlag,    // has_flag(flag)
+		FlagEquals, // flag_is(flag, value)
+		HasItem,    // has_item(item) or has_item(item, min_qty)
+		Not,
+		And,
+		Or,
+		StatAtLeast // stat_at_least(stat, min_value)
+	};
+
+	// Guard of a conditional choice: `choice "label" if <condition>:`.
+	// Leaves use `name` (plus `value` / `qty`, which is the minimum value for
+	// StatAtLeast); Not has one operand, And/Or have two or more.
+	struct ConditionAst {
+		SourcePos pos;
+		ConditionOp op = ConditionOp::HasFlag;
+		std::string name;
+		ValueAst value;
+		int qty = 1;
+		std::vector<ConditionAst> operands;
+	};
+
 	struct ChoiceAst {
 		SourcePos pos;
 		std::string label;
+		// Choice is only offered while the condition holds; unset = always.
+		std::optional<ConditionAst> condition;
 		std::vector<std::variant<GotoStmtAst, EffectStmtAst>> body;
 	};
 
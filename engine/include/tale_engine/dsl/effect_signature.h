@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "tale_engine/hash.h"
+
+namespace tale_engine::dsl {
+
+	// Argument kinds an effect call can take. Flag, Item and Stat are
+	// identifiers naming a flag / item / stat (indexed as references); Int
+	// is an integer literal; Value is any literal (string, integer, true,
+	// false); Pack is an identifier naming an enemy pack of the combat
+	// catalog.
+	enum class EffectArg : std::uint8_t { Flag, Item, Int, Value, Stat, Pack };
+
+	inline constexpr std::size_t kMaxEffectArgs = 4;
+
+	struct EffectSignature {
+		std::string_view name;
+		std::uint8_t arity = 0;
+		std::array<EffectArg, kMaxEffectArgs> args{};
+	};
+
+	using EffectId = std::uint32_t;
+	inline constexpr EffectId kNoEffect = UINT32_MAX;
+
+	// Effects every table starts with; their ids are fixed.
+	// Only the first three have dedicated AST nodes; the others parse to
+	// EffectNativeAst like host effects.
+	enum BuiltinEffect : EffectId { SetFlag, GiveItem, TakeItem, AddStat, ReduceStat, BuffStat, Equip, StartCombat, kBuiltinEffectCount };
+
+	inline constexpr std::array<EffectSignature, kBuiltinEffectCount> kBuiltinEffects{ {
+		{ "set_flag", 2, { EffectArg::Flag, EffectArg::Value } },
+		{ "give_item", 2, { EffectArg::Item, EffectArg::Int } },
+		{ "take_item", 2, { EffectArg::Item, EffectArg::Int } },
+		{ "add_stat", 2, { EffectArg::Stat, EffectArg::Int } },
+		{ "reduce_stat", 2, { EffectArg::Stat, EffectArg::Int } },
+		{ "buff_stat", 3, { EffectArg::Stat, EffectArg::Int, EffectArg::Int } },
+		{ "equip", 1, { EffectArg::Item } },
+		{ "start_combat", 1, { EffectArg::Pack } },
+	} };
+
+	namespace effect_hash {
+
+		constexpr std::uint64_t hash(std::string_view name, std::uint64_t seed) {
+			return mix64(fnv1a64(name, kFnvOffset64 ^ seed));
+		}
+
+		constexpr std::size_t table_size(std::size_t count) {
+			std::size_t n = 4;
+			while (n < count * 2) n *= 2;
+			return n;
+		}
+
+		// Fills `slots` (power-of-two size) so that every signature lands in
+		// its own slot under `seed`. Returns false on a collision.
+		constexpr bool place(std::span<const EffectSignature> sigs, std::uint64_t seed, std::span<EffectId> slots) {
+			for (auto& s : slots) s = kNoEffect;
+			const std::uint64_t mask = slots.size() - 1;
+			for (std::size_t i = 0; i < sigs.size(); ++i) {
+				EffectId& slot = slots[hash(sigs[i].name, seed) & mask];
+				if (slot != kNoEffect) return false;
+				slot = static_cast<EffectId>(i);
+			}
+			return true;
+		}
+
+	} // namespace effect_hash
+
+	// Perfect hash over the built-in effects, found at compile time.
+	struct BuiltinEffectTable {
+		static constexpr std::size_t kSlots = effect_hash::table_size(kBuiltinEffectCount);
+		std::uint64_t seed = 0;
+		std::array<EffectId, kSlots> slots{};
+	};
+
+	consteval BuiltinEffectTable make_builtin_effect_table() {
+		BuiltinEffectTable t;
+		while (!effect_hash::place(kBuiltinEffects, t.seed, t.slots)) t.seed++;
+		return t;
+	}
+
+	inline constexpr BuiltinEffectTable kBuiltinEffectTable = make_builtin_effect_table();
+
+	// Effect signatures by name: the built-ins plus whatever a host adds.
+	//
+	// Lookup is a perfect hash: one hash, one slot, one string compare. The
+	// built-in layout is computed at compile time; add() re-seeds the table,
+	// which happens once per registration at startup, never while parsing or
+	// running.
+	class EffectTable {
+	public:
+		EffectTable();
+
+		// Returns the new id, or kNoEffect if the name is taken or the
+		// signature has more than kMaxEffectArgs arguments. `sig.name` must
+		// outlive the table (normally a string literal).
+		EffectId add(const EffectSignature& sig);
+
+		EffectId find(std::string_view name) const {
+			const EffectId id = slots_[effect_hash::hash(name, seed_) & (slots_.size() - 1)];
+			return id != kNoEffect && sigs_[id].name == name ? id : kNoEffect;
+		}
+
+		const EffectSignature& signature(EffectId id) const { return sigs_[id]; }
+		std::size_t size() const { return sigs_.size(); }
+
+		// Changes whenever a signature is added; keys cached parse results.
+		std::uint64_t fingerprint() const;
+
+		// Table with only the built-ins.
+		static const EffectTable& builtins();
+
+	private:
+		std::vector<EffectSignature> sigs_;
+		std::vector<EffectId> slots_;
+		std::uint64_t seed_ = 0;
+	};
+
+} // namespace tale_engine::dsl
@@ -1,4 +1,5 @@
 #pragma once
+#include <memory_resource>
 #include <string_view>
 #include <vector>
 
@@ -9,11 +10,13 @@ namespace tale_engine::dsl {
 
     class Lexer {
     public:
+        // The token list allocates from `resource`, which must outlive it.
         Lexer(std::string_view source,
             std::string filename,
-            Diagnostics& diagnostics);
+            Diagnostics& diagnostics,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
-        std::vector<Token> lex();
+        TokenList lex();
 
     private:
         char peek() const;
@@ -41,7 +44,7 @@ namespace tale_engine::dsl {
         int column_ = 1;
 
         std::vector<int> indent_stack_{ 0 };
-        std::vector<Token> tokens_;
+        TokenList tokens_;
     };
 
 } // namespace tale_engine::dsl
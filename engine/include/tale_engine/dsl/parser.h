@@ -3,6 +3,7 @@
 #include <string_view>
 
 #include "tale_engine/dsl/ast.h"
+#include "tale_engine/dsl/effect_signature.h"
 #include "tale_engine/dsl/token.h"
 #include "tale_engine/diagnostics.h"
 
@@ -10,7 +11,9 @@ namespace tale_engine::dsl {
 
 	class Parser {
 	public:
-		Parser(std::vector<Token> tokens, Diagnostics& diagnostics);
+		// Effect calls are checked against `effects`, which must outlive the parser.
+		Parser(TokenList tokens, Diagnostics& diagnostics,
+			const EffectTable& effects = EffectTable::builtins());
 
 		FileAst parse_file();
 
@@ -37,15 +40,23 @@ namespace tale_engine::dsl {
 		GotoStmtAst parse_goto_stmt(const Token& kw);
 		EffectStmtAst parse_effect_stmt();
 
+		// Choice conditions
+		ConditionAst parse_condition();
+		ConditionAst parse_condition_and();
+		ConditionAst parse_condition_unary();
+		ConditionAst parse_condition_call(const Token& nameTok);
+
 		// Effect calls
 		EffectCallAst parse_effect_call(const Token& nameTok);
+		ValueAst parse_effect_arg(EffectArg kind);
 		ValueAst parse_value();
 
 		int parse_int(const Token& tok);
 
 	private:
-		std::vector<Token> tokens_;
+		TokenList tokens_;
 		Diagnostics& diagnostics_;
+		const EffectTable* effects_;
 		std::size_t current_ = 0;
 	};
 
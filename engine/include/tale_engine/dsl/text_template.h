@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace tale_engine::dsl {
+
+	// Text line template syntax:
+	//   {name}    value of flag `name` (empty while unset)
+	//   {#name}   quantity of item `name`
+	//   {{ / }}   literal brace
+	// Lines without braces are plain text and are used as-is.
+
+	enum class TemplatePartKind : unsigned char { Literal, Flag, Item };
+
+	struct TemplatePart {
+		TemplatePartKind kind;
+		// Literal text, or the flag / item name. Views into the parsed line.
+		std::string_view text;
+	};
+
+	struct TemplateParse {
+		std::vector<TemplatePart> parts;
+		const char* error = nullptr; // set when the line is malformed
+		std::size_t error_offset = 0;
+	};
+
+	inline bool is_plain_text(std::string_view line) {
+		return line.find_first_of("{}") == std::string_view::npos;
+	}
+
+	// Splits a line into literal and placeholder parts (adjacent literals are
+	// not merged across escapes).
+	TemplateParse parse_template(std::string_view line);
+
+	// True if the line has at least one {flag} or {#item} placeholder.
+	bool has_placeholders(std::string_view line);
+
+} // namespace tale_engine::dsl
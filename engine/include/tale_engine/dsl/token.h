@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <cstdint>
+#include <memory_resource>
+#include <vector>
 
 #include "tale_engine/diagnostics.h"
 
@@ -29,4 +31,6 @@ namespace tale_engine::dsl {
 		SourcePos pos;
 	};
 
+	using TokenList = std::pmr::vector<Token>;
+
 } // namespace tale_engine::dsl
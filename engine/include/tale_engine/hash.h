@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+namespace tale_engine {
+
+	// Stable, platform-independent hashing helpers.
+	// Results must never depend on std::hash, pointer values or endianness,
+	// because they end up in cache keys and on-disk files.
+
+	inline constexpr std::uint64_t kFnvOffset64 = 0xcbf29ce484222325ull;
+	inline constexpr std::uint64_t kFnvPrime64 = 0x100000001b3ull;
+
+	constexpr std::uint64_t fnv1a64(std::string_view bytes, std::uint64_t h = kFnvOffset64) {
+		for (const char c : bytes) {
+			h ^= static_cast<std::uint8_t>(c);
+			h *= kFnvPrime64;
+		}
+		return h;
+	}
+
+	// splitmix64 finalizer: cheap avalanche for 64-bit values.
+	constexpr std::uint64_t mix64(std::uint64_t x) {
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ull;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebull;
+		x ^= x >> 31;
+		return x;
+	}
+
+	constexpr std::uint64_t hash_combine(std::uint64_t seed, std::uint64_t v) {
+		return mix64(seed ^ (v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+	}
+
+} // namespace tale_engine
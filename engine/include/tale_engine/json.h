@@ -0,0 +1,85 @@
+#pragma once
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tale_engine {
+
+	// Writes `s` as a quoted JSON string. Shared by every machine-readable
+	// output of the engine (diagnostics, traces, reports).
+	inline void write_json_string(std::ostream& out, std::string_view s) {
+		out.put('"');
+		for (const char c : s) {
+			switch (c) {
+			case '"': out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n"; break;
+			case '\r': out << "\\r"; break;
+			case '\t': out << "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char buf[8];
+					std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+					out << buf;
+				}
+				else {
+					out.put(c);
+				}
+				break;
+			}
+		}
+		out.put('"');
+	}
+
+	// Parsed JSON document, for reading requests (see tools/lsp). Accessors
+	// never fail: a missing member or a value of the wrong kind reads as
+	// null, false, 0, "" or an empty list.
+	class JsonValue {
+	public:
+		enum class Kind : std::uint8_t { Null, Bool, Number, String, Array, Object };
+
+		JsonValue() = default;
+
+		Kind kind() const { return kind_; }
+		bool is_null() const { return kind_ == Kind::Null; }
+		bool is_string() const { return kind_ == Kind::String; }
+
+		bool as_bool() const { return kind_ == Kind::Bool && bool_; }
+		double as_number() const { return kind_ == Kind::Number ? number_ : 0; }
+		// Truncates toward zero; a number outside int's range reads as 0.
+		int as_int() const {
+			const double n = as_number();
+			return n > static_cast<double>(INT_MIN) - 1 && n < static_cast<double>(INT_MAX) + 1 ? static_cast<int>(n) : 0;
+		}
+		const std::string& as_string() const { return string_; }
+
+		const std::vector<JsonValue>& items() const { return items_; }
+		const std::vector<std::pair<std::string, JsonValue>>& members() const { return members_; }
+
+		// Object member by key, or a null value.
+		const JsonValue& operator[](std::string_view key) const;
+
+	private:
+		friend class JsonReader;
+
+		Kind kind_ = Kind::Null;
+		bool bool_ = false;
+		double number_ = 0;
+		std::string string_;
+		std::vector<JsonValue> items_;
+		std::vector<std::pair<std::string, JsonValue>> members_;
+	};
+
+	// Parses one JSON document (RFC 8259; nesting limited to 256 levels).
+	// Returns false and leaves `out` null on malformed input.
+	bool parse_json(std::string_view text, JsonValue& out);
+
+	// Writes `value` back as compact JSON.
+	void write_json(std::ostream& out, const JsonValue& value);
+
+} // namespace tale_engine
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tale_engine::lz {
+
+	// Byte-oriented LZ77 codec for small independent blocks (compiled scene
+	// records), tuned for decode speed.
+	//
+	// A block is a run of sequences, each a token byte (literal count in the
+	// high nibble, match length - kMinMatch in the low one; 15 means more
+	// length bytes follow, 255 at a time), the literals, then a 2-byte
+	// little-endian match offset. The last sequence has literals only. The
+	// decoded size is not stored; callers keep it next to the block.
+	//
+	// Blocks may be compressed against a shared dictionary: matches reach
+	// back past the start of the block into the end of the dictionary, so
+	// phrases common to many blocks are stored once. Compressor and
+	// decompressor must use the same dictionary bytes.
+
+	inline constexpr std::size_t kMinMatch = 4;
+	inline constexpr std::size_t kMaxOffset = 65535;
+
+	// Compresses many blocks against one dictionary, indexing the
+	// dictionary once. Output is deterministic.
+	class Compressor {
+	public:
+		explicit Compressor(std::string_view dictionary = {});
+
+		// Appends the compressed form of `src` to `out`.
+		void compress(std::string_view src, std::string& out);
+
+	private:
+		std::string buf_; // dictionary window, then the current block
+		std::size_t base_;
+		std::vector<std::int32_t> dict_head_; // hash chains over the dictionary
+		std::vector<std::int32_t> dict_prev_;
+		std::vector<std::uint32_t> block_head_; // over the block, valid where stamped
+		std::vector<std::uint32_t> block_stamp_;
+		std::vector<std::uint32_t> block_prev_;
+		std::uint32_t stamp_ = 0;
+	};
+
+	// One-off compress with a throwaway Compressor.
+	void compress(std::string_view src, std::string_view dictionary, std::string& out);
+
+	// Decodes a whole block into out[0, size). Returns false, with `out`
+	// unspecified, if `src` is malformed or does not decode to exactly
+	// `size` bytes; never reads or writes out of bounds.
+	bool decompress(std::string_view src, std::string_view dictionary, char* out, std::size_t size);
+
+	// Builds a dictionary of at most `max_size` bytes from sample blocks:
+	// the segments that share the most substrings with other samples, most
+	// useful last (closest to the blocks, so cheapest to reference).
+	std::string train_dictionary(std::span<const std::string_view> samples, std::size_t max_size);
+
+} // namespace tale_engine::lz
@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+
+// Memory resources for engine containers.
+//
+// Lexer, Interpreter and State take a std::pmr::memory_resource* (default:
+// std::pmr::get_default_resource()) for the containers they own, so a host
+// can hand each subsystem a monotonic, pool or tracking resource.
+//
+// Everything a session grows while it plays is accounted: the slots,
+// indexes, journal, flag values, items and stats of a State, and the
+// Interpreter's scene table, compiled effects, step memos and step
+// buffer. A session limit therefore caps the session.
+//
+// Load-time data is not accounted and uses the global allocator, so
+// reports leave out the cost of parsing:
+//   - the AST (FileAst) and the Parser building it, which sessions share;
+//   - strings inside tokens (the token array itself is accounted);
+//   - compiled conditions and text templates, sized by the content;
+//   - the current scene id of a State, one of the story's ids.
+//
+// Resources here are not synchronized: give each session (thread) its own.
+
+namespace tale_engine::memory {
+
+	enum class Subsystem : std::uint8_t { Lexer, Interpreter, State, kCount };
+
+	const char* subsystem_name(Subsystem subsystem);
+
+	struct MemoryStats {
+		std::size_t live_bytes = 0;
+		std::size_t peak_bytes = 0;
+		std::uint64_t allocations = 0;
+		std::uint64_t deallocations = 0;
+		std::uint64_t failures = 0; // requests refused by the limit or upstream
+	};
+
+	// Forwards to `upstream` and counts what passes through.
+	//
+	// With a non-zero limit, a request that would take live bytes past it is
+	// refused: nothing is forwarded and std::bad_alloc is thrown, as the
+	// memory_resource contract requires.
+	class AccountingResource : public std::pmr::memory_resource {
+	public:
+		explicit AccountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource(),
+			std::size_t limit = 0);
+
+		AccountingResource(const AccountingResource&) = delete;
+		AccountingResource& operator=(const AccountingResource&) = delete;
+
+		const MemoryStats& stats() const { return stats_; }
+		std::pmr::memory_resource* upstream() const { return upstream_; }
+
+		std::size_t limit() const { return limit_; }
+		void set_limit(std::size_t limit) { limit_ = limit; }
+
+		// Restarts peak tracking from the current live bytes, e.g. between phases.
+		void reset_peak() { stats_.peak_bytes = stats_.live_bytes; }
+
+	private:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+		void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	private:
+		std::pmr::memory_resource* upstream_;
+		std::size_t limit_;
+		MemoryStats stats_;
+	};
+
+	// One AccountingResource per subsystem, all drawing from a session
+	// resource that enforces `session_limit` (0 = unlimited) over their sum.
+	// Per-subsystem caps can be set on subsystem(s) in addition.
+	class MemoryAccounting {
+	public:
+		explicit MemoryAccounting(std::size_t session_limit = 0,
+			std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+		MemoryAccounting(const MemoryAccounting&) = delete;
+		MemoryAccounting& operator=(const MemoryAccounting&) = delete;
+
+		AccountingResource& subsystem(Subsystem s) { return subsystems_[static_cast<std::size_t>(s)]; }
+		const AccountingResource& subsystem(Subsystem s) const { return subsystems_[static_cast<std::size_t>(s)]; }
+		std::pmr::memory_resource* resource(Subsystem s) { return &subsystem(s); }
+
+		// Totals over all subsystems; the peak is the peak of the sum.
+		AccountingResource& session() { return session_; }
+		const MemoryStats& total() const { return session_.stats(); }
+
+		// Table: per subsystem live/peak bytes and allocation counts, then the total.
+		void write_report(std::ostream& out) const;
+
+	private:
+		AccountingResource session_;
+		std::array<AccountingResource, static_cast<std::size_t>(Subsystem::kCount)> subsystems_;
+	};
+
+} // namespace tale_engine::memory
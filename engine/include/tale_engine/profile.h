@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Hot-path instrumentation.
+//
+// TALE_PROFILE_SCOPE("name")      times the enclosing scope
+// TALE_PROFILE_COUNT("name", n)   adds n to a per-thread counter
+//
+// Both compile to nothing unless TALE_ENGINE_PROFILING is defined to 1
+// (CMake option TALE_ENGINE_ENABLE_PROFILING). When compiled in, recording is
+// still off until profile::set_enabled(true); a disabled scope costs one
+// relaxed atomic load.
+//
+// Each thread records into its own fixed-size ring buffer (oldest events are
+// overwritten) plus per-site aggregates, so recording never takes a lock.
+// Export functions must be called after recording threads have stopped.
+
+namespace tale_engine::profile {
+
+	inline constexpr bool kCompiledIn =
+#if defined(TALE_ENGINE_PROFILING) && TALE_ENGINE_PROFILING
+		true;
+#else
+		false;
+#endif
+
+	enum class SiteKind : std::uint8_t { Scope, Counter };
+
+	// One instrumentation point. Instances are function-local statics created by
+	// the macros; the id indexes the per-thread aggregate arrays.
+	class Site {
+	public:
+		Site(const char* name, SiteKind kind);
+		const char* name() const { return name_; }
+		std::uint32_t id() const { return id_; }
+
+	private:
+		const char* name_;
+		std::uint32_t id_;
+	};
+
+	namespace detail {
+		extern std::atomic<bool> g_enabled;
+		std::uint64_t now_ns();
+		void record_scope(const Site& site, std::uint64_t start_ns, std::uint64_t end_ns);
+		void record_count(const Site& site, std::int64_t delta);
+	}
+
+	inline bool enabled() { return detail::g_enabled.load(std::memory_order_relaxed); }
+	void set_enabled(bool on);
+
+	// Drops all recorded events and aggregates.
+	void reset();
+
+	// Chrome trace-event JSON (chrome://tracing, Perfetto).
+	void write_chrome_trace(std::ostream& out);
+
+	// Human-readable table: per scope calls/total/avg/max, then counter totals.
+	void write_summary(std::ostream& out);
+
+	// Enables recording for its lifetime and, on destruction, writes a Chrome
+	// trace to `trace_path` and the summary table to `summary`. Used by the
+	// tools' --profile flag. An empty path makes it a no-op.
+	class Session {
+	public:
+		Session(std::string trace_path, std::ostream& summary);
+		~Session();
+
+		Session(const Session&) = delete;
+		Session& operator=(const Session&) = delete;
+
+	private:
+		std::string trace_path_;
+		std::ostream& summary_;
+	};
+
+	class ScopedTimer {
+	public:
+		explicit ScopedTimer(const Site& site)
+			: site_(site), start_(enabled() ? detail::now_ns() : 0) {}
+
+		~ScopedTimer() {
+			if (start_ != 0) detail::record_scope(site_, start_, detail::now_ns());
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+		const Site& site_;
+		std::uint64_t start_;
+	};
+
+} // namespace tale_engine::profile
+
+#define TALE_PROFILE_CONCAT_INNER(a, b) a##b
+#define TALE_PROFILE_CONCAT(a, b) TALE_PROFILE_CONCAT_INNER(a, b)
+
+#if defined(TALE_ENGINE_PROFILING) && TALE_ENGINE_PROFILING
+#define TALE_PROFILE_SCOPE(name)                                                                                  \
+	static const ::tale_engine::profile::Site TALE_PROFILE_CONCAT(tale_profile_site_, __LINE__){                 \
+		name, ::tale_engine::profile::SiteKind::Scope };                                                        \
+	const ::tale_engine::profile::ScopedTimer TALE_PROFILE_CONCAT(tale_profile_scope_, __LINE__){               \
+		TALE_PROFILE_CONCAT(tale_profile_site_, __LINE__) }
+
+#define TALE_PROFILE_COUNT(name, delta)                                                                           \
+	do {                                                                                                        \
+		static const ::tale_engine::profile::Site tale_profile_counter_site_{                                   \
+			name, ::tale_engine::profile::SiteKind::Counter };                                                  \
+		if (::tale_engine::profile::enabled())                                                                  \
+			::tale_engine::profile::detail::record_count(tale_profile_counter_site_, (delta));                  \
+	} while (0)
+#else
+#define TALE_PROFILE_SCOPE(name) ((void)0)
+#define TALE_PROFILE_COUNT(name, delta) ((void)0)
+#endif
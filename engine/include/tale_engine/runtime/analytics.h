@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "tale_engine/dsl/ast.h"
+
+namespace tale_engine::runtime {
+
+	// Ids used by analytics, all dense and derived from the FileAst alone:
+	//   scene     index in FileAst::scenes
+	//   statement scene bodies numbered scene by scene, in statement order
+	//   choice    ChoiceAst statements numbered the same way
+	//   effect    effect statements, top level and inside choices, numbered
+	//             the same way (choice bodies in place)
+	// Statement and effect ids match the Interpreter's internal numbering, so
+	// recording needs no lookups.
+
+	struct AnalyticsSnapshot {
+		std::vector<std::uint64_t> scene_visits;      // by scene; one per step() of the scene
+		std::vector<std::uint64_t> choice_selections; // by choice
+		std::vector<std::uint64_t> effect_runs;       // by effect
+		std::vector<std::uint64_t> effect_failures;   // by effect; e.g. take_item with too few items
+	};
+
+	// Counters of one recording thread (normally one Interpreter, see
+	// Interpreter::set_analytics). Only the owning thread writes; increments
+	// are relaxed atomic stores, which compile to plain adds, so snapshot()
+	// may read them concurrently without locks.
+	class AnalyticsShard {
+	public:
+		void scene_visited(std::uint32_t scene) { bump(scenes_[scene]); }
+		void choice_selected(std::uint32_t statement) { bump(statements_[statement]); }
+		void effect_run(std::uint32_t effect, bool failed) {
+			bump(effects_[effect]);
+			if (failed) bump(failures_[effect]);
+		}
+
+	private:
+		friend class Analytics;
+		using Counter = std::atomic<std::uint64_t>;
+
+		AnalyticsShard(std::size_t scenes, std::size_t statements, std::size_t effects)
+			: scenes_(scenes), statements_(statements), effects_(effects), failures_(effects) {}
+
+		static void bump(Counter& c) { c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+		std::vector<Counter> scenes_;
+		std::vector<Counter> statements_; // choices counted under their statement id
+		std::vector<Counter> effects_;
+		std::vector<Counter> failures_;
+	};
+
+	// Visit analytics for one story, aggregated over any number of shards.
+	// `ast` must outlive the Analytics. Shards live as long as it does.
+	class Analytics {
+	public:
+		explicit Analytics(const dsl::FileAst& ast);
+
+		Analytics(const Analytics&) = delete;
+		Analytics& operator=(const Analytics&) = delete;
+
+		// Thread-safe; takes a lock, so create shards up front, not per step.
+		AnalyticsShard& make_shard();
+
+		// Sums all shards. While recording continues, each counter is read at
+		// some recent value.
+		AnalyticsSnapshot snapshot() const;
+
+		std::size_t scene_count() const { return ast_.scenes.size(); }
+		std::size_t choice_count() const { return choices_.size(); }
+		std::size_t effect_count() const { return effects_.size(); }
+
+		// One row per scene, choice and effect:
+		//   kind,id,scene,label,file,line,count,failures
+		// `label` is the choice label or effect name; `failures` is empty
+		// except for effects.
+		void write_csv(std::ostream& out, const AnalyticsSnapshot& snapshot) const;
+		// {"scenes":[...],"choices":[...],"effects":[...]} with the same fields.
+		void write_json(std::ostream& out, const AnalyticsSnapshot& snapshot) const;
+
+	private:
+		struct ChoiceSite {
+			const dsl::ChoiceAst* choice;
+			std::uint32_t scene;
+			std::uint32_t statement;
+		};
+
+		struct EffectSite {
+			const dsl::EffectStmtAst* effect;
+			std::uint32_t scene;
+		};
+
+		const dsl::FileAst& ast_;
+		std::size_t statement_count_ = 0;
+		std::vector<ChoiceSite> choices_;
+		std::vector<EffectSite> effects_;
+
+		mutable std::mutex mutex_; // guards shards_
+		std::vector<std::unique_ptr<AnalyticsShard>> shards_;
+	};
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,282 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tale_engine/diagnostics.h"
+
+namespace tale_engine::runtime {
+
+	class EffectRegistry;
+
+	enum class StatusKind : std::uint8_t { None, Poison, Bleed, Stun };
+
+	// Catalog values are limited to [0, kMaxCombatValue], which keeps every
+	// step of the damage pipeline inside 32-bit arithmetic.
+	inline constexpr int kMaxCombatValue = 10000;
+	// Fighters per encounter, both sides together.
+	inline constexpr std::size_t kMaxCombatants = 32;
+	inline constexpr std::uint32_t kDefaultMaxRounds = 100;
+
+	// One fighter. An attack hits with 75 + accuracy - target evasion
+	// percent (within [5, 95]) and deals
+	//   max(1, uniform[damage_min, damage_max] * (100 + power * scaling) / 100 - armor)
+	// where the scaling factor is at most 1000x.
+	struct CombatantDef {
+		std::string id;
+		int max_hp = 10;
+		int hp = -1;            // starting hit points; -1 for max_hp
+		int accuracy = 0;
+		int evasion = 0;
+		int damage_min = 1;
+		int damage_max = 1;
+		int power = 0;          // attribute damage scales with (e.g. strength)
+		int scaling = 0;        // percent of damage added per point of power
+		int armor = 0;
+		int dexterity = 0;      // initiative is dexterity + 1d20, rolled once per fight
+		StatusKind on_hit = StatusKind::None;
+		int on_hit_chance = 0;  // percent, rolled on every hit
+		int on_hit_power = 0;   // damage per turn (Poison, Bleed)
+		int on_hit_turns = 0;
+		int heals = 0;          // self-heals available
+		int heal_amount = 0;    // hit points restored per heal
+		int heal_below = 0;     // heals while below this percent of max_hp
+	};
+
+	using CombatantId = std::uint32_t;
+	inline constexpr CombatantId kNoCombatant = static_cast<CombatantId>(-1);
+	using PackId = std::uint32_t;
+	inline constexpr PackId kNoPack = static_cast<PackId>(-1);
+
+	struct EnemyPack {
+		std::string id;
+		std::vector<CombatantId> members;
+	};
+
+	// Combatant templates and the enemy packs start_combat() names. The
+	// combatant "player", when present, is the template the player's stats
+	// are laid over.
+	class CombatCatalog {
+	public:
+		// Returns the new id, or kNoCombatant if the id is taken.
+		CombatantId add_combatant(CombatantDef def);
+		// Returns the new id, or kNoPack if the id is taken or the pack is
+		// empty or leaves no room for the player.
+		PackId add_pack(std::string_view id, std::vector<CombatantId> members);
+
+		CombatantId find_combatant(std::string_view id) const;
+		PackId find_pack(std::string_view id) const;
+		const CombatantDef& combatant(CombatantId id) const { return combatants_[id]; }
+		const EnemyPack& pack(PackId id) const { return packs_[id]; }
+		std::size_t combatant_count() const { return combatants_.size(); }
+		std::size_t pack_count() const { return packs_.size(); }
+
+	private:
+		std::vector<CombatantDef> combatants_;
+		std::unordered_map<std::string, CombatantId> combatant_index_;
+		std::vector<EnemyPack> packs_;
+		std::unordered_map<std::string, PackId> pack_index_;
+	};
+
+	// Combat catalog: the JSON form content authors edit. Combatant fields
+	// are the CombatantDef members; "on_hit" is "poison", "bleed" or "stun".
+	//
+	//   {"combatants":[
+	//   {"id":"wolf","max_hp":14,"accuracy":5,"damage_min":2,"damage_max":5,"dexterity":6,
+	//    "on_hit":"bleed","on_hit_chance":25,"on_hit_power":1,"on_hit_turns":3},
+	//   ...],
+	//   "packs":[{"id":"wolves","members":["wolf","wolf"]}]}
+	//
+	// Only "id" (and a pack's "members") is required. Reports malformed
+	// entries and repeated ids against `path` and returns false if any were
+	// found; valid entries are still added.
+	bool read_combat_catalog(std::string_view json, const std::string& path, CombatCatalog& out, Diagnostics& diagnostics);
+
+	// Outcome from the party's point of view; Draw when the round limit runs out.
+	enum class CombatOutcome : std::uint8_t { Won, Lost, Draw };
+
+	struct CombatResult {
+		CombatOutcome outcome = CombatOutcome::Draw;
+		std::uint32_t rounds = 0;
+		int party_hp = 0; // hit points left on each side
+		int enemy_hp = 0;
+	};
+
+	enum class CombatEventKind : std::uint8_t {
+		Initiative, // amount = initiative
+		Hit,        // amount = damage
+		Miss,
+		Status,     // status applied to target; amount = turns
+		Tick,       // status damage taken by actor at its turn start
+		Stunned,    // actor loses its turn
+		Heal,       // amount = hit points restored
+		Death
+	};
+
+	struct CombatEvent {
+		std::uint32_t encounter = 0;
+		std::uint32_t round = 0;
+		std::uint8_t actor = 0;  // index within the encounter: party first, then enemies
+		std::uint8_t target = 0;
+		CombatEventKind kind = CombatEventKind::Hit;
+		StatusKind status = StatusKind::None;
+		int amount = 0;
+	};
+
+	// One line per event of `encounter`; `names` are its combatants, party first.
+	void write_combat_log(std::ostream& out, std::span<const CombatEvent> events, std::uint32_t encounter,
+		std::span<const std::string_view> names);
+
+	// Many independent encounters fought in lockstep.
+	//
+	// Combatants of all encounters live in one set of flat per-field arrays.
+	// Fights are turn-based: every round each living combatant acts once,
+	// in initiative order. The batch advances one turn slot at a time
+	// across all encounters; a slot holds at most one action per encounter,
+	// so the attacks of a slot are gathered into contiguous arrays and the
+	// hit roll, base damage, scaling, armor and on-hit steps each run as one
+	// branch-free loop the compiler vectorizes, with no write conflicts when
+	// damage is scattered back.
+	//
+	// AI: heal below the heal threshold while heals last, otherwise attack
+	// the living opponent with the fewest hit points (lowest index on ties).
+	// Statuses tick at the afflicted combatant's turn start: poison refreshes
+	// to the stronger dose, bleed stacks its damage, stun skips the turn.
+	//
+	// Every random number an encounter uses is a Philox block addressed by
+	// (encounter stream, round, turn slot), and the stream depends only on
+	// the batch seed and the id given to add(). An encounter therefore plays
+	// out bit-identically whatever else shares its batch or thread.
+	class CombatBatch {
+	public:
+		explicit CombatBatch(std::uint64_t seed);
+
+		// Adds an encounter; returns its index. `party` is side 0. Needs at
+		// least one combatant per side and at most kMaxCombatants in total.
+		std::uint32_t add(std::span<const CombatantDef> party, std::span<const CombatantDef> enemies, std::uint64_t id);
+
+		// Events are appended to `log` during run(); null (the default)
+		// records nothing.
+		void set_log(std::vector<CombatEvent>* log) { log_ = log; }
+
+		// Fights every encounter added since the last run() to the end.
+		void run(std::uint32_t max_rounds = kDefaultMaxRounds);
+
+		std::size_t size() const { return first_.size(); }
+		const CombatResult& result(std::uint32_t encounter) const { return results_[encounter]; }
+		int hp(std::uint32_t encounter, std::size_t index) const { return hp_[first_[encounter] + index]; }
+
+		// Drops all encounters; keeps the allocated capacity.
+		void clear();
+
+	private:
+		void roll_initiative();
+		void take_turn(std::uint32_t e, std::uint32_t c, std::uint32_t round, std::uint32_t slot);
+		void resolve_attacks();
+		void apply_attacks(std::uint32_t round);
+		void damage(std::uint32_t e, std::uint32_t c, int amount, std::uint32_t round);
+		void log(std::uint32_t e, std::uint32_t round, std::uint32_t actor, std::uint32_t target, CombatEventKind kind,
+			StatusKind status, int amount);
+
+	private:
+		std::uint64_t seed_;
+		std::vector<CombatEvent>* log_ = nullptr;
+
+		// Per combatant, all encounters back to back.
+		std::vector<int> hp_;
+		std::vector<int> max_hp_;
+		std::vector<int> accuracy_;
+		std::vector<int> evasion_;
+		std::vector<int> damage_min_;
+		std::vector<int> damage_span_; // damage_max - damage_min + 1
+		std::vector<int> scale_;       // 100 + power * scaling, capped
+		std::vector<int> armor_;
+		std::vector<int> dexterity_;
+		std::vector<int> initiative_;
+		std::vector<StatusKind> on_hit_;
+		std::vector<int> on_hit_chance_;
+		std::vector<int> on_hit_power_;
+		std::vector<int> on_hit_turns_;
+		std::vector<int> heals_;
+		std::vector<int> heal_amount_;
+		std::vector<int> heal_below_;
+		std::vector<std::uint8_t> side_;
+		std::vector<int> poison_turns_;
+		std::vector<int> poison_power_;
+		std::vector<int> bleed_turns_;
+		std::vector<int> bleed_power_;
+		std::vector<int> stun_turns_;
+		std::vector<std::uint8_t> order_; // local indices in initiative order, same offsets as the combatants
+
+		// Per encounter.
+		std::vector<std::uint32_t> first_;
+		std::vector<std::uint8_t> count_;
+		std::vector<std::uint8_t> alive_party_;
+		std::vector<std::uint8_t> alive_enemies_;
+		std::vector<std::uint64_t> stream_;
+		std::vector<std::uint8_t> done_;
+		std::vector<CombatResult> results_;
+		std::uint32_t started_ = 0; // encounters before this one have run
+
+		// Attacks of the current turn slot, one per encounter at most.
+		std::vector<std::uint32_t> active_;
+		std::vector<std::uint32_t> act_encounter_;
+		std::vector<std::uint32_t> act_attacker_;
+		std::vector<std::uint32_t> act_target_;
+		std::vector<std::uint64_t> act_stream_;
+		std::vector<std::uint64_t> act_block_;
+		std::vector<std::uint32_t> act_random_; // 4 words per attack
+		std::vector<int> act_accuracy_;
+		std::vector<int> act_evasion_;
+		std::vector<int> act_damage_min_;
+		std::vector<int> act_damage_span_;
+		std::vector<int> act_scale_;
+		std::vector<int> act_armor_;
+		std::vector<int> act_on_hit_chance_;
+		std::vector<int> act_damage_;
+		std::vector<std::uint8_t> act_hit_;
+		std::vector<std::uint8_t> act_inflict_;
+	};
+
+	struct CombatSimulation {
+		std::uint64_t seed = 0;
+		std::uint64_t first_id = 0; // encounter i uses id first_id + i
+		std::size_t count = 0;
+		unsigned threads = 0;       // 0 = hardware concurrency
+		std::size_t batch = 1024;   // encounters per lockstep batch
+		std::uint32_t max_rounds = kDefaultMaxRounds;
+	};
+
+	// Fights `sim.count` copies of one encounter, split into batches shared
+	// out to worker threads. Results are in id order and identical for any
+	// thread count or batch size.
+	std::vector<CombatResult> simulate_combat(std::span<const CombatantDef> party, std::span<const CombatantDef> enemies,
+		const CombatSimulation& sim);
+
+	// Host side of the start_combat(pack) effect.
+	//
+	// The player fights the pack as the catalog's "player" combatant (or a
+	// default one), with every CombatantDef field that names a State stat
+	// (max_hp, accuracy, armor, ...) taken from that stat; a stat "hp" sets
+	// the starting hit points and receives the damage taken. The outcome is
+	// left in the flag combat_result as "won", "lost" or "draw", and the
+	// flag combat_count counts the fights started.
+	//
+	// The fight's stream is split off `seed` by the State's time and
+	// combat_count, so two fights in one choice differ and a replay with the
+	// recorded seed fights the same fights.
+	struct CombatContext {
+		const CombatCatalog* catalog = nullptr;
+		std::uint64_t seed = 0;
+		std::ostream* log = nullptr; // combat log, if wanted
+	};
+
+	// Points start_combat in `registry` at `context`, which must outlive it.
+	void bind_combat(EffectRegistry& registry, CombatContext& context);
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "tale_engine/dsl/ast.h"
+#include "tale_engine/runtime/state.h"
+
+namespace tale_engine::runtime {
+
+	using ConditionId = std::uint32_t;
+	inline constexpr ConditionId kNoCondition = static_cast<ConditionId>(-1);
+
+	// All choice conditions of a FileAst compiled to postfix predicate code.
+	//
+	// Flag, item and stat names are interned into program-wide input slots; each
+	// condition lists the inputs it reads, and the inverse (input -> dependent
+	// conditions) drives ConditionCache invalidation.
+	class ConditionProgram {
+	public:
+		enum class Op : std::uint8_t {
+			HasFlag,    // push flag[a] is set
+			FlagEquals, // push flag[a] == constants[b]
+			HasItem,    // push item[a] >= b
+			StatAtLeast, // push stat[a] >= b
+			Not,        // pop 1, push !x
+			And,        // pop a, push all
+			Or          // pop a, push any
+		};
+
+		struct Instr {
+			Op op;
+			std::uint32_t a = 0;
+			std::int32_t b = 0;
+		};
+
+		struct Input {
+			SlotKind kind;
+			std::string name;
+		};
+
+		ConditionId add(const dsl::ConditionAst& condition);
+
+		std::size_t size() const { return code_offsets_.empty() ? 0 : code_offsets_.size() - 1; }
+		const std::vector<Input>& inputs() const { return inputs_; }
+
+		// Must be called once after the last add(); builds the dependency index.
+		void finalize();
+
+	private:
+		friend class ConditionCache;
+
+		std::uint32_t input(SlotKind kind, const std::string& name);
+		void emit(const dsl::ConditionAst& c);
+
+	private:
+		std::vector<Instr> code_;
+		std::vector<std::uint32_t> code_offsets_; // condition i = code_[off[i], off[i+1])
+		std::vector<std::variant<std::string, int, bool>> constants_;
+
+		std::vector<Input> inputs_;
+		std::unordered_map<std::string, std::uint32_t> input_index_[3]; // per SlotKind
+		std::vector<std::uint32_t> deps_offsets_;   // input i -> dependents_[off[i], off[i+1])
+		std::vector<ConditionId> dependents_;
+		std::vector<std::vector<std::uint32_t>> reads_; // per condition, distinct inputs (until finalize)
+	};
+
+	// Cached condition results for one State at a time.
+	//
+	// On first use with a State (or after its journal restarts) every input is
+	// resolved to a State slot and all conditions are marked dirty. Afterwards
+	// sync() replays only the State's change journal, marking just the
+	// conditions that read a changed slot; value() re-evaluates a condition
+	// only if it is dirty.
+	class ConditionCache {
+	public:
+		explicit ConditionCache(const ConditionProgram& program);
+
+		void sync(State& state);
+
+		// Requires a prior sync() with the same State.
+		bool value(const State& state, ConditionId id);
+
+	private:
+		bool evaluate(const State& state, ConditionId id);
+
+	private:
+		const ConditionProgram& program_;
+
+		std::uint64_t epoch_ = 0; // State journal epoch we are bound to (0 = none)
+		std::size_t cursor_ = 0;  // journal entries already applied
+
+		std::vector<SlotId> slot_of_input_;
+		// State slot -> program input, per SlotKind; kNoInput if unreferenced.
+		std::vector<std::uint32_t> input_of_slot_[3];
+
+		std::vector<std::uint8_t> dirty_;
+		std::vector<std::uint8_t> result_;
+		std::vector<std::uint8_t> stack_;
+	};
+
+} // namespace tale_engine::runtime
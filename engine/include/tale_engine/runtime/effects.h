@@ -0,0 +1,71 @@
+#pragma once
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/effect_signature.h"
+#include "tale_engine/runtime/state.h"
+#include "tale_engine/runtime/value.h"
+
+namespace tale_engine::runtime {
+
+	// Arguments and context of one effect execution. Arguments follow the
+	// effect's signature: Flag, Item, Stat and Pack arguments hold the name
+	// as a string, Int an int, Value whatever literal the content used.
+	struct EffectCall {
+		State& state;
+		Diagnostics& diagnostics;
+		const SourcePos& pos;
+		std::span<const Value> args;
+		void* user; // as passed to EffectRegistry::add or bind
+		// Set by the handler when the effect could not apply (e.g. take_item
+		// with too few items); counted by analytics.
+		bool failed = false;
+
+		const std::string& name(std::size_t i) const { return std::get<std::string>(args[i].data); }
+		int integer(std::size_t i) const { return std::get<int>(args[i].data); }
+	};
+
+	using EffectHandler = void (*)(EffectCall& call);
+
+	// Effects the runtime can execute: signature plus handler, under the ids
+	// of the underlying dsl::EffectTable. Built-ins are registered up front.
+	//
+	// Parse content with signatures() so native effects type-check, then hand
+	// the registry to the Interpreter. The Interpreter resolves every effect
+	// statement to its handler once, at construction; executing an effect is
+	// a single indirect call, the same for built-in and native effects.
+	class EffectRegistry {
+	public:
+		EffectRegistry();
+
+		// Returns the new id, or dsl::kNoEffect if the name is taken or the
+		// signature is invalid. `user` is passed back to the handler.
+		dsl::EffectId add(const dsl::EffectSignature& sig, EffectHandler handler, void* user = nullptr);
+
+		const dsl::EffectTable& signatures() const { return table_; }
+		dsl::EffectId find(std::string_view name) const { return table_.find(name); }
+
+		// Replaces the handler of an existing effect, e.g. a built-in that
+		// needs host data. Returns false for an unknown id or a null handler.
+		bool bind(dsl::EffectId id, EffectHandler handler, void* user = nullptr);
+
+		EffectHandler handler(dsl::EffectId id) const { return entries_[id].handler; }
+		void* user(dsl::EffectId id) const { return entries_[id].user; }
+
+		// Registry with only the built-ins.
+		static const EffectRegistry& builtins();
+
+	private:
+		struct Entry {
+			EffectHandler handler;
+			void* user;
+		};
+
+		dsl::EffectTable table_;
+		std::vector<Entry> entries_;
+	};
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "tale_engine/dsl/ast.h"
+#include "tale_engine/runtime/value.h"
+
+namespace tale_engine::runtime {
+
+	// Story content compiled into the executable (see tools/embed and
+	// tale_embed_story() in cmake/TaleEmbed.cmake).
+	//
+	// Everything is a literal type so generated sources can hold the whole
+	// story in constexpr tables: no file I/O, lexing, parsing or validation
+	// happens at startup. Strings view literals in static storage. Child
+	// ranges (text lines, choice bodies, condition operands) index into the
+	// flat tables of the owning EmbeddedStory.
+
+	inline constexpr std::uint32_t kNoEmbeddedCondition = UINT32_MAX;
+
+	struct EmbeddedPos {
+		std::uint32_t file = 0; // index into EmbeddedStory::files
+		int line = 1;
+		int column = 1;
+	};
+
+	enum class EmbeddedValueKind : std::uint8_t { String, Int, Bool };
+
+	struct EmbeddedValue {
+		EmbeddedPos pos;
+		EmbeddedValueKind kind = EmbeddedValueKind::Bool;
+		std::string_view text;
+		int number = 0; // Int value, or 0/1 for Bool
+	};
+
+	struct EmbeddedCondition {
+		EmbeddedPos pos;
+		dsl::ConditionOp op = dsl::ConditionOp::HasFlag;
+		std::string_view name;
+		EmbeddedValue value;
+		int qty = 1;
+		std::uint32_t first = 0; // operands: conditions[first, first + count)
+		std::uint32_t count = 0;
+	};
+
+	// Argument of a native effect call.
+	struct EmbeddedArg {
+		dsl::EffectArg kind = dsl::EffectArg::Value;
+		EmbeddedValue value;
+	};
+
+	enum class EmbeddedStmtKind : std::uint8_t { Text, Choice, Goto, SetFlag, GiveItem, TakeItem, Native };
+
+	struct EmbeddedStmt {
+		EmbeddedPos pos;
+		EmbeddedStmtKind kind = EmbeddedStmtKind::Goto;
+		std::string_view name; // goto target, flag, item, choice label or native effect
+		EmbeddedValue value;   // SetFlag
+		int qty = 0;           // GiveItem / TakeItem
+		// Text: lines[first, first + count); Choice: body in stmts[first, first + count);
+		// Native: args[first, first + count).
+		std::uint32_t first = 0;
+		std::uint32_t count = 0;
+		std::uint32_t condition = kNoEmbeddedCondition; // Choice
+	};
+
+	struct EmbeddedScene {
+		EmbeddedPos pos;
+		std::string_view id;
+		std::uint32_t first = 0; // body: stmts[first, first + count)
+		std::uint32_t count = 0;
+	};
+
+	struct EmbeddedStory {
+		std::span<const std::string_view> files;
+		std::span<const EmbeddedScene> scenes;
+		std::span<const EmbeddedStmt> stmts;
+		std::span<const std::string_view> lines;
+		std::span<const EmbeddedCondition> conditions;
+		std::span<const EmbeddedArg> args;
+		// runtime::content_hash of the content, for checking session logs.
+		std::uint64_t content_hash = 0;
+	};
+
+	// The Interpreter runs embedded stories in place (see its EmbeddedStory
+	// constructor); these convert single entries for it.
+	SourcePos to_source_pos(const EmbeddedStory& story, const EmbeddedPos& pos);
+	Value to_value(const EmbeddedStory& story, const EmbeddedValue& value);
+	dsl::ConditionAst to_condition_ast(const EmbeddedStory& story, const EmbeddedCondition& condition);
+
+	// Builds the AST the story was generated from (same content_hash), for
+	// tools that need one, such as Analytics; nothing is re-validated.
+	dsl::FileAst to_ast(const EmbeddedStory& story);
+
+} // namespace tale_engine::runtime
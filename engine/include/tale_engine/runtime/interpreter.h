@@ -1,56 +1,258 @@
 #pragma once
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "tale_engine/dsl/ast.h"
+#include "tale_engine/runtime/analytics.h"
+#include "tale_engine/runtime/conditions.h"
+#include "tale_engine/runtime/effects.h"
+#include "tale_engine/runtime/embedded_story.h"
+#include "tale_engine/runtime/session_log.h"
 #include "tale_engine/runtime/state.h"
+#include "tale_engine/runtime/string_table.h"
+#include "tale_engine/runtime/text_templates.h"
+#include "tale_engine/runtime/triggers.h"
 #include "tale_engine/diagnostics.h"
 
 namespace tale_engine::runtime {
 
     struct ChoiceOption {
-        std::string label;
+        // A view of the story's label (AST, embedded table or string table).
+        std::string_view label;
         // The index of the choice statement inside the current scene body.
         // Used to resolve effects + goto for that specific choice.
         std::size_t choice_stmt_index = 0;
     };
 
+    // One emitted text line: a view of the source line (AST or string
+    // table) when it is plain text, otherwise a range of StepResult::rendered.
+    struct TextLine {
+        const char* source = nullptr;
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+    };
+
+    // Allocator-aware, so the Interpreter's buffers and memos of it live on
+    // the Interpreter's resource; copies made by the host use the default one.
     struct StepResult {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+
+        StepResult() = default;
+        explicit StepResult(const allocator_type& alloc) : text(alloc), rendered(alloc), choices(alloc) {}
+        StepResult(const StepResult& other, const allocator_type& alloc)
+            : text(other.text, alloc), rendered(other.rendered, alloc), choices(other.choices, alloc),
+              next_scene_id(other.next_scene_id) {}
+        StepResult(const StepResult&) = default;
+        StepResult(StepResult&&) = default;
+        StepResult& operator=(const StepResult&) = default;
+        StepResult& operator=(StepResult&&) = default;
+
         // Text lines emitted by executing the scene up to the first choice (or end).
-        std::vector<std::string> text;
+        // Read them with line(i); plain lines are views of their source.
+        std::pmr::vector<TextLine> text;
+        // Output of templated lines, rendered as the scene executes.
+        std::pmr::string rendered;
+
+        std::string_view line(std::size_t i) const {
+            const TextLine& t = text[i];
+            return t.source ? std::string_view(t.source, t.length) : std::string_view(rendered).substr(t.offset, t.length);
+        }
 
         // Available choices (if any). If empty, the scene is terminal (in v1).
-        std::vector<ChoiceOption> choices;
+        std::pmr::vector<ChoiceOption> choices;
+
+        // If a scene immediately transfers (e.g., via top-level goto), next_scene_id is set
+        // (a view of the story's goto target). For v1 we keep this simple.
+        std::string_view next_scene_id;
+    };
 
-        // If a scene immediately transfers (e.g., via top-level goto), next_scene_id is set.
-        // For v1 we keep this simple.
-        std::string next_scene_id;
+    // How a scene's step() output depends on State.
+    enum class StepDependency : std::uint8_t {
+        None,       // plain text, choices and gotos only: the output never changes
+        Conditions, // additionally has conditional choices; only the offered
+                    // subset varies, with the conditions' values
+        Full        // runs effects, interpolates text or has too many
+                    // conditions; never cached
     };
 
+    // Conditional choices a scene may have and still be cached.
+    inline constexpr std::size_t kMaxMemoConditions = 16;
+
     class Interpreter {
     public:
-        Interpreter(const dsl::FileAst& ast, Diagnostics& diagnostics);
+        // Effects run through `effects`, which (with the user data of its
+        // handlers) must outlive the interpreter. Effects the content calls
+        // but the registry lacks warn when executed.
+        //
+        // The scene table, compiled effects, step memos and the step_ref()
+        // buffer allocate from `resource`, which must outlive the
+        // interpreter. Compiled conditions and text templates use the global
+        // allocator.
+        //
+        // Scene ids, text, labels and goto targets are viewed in place, so
+        // `ast` must outlive the interpreter.
+        Interpreter(const dsl::FileAst& ast, Diagnostics& diagnostics,
+            const EffectRegistry& effects = EffectRegistry::builtins(),
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        // Runs an embedded story straight from its constexpr tables: no AST
+        // is built. Only conditions and effect arguments are compiled, as
+        // for parsed content; numbering (analytics ids, string table keys)
+        // is the same as for the AST the story was generated from.
+        Interpreter(const EmbeddedStory& story, Diagnostics& diagnostics,
+            const EffectRegistry& effects = EffectRegistry::builtins(),
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        Interpreter(const Interpreter&) = delete;
+        Interpreter& operator=(const Interpreter&) = delete;
 
         // Sets start scene. If empty, starts at first scene in file.
         bool start(State& state, const std::string& start_scene_id = "");
 
-        // Executes the current scene and returns text + choices.
-        StepResult step(State& state);
+        // Executes the current scene and returns text + choices. Conditional
+        // choices are only offered while their condition holds; conditions are
+        // re-evaluated only when a flag or item they read has changed.
+        StepResult step(State& state) { return step_ref(state); }
 
-        // Applies the selected choice (by index in StepResult.choices) and advances state.current_scene.
+        // Same as step(), but returns a reference that stays valid until the
+        // next step/step_ref call. Scenes classified None or Conditions are
+        // memoized per (scene, condition values, headless), so revisiting a
+        // hub scene is a lookup with no re-execution and no copying.
+        const StepResult& step_ref(State& state);
+
+        // Applies the selected choice (by index in StepResult.choices) and advances state.current_scene
+        // and, by one tick, state.time().
         bool apply_choice(State& state, const StepResult& step, std::size_t choice_index);
 
+        // Every successful apply_choice is reported to `recorder` (not owned; may be null).
+        void set_recorder(SessionRecorder* recorder) { recorder_ = recorder; }
+
+        // Scene visits, selected choices and effect runs are counted in
+        // `shard` (not owned; may be null), which must come from an
+        // Analytics built over the same FileAst.
+        void set_analytics(AnalyticsShard* shard) { analytics_ = shard; }
+
+        // apply_choice fires TriggerEvent::ChoiceSelected for kPlayerEntity
+        // in `triggers` (not owned; may be null) before the choice's effects
+        // run, with the choice index as TriggerArgs::amount.
+        void set_triggers(TriggerSystem* triggers) { triggers_ = triggers; }
+
+        // Text lines and choice labels are looked up in `strings` (not owned;
+        // must stay open while set), falling back to the story's own text
+        // for keys it lacks; null restores the story's text. Switching
+        // recompiles the text templates and drops step memos; the story
+        // itself is not re-parsed.
+        void set_strings(const StringTable* strings);
+
+        // Headless mode skips building StepResult text and choice labels;
+        // used by replay and simulations that never display anything.
+        void set_headless(bool headless) { headless_ = headless; }
+        bool headless() const { return headless_; }
+
     private:
-        const dsl::SceneAst* find_scene(const std::string& id) const;
+        enum class StmtKind : std::uint8_t { Text, Effect, Goto, Choice };
+
+        // A scene body statement reduced to what step() and apply_choice()
+        // read. Strings view the story (AST or embedded tables).
+        struct Stmt {
+            StmtKind kind = StmtKind::Text;
+            bool conditional = false;       // Choice
+            bool has_goto = false;          // Choice
+            std::uint32_t count = 0;        // Text: lines; Choice: effects in its body
+            std::string_view target;        // Goto; Choice: its first goto
+            std::string_view label;         // Choice
+            const SourcePos* pos = nullptr; // Choice
+        };
+
+        struct SceneEntry {
+            std::string_view id;
+            std::uint32_t index; // into entries_ and memos_
+            StepDependency dependency;
+            // Id of the scene's first conditional choice; the others follow
+            // in statement order.
+            ConditionId first_condition;
+            // Conditional choices in the choice run step() offers.
+            std::uint32_t step_conditions;
+            // Id of the scene's first text line in text_.
+            TextLineId first_line;
+            // Scene body statement i is stmts_[first_stmt + i]; its effects
+            // start at effects_[stmt_effects_[first_stmt + i]].
+            std::uint32_t first_stmt;
+            std::uint32_t stmt_count;
+        };
+
+        // An effect statement resolved to its handler.
+        struct CompiledEffect {
+            EffectHandler handler;
+            void* user;
+            const SourcePos* pos;
+            std::uint32_t first_arg; // effect_args_[first_arg, first_arg + arg_count)
+            std::uint32_t arg_count;
+        };
+
+        // Memoized outputs of one scene; a handful of variants at most.
+        using MemoVariants = std::pmr::vector<std::pair<std::uint64_t, StepResult>>;
+        static constexpr std::size_t kMaxMemoVariants = 8;
+
+        const SceneEntry* find_entry(std::string_view id) const;
+
+        // Building the scene table
+        void add_scene(std::string_view id);
+        void add_line(std::string_view line);
+        void add_stmt(const Stmt& stmt, std::uint32_t first_effect);
+        void index_scenes();
+        StepDependency classify(const SceneEntry& entry, std::uint32_t& step_conditions) const;
+        void compile_effect(const EffectRegistry& effects, const dsl::EffectStmtAst& eff);
+        void compile_effect(const EffectRegistry& effects, const EmbeddedStory& story, const EmbeddedStmt& eff);
+        void resolve_effect(const EffectRegistry& effects, dsl::EffectId id, std::string_view name,
+            std::span<const dsl::EffectArg> arg_kinds, const SourcePos* pos, std::uint32_t first_arg);
 
         // Execute helpers
-        void apply_effect(State& state, const dsl::EffectStmtAst& eff);
-        bool try_extract_goto(const std::vector<std::variant<dsl::GotoStmtAst, dsl::EffectStmtAst>>& body,
-            std::string& out_target) const;
+        void execute(State& state, const SceneEntry& entry, StepResult& out);
+        void run_effect(State& state, std::uint32_t id);
 
     private:
-        const dsl::FileAst& ast_;
         Diagnostics& diags_;
+
+        // Scenes in story order, duplicates included; lookup by id, where
+        // the first declaration wins, as in validation.
+        std::pmr::vector<SceneEntry> entries_;
+        std::pmr::unordered_map<std::string_view, std::uint32_t> scenes_;
+        std::pmr::vector<Stmt> stmts_;
+        std::pmr::vector<std::string_view> lines_; // story text by TextLineId
+
+        // Positions and effect names an embedded story only has in its
+        // tables' form; deques keep the pointers handed out stable.
+        std::pmr::deque<SourcePos> positions_;
+        std::pmr::deque<std::string_view> effect_names_;
+
+        ConditionProgram conditions_;
+        ConditionCache condition_cache_;
+
+        TextTemplates text_;
+
+        std::pmr::vector<CompiledEffect> effects_; // scene by scene, in statement order
+        std::pmr::vector<Value> effect_args_;
+        std::pmr::vector<std::uint32_t> stmt_effects_;
+
+        // Choice labels from the string table, by statement like
+        // stmt_effects_; empty while the story's own labels are used.
+        std::pmr::vector<std::string_view> labels_;
+
+        std::pmr::vector<MemoVariants> memos_; // by SceneEntry::index
+        StepResult scratch_;              // output of uncached steps
+
+        SessionRecorder* recorder_ = nullptr;
+        AnalyticsShard* analytics_ = nullptr;
+        TriggerSystem* triggers_ = nullptr;
+        bool headless_ = false;
     };
 
 } // namespace tale_engine::runtime
@@ -0,0 +1,180 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tale_engine/diagnostics.h"
+
+namespace tale_engine::runtime {
+
+	// Dense index of an item inside one Inventory (and its State). Catalog
+	// items keep their catalog ids; items without a definition are appended
+	// on first use.
+	using ItemId = std::uint32_t;
+	inline constexpr ItemId kNoItem = static_cast<ItemId>(-1);
+
+	using TagId = std::uint32_t;
+	using EquipSlot = std::uint32_t;
+	inline constexpr EquipSlot kNoEquipSlot = static_cast<EquipSlot>(-1);
+
+	using InstanceId = std::uint32_t;
+	inline constexpr InstanceId kNoInstance = static_cast<InstanceId>(-1);
+
+	struct ItemDef {
+		std::string id;
+		int weight = 0;                  // per unit
+		bool unique = false;             // every unit is a separate instance
+		EquipSlot slot = kNoEquipSlot;   // unique items only
+		std::uint32_t first_tag = 0;     // tags_[first_tag, first_tag + tag_count)
+		std::uint32_t tag_count = 0;
+	};
+
+	// Item definitions shared by every State of a game. Tags and equipment
+	// slots are interned into dense ids as items name them.
+	class ItemCatalog {
+	public:
+		// Returns the new id, or kNoItem if the id is taken or a stackable
+		// item names an equipment slot.
+		ItemId add(std::string_view id, int weight, bool unique, std::string_view slot, std::span<const std::string> tags);
+
+		ItemId find(std::string_view id) const;
+		std::size_t size() const { return defs_.size(); }
+		const ItemDef& def(ItemId id) const { return defs_[id]; }
+		std::span<const TagId> tags(ItemId id) const {
+			return std::span<const TagId>(tags_).subspan(defs_[id].first_tag, defs_[id].tag_count);
+		}
+
+		TagId find_tag(std::string_view name) const;
+		std::size_t tag_count() const { return tag_names_.size(); }
+		const std::string& tag_name(TagId tag) const { return tag_names_[tag]; }
+
+		EquipSlot find_slot(std::string_view name) const;
+		std::size_t slot_count() const { return slot_names_.size(); }
+		const std::string& slot_name(EquipSlot slot) const { return slot_names_[slot]; }
+
+	private:
+		std::vector<ItemDef> defs_;
+		std::vector<TagId> tags_;
+		std::unordered_map<std::string, ItemId> index_;
+		std::vector<std::string> tag_names_;
+		std::unordered_map<std::string, TagId> tag_index_;
+		std::vector<std::string> slot_names_;
+		std::unordered_map<std::string, EquipSlot> slot_index_;
+	};
+
+	// Item catalog: the JSON form content authors edit.
+	//
+	//   {"items":[
+	//   {"id":"iron_sword","weight":30,"unique":true,"slot":"hand","tags":["weapon","metal"]},
+	//   {"id":"arrow","weight":1,"tags":["ammo"]},
+	//   ...]}
+	//
+	// Only "id" is required. Reports malformed entries and repeated ids
+	// against `path` and returns false if any were found; valid entries are
+	// still added.
+	bool read_item_catalog(std::string_view json, const std::string& path, ItemCatalog& out, Diagnostics& diagnostics);
+
+	// Items of one State.
+	//
+	// Stackable items are a quantity per item in flat arrays. Unique items
+	// also get one instance per unit in a pooled slab: freed instances are
+	// reused, and each item threads its instances through an intrusive list,
+	// so giving, taking and equipping cost O(quantity moved) whatever the
+	// inventory holds. Total weight, tag counts (units held per tag) and the
+	// occupant of each equipment slot are updated by those operations and
+	// never recomputed.
+	class Inventory {
+	public:
+		explicit Inventory(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+		Inventory(Inventory&& other) noexcept = default;
+		Inventory& operator=(Inventory&& other) = default;
+
+		// Copies `other` into this object's resource.
+		void assign(const Inventory& other);
+
+		// Drops every item; catalog items come back with quantity 0.
+		// `catalog` must outlive this.
+		void reset(const ItemCatalog* catalog);
+		const ItemCatalog* catalog() const { return catalog_; }
+
+		ItemId find(std::string_view name) const;
+		ItemId intern(std::string_view name);
+		std::size_t size() const { return qty_.size(); }
+		std::string_view name(ItemId id) const { return names_[id]; }
+
+		int qty(ItemId id) const { return qty_[id]; }
+		// Quantities saturate at INT_MAX; anything beyond is not given.
+		void give(ItemId id, int qty);
+		// Returns false, changing nothing, if fewer than `qty` are held.
+		// Unique items give up unequipped instances first.
+		bool take(ItemId id, int qty);
+
+		// Instances of a unique item, most recently given first.
+		InstanceId first_instance(ItemId id) const { return head_[id]; }
+		InstanceId next_instance(InstanceId instance) const { return inst_next_[instance]; }
+		ItemId instance_item(InstanceId instance) const { return inst_item_[instance]; }
+		EquipSlot instance_slot(InstanceId instance) const { return inst_equipped_[instance]; }
+
+		// Puts the instance in its item's slot, unequipping the previous
+		// occupant. False if the item has no slot.
+		bool equip(InstanceId instance);
+		// Returns the instance taken out of `slot`, or kNoInstance.
+		InstanceId unequip(EquipSlot slot);
+		InstanceId equipped(EquipSlot slot) const { return slot < equipped_.size() ? equipped_[slot] : kNoInstance; }
+
+		std::int64_t total_weight() const { return total_weight_; }
+		std::int64_t tag_count(TagId tag) const { return tag < tag_counts_.size() ? tag_counts_[tag] : 0; }
+
+		// Hash of non-zero quantities and of what each slot holds; 0 for an
+		// empty inventory. hash() is O(1); compute_hash() starts over.
+		std::uint64_t hash() const { return hash_; }
+		std::uint64_t compute_hash() const;
+
+		std::pmr::memory_resource* resource() const { return qty_.get_allocator().resource(); }
+
+	private:
+		struct NameHash {
+			using is_transparent = void;
+			std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+		};
+		struct NameEqual {
+			using is_transparent = void;
+			bool operator()(std::string_view a, std::string_view b) const { return a == b; }
+		};
+
+		ItemId append(std::string_view name);
+		void add_units(ItemId id, int qty); // weight and tags; qty may be negative
+		void set_qty(ItemId id, int qty);
+		std::uint64_t equip_hash(EquipSlot slot) const;
+		InstanceId allocate(ItemId id);
+		void release(InstanceId instance);
+
+	private:
+		const ItemCatalog* catalog_ = nullptr;
+
+		// Per item.
+		std::pmr::vector<std::pmr::string> names_;
+		std::pmr::unordered_map<std::pmr::string, ItemId, NameHash, NameEqual> index_;
+		std::pmr::vector<int> qty_;
+		std::pmr::vector<InstanceId> head_; // kNoInstance for stackable items
+
+		// Instance slab; free instances chain through inst_next_.
+		std::pmr::vector<ItemId> inst_item_;
+		std::pmr::vector<InstanceId> inst_next_;
+		std::pmr::vector<InstanceId> inst_prev_;
+		std::pmr::vector<EquipSlot> inst_equipped_;
+		InstanceId free_ = kNoInstance;
+
+		std::pmr::vector<InstanceId> equipped_; // by catalog slot
+		std::pmr::vector<std::int64_t> tag_counts_; // by catalog tag
+		std::int64_t total_weight_ = 0;
+		std::uint64_t hash_ = 0;
+	};
+
+} // namespace tale_engine::runtime
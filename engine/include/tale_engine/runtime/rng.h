@@ -0,0 +1,120 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace tale_engine::runtime {
+
+	// Well-known stream ids for engine subsystems. Each subsystem splits its
+	// own stream off the session RNG, so adding a roll in one subsystem never
+	// shifts the sequence seen by another.
+	enum class RngStream : std::uint64_t {
+		Checks = 1,
+		Loot = 2,
+		Combat = 3,
+		Simulation = 4
+	};
+
+	// Philox4x32-10 block function (Salmon et al., "Parallel Random Numbers:
+	// As Easy as 1, 2, 3"). Pure 32-bit integer arithmetic, so results are
+	// identical on every compiler and platform.
+	namespace philox {
+		inline constexpr std::uint32_t kMul0 = 0xD2511F53u;
+		inline constexpr std::uint32_t kMul1 = 0xCD9E8D57u;
+		inline constexpr std::uint32_t kWeyl0 = 0x9E3779B9u;
+		inline constexpr std::uint32_t kWeyl1 = 0xBB67AE85u;
+		inline constexpr int kRounds = 10;
+	}
+
+	constexpr std::array<std::uint32_t, 4> philox4x32_10(std::array<std::uint32_t, 4> ctr,
+		std::array<std::uint32_t, 2> key) {
+		for (int round = 0; round < philox::kRounds; ++round) {
+			const std::uint64_t p0 = static_cast<std::uint64_t>(philox::kMul0) * ctr[0];
+			const std::uint64_t p1 = static_cast<std::uint64_t>(philox::kMul1) * ctr[2];
+			ctr = { static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<std::uint32_t>(p1),
+				static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<std::uint32_t>(p0) };
+			key[0] += philox::kWeyl0;
+			key[1] += philox::kWeyl1;
+		}
+		return ctr;
+	}
+
+	// Philox blocks at arbitrary counters under one seed: out[4 * i, 4 * i + 4)
+	// receives block blocks[i] of stream streams[i], i.e. the outputs
+	// 4 * blocks[i] .. 4 * blocks[i] + 3 of Rng(seed, streams[i]). Uses the
+	// same vectorizable kernel as Rng::fill(); for batches that draw from
+	// many streams at once.
+	void philox_blocks(std::uint64_t seed, std::span<const std::uint64_t> streams, std::span<const std::uint64_t> blocks,
+		std::uint32_t* out);
+
+	// Counter-based deterministic RNG.
+	//
+	// The 64-bit seed is the Philox key; the 128-bit counter is (stream id,
+	// block index). Streams therefore never overlap, splitting costs nothing
+	// and no state is shared between streams, sessions or worker threads.
+	// An Rng is just (seed, stream, position): copy it to fork, compare
+	// position() to check lockstep.
+	class Rng {
+	public:
+		explicit Rng(std::uint64_t seed = 0, std::uint64_t stream = 0);
+
+		// Independent child stream. Depends only on this stream's identity and
+		// `id`, never on how many numbers have been drawn from it.
+		Rng split(std::uint64_t id) const;
+		Rng split(RngStream id) const { return split(static_cast<std::uint64_t>(id)); }
+
+		std::uint64_t seed() const { return seed_; }
+		std::uint64_t stream() const { return stream_; }
+
+		// Number of 32-bit outputs consumed so far; seek() restores it.
+		std::uint64_t position() const { return block_ * 4 - (4 - index_); }
+		void seek(std::uint64_t position);
+
+		std::uint32_t next_u32() {
+			if (index_ == 4) refill();
+			return buffer_[index_++];
+		}
+
+		std::uint64_t next_u64() {
+			const std::uint64_t lo = next_u32();
+			return lo | (static_cast<std::uint64_t>(next_u32()) << 32);
+		}
+
+		// Uniform in [0, 1) with 53 random bits; exact on IEEE-754 doubles.
+		double next_double() {
+			return static_cast<double>(next_u64() >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+		// Unbiased uniform integer in [0, bound) (Lemire's multiply-shift with
+		// rejection). bound == 0 returns 0.
+		std::uint32_t uniform(std::uint32_t bound);
+
+		// Uniform integer in [lo, hi] (inclusive). Requires lo <= hi.
+		std::int32_t range(std::int32_t lo, std::int32_t hi);
+
+		// Sum of `count` dice with `sides` faces each ("3d6" = roll(3, 6)).
+		std::int32_t roll(std::int32_t count, std::int32_t sides);
+
+		// True with probability numerator / denominator.
+		bool chance(std::uint32_t numerator, std::uint32_t denominator) {
+			return uniform(denominator) < numerator;
+		}
+
+		// Batch API. fill() continues the same sequence next_u32() would
+		// produce, but generates whole blocks with a vectorizable kernel.
+		void fill(std::span<std::uint32_t> out);
+		void fill_uniform(std::span<std::uint32_t> out, std::uint32_t bound);
+		void fill_rolls(std::span<std::int32_t> out, std::int32_t count, std::int32_t sides);
+
+	private:
+		void refill();
+
+	private:
+		std::uint64_t seed_;
+		std::uint64_t stream_;
+		std::uint64_t block_ = 0; // next block to generate
+		std::array<std::uint32_t, 4> buffer_{};
+		std::uint32_t index_ = 4; // 4 = buffer exhausted
+	};
+
+} // namespace tale_engine::runtime
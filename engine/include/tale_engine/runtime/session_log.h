@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tale_engine/dsl/ast.h"
+#include "tale_engine/runtime/state.h"
+
+namespace tale_engine::runtime {
+
+	class Interpreter;
+
+	// Everything needed to reproduce a session: where it started, the RNG seed
+	// and every choice index passed to Interpreter::apply_choice, plus
+	// (optionally) the State hash observed after each choice.
+	struct SessionLog {
+		std::string start_scene;
+		std::uint64_t seed = 0;
+		// Hash of the compiled content the session ran against (0 = unknown).
+		std::uint64_t content_hash = 0;
+
+		bool has_hashes = false;
+		std::vector<std::uint32_t> choices;
+		std::vector<std::uint64_t> hashes; // parallel to choices if has_hashes
+	};
+
+	// Compact binary encoding: varint choice indices, optional 8-byte hashes.
+	std::string encode_session(const SessionLog& log);
+	bool decode_session(std::string_view bytes, SessionLog& out);
+
+	// Stable hash of a content AST, stored in logs to catch replays against
+	// different content.
+	std::uint64_t content_hash(const dsl::FileAst& ast);
+
+	// Receives choices from Interpreter::apply_choice (see set_recorder).
+	class SessionRecorder {
+	public:
+		SessionRecorder(std::string start_scene, std::uint64_t seed, bool record_hashes = true);
+
+		void set_content_hash(std::uint64_t h) { log_.content_hash = h; }
+		void on_choice(std::uint32_t choice_index, const State& state_after);
+
+		const SessionLog& log() const { return log_; }
+
+	private:
+		SessionLog log_;
+	};
+
+	struct ReplayResult {
+		static constexpr std::size_t kNoDivergence = static_cast<std::size_t>(-1);
+
+		bool ok = false;
+		// Choices applied before stopping.
+		std::size_t steps = 0;
+		// First step whose State hash differed from the log, or kNoDivergence.
+		std::size_t diverged_at = kNoDivergence;
+		std::uint64_t expected_hash = 0;
+		std::uint64_t actual_hash = 0;
+		std::string message;
+	};
+
+	// Re-executes a log headlessly (no text is collected). Follows top-level
+	// gotos exactly like an interactive driver, applies each logged choice and
+	// stops at the first hash mismatch or invalid choice.
+	// If `scene_trace` is set, the id of every scene stepped (goto transfers
+	// included) is appended to it, e.g. to collect visit profiles.
+	ReplayResult replay(Interpreter& interpreter, State& state, const SessionLog& log,
+		std::vector<std::string>* scene_trace = nullptr);
+
+} // namespace tale_engine::runtime
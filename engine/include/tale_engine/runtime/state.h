@@ -1,28 +1,148 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
+#include "tale_engine/runtime/inventory.h"
+#include "tale_engine/runtime/stats.h"
 #include "tale_engine/runtime/value.h"
 
 namespace tale_engine::runtime {
 
+	// Dense index of a flag, item or stat inside one State. Slots are created
+	// on first use (by name or by flag_slot()/item_slot()/stat_slot()) and
+	// never removed, so an id stays valid for the lifetime of the State it
+	// came from (stat slots until the next set_stat_schema()).
+	using SlotId = std::uint32_t;
+
+	enum class SlotKind : std::uint8_t { Flag, Item, Stat };
+
+	struct StateChange {
+		SlotKind kind;
+		SlotId slot;
+	};
+
 	class State {
 	public:
-		void set_flag(std::string name, Value v);
+		// Slots, name indexes and the journal allocate from `resource`, which
+		// must outlive the state.
+		explicit State(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+		// Copies and moves start a new journal epoch (see journal_epoch()), so
+		// caches bound to the source never mistake the copy for the original.
+		// A copy uses the source's resource; assignment keeps the target's.
+		State(const State& other);
+		State(State&& other) noexcept;
+		State& operator=(const State& other);
+		State& operator=(State&& other); // copies when the resources differ
+
+		// The value is copied into the state's resource; its position is
+		// not kept.
+		void set_flag(std::string name, const Value& v);
 		bool has_flag(const std::string& name) const;
-		const Value* get_flag(const std::string& name) const;
+		const FlagValue* get_flag(const std::string& name) const;
 
 		void give_item(std::string item_id, int qty);
 		bool take_item(const std::string& item_id, int qty); // returns false if insufficient
 		int get_item_qty(const std::string& item_id) const;
 
-		void set_current_scene(std::string id);
+		// Item definitions (weights, tags, equipment slots); items the
+		// catalog lacks stack and weigh nothing. Setting a catalog drops
+		// every item and starts a new journal epoch; `catalog` must outlive
+		// the state, null removes it.
+		void set_item_catalog(const ItemCatalog* catalog);
+		bool equip(InstanceId instance);
+		InstanceId unequip(EquipSlot slot);
+		const Inventory& inventory() const { return inventory_; }
+
+		// Stats (see Stats for the stacking rules). Stats without a schema
+		// definition are plain base stats starting at 0. Setting a schema
+		// drops every stat and modifier and starts a new journal epoch;
+		// `schema` (finalized) must outlive the state, null removes it.
+		void set_stat_schema(const StatSchema* schema);
+		int get_stat(std::string_view name) const; // 0 for unknown stats
+		void set_stat_base(SlotId slot, int base);
+		ModifierId add_stat_modifier(const Modifier& modifier);
+		bool remove_stat_modifier(ModifierId id);
+		const Stats& stats() const { return stats_; }
+
+		// World time in ticks; the interpreter advances it by one per
+		// applied choice. Timed stat modifiers expire as it passes.
+		void advance_time(std::uint64_t ticks);
+		std::uint64_t time() const { return stats_.now(); }
+
+		void set_current_scene(std::string_view id);
 		const std::string& current_scene() const;
 
+		// Slot access for compiled code (conditions) that resolves names once.
+		SlotId flag_slot(std::string_view name);
+		SlotId item_slot(std::string_view name);
+		SlotId stat_slot(std::string_view name);
+		const FlagValue* flag_at(SlotId slot) const; // nullptr while unset
+		int item_qty_at(SlotId slot) const;
+		int stat_at(SlotId slot) const { return stats_.value(slot); }
+
+		// Change journal: every flag/item mutation appends the touched slot,
+		// every stat mutation the stats whose value changed.
+		// Consumers remember (epoch, journal_size()) and later read
+		// changes_since() to find out exactly what changed. The journal is
+		// cleared when it grows past a bound, which starts a new epoch;
+		// a consumer that sees a different epoch must resynchronize fully.
+		std::uint64_t journal_epoch() const { return epoch_; }
+		std::size_t journal_size() const { return journal_.size(); }
+		std::span<const StateChange> changes_since(std::size_t offset) const {
+			return std::span<const StateChange>(journal_).subspan(offset);
+		}
+
+		// Hash of the observable state (flags, non-zero item quantities,
+		// equipment, stats, current scene). Independent of insertion order, slot numbering and platform.
+		// hash() is maintained incrementally by every mutation and is O(1);
+		// compute_hash() recomputes the same value from scratch.
+		std::uint64_t hash() const;
+		std::uint64_t compute_hash() const;
+
+		std::pmr::memory_resource* resource() const { return flags_.get_allocator().resource(); }
+
 	private:
-		std::unordered_map<std::string, Value> flags_;
-		std::unordered_map<std::string, int> inventory_;
+		struct NameHash {
+			using is_transparent = void;
+			std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+		};
+		struct NameEqual {
+			using is_transparent = void;
+			bool operator()(std::string_view a, std::string_view b) const { return a == b; }
+		};
+		using NameIndex = std::pmr::unordered_map<std::pmr::string, SlotId, NameHash, NameEqual>;
+
+		struct FlagSlot {
+			std::pmr::string name;
+			FlagValue value;
+			bool set = false;
+		};
+
+		SlotId intern_flag(std::string_view name);
+		void copy_slots(const State& other); // into this state's resource
+		void record(SlotKind kind, SlotId slot);
+		void record_stats();
+		void restart_journal();
+
+	private:
+		std::pmr::vector<FlagSlot> flags_;
+		NameIndex flag_index_;
+		Inventory inventory_;
+		Stats stats_;
+
 		std::string current_scene_;
+		std::uint64_t hash_;
+
+		std::pmr::vector<StateChange> journal_;
+		std::uint64_t epoch_;
 	};
 
 } // namespace tale_engine::runtime
@@ -0,0 +1,204 @@
+#pragma once
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tale_engine::runtime {
+
+	// Dense index of a stat inside one Stats (and its State). Schema stats
+	// keep their schema ids; stats used without a definition are appended
+	// on first use.
+	using StatId = std::uint32_t;
+	inline constexpr StatId kNoStat = static_cast<StatId>(-1);
+
+	using ModifierId = std::uint32_t;
+	inline constexpr ModifierId kNoModifier = 0;
+
+	// Derived stat input: adds value(source) * percent / 100.
+	struct StatTerm {
+		StatId source;
+		int percent = 100;
+	};
+
+	struct StatDef {
+		std::string name;
+		int base = 0;
+		int min = INT_MIN;
+		int max = INT_MAX;
+		std::uint32_t first_term = 0; // terms_[first_term, first_term + term_count)
+		std::uint32_t term_count = 0; // 0 for base stats
+	};
+
+	// Stat definitions shared by every State of a game: base stats, and
+	// derived stats computed from stats defined before them (so definitions
+	// never form a cycle, and ids are already in dependency order).
+	class StatSchema {
+	public:
+		// Return the new id, or kNoStat if the name is taken or a term
+		// refers to a stat not defined yet.
+		StatId add_base(std::string_view name, int base = 0, int min = INT_MIN, int max = INT_MAX);
+		StatId add_derived(std::string_view name, std::span<const StatTerm> terms, int base = 0, int min = INT_MIN, int max = INT_MAX);
+
+		// Must be called once after the last add(); builds the dependency index.
+		void finalize();
+
+		StatId find(std::string_view name) const;
+		std::size_t size() const { return defs_.size(); }
+		const StatDef& def(StatId id) const { return defs_[id]; }
+		std::span<const StatTerm> terms(StatId id) const {
+			return std::span<const StatTerm>(terms_).subspan(defs_[id].first_term, defs_[id].term_count);
+		}
+		// Derived stats reading `id` directly.
+		std::span<const StatId> dependents(StatId id) const {
+			return std::span<const StatId>(dependents_).subspan(deps_offsets_[id], deps_offsets_[id + 1] - deps_offsets_[id]);
+		}
+
+	private:
+		std::vector<StatDef> defs_;
+		std::vector<StatTerm> terms_;
+		std::unordered_map<std::string, StatId> index_;
+		std::vector<std::uint32_t> deps_offsets_; // stat i -> dependents_[off[i], off[i+1])
+		std::vector<StatId> dependents_;
+	};
+
+	enum class ModifierKind : std::uint8_t {
+		Add,      // amount is added
+		Multiply, // amount is a percentage: +50 scales by 1.5, -25 by 0.75
+		Cap       // value is at most amount
+	};
+
+	struct Modifier {
+		StatId stat = kNoStat;
+		ModifierKind kind = ModifierKind::Add;
+		int amount = 0;
+		std::uint32_t duration = 0; // ticks until it expires; 0 = until removed
+	};
+
+	// Stat values and active modifiers of one State, stored column-wise.
+	//
+	// Stacking rules, applied in this order to get a stat's value:
+	//   1. raw: the base value, plus for derived stats the sum of
+	//      value(source) * percent over its terms, divided by 100;
+	//   2. plus the sum of all Add modifiers;
+	//   3. times (100 + sum of all Multiply percentages) / 100, never below 0
+	//      (percentages add up: +20% and +30% make +50%);
+	//   4. at most the lowest Cap;
+	//   5. clamped to the stat's [min, max].
+	// Divisions truncate toward zero. Every step uses 64-bit arithmetic.
+	//
+	// Values are cached. A mutation marks its stat dirty and recomputes
+	// dirty stats in id order; a derived stat is marked only when one of
+	// its sources actually changed value, so only dependent stats are
+	// touched. Add and Multiply sums are kept per stat, so adding or
+	// removing a modifier is O(1) plus the recomputation; removing a Cap
+	// scans only the Caps of its own stat.
+	class Stats {
+	public:
+		explicit Stats(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+		Stats(Stats&& other) noexcept = default;
+		Stats& operator=(Stats&& other) = default;
+
+		// Copies `other` into this object's resource.
+		void assign(const Stats& other);
+
+		// Drops all stats and modifiers; schema stats (if any) come back at
+		// their base values. `schema` must be finalized and outlive this.
+		void reset(const StatSchema* schema);
+		const StatSchema* schema() const { return schema_; }
+
+		StatId find(std::string_view name) const;
+		StatId intern(std::string_view name);
+		std::size_t size() const { return value_.size(); }
+		std::string_view name(StatId id) const { return names_[id]; }
+
+		int value(StatId id) const { return value_[id]; }
+		int base(StatId id) const { return base_[id]; }
+
+		void set_base(StatId id, int base);
+
+		// Returns kNoModifier if `m.stat` is out of range.
+		ModifierId add_modifier(const Modifier& m);
+		bool remove_modifier(ModifierId id);
+		std::size_t modifier_count() const { return mod_id_.size(); }
+
+		// Moves the clock forward and removes modifiers that expire.
+		void advance(std::uint64_t ticks);
+		std::uint64_t now() const { return now_; }
+
+		// Stats whose value changed during the last mutating call.
+		std::span<const StatId> changed() const { return changed_; }
+
+		// Hash of base values that differ from their defaults, active
+		// modifiers and (while a timed modifier is active) the clock; 0 for
+		// untouched stats. hash() is O(1); compute_hash() starts over.
+		std::uint64_t hash() const;
+		std::uint64_t compute_hash() const;
+
+		std::pmr::memory_resource* resource() const { return value_.get_allocator().resource(); }
+
+	private:
+		struct NameHash {
+			using is_transparent = void;
+			std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+		};
+		struct NameEqual {
+			using is_transparent = void;
+			bool operator()(std::string_view a, std::string_view b) const { return a == b; }
+		};
+
+		struct Expiry {
+			std::uint64_t at;
+			ModifierId id;
+		};
+
+		StatId append(std::string_view name, int base, int min, int max);
+		int default_base(StatId id) const;
+		std::uint64_t base_hash(StatId id) const;
+		std::uint64_t modifier_hash(std::size_t index) const;
+		void remove_at(std::size_t index);
+		void mark(StatId id);
+		void flush();
+		int compute(StatId id) const;
+
+	private:
+		const StatSchema* schema_ = nullptr;
+
+		// Per stat.
+		std::pmr::vector<std::pmr::string> names_;
+		std::pmr::unordered_map<std::pmr::string, StatId, NameHash, NameEqual> index_;
+		std::pmr::vector<int> value_;
+		std::pmr::vector<int> base_;
+		std::pmr::vector<int> min_;
+		std::pmr::vector<int> max_;
+		std::pmr::vector<std::int64_t> add_sum_;
+		std::pmr::vector<std::int64_t> mul_sum_;
+		std::pmr::vector<int> cap_;               // lowest of caps_ while it is not empty
+		std::pmr::vector<std::pmr::vector<int>> caps_; // amounts of the active Caps
+		std::pmr::vector<std::uint8_t> dirty_;
+
+		// Per active modifier; removal swaps the last one in.
+		std::pmr::vector<ModifierId> mod_id_;
+		std::pmr::vector<StatId> mod_stat_;
+		std::pmr::vector<ModifierKind> mod_kind_;
+		std::pmr::vector<int> mod_amount_;
+		std::pmr::vector<std::uint64_t> mod_expires_; // 0 = never
+		std::pmr::unordered_map<ModifierId, std::uint32_t> mod_index_;
+		ModifierId next_modifier_ = 1;
+
+		std::pmr::vector<Expiry> expiries_; // min-heap; entries of removed modifiers are skipped
+		std::uint64_t now_ = 0;
+		std::size_t timed_ = 0; // active modifiers with an expiry
+
+		std::pmr::vector<StatId> pending_; // min-heap of dirty stats
+		std::pmr::vector<StatId> changed_;
+		std::uint64_t hash_ = 0;
+	};
+
+} // namespace tale_engine::runtime
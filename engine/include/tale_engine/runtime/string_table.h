@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace tale_engine::runtime {
+
+	// Localized text of a story, one locale per table (see
+	// compile/localization.h for extraction and encoding, tools/strings for
+	// the command line).
+	//
+	// Every text line and choice label has a key derived from where it sits:
+	//   <scene>.t<n>   n-th text line of the scene, counting across blocks
+	//   <scene>.c<n>   label of the n-th choice statement of the scene
+	// Keys only change when content moves within its own scene, and survive
+	// compile::optimize (merged text blocks keep their line numbering).
+
+	inline constexpr std::string_view kStringTableMagic{ "TALES\0\0\1", 8 };
+	inline constexpr std::uint32_t kStringTableVersion = 1;
+
+	std::string text_key(std::string_view scene, std::uint32_t line);
+	std::string label_key(std::string_view scene, std::uint32_t choice);
+
+	// fnv1a64 of the key, computed without building it.
+	std::uint64_t text_key_hash(std::string_view scene, std::uint32_t line);
+	std::uint64_t label_key_hash(std::string_view scene, std::uint32_t choice);
+
+	// A string table file, read in place.
+	//
+	// Layout (little-endian):
+	//   magic[8] version:u32 count:u32 locale_size:u32 locale[locale_size]
+	//   zero padding to a multiple of 8
+	//   count x { key_hash:u64 offset:u32 size:u32 }, sorted by key_hash
+	//   string bytes; offsets are relative to their start
+	// Lookups binary-search the index where it lies, so opening a table costs
+	// one validation pass and the only memory is the mapping itself. Files
+	// are memory-mapped where the platform allows and read whole otherwise.
+	class StringTable {
+	public:
+		StringTable() = default;
+		~StringTable();
+
+		StringTable(const StringTable&) = delete;
+		StringTable& operator=(const StringTable&) = delete;
+
+		// Returns false if the file cannot be read or is not a valid table;
+		// the table is then empty. Replaces any table previously opened.
+		bool open(const std::string& path);
+		// Uses `bytes` in place; they must outlive the table.
+		bool view(std::string_view bytes);
+		void close();
+
+		bool is_open() const { return !bytes_.empty(); }
+		std::string_view locale() const { return locale_; }
+		std::size_t size() const { return count_; }
+
+		std::optional<std::string_view> find(std::uint64_t key_hash) const;
+
+	private:
+		bool load(std::string_view bytes);
+		void unmap();
+
+	private:
+		std::string_view bytes_;
+		std::string_view locale_;
+		std::size_t index_offset_ = 0;
+		std::size_t strings_offset_ = 0;
+		std::uint32_t count_ = 0;
+
+		void* mapping_ = nullptr; // owned mapping of bytes_, if any
+		std::size_t mapping_size_ = 0;
+		std::string buffer_;      // owned copy when mapping is unavailable
+	};
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tale_engine/dsl/text_template.h"
+#include "tale_engine/runtime/state.h"
+
+namespace tale_engine::runtime {
+
+	using TextLineId = std::uint32_t;
+
+	// Text lines of a story compiled at load time (see dsl/text_template.h).
+	//
+	// Each line becomes a run of segments: literal spans viewing the source
+	// line, and flag/item references resolved to State slots. Rendering walks
+	// the segments and appends to a caller-owned buffer; it never parses or
+	// builds temporary strings. Plain lines keep no segments at all.
+	class TextTemplates {
+	public:
+		// `line` must outlive this object (it is normally AST storage, or a
+		// StringTable). Malformed templates render verbatim.
+		TextLineId add(std::string_view line);
+
+		std::size_t size() const { return lines_.size(); }
+		std::string_view source(TextLineId id) const { return lines_[id].source; }
+
+		// No braces: the source line is the rendered text.
+		bool is_plain(TextLineId id) const { return lines_[id].plain; }
+		// Output depends on State (has {flag} or {#item} placeholders).
+		bool is_dynamic(TextLineId id) const { return lines_[id].dynamic; }
+
+		// Appends the rendered line to `out`.
+		void render(State& state, TextLineId id, std::pmr::string& out);
+
+	private:
+		struct Segment {
+			dsl::TemplatePartKind kind;
+			std::uint32_t input = 0;    // Flag / Item
+			std::string_view text{};    // Literal
+		};
+
+		struct Line {
+			std::string_view source;
+			std::uint32_t first = 0; // segments_[first, first + count)
+			std::uint32_t count = 0;
+			bool plain = true;
+			bool dynamic = false;
+		};
+
+		struct Input {
+			SlotKind kind;
+			std::string_view name;
+		};
+
+		std::uint32_t input(SlotKind kind, std::string_view name);
+		void bind(State& state);
+
+	private:
+		std::vector<Line> lines_;
+		std::vector<Segment> segments_;
+
+		std::vector<Input> inputs_;
+		std::unordered_map<std::string_view, std::uint32_t> input_index_[2]; // per SlotKind
+
+		// Input -> State slot for the State with journal epoch bound_epoch_.
+		std::vector<SlotId> slots_;
+		std::uint64_t bound_epoch_ = 0;
+	};
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,188 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tale_engine::runtime {
+
+	class State;
+	class TriggerSystem;
+
+	// Events active effects can react to.
+	enum class TriggerEvent : std::uint8_t { Hit, Crit, TurnStart, TurnEnd, Kill, ChoiceSelected };
+	inline constexpr std::size_t kTriggerEventCount = 6;
+
+	// What an event happens to (the player, a combatant, ...). Ids are the
+	// host's and index a table per event, so keep them dense, like slot
+	// ids. Effects subscribed for kAnyEntity hear the event for every
+	// entity.
+	using EntityId = std::uint32_t;
+	inline constexpr EntityId kPlayerEntity = 0;
+	inline constexpr EntityId kAnyEntity = static_cast<EntityId>(-1);
+
+	using TriggerKindId = std::uint32_t;
+	inline constexpr TriggerKindId kNoTriggerKind = static_cast<TriggerKindId>(-1);
+
+	// How applying a kind again to the same entity and event combines with
+	// the effect already there.
+	enum class StackRule : std::uint8_t {
+		Independent, // a separate effect every time
+		Stack,       // one effect: stacks add up to max_stacks; magnitude and charges are the new ones
+		Refresh,     // one effect: charges are the new ones, the stronger magnitude stays
+		Replace      // one effect: magnitude, charges and source are the new ones
+	};
+
+	// Names one active effect. Stays invalid once the effect is gone, even
+	// after its slot is reused.
+	struct TriggerHandle {
+		std::uint32_t index = static_cast<std::uint32_t>(-1);
+		std::uint32_t generation = 0;
+
+		bool operator==(const TriggerHandle&) const = default;
+	};
+
+	struct ActiveTrigger {
+		TriggerKindId kind = kNoTriggerKind;
+		EntityId source = kAnyEntity;
+		int magnitude = 0;
+		std::uint16_t stacks = 1;
+		std::uint16_t charges = 0; // firings left; 0 = until removed
+	};
+
+	// Event details, shared by every handler one fire() runs; handlers may
+	// adjust `amount` (e.g. damage) for the ones after them.
+	struct TriggerArgs {
+		State* state = nullptr;
+		EntityId other = kAnyEntity; // the other party: attacker, killer, ...
+		int amount = 0;              // Hit, Crit: damage; ChoiceSelected: choice index
+	};
+
+	struct TriggerCall {
+		TriggerSystem& triggers;
+		TriggerEvent event;
+		EntityId entity;       // the entity the event happened to
+		TriggerHandle handle;
+		ActiveTrigger effect;  // after this firing's charge was spent
+		TriggerArgs& args;
+		void* user;            // as given in TriggerKind
+	};
+
+	using TriggerHandler = void (*)(TriggerCall& call);
+
+	struct TriggerKind {
+		std::string name;
+		TriggerHandler handler = nullptr;
+		void* user = nullptr;
+		StackRule stacking = StackRule::Independent;
+		std::uint16_t max_stacks = 1;
+		std::uint32_t dispel_tags = 0; // categories dispel() can target; 0 = cannot be dispelled
+	};
+
+	// Active effects that react to events.
+	//
+	// Effects are stored in buckets, one per (event, entity), each a
+	// contiguous array found through a per-event table indexed by entity.
+	// Firing an event looks up two buckets (the entity's and kAnyEntity's)
+	// and walks only them, however many effects are live elsewhere.
+	// Handles map to (bucket, position) through a generation-checked table,
+	// so removal is O(1): the bucket's last effect moves into the hole.
+	// Stacking merges into the existing effect in place, found in O(1)
+	// through the bucket's table of effects by stacking kind, and dispelling
+	// removes stacks or effects the same way, so neither allocates; memory
+	// only grows to the peak number of live effects and buckets.
+	//
+	// Handlers may apply and remove effects, and fire further events, while
+	// an event is being fired. Effects removed meanwhile are skipped and
+	// compacted away when the outermost fire() returns (their handle indexes
+	// are only reused after that); effects applied meanwhile first react to
+	// the next event.
+	class TriggerSystem {
+	public:
+		TriggerSystem();
+
+		// Returns the new id, or kNoTriggerKind if the name is taken or the
+		// handler is null.
+		TriggerKindId add_kind(TriggerKind kind);
+		TriggerKindId find_kind(std::string_view name) const;
+		const TriggerKind& kind(TriggerKindId id) const { return kinds_[id]; }
+
+		// Applies an effect of `kind` that reacts to `event` happening to
+		// `entity`, merging it by the kind's stacking rule. Returns the handle
+		// of the new or merged effect; an invalid handle for an unknown kind.
+		TriggerHandle apply(TriggerKindId kind, TriggerEvent event, EntityId entity, int magnitude = 0,
+			std::uint16_t charges = 0, EntityId source = kAnyEntity);
+
+		// False if the effect is already gone.
+		bool remove(TriggerHandle handle);
+		bool contains(TriggerHandle handle) const;
+		// Null if the effect is gone; valid until the next change.
+		const ActiveTrigger* get(TriggerHandle handle) const;
+
+		// Removes up to `max_stacks` stacks from the effects on `entity`
+		// whose kind shares a dispel tag with `tags` (event by event, each
+		// bucket from the back); an effect loses its stacks before it goes.
+		// Returns the stacks removed.
+		std::size_t dispel(EntityId entity, std::uint32_t tags, std::size_t max_stacks = SIZE_MAX);
+		// Removes every effect subscribed for `entity` (e.g. when it dies);
+		// returns how many.
+		std::size_t clear_entity(EntityId entity);
+
+		// Runs the handlers of the effects subscribed to `event` for
+		// `entity`, then of those subscribed for kAnyEntity. Each firing
+		// spends a charge; an effect whose last charge is spent is removed
+		// after its handler ran. Effects the handlers apply first run on the
+		// next fire(). Returns the number of handlers run.
+		std::size_t fire(TriggerEvent event, EntityId entity, TriggerArgs& args);
+
+		// Live effects.
+		std::size_t size() const { return live_; }
+
+	private:
+		static constexpr std::uint32_t kNoBucket = static_cast<std::uint32_t>(-1);
+		static constexpr std::uint32_t kNoIndex = static_cast<std::uint32_t>(-1);
+
+		struct Slot {
+			ActiveTrigger effect; // kind == kNoTriggerKind: removed during a fire
+			std::uint32_t handle;
+		};
+
+		struct Bucket {
+			std::vector<Slot> slots;
+			std::vector<std::uint32_t> merge; // [stacking kind]: handle of its effect here; kNoIndex if none
+			bool dirty = false; // holds removed slots awaiting compaction
+		};
+
+		std::uint32_t find_bucket(TriggerEvent event, EntityId entity) const;
+		std::uint32_t make_bucket(TriggerEvent event, EntityId entity);
+		// Runs the live effects at positions [0, end) of `bucket`.
+		std::size_t fire_bucket(std::uint32_t bucket, std::size_t end, TriggerEvent event, EntityId entity, TriggerArgs& args);
+		void remove_at(std::uint32_t bucket, std::uint32_t pos);
+		void compact();
+
+	private:
+		std::vector<TriggerKind> kinds_;
+		std::unordered_map<std::string, TriggerKindId> kind_index_;
+		std::vector<std::uint32_t> stacking_index_; // per kind: its column in Bucket::merge; kNoIndex if Independent
+		std::uint32_t stacking_kinds_ = 0;
+
+		std::vector<Bucket> buckets_;
+		std::array<std::vector<std::uint32_t>, kTriggerEventCount> entity_buckets_; // [event][entity]; kNoBucket if none
+		std::array<std::uint32_t, kTriggerEventCount> any_buckets_; // kAnyEntity's, by event
+		std::vector<std::uint32_t> dirty_;
+
+		// Per handle index; freed indexes are reused with the next generation.
+		std::vector<std::uint32_t> handle_bucket_;
+		std::vector<std::uint32_t> handle_pos_;
+		std::vector<std::uint32_t> handle_generation_;
+		std::vector<std::uint32_t> free_handles_;
+		std::vector<std::uint32_t> released_handles_; // removed during a fire; freed by compact()
+
+		std::size_t live_ = 0;
+		std::uint32_t firing_ = 0; // nesting depth of fire()
+	};
+
+} // namespace tale_engine::runtime
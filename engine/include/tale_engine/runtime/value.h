@@ -1,5 +1,7 @@
 #pragma once
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <variant>
 
 #include "tale_engine/diagnostics.h"
@@ -11,6 +13,20 @@ namespace tale_engine::runtime {
 		std::variant<std::string, int, bool> data;
 	};
 
+	// A flag's value as a State holds it: Value::data without the source
+	// position, the string on the State's memory resource.
+	struct FlagValue {
+		std::variant<std::pmr::string, int, bool> data;
+	};
+
+	// Same type and same value.
+	inline bool equals(const FlagValue& flag, const std::variant<std::string, int, bool>& value) {
+		if (flag.data.index() != value.index()) return false;
+		if (const auto* s = std::get_if<std::pmr::string>(&flag.data)) return std::string_view(*s) == std::get<std::string>(value);
+		if (const auto* n = std::get_if<int>(&flag.data)) return *n == std::get<int>(value);
+		return std::get<bool>(flag.data) == std::get<bool>(value);
+	}
+
 	inline std::string type_name(const Value& v) {
 		if (std::holds_alternative<std::string>(v.data)) return "string";
 		if (std::holds_alternative<int>(v.data)) return "int";
@@ -0,0 +1,178 @@
+#include "tale_engine/analysis/reference_index.h"
+
+#include <algorithm>
+
+#include "tale_engine/dsl/text_template.h"
+#include "tale_engine/profile.h"
+
+namespace tale_engine::analysis {
+
+    std::uint32_t ReferenceIndex::intern_file(std::string_view file) {
+        auto it = file_ids_.find(file);
+        if (it != file_ids_.end()) return it->second;
+
+        const auto id = static_cast<std::uint32_t>(files_.size());
+        files_.emplace_back(file);
+        file_symbols_.emplace_back();
+        file_ids_.emplace(std::string(file), id);
+        return id;
+    }
+
+    void ReferenceIndex::add(SymbolKind kind, std::string_view name, std::uint32_t file, const SourcePos& pos, RefRole role) {
+        auto& names = by_name_[static_cast<std::size_t>(kind)];
+        auto it = names.find(name);
+        if (it == names.end()) {
+            const auto id = static_cast<SymbolId>(symbols_.size());
+            symbols_.push_back(Symbol{ kind, std::string(name), {} });
+            it = names.emplace(std::string(name), id).first;
+        }
+
+        auto& sym = symbols_[it->second];
+        // Record the symbol for the file once (sites of one file are contiguous).
+        if (sym.sites.empty() || sym.sites.back().file != file) {
+            file_symbols_[file].push_back(it->second);
+        }
+        sym.sites.push_back(ReferenceSite{ file, pos.line, pos.column, role });
+    }
+
+    void ReferenceIndex::remove_file(std::string_view file) {
+        auto it = file_ids_.find(file);
+        if (it == file_ids_.end()) return;
+        const std::uint32_t id = it->second;
+
+        for (const SymbolId s : file_symbols_[id]) {
+            auto& sites = symbols_[s].sites;
+            sites.erase(std::remove_if(sites.begin(), sites.end(),
+                [id](const ReferenceSite& r) { return r.file == id; }), sites.end());
+        }
+        file_symbols_[id].clear();
+    }
+
+    void ReferenceIndex::update_file(std::string_view file, const dsl::FileAst& ast) {
+        TALE_PROFILE_SCOPE("ReferenceIndex::update_file");
+        remove_file(file);
+        const std::uint32_t id = intern_file(file);
+
+        auto add_effect = [&](const dsl::EffectStmtAst& eff) {
+            if (const auto* s = std::get_if<dsl::EffectSetFlagAst>(&eff.call)) {
+                add(SymbolKind::Flag, s->name, id, s->pos, RefRole::SetFlag);
+            }
+            else if (const auto* g = std::get_if<dsl::EffectGiveItemAst>(&eff.call)) {
+                add(SymbolKind::Item, g->item_id, id, g->pos, RefRole::GiveItem);
+            }
+            else if (const auto* t = std::get_if<dsl::EffectTakeItemAst>(&eff.call)) {
+                add(SymbolKind::Item, t->item_id, id, t->pos, RefRole::TakeItem);
+            }
+            else if (const auto* n = std::get_if<dsl::EffectNativeAst>(&eff.call)) {
+                // start_combat leaves its outcome in a flag.
+                if (n->name == dsl::kBuiltinEffects[dsl::StartCombat].name) {
+                    add(SymbolKind::Flag, "combat_result", id, n->pos, RefRole::SetFlag);
+                }
+                for (std::size_t i = 0; i < n->args.size(); ++i) {
+                    const auto* name = std::get_if<std::string>(&n->args[i].value);
+                    if (!name || name->empty()) continue;
+                    if (n->arg_kinds[i] == dsl::EffectArg::Flag) add(SymbolKind::Flag, *name, id, n->args[i].pos, RefRole::EffectArg);
+                    else if (n->arg_kinds[i] == dsl::EffectArg::Item) add(SymbolKind::Item, *name, id, n->args[i].pos, RefRole::EffectArg);
+                    else if (n->arg_kinds[i] == dsl::EffectArg::Stat) add(SymbolKind::Stat, *name, id, n->args[i].pos, RefRole::EffectArg);
+                }
+            }
+        };
+
+        auto add_condition = [&](const dsl::ConditionAst& root) {
+            std::vector<const dsl::ConditionAst*> pending{ &root };
+            while (!pending.empty()) {
+                const auto* c = pending.back();
+                pending.pop_back();
+                switch (c->op) {
+                case dsl::ConditionOp::HasFlag:
+                case dsl::ConditionOp::FlagEquals:
+                    if (!c->name.empty()) add(SymbolKind::Flag, c->name, id, c->pos, RefRole::TestFlag);
+                    break;
+                case dsl::ConditionOp::HasItem:
+                    if (!c->name.empty()) add(SymbolKind::Item, c->name, id, c->pos, RefRole::TestItem);
+                    break;
+                case dsl::ConditionOp::StatAtLeast:
+                    if (!c->name.empty()) add(SymbolKind::Stat, c->name, id, c->pos, RefRole::TestStat);
+                    break;
+                default:
+                    for (auto it = c->operands.rbegin(); it != c->operands.rend(); ++it) pending.push_back(&*it);
+                    break;
+                }
+            }
+        };
+
+        for (const auto& scene : ast.scenes) {
+            add(SymbolKind::Scene, scene.id, id, scene.pos, RefRole::Definition);
+
+            for (const auto& stmt : scene.body) {
+                if (const auto* tb = std::get_if<dsl::TextBlockAst>(&stmt)) {
+                    for (const auto& line : tb->lines) {
+                        if (dsl::is_plain_text(line)) continue;
+                        for (const auto& part : dsl::parse_template(line).parts) {
+                            if (part.kind == dsl::TemplatePartKind::Flag) add(SymbolKind::Flag, part.text, id, tb->pos, RefRole::ReadFlag);
+                            else if (part.kind == dsl::TemplatePartKind::Item) add(SymbolKind::Item, part.text, id, tb->pos, RefRole::ReadItem);
+                        }
+                    }
+                }
+                else if (const auto* g = std::get_if<dsl::GotoStmtAst>(&stmt)) {
+                    add(SymbolKind::Scene, g->target_scene_id, id, g->pos, RefRole::Goto);
+                }
+                else if (const auto* eff = std::get_if<dsl::EffectStmtAst>(&stmt)) {
+                    add_effect(*eff);
+                }
+                else if (const auto* ch = std::get_if<dsl::ChoiceAst>(&stmt)) {
+                    if (ch->condition) add_condition(*ch->condition);
+                    for (const auto& cstmt : ch->body) {
+                        if (const auto* cg = std::get_if<dsl::GotoStmtAst>(&cstmt)) {
+                            add(SymbolKind::Scene, cg->target_scene_id, id, cg->pos, RefRole::Goto);
+                        }
+                        else {
+                            add_effect(std::get<dsl::EffectStmtAst>(cstmt));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::span<const ReferenceSite> ReferenceIndex::find(SymbolKind kind, std::string_view name) const {
+        const auto& names = by_name_[static_cast<std::size_t>(kind)];
+        auto it = names.find(name);
+        if (it == names.end()) return {};
+        return symbols_[it->second].sites;
+    }
+
+    bool ReferenceIndex::has_role(SymbolKind kind, std::string_view name, RefRole role) const {
+        const auto sites = find(kind, name);
+        return std::any_of(sites.begin(), sites.end(), [role](const ReferenceSite& r) { return r.role == role; });
+    }
+
+    SourcePos ReferenceIndex::to_pos(const ReferenceSite& site) const {
+        return SourcePos{ files_[site.file], site.line, site.column };
+    }
+
+    void lint_references(const ReferenceIndex& index, Diagnostics& diagnostics) {
+        index.for_each_symbol(SymbolKind::Item, [&](std::string_view name, std::span<const ReferenceSite> sites) {
+            const ReferenceSite* first_take = nullptr;
+            for (const auto& r : sites) {
+                if (r.role == RefRole::GiveItem || r.role == RefRole::EffectArg) return;
+                if (r.role == RefRole::TakeItem && !first_take) first_take = &r;
+            }
+            if (first_take) {
+                diagnostics.warning(index.to_pos(*first_take), "Item is taken but never given: " + std::string(name));
+            }
+        });
+
+        index.for_each_symbol(SymbolKind::Flag, [&](std::string_view name, std::span<const ReferenceSite> sites) {
+            const ReferenceSite* first_read = nullptr;
+            for (const auto& r : sites) {
+                if (r.role == RefRole::SetFlag || r.role == RefRole::EffectArg) return;
+                if ((r.role == RefRole::TestFlag || r.role == RefRole::ReadFlag) && !first_read) first_read = &r;
+            }
+            if (first_read) {
+                diagnostics.warning(index.to_pos(*first_read), "Flag is read but never set: " + std::string(name));
+            }
+        });
+    }
+
+} // namespace tale_engine::analysis
@@ -0,0 +1,183 @@
+#include "tale_engine/analysis/scene_graph.h"
+
+#include <algorithm>
+
+#include "tale_engine/hash.h"
+#include "tale_engine/profile.h"
+
+namespace tale_engine::analysis {
+
+    namespace {
+        template <typename Fn>
+        void for_each_goto(const dsl::SceneAst& scene, Fn&& fn) {
+            for (const auto& stmt : scene.body) {
+                if (const auto* g = std::get_if<dsl::GotoStmtAst>(&stmt)) {
+                    fn(*g);
+                }
+                else if (const auto* ch = std::get_if<dsl::ChoiceAst>(&stmt)) {
+                    for (const auto& cstmt : ch->body) {
+                        if (const auto* cg = std::get_if<dsl::GotoStmtAst>(&cstmt)) fn(*cg);
+                    }
+                }
+            }
+        }
+    }
+
+    SceneGraph::SceneGraph(const dsl::FileAst& ast) {
+        TALE_PROFILE_SCOPE("SceneGraph::build");
+        const std::size_t n = ast.scenes.size();
+        ids_.reserve(n);
+
+        std::size_t capacity = 16;
+        while (capacity < n * 2) capacity <<= 1;
+        slots_.resize(capacity);
+        slot_mask_ = capacity - 1;
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto& scene = ast.scenes[i];
+            ids_.push_back(scene.id);
+
+            const std::uint64_t h = fnv1a64(scene.id);
+            std::uint64_t at = h & slot_mask_;
+            while (slots_[at].scene != kNoScene) {
+                if (slots_[at].hash == h && ids_[slots_[at].scene] == scene.id) break;
+                at = (at + 1) & slot_mask_;
+            }
+            if (slots_[at].scene == kNoScene) slots_[at] = Slot{ h, static_cast<SceneIndex>(i) };
+            else duplicates_.push_back(static_cast<SceneIndex>(i));
+        }
+
+        // Scenes are visited in index order, so appending resolved targets
+        // directly yields the CSR arrays in a single pass.
+        offsets_.reserve(n + 1);
+        offsets_.push_back(0);
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto& scene = ast.scenes[i];
+            for_each_goto(scene, [&](const dsl::GotoStmtAst& g) {
+                const SceneIndex target = index_of(g.target_scene_id);
+                if (target != kNoScene) targets_.push_back(target);
+                else unresolved_.push_back(GotoRef{ static_cast<SceneIndex>(i), &g });
+            });
+            offsets_.push_back(static_cast<std::uint32_t>(targets_.size()));
+
+            for (const auto& stmt : scene.body) {
+                const auto* ch = std::get_if<dsl::ChoiceAst>(&stmt);
+                if (!ch) continue;
+                const bool has_goto = std::any_of(ch->body.begin(), ch->body.end(), [](const auto& s) {
+                    return std::holds_alternative<dsl::GotoStmtAst>(s);
+                });
+                if (!has_goto) choices_without_goto_.push_back(ChoiceRef{ static_cast<SceneIndex>(i), ch });
+            }
+        }
+    }
+
+    SceneIndex SceneGraph::index_of(std::string_view id) const {
+        return find_slot(id, fnv1a64(id));
+    }
+
+    SceneIndex SceneGraph::find_slot(std::string_view id, std::uint64_t hash) const {
+        for (std::uint64_t at = hash & slot_mask_;; at = (at + 1) & slot_mask_) {
+            const Slot& slot = slots_[at];
+            if (slot.scene == kNoScene) return kNoScene;
+            if (slot.hash == hash && ids_[slot.scene] == id) return slot.scene;
+        }
+    }
+
+    std::vector<bool> SceneGraph::reachable_from(SceneIndex start) const {
+        std::vector<bool> seen(scene_count(), false);
+        if (start >= scene_count()) return seen;
+
+        std::vector<SceneIndex> queue;
+        queue.reserve(scene_count());
+        queue.push_back(start);
+        seen[start] = true;
+
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            for (const SceneIndex next : successors(queue[head])) {
+                if (!seen[next]) {
+                    seen[next] = true;
+                    queue.push_back(next);
+                }
+            }
+        }
+        return seen;
+    }
+
+    std::vector<SceneIndex> SceneGraph::dead_ends() const {
+        std::vector<SceneIndex> out;
+        for (SceneIndex v = 0; v < scene_count(); ++v) {
+            if (offsets_[v] == offsets_[v + 1]) out.push_back(v);
+        }
+        return out;
+    }
+
+    SceneGraph::Components SceneGraph::strongly_connected_components() const {
+        constexpr std::uint32_t kUnvisited = UINT32_MAX;
+        const std::size_t n = scene_count();
+
+        Components result;
+        result.component_of.assign(n, kUnvisited);
+
+        std::vector<std::uint32_t> order(n, kUnvisited); // discovery index
+        std::vector<std::uint32_t> low(n, 0);
+        std::vector<SceneIndex> stack;   // Tarjan stack
+        std::vector<bool> on_stack(n, false);
+
+        // Explicit DFS frames: (vertex, next edge offset).
+        struct Frame {
+            SceneIndex v;
+            std::uint32_t edge;
+        };
+        std::vector<Frame> frames;
+
+        std::uint32_t counter = 0;
+        for (SceneIndex root = 0; root < n; ++root) {
+            if (order[root] != kUnvisited) continue;
+
+            frames.push_back(Frame{ root, offsets_[root] });
+            order[root] = low[root] = counter++;
+            stack.push_back(root);
+            on_stack[root] = true;
+
+            while (!frames.empty()) {
+                Frame& f = frames.back();
+                if (f.edge < offsets_[f.v + 1]) {
+                    const SceneIndex w = targets_[f.edge++];
+                    if (order[w] == kUnvisited) {
+                        order[w] = low[w] = counter++;
+                        stack.push_back(w);
+                        on_stack[w] = true;
+                        frames.push_back(Frame{ w, offsets_[w] });
+                    }
+                    else if (on_stack[w]) {
+                        low[f.v] = std::min(low[f.v], order[w]);
+                    }
+                    continue;
+                }
+
+                const SceneIndex v = f.v;
+                frames.pop_back();
+                if (!frames.empty()) {
+                    const SceneIndex parent = frames.back().v;
+                    low[parent] = std::min(low[parent], low[v]);
+                }
+
+                if (low[v] == order[v]) {
+                    const auto id = static_cast<std::uint32_t>(result.component_size.size());
+                    std::uint32_t size = 0;
+                    SceneIndex w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        on_stack[w] = false;
+                        result.component_of[w] = id;
+                        size++;
+                    } while (w != v);
+                    result.component_size.push_back(size);
+                }
+            }
+        }
+        return result;
+    }
+
+} // namespace tale_engine::analysis
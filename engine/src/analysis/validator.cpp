@@ -0,0 +1,101 @@
+#include "tale_engine/analysis/validator.h"
+
+#include <utility>
+#include <vector>
+
+#include "tale_engine/profile.h"
+
+namespace tale_engine::analysis {
+
+    ValidateChecks enabled_checks(const ValidateOptions& options, bool has_scenes, bool start_exists) {
+        ValidateChecks checks;
+        checks.scene_ids = has_scenes;
+        const bool graph = has_scenes && start_exists;
+        checks.unreachable = graph && options.warn_unreachable;
+        checks.choices_without_goto = graph && options.warn_choice_without_goto;
+        checks.dead_ends = graph && options.warn_dead_ends;
+        return checks;
+    }
+
+    Diagnostic no_scenes_error() {
+        return Diagnostic{ Severity::Error, SourcePos{ "<input>", 1, 1 }, "No scenes found. Expected at least one 'scene' block." };
+    }
+
+    Diagnostic missing_start_error(std::string_view start_scene) {
+        return Diagnostic{ Severity::Error, SourcePos{ "<input>", 1, 1 }, "Start scene does not exist: " + std::string(start_scene) };
+    }
+
+    Diagnostic duplicate_scene_error(const dsl::SceneAst& scene) {
+        return Diagnostic{ Severity::Error, scene.pos, "Duplicate scene id: " + scene.id };
+    }
+
+    Diagnostic unresolved_goto_error(const dsl::GotoStmtAst& stmt) {
+        return Diagnostic{ Severity::Error, stmt.pos, "Goto target scene does not exist: " + stmt.target_scene_id };
+    }
+
+    Diagnostic unreachable_scene_warning(const dsl::SceneAst& scene, std::string_view start_scene) {
+        return Diagnostic{ Severity::Warning, scene.pos,
+            "Scene is unreachable from start scene '" + std::string(start_scene) + "': " + scene.id };
+    }
+
+    Diagnostic choice_without_goto_warning(const dsl::ChoiceAst& choice, std::string_view scene) {
+        return Diagnostic{ Severity::Warning, choice.pos, "Choice has no goto; selecting it stays in scene: " + std::string(scene) };
+    }
+
+    Diagnostic dead_end_warning(const dsl::SceneAst& scene) {
+        return Diagnostic{ Severity::Warning, scene.pos, "Scene is a dead end (no outgoing goto): " + scene.id };
+    }
+
+    bool validate(const dsl::FileAst& ast,
+        const SceneGraph& graph,
+        Diagnostics& diagnostics,
+        const ValidateOptions& options) {
+        TALE_PROFILE_SCOPE("analysis::validate");
+
+        bool ok = true;
+        auto report = [&](Diagnostic d) {
+            if (d.severity == Severity::Error) ok = false;
+            diagnostics.add(std::move(d));
+        };
+
+        if (ast.scenes.empty()) {
+            report(no_scenes_error());
+            return ok;
+        }
+
+        SceneIndex start = 0;
+        if (!options.start_scene.empty()) start = graph.index_of(options.start_scene);
+        const ValidateChecks checks = enabled_checks(options, true, start != kNoScene);
+
+        // 1) Unique scene ids
+        for (const SceneIndex dup : graph.duplicate_scenes()) report(duplicate_scene_error(ast.scenes[dup]));
+
+        // 2) Goto targets exist
+        for (const auto& ref : graph.unresolved_gotos()) report(unresolved_goto_error(*ref.stmt));
+
+        // 3) Graph analysis
+        if (start == kNoScene) report(missing_start_error(options.start_scene));
+
+        if (checks.unreachable) {
+            const auto reachable = graph.reachable_from(start);
+            std::vector<bool> duplicate(graph.scene_count(), false);
+            for (const SceneIndex dup : graph.duplicate_scenes()) duplicate[dup] = true;
+            for (SceneIndex i = 0; i < graph.scene_count(); ++i) {
+                if (reports_unreachable(reachable[i], duplicate[i])) report(unreachable_scene_warning(ast.scenes[i], ast.scenes[start].id));
+            }
+        }
+
+        if (checks.choices_without_goto) {
+            for (const auto& ref : graph.choices_without_goto()) {
+                report(choice_without_goto_warning(*ref.choice, ast.scenes[ref.scene].id));
+            }
+        }
+
+        if (checks.dead_ends) {
+            for (const SceneIndex v : graph.dead_ends()) report(dead_end_warning(ast.scenes[v]));
+        }
+
+        return ok;
+    }
+
+} // namespace tale_engine::analysis
@@ -0,0 +1,566 @@
+#include "tale_engine/compile/ast_codec.h"
+
+#include <unordered_map>
+#include <utility>
+
+#include "tale_engine/binary_io.h"
+#include "tale_engine/lz.h"
+
+namespace tale_engine::compile {
+
+    namespace {
+
+        enum class StmtTag : std::uint8_t { Text = 0, Choice = 1, Goto = 2, Effect = 3 };
+        enum class EffectTag : std::uint8_t { SetFlag = 0, GiveItem = 1, TakeItem = 2, Native = 3 };
+        enum class ValueTag : std::uint8_t { String = 0, Int = 1, Bool = 2 };
+
+        constexpr std::uint8_t kFlagCompressed = 1;
+
+        // Conditions nest; decoding untrusted bytes must not recurse unboundedly.
+        constexpr int kMaxConditionDepth = 256;
+
+        // Source file names repeat in every SourcePos; they are interned into a
+        // table written ahead of the body, in order of first appearance.
+        class Encoder {
+        public:
+            void pos(const SourcePos& p) {
+                auto [it, inserted] = file_index_.try_emplace(p.file, static_cast<std::uint32_t>(files_.size()));
+                if (inserted) files_.push_back(&it->first);
+                body_.varint(it->second);
+                body_.varint(static_cast<std::uint32_t>(p.line));
+                body_.varint(static_cast<std::uint32_t>(p.column));
+            }
+
+            void value(const dsl::ValueAst& v) {
+                pos(v.pos);
+                if (const auto* s = std::get_if<std::string>(&v.value)) {
+                    body_.u8(static_cast<std::uint8_t>(ValueTag::String));
+                    body_.str(*s);
+                }
+                else if (const auto* i = std::get_if<int>(&v.value)) {
+                    body_.u8(static_cast<std::uint8_t>(ValueTag::Int));
+                    body_.i32(*i);
+                }
+                else {
+                    body_.u8(static_cast<std::uint8_t>(ValueTag::Bool));
+                    body_.u8(std::get<bool>(v.value) ? 1 : 0);
+                }
+            }
+
+            void effect(const dsl::EffectStmtAst& e) {
+                pos(e.pos);
+                if (const auto* s = std::get_if<dsl::EffectSetFlagAst>(&e.call)) {
+                    body_.u8(static_cast<std::uint8_t>(EffectTag::SetFlag));
+                    pos(s->pos);
+                    body_.str(s->name);
+                    value(s->value);
+                }
+                else if (const auto* g = std::get_if<dsl::EffectGiveItemAst>(&e.call)) {
+                    body_.u8(static_cast<std::uint8_t>(EffectTag::GiveItem));
+                    pos(g->pos);
+                    body_.str(g->item_id);
+                    body_.i32(g->qty);
+                }
+                else if (const auto* t = std::get_if<dsl::EffectTakeItemAst>(&e.call)) {
+                    body_.u8(static_cast<std::uint8_t>(EffectTag::TakeItem));
+                    pos(t->pos);
+                    body_.str(t->item_id);
+                    body_.i32(t->qty);
+                }
+                else if (const auto* n = std::get_if<dsl::EffectNativeAst>(&e.call)) {
+                    body_.u8(static_cast<std::uint8_t>(EffectTag::Native));
+                    pos(n->pos);
+                    body_.str(n->name);
+                    body_.varint(n->args.size());
+                    for (std::size_t i = 0; i < n->args.size(); ++i) {
+                        body_.u8(static_cast<std::uint8_t>(n->arg_kinds[i]));
+                        value(n->args[i]);
+                    }
+                }
+            }
+
+            void condition(const dsl::ConditionAst& c) {
+                pos(c.pos);
+                body_.u8(static_cast<std::uint8_t>(c.op));
+                switch (c.op) {
+                case dsl::ConditionOp::HasFlag:
+                    body_.str(c.name);
+                    break;
+                case dsl::ConditionOp::FlagEquals:
+                    body_.str(c.name);
+                    value(c.value);
+                    break;
+                case dsl::ConditionOp::HasItem:
+                case dsl::ConditionOp::StatAtLeast:
+                    body_.str(c.name);
+                    body_.i32(c.qty);
+                    break;
+                case dsl::ConditionOp::Not:
+                case dsl::ConditionOp::And:
+                case dsl::ConditionOp::Or:
+                    body_.varint(c.operands.size());
+                    for (const auto& o : c.operands) condition(o);
+                    break;
+                }
+            }
+
+            void go(const dsl::GotoStmtAst& g) {
+                pos(g.pos);
+                body_.str(g.target_scene_id);
+            }
+
+            void stmt(const dsl::StmtAst& s) {
+                if (const auto* tb = std::get_if<dsl::TextBlockAst>(&s)) {
+                    body_.u8(static_cast<std::uint8_t>(StmtTag::Text));
+                    pos(tb->pos);
+                    body_.varint(tb->lines.size());
+                    for (const auto& line : tb->lines) body_.str(line);
+                }
+                else if (const auto* ch = std::get_if<dsl::ChoiceAst>(&s)) {
+                    body_.u8(static_cast<std::uint8_t>(StmtTag::Choice));
+                    pos(ch->pos);
+                    body_.str(ch->label);
+                    body_.u8(ch->condition ? 1 : 0);
+                    if (ch->condition) condition(*ch->condition);
+                    body_.varint(ch->body.size());
+                    for (const auto& cs : ch->body) {
+                        if (const auto* g = std::get_if<dsl::GotoStmtAst>(&cs)) {
+                            body_.u8(static_cast<std::uint8_t>(StmtTag::Goto));
+                            go(*g);
+                        }
+                        else {
+                            body_.u8(static_cast<std::uint8_t>(StmtTag::Effect));
+                            effect(std::get<dsl::EffectStmtAst>(cs));
+                        }
+                    }
+                }
+                else if (const auto* g = std::get_if<dsl::GotoStmtAst>(&s)) {
+                    body_.u8(static_cast<std::uint8_t>(StmtTag::Goto));
+                    go(*g);
+                }
+                else {
+                    body_.u8(static_cast<std::uint8_t>(StmtTag::Effect));
+                    effect(std::get<dsl::EffectStmtAst>(s));
+                }
+            }
+
+            // Scene records are written in `layout` order (source order if
+            // empty); the scene table ahead of them maps each record back to
+            // its id and source index.
+            void file(const dsl::FileAst& ast, std::span<const std::uint32_t> layout) {
+                const std::size_t n = ast.scenes.size();
+                table_.reserve(n);
+                for (std::size_t i = 0; i < n; ++i) {
+                    const std::uint32_t source = layout.empty() ? static_cast<std::uint32_t>(i) : layout[i];
+                    const auto& scene = ast.scenes[source];
+                    const std::size_t start = body_.size();
+                    pos(scene.pos);
+                    body_.varint(scene.body.size());
+                    for (const auto& s : scene.body) stmt(s);
+                    table_.push_back(TableRow{ &scene.id, source, start, body_.size() - start });
+                }
+            }
+
+            std::string finish(const EncodeOptions& options) {
+                std::string dictionary;
+                std::string records;
+                if (options.compress) {
+                    const std::string_view body = body_.bytes();
+                    std::vector<std::string_view> samples;
+                    samples.reserve(table_.size());
+                    for (const auto& row : table_) samples.push_back(body.substr(row.offset, row.length));
+                    dictionary = lz::train_dictionary(samples, options.dictionary_size);
+
+                    lz::Compressor compressor(dictionary);
+                    for (std::size_t i = 0; i < table_.size(); ++i) {
+                        auto& row = table_[i];
+                        row.raw_length = row.length;
+                        row.offset = records.size();
+                        compressor.compress(samples[i], records);
+                        row.length = records.size() - row.offset;
+                    }
+                }
+
+                ByteWriter out;
+                out.raw(kCompiledMagic);
+                out.u32(kFormatVersion);
+                out.u8(options.compress ? kFlagCompressed : 0);
+                out.varint(files_.size());
+                for (const auto* f : files_) out.str(*f);
+                if (options.compress) out.str(dictionary);
+                out.varint(table_.size());
+                for (const auto& row : table_) {
+                    out.str(*row.id);
+                    out.varint(row.source_index);
+                    out.varint(row.offset);
+                    out.varint(row.length);
+                    if (options.compress) out.varint(row.raw_length);
+                }
+                out.raw(options.compress ? std::string_view(records) : std::string_view(body_.bytes()));
+                return out.take();
+            }
+
+        private:
+            struct TableRow {
+                const std::string* id;
+                std::uint32_t source_index;
+                std::size_t offset;
+                std::size_t length;
+                std::size_t raw_length = 0;
+            };
+
+            std::vector<TableRow> table_;
+            ByteWriter body_;
+            std::unordered_map<std::string, std::uint32_t> file_index_;
+            std::vector<const std::string*> files_;
+        };
+
+        class Decoder {
+        public:
+            explicit Decoder(std::string_view bytes) : bytes_(bytes), in_(bytes) {}
+
+            // Reads everything up to the first scene record.
+            bool header(SceneTable& table) {
+                if (in_.raw(kCompiledMagic.size()) != kCompiledMagic) return false;
+                if (in_.u32() != kFormatVersion) return false;
+                const std::uint8_t flags = in_.u8();
+                if ((flags & ~kFlagCompressed) != 0) return false;
+                table.compressed = (flags & kFlagCompressed) != 0;
+                const std::uint64_t files = in_.varint();
+                for (std::uint64_t i = 0; i < files && in_.ok(); ++i) table.files.push_back(in_.str());
+                if (table.compressed) {
+                    const std::string_view dictionary = in_.str_view();
+                    table.dictionary_offset = in_.position() - dictionary.size();
+                    table.dictionary_length = dictionary.size();
+                }
+
+                const std::uint64_t n = in_.varint();
+                if (!in_.ok() || n > bytes_.size()) return false; // each row takes >= 4 bytes
+                table.scenes.reserve(static_cast<std::size_t>(n));
+                for (std::uint64_t i = 0; i < n && in_.ok(); ++i) {
+                    SceneTableEntry e;
+                    e.id = in_.str();
+                    e.source_index = static_cast<std::uint32_t>(in_.varint());
+                    e.offset = in_.varint();
+                    e.length = in_.varint();
+                    e.raw_length = table.compressed ? in_.varint() : e.length;
+                    table.scenes.push_back(std::move(e));
+                }
+                table.records_offset = in_.position();
+                if (!in_.ok()) return false;
+
+                // source_index must be a permutation.
+                const std::uint64_t records = bytes_.size() - table.records_offset;
+                std::vector<bool> seen(table.scenes.size(), false);
+                for (const auto& e : table.scenes) {
+                    if (e.source_index >= n || seen[e.source_index]) return false;
+                    if (e.offset > records || e.length > records - e.offset) return false;
+                    // A token byte expands to at most ~255 bytes; larger claims are corrupt.
+                    if (e.raw_length / 256 > e.length) return false;
+                    seen[e.source_index] = true;
+                }
+                files_ = &table.files;
+                return true;
+            }
+
+            void use_files(const std::vector<std::string>& files) { files_ = &files; }
+
+            // Positions the reader on one scene record, decompressing it into
+            // scratch_ if needed.
+            bool seek_record(const SceneTable& table, const SceneTableEntry& e) {
+                const std::string_view stored = bytes_.substr(static_cast<std::size_t>(table.records_offset + e.offset),
+                                                              static_cast<std::size_t>(e.length));
+                if (!table.compressed) {
+                    in_ = ByteReader(stored);
+                    return true;
+                }
+                scratch_.resize(static_cast<std::size_t>(e.raw_length));
+                const std::string_view dictionary = bytes_.substr(static_cast<std::size_t>(table.dictionary_offset),
+                                                                  static_cast<std::size_t>(table.dictionary_length));
+                if (!lz::decompress(stored, dictionary, scratch_.data(), scratch_.size())) return false;
+                in_ = ByteReader(scratch_);
+                return true;
+            }
+
+            // Positions the reader on record bytes the caller already has.
+            void use_record(std::string_view record) { in_ = ByteReader(record); }
+
+            SourcePos pos() {
+                SourcePos p;
+                const std::uint64_t f = in_.varint();
+                if (f < files_->size()) p.file = (*files_)[static_cast<std::size_t>(f)];
+                else fail();
+                p.line = static_cast<int>(in_.varint());
+                p.column = static_cast<int>(in_.varint());
+                return p;
+            }
+
+            dsl::ValueAst value() {
+                dsl::ValueAst v;
+                v.pos = pos();
+                switch (static_cast<ValueTag>(in_.u8())) {
+                case ValueTag::String: v.value = in_.str(); break;
+                case ValueTag::Int: v.value = static_cast<int>(in_.i32()); break;
+                case ValueTag::Bool: v.value = in_.u8() != 0; break;
+                default: fail(); break;
+                }
+                return v;
+            }
+
+            dsl::EffectStmtAst effect() {
+                dsl::EffectStmtAst e;
+                e.pos = pos();
+                switch (static_cast<EffectTag>(in_.u8())) {
+                case EffectTag::SetFlag: {
+                    dsl::EffectSetFlagAst s;
+                    s.pos = pos();
+                    s.name = in_.str();
+                    s.value = value();
+                    e.call = std::move(s);
+                    break;
+                }
+                case EffectTag::GiveItem: {
+                    dsl::EffectGiveItemAst g;
+                    g.pos = pos();
+                    g.item_id = in_.str();
+                    g.qty = in_.i32();
+                    e.call = std::move(g);
+                    break;
+                }
+                case EffectTag::TakeItem: {
+                    dsl::EffectTakeItemAst t;
+                    t.pos = pos();
+                    t.item_id = in_.str();
+                    t.qty = in_.i32();
+                    e.call = std::move(t);
+                    break;
+                }
+                case EffectTag::Native: {
+                    dsl::EffectNativeAst n;
+                    n.pos = pos();
+                    n.name = in_.str();
+                    const std::uint64_t count = in_.varint();
+                    if (count > dsl::kMaxEffectArgs) {
+                        fail();
+                        break;
+                    }
+                    for (std::uint64_t i = 0; i < count && ok(); ++i) {
+                        const std::uint8_t kind = in_.u8();
+                        if (kind > static_cast<std::uint8_t>(dsl::EffectArg::Pack)) fail();
+                        const auto arg_kind = static_cast<dsl::EffectArg>(kind);
+                        dsl::ValueAst v = value();
+                        // Handlers rely on the argument types the signature promises.
+                        if ((arg_kind == dsl::EffectArg::Flag || arg_kind == dsl::EffectArg::Item || arg_kind == dsl::EffectArg::Stat ||
+                             arg_kind == dsl::EffectArg::Pack) &&
+                            !std::holds_alternative<std::string>(v.value)) fail();
+                        if (arg_kind == dsl::EffectArg::Int && !std::holds_alternative<int>(v.value)) fail();
+                        n.arg_kinds.push_back(arg_kind);
+                        n.args.push_back(std::move(v));
+                    }
+                    e.call = std::move(n);
+                    break;
+                }
+                default:
+                    fail();
+                    break;
+                }
+                return e;
+            }
+
+            dsl::ConditionAst condition(int depth = 0) {
+                dsl::ConditionAst c;
+                if (depth > kMaxConditionDepth) {
+                    fail();
+                    return c;
+                }
+                c.pos = pos();
+                const std::uint8_t op = in_.u8();
+                if (op > static_cast<std::uint8_t>(dsl::ConditionOp::StatAtLeast)) {
+                    fail();
+                    return c;
+                }
+                c.op = static_cast<dsl::ConditionOp>(op);
+                switch (c.op) {
+                case dsl::ConditionOp::HasFlag:
+                    c.name = in_.str();
+                    break;
+                case dsl::ConditionOp::FlagEquals:
+                    c.name = in_.str();
+                    c.value = value();
+                    break;
+                case dsl::ConditionOp::HasItem:
+                case dsl::ConditionOp::StatAtLeast:
+                    c.name = in_.str();
+                    c.qty = in_.i32();
+                    break;
+                case dsl::ConditionOp::Not:
+                case dsl::ConditionOp::And:
+                case dsl::ConditionOp::Or: {
+                    const std::uint64_t n = in_.varint();
+                    for (std::uint64_t i = 0; i < n && ok(); ++i) c.operands.push_back(condition(depth + 1));
+                    break;
+                }
+                }
+                return c;
+            }
+
+            dsl::GotoStmtAst go() {
+                dsl::GotoStmtAst g;
+                g.pos = pos();
+                g.target_scene_id = in_.str();
+                return g;
+            }
+
+            dsl::StmtAst stmt() {
+                switch (static_cast<StmtTag>(in_.u8())) {
+                case StmtTag::Text: {
+                    dsl::TextBlockAst tb;
+                    tb.pos = pos();
+                    const std::uint64_t n = in_.varint();
+                    for (std::uint64_t i = 0; i < n && in_.ok(); ++i) tb.lines.push_back(in_.str());
+                    return tb;
+                }
+                case StmtTag::Choice: {
+                    dsl::ChoiceAst ch;
+                    ch.pos = pos();
+                    ch.label = in_.str();
+                    if (in_.u8() != 0) ch.condition = condition();
+                    const std::uint64_t n = in_.varint();
+                    for (std::uint64_t i = 0; i < n && in_.ok(); ++i) {
+                        const auto tag = static_cast<StmtTag>(in_.u8());
+                        if (tag == StmtTag::Goto) ch.body.push_back(go());
+                        else if (tag == StmtTag::Effect) ch.body.push_back(effect());
+                        else fail();
+                    }
+                    return ch;
+                }
+                case StmtTag::Goto:
+                    return go();
+                case StmtTag::Effect:
+                    return effect();
+                }
+                fail();
+                return dsl::TextBlockAst{};
+            }
+
+            // Decodes the record the reader is positioned on.
+            bool scene(dsl::SceneAst& out) {
+                out.pos = pos();
+                out.body.clear();
+                const std::uint64_t m = in_.varint();
+                for (std::uint64_t j = 0; j < m && ok(); ++j) out.body.push_back(stmt());
+                return ok() && in_.at_end();
+            }
+
+        private:
+            void fail() { failed_ = true; }
+            bool ok() const { return !failed_ && in_.ok(); }
+
+            std::string_view bytes_;
+            ByteReader in_;
+            std::string scratch_; // decompressed record
+            const std::vector<std::string>* files_ = nullptr;
+            bool failed_ = false;
+        };
+
+    } // namespace
+
+    std::string encode_file(const dsl::FileAst& ast, std::span<const std::uint32_t> layout, const EncodeOptions& options) {
+        if (!layout.empty() && layout.size() != ast.scenes.size()) return {};
+        Encoder enc;
+        enc.file(ast, layout);
+        return enc.finish(options);
+    }
+
+    bool decode_file(std::string_view bytes, dsl::FileAst& out) {
+        SceneTable table;
+        Decoder dec(bytes);
+        if (!dec.header(table)) return false;
+
+        out.scenes.clear();
+        out.scenes.resize(table.scenes.size());
+        for (auto& entry : table.scenes) {
+            auto& scene = out.scenes[entry.source_index];
+            if (!dec.seek_record(table, entry)) return false;
+            scene.id = std::move(entry.id);
+            if (!dec.scene(scene)) return false;
+        }
+        return true;
+    }
+
+    bool read_scene_table(std::string_view bytes, SceneTable& out) {
+        out = SceneTable{};
+        Decoder dec(bytes);
+        return dec.header(out);
+    }
+
+    bool decode_scene(std::string_view bytes, const SceneTable& table, std::size_t stored_index, dsl::SceneAst& out) {
+        if (stored_index >= table.scenes.size()) return false;
+        // The header is not re-read: the table already carries the file names.
+        Decoder dec(bytes);
+        dec.use_files(table.files);
+        if (!dec.seek_record(table, table.scenes[stored_index])) return false;
+        out.id = table.scenes[stored_index].id;
+        return dec.scene(out);
+    }
+
+    bool read_record(std::string_view bytes, const SceneTable& table, std::size_t stored_index, std::string& out) {
+        if (stored_index >= table.scenes.size()) return false;
+        const auto& e = table.scenes[stored_index];
+        const std::string_view stored = bytes.substr(static_cast<std::size_t>(table.records_offset + e.offset),
+                                                     static_cast<std::size_t>(e.length));
+        if (!table.compressed) {
+            out.assign(stored);
+            return true;
+        }
+        out.resize(static_cast<std::size_t>(e.raw_length));
+        const std::string_view dictionary = bytes.substr(static_cast<std::size_t>(table.dictionary_offset),
+                                                         static_cast<std::size_t>(table.dictionary_length));
+        return lz::decompress(stored, dictionary, out.data(), out.size());
+    }
+
+    bool decode_record(std::string_view record, const SceneTable& table, std::size_t stored_index, dsl::SceneAst& out) {
+        if (stored_index >= table.scenes.size()) return false;
+        Decoder dec(record);
+        dec.use_files(table.files);
+        dec.use_record(record);
+        out.id = table.scenes[stored_index].id;
+        return dec.scene(out);
+    }
+
+    bool is_compiled(std::string_view bytes) {
+        return bytes.substr(0, kCompiledMagic.size()) == kCompiledMagic;
+    }
+
+    std::string encode_diagnostics(const std::vector<Diagnostic>& diags) {
+        ByteWriter w;
+        w.varint(diags.size());
+        for (const auto& d : diags) {
+            w.u8(static_cast<std::uint8_t>(d.severity));
+            w.str(d.pos.file);
+            w.varint(static_cast<std::uint32_t>(d.pos.line));
+            w.varint(static_cast<std::uint32_t>(d.pos.column));
+            w.str(d.message);
+        }
+        return w.take();
+    }
+
+    bool decode_diagnostics(std::string_view bytes, std::vector<Diagnostic>& out) {
+        ByteReader r(bytes);
+        out.clear();
+        const std::uint64_t n = r.varint();
+        for (std::uint64_t i = 0; i < n && r.ok(); ++i) {
+            Diagnostic d;
+            const std::uint8_t sev = r.u8();
+            if (sev > static_cast<std::uint8_t>(Severity::Info)) return false;
+            d.severity = static_cast<Severity>(sev);
+            d.pos.file = r.str();
+            d.pos.line = static_cast<int>(r.varint());
+            d.pos.column = static_cast<int>(r.varint());
+            d.message = r.str();
+            out.push_back(std::move(d));
+        }
+        return r.ok() && r.at_end();
+    }
+
+} // namespace tale_engine::compile
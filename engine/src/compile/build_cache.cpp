@@ -0,0 +1,162 @@
+#include "tale_engine/compile/build_cache.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#include <process.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#include "tale_engine/binary_io.h"
+#include "tale_engine/compile/ast_codec.h"
+#include "tale_engine/compile/project.h"
+#include "tale_engine/dsl/lexer.h"
+#include "tale_engine/dsl/parser.h"
+#include "tale_engine/hash.h"
+#include "tale_engine/version.h"
+
+namespace tale_engine::compile {
+
+    namespace {
+        constexpr std::string_view kEntryMagic = "TALEUNIT";
+
+        void append_hex(std::string& out, std::uint64_t v) {
+            static constexpr char digits[] = "0123456789abcdef";
+            for (int i = 60; i >= 0; i -= 4) out.push_back(digits[(v >> i) & 0xf]);
+        }
+
+        std::uint64_t process_id() {
+#if defined(_WIN32)
+            return static_cast<std::uint64_t>(_getpid());
+#elif defined(__unix__) || defined(__APPLE__)
+            return static_cast<std::uint64_t>(getpid());
+#else
+            return 0;
+#endif
+        }
+
+        // Unique among all writers of a cache directory: the process id and
+        // a per-process random nonce tell processes apart (even where the
+        // id is unavailable or reused), the thread id and counter tell
+        // writes within one process apart.
+        std::string temp_suffix() {
+            static const std::uint64_t nonce = [] {
+                std::random_device rd;
+                return (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+            }();
+            static std::atomic<std::uint64_t> counter{ 0 };
+            std::string out = ".tmp";
+            append_hex(out, process_id());
+            out.push_back('-');
+            append_hex(out, hash_combine(nonce, std::hash<std::thread::id>{}(std::this_thread::get_id())));
+            out.push_back('-');
+            append_hex(out, counter.fetch_add(1, std::memory_order_relaxed));
+            return out;
+        }
+    }
+
+    CompiledUnit compile_source(std::string path, std::string_view source, const dsl::EffectTable& effects) {
+        CompiledUnit unit;
+        unit.path = std::move(path);
+
+        Diagnostics diags;
+        dsl::Lexer lexer(source, unit.path, diags);
+        auto tokens = lexer.lex();
+
+        dsl::Parser parser(std::move(tokens), diags, effects);
+        unit.ast = parser.parse_file();
+        unit.diagnostics = diags.all();
+        return unit;
+    }
+
+    BuildCache::BuildCache(std::filesystem::path dir) : dir_(std::move(dir)) {
+    }
+
+    std::string BuildCache::key_for(std::string_view path, std::string_view source, const dsl::EffectTable& effects) {
+        // Two independently seeded passes give a 128-bit key.
+        std::uint64_t version = kFormatVersion;
+        version = hash_combine(version, static_cast<std::uint64_t>(kVersionMajor));
+        version = hash_combine(version, static_cast<std::uint64_t>(kVersionMinor));
+        version = hash_combine(version, static_cast<std::uint64_t>(kVersionPatch));
+        version = hash_combine(version, effects.fingerprint());
+
+        std::uint64_t lo = fnv1a64(source, kFnvOffset64 ^ version);
+        std::uint64_t hi = fnv1a64(source, mix64(kFnvOffset64 + version));
+        lo = hash_combine(lo, fnv1a64(path));
+        hi = hash_combine(hi, source.size());
+        hi = hash_combine(hi, fnv1a64(path, mix64(version)));
+
+        std::string key;
+        key.reserve(32);
+        append_hex(key, hi);
+        append_hex(key, lo);
+        return key;
+    }
+
+    std::filesystem::path BuildCache::entry_path(const std::string& key) const {
+        // Fan out by the first byte so directories stay small on big projects.
+        return dir_ / key.substr(0, 2) / (key + ".tcu");
+    }
+
+    bool BuildCache::load(const std::string& key, CompiledUnit& out) const {
+        const std::string bytes = read_file(entry_path(key));
+        if (bytes.empty()) return false;
+
+        ByteReader r(bytes);
+        if (r.raw(kEntryMagic.size()) != kEntryMagic) return false;
+        if (r.u32() != kFormatVersion) return false;
+        if (r.str_view() != key) return false;
+
+        const std::string_view diags = r.str_view();
+        const std::string_view ast = r.str_view();
+        if (!r.ok() || !r.at_end()) return false;
+
+        CompiledUnit unit;
+        unit.path = out.path;
+        if (!decode_diagnostics(diags, unit.diagnostics)) return false;
+        if (!decode_file(ast, unit.ast)) return false;
+        unit.from_cache = true;
+        out = std::move(unit);
+        return true;
+    }
+
+    bool BuildCache::store(const std::string& key, const CompiledUnit& unit) const {
+        ByteWriter w;
+        w.raw(kEntryMagic);
+        w.u32(kFormatVersion);
+        w.str(key);
+        w.str(encode_diagnostics(unit.diagnostics));
+        w.str(encode_file(unit.ast));
+
+        const auto path = entry_path(key);
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        if (ec) return false;
+
+        // Unique temp name per write; rename is atomic on the same volume.
+        auto tmp = path;
+        tmp += temp_suffix();
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            if (!f) return false;
+            f.write(w.bytes().data(), static_cast<std::streamsize>(w.size()));
+            if (!f) return false;
+        }
+
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace tale_engine::compile
@@ -0,0 +1,255 @@
+#include "tale_engine/compile/embed.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tale_engine/runtime/embedded_story.h"
+#include "tale_engine/runtime/session_log.h"
+
+namespace tale_engine::compile {
+
+    namespace {
+
+        using runtime::EmbeddedPos;
+        using runtime::EmbeddedStmtKind;
+        using runtime::EmbeddedValueKind;
+
+        // std::string_view literal that round-trips any bytes, NULs included
+        // (hence the sv suffix). Octal escapes never swallow the digits that
+        // follow (hex escapes would).
+        std::string literal(std::string_view s) {
+            std::string out = "\"";
+            for (const char ch : s) {
+                const auto c = static_cast<unsigned char>(ch);
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += ch;
+                }
+                else if (c >= 0x20 && c < 0x7f && c != '?') { // '?' would risk trigraphs
+                    out += ch;
+                }
+                else {
+                    out += '\\';
+                    out += static_cast<char>('0' + ((c >> 6) & 7));
+                    out += static_cast<char>('0' + ((c >> 3) & 7));
+                    out += static_cast<char>('0' + (c & 7));
+                }
+            }
+            out += "\"sv";
+            return out;
+        }
+
+        // Flattens the AST into the tables of runtime::EmbeddedStory, already
+        // formatted as initializers.
+        class TableWriter {
+        public:
+            void file(const dsl::FileAst& ast) {
+                for (const auto& scene : ast.scenes) {
+                    const std::size_t first = stmts_.size();
+                    stmts_.resize(first + scene.body.size());
+                    for (std::size_t i = 0; i < scene.body.size(); ++i) top_level(first + i, scene.body[i]);
+                    scenes_.push_back("{ " + pos(scene.pos) + ", " + literal(scene.id) + ", " + std::to_string(first) + ", "
+                        + std::to_string(scene.body.size()) + " }");
+                }
+            }
+
+            void write(std::ostream& out) const {
+                table(out, "std::string_view", "kFiles", files_);
+                table(out, "tale_engine::runtime::EmbeddedScene", "kScenes", scenes_);
+                table(out, "tale_engine::runtime::EmbeddedStmt", "kStmts", stmts_);
+                table(out, "std::string_view", "kLines", lines_);
+                table(out, "tale_engine::runtime::EmbeddedCondition", "kConditions", conditions_);
+                table(out, "tale_engine::runtime::EmbeddedArg", "kArgs", args_);
+            }
+
+            // Initializers of the EmbeddedStory table spans, in member order.
+            void write_spans(std::ostream& out) const {
+                out << "        " << span("kFiles", files_) << ",\n"
+                    << "        " << span("kScenes", scenes_) << ",\n"
+                    << "        " << span("kStmts", stmts_) << ",\n"
+                    << "        " << span("kLines", lines_) << ",\n"
+                    << "        " << span("kConditions", conditions_) << ",\n"
+                    << "        " << span("kArgs", args_) << ",\n";
+            }
+
+        private:
+            static std::string_view span(std::string_view array, const std::vector<std::string>& rows) {
+                return rows.empty() ? std::string_view("{}") : array;
+            }
+
+            static void table(std::ostream& out, std::string_view type, std::string_view name, const std::vector<std::string>& rows) {
+                // Zero-length arrays are ill-formed; the story uses an empty span instead.
+                if (rows.empty()) return;
+                out << "    constexpr " << type << " " << name << "[] = {\n";
+                for (const auto& row : rows) out << "        " << row << ",\n";
+                out << "    };\n\n";
+            }
+
+            std::string pos(const SourcePos& p) {
+                auto [it, inserted] = file_index_.try_emplace(p.file, static_cast<std::uint32_t>(files_.size()));
+                if (inserted) files_.push_back(literal(p.file));
+                return "{ " + std::to_string(it->second) + ", " + std::to_string(p.line) + ", " + std::to_string(p.column) + " }";
+            }
+
+            std::string value(const dsl::ValueAst& v) {
+                const std::string p = pos(v.pos);
+                if (const auto* s = std::get_if<std::string>(&v.value)) {
+                    return "{ " + p + ", tale_engine::runtime::EmbeddedValueKind::String, " + literal(*s) + ", 0 }";
+                }
+                if (const auto* n = std::get_if<int>(&v.value)) {
+                    return "{ " + p + ", tale_engine::runtime::EmbeddedValueKind::Int, {}, " + std::to_string(*n) + " }";
+                }
+                return "{ " + p + ", tale_engine::runtime::EmbeddedValueKind::Bool, {}, " + (std::get<bool>(v.value) ? "1" : "0") + " }";
+            }
+
+            static std::string_view kind_name(EmbeddedStmtKind k) {
+                switch (k) {
+                case EmbeddedStmtKind::Text: return "Text";
+                case EmbeddedStmtKind::Choice: return "Choice";
+                case EmbeddedStmtKind::Goto: return "Goto";
+                case EmbeddedStmtKind::SetFlag: return "SetFlag";
+                case EmbeddedStmtKind::GiveItem: return "GiveItem";
+                case EmbeddedStmtKind::TakeItem: return "TakeItem";
+                case EmbeddedStmtKind::Native: return "Native";
+                }
+                return "Goto";
+            }
+
+            static std::string_view arg_name(dsl::EffectArg kind) {
+                switch (kind) {
+                case dsl::EffectArg::Flag: return "Flag";
+                case dsl::EffectArg::Item: return "Item";
+                case dsl::EffectArg::Int: return "Int";
+                case dsl::EffectArg::Value: return "Value";
+                case dsl::EffectArg::Stat: return "Stat";
+                case dsl::EffectArg::Pack: return "Pack";
+                }
+                return "Value";
+            }
+
+            static std::string_view op_name(dsl::ConditionOp op) {
+                switch (op) {
+                case dsl::ConditionOp::HasFlag: return "HasFlag";
+                case dsl::ConditionOp::FlagEquals: return "FlagEquals";
+                case dsl::ConditionOp::HasItem: return "HasItem";
+                case dsl::ConditionOp::Not: return "Not";
+                case dsl::ConditionOp::And: return "And";
+                case dsl::ConditionOp::Or: return "Or";
+                case dsl::ConditionOp::StatAtLeast: return "StatAtLeast";
+                }
+                return "HasFlag";
+            }
+
+            std::string stmt(const SourcePos& p, EmbeddedStmtKind kind, std::string_view name, const std::string& val, int qty,
+                std::size_t first, std::size_t count, const std::string& condition) {
+                return "{ " + pos(p) + ", tale_engine::runtime::EmbeddedStmtKind::" + std::string(kind_name(kind)) + ", "
+                    + literal(name) + ", " + val + ", " + std::to_string(qty) + ", " + std::to_string(first) + ", "
+                    + std::to_string(count) + ", " + condition + " }";
+            }
+
+            std::string goto_stmt(const dsl::GotoStmtAst& g) {
+                return stmt(g.pos, EmbeddedStmtKind::Goto, g.target_scene_id, "{}", 0, 0, 0, "tale_engine::runtime::kNoEmbeddedCondition");
+            }
+
+            std::string effect(const dsl::EffectStmtAst& e) {
+                const char* none = "tale_engine::runtime::kNoEmbeddedCondition";
+                if (const auto* s = std::get_if<dsl::EffectSetFlagAst>(&e.call)) {
+                    return stmt(e.pos, EmbeddedStmtKind::SetFlag, s->name, value(s->value), 0, 0, 0, none);
+                }
+                if (const auto* g = std::get_if<dsl::EffectGiveItemAst>(&e.call)) {
+                    return stmt(e.pos, EmbeddedStmtKind::GiveItem, g->item_id, "{}", g->qty, 0, 0, none);
+                }
+                if (const auto* t = std::get_if<dsl::EffectTakeItemAst>(&e.call)) {
+                    return stmt(e.pos, EmbeddedStmtKind::TakeItem, t->item_id, "{}", t->qty, 0, 0, none);
+                }
+                const auto& n = std::get<dsl::EffectNativeAst>(e.call);
+                const std::size_t first = args_.size();
+                for (std::size_t i = 0; i < n.args.size(); ++i) {
+                    args_.push_back("{ tale_engine::dsl::EffectArg::" + std::string(arg_name(n.arg_kinds[i])) + ", " + value(n.args[i]) + " }");
+                }
+                return stmt(e.pos, EmbeddedStmtKind::Native, n.name, "{}", 0, first, n.args.size(), none);
+            }
+
+            // Operands of a node occupy a contiguous run right after it is placed.
+            void condition(std::size_t slot, const dsl::ConditionAst& c) {
+                const std::size_t first = conditions_.size();
+                conditions_.resize(first + c.operands.size());
+                conditions_[slot] = "{ " + pos(c.pos) + ", tale_engine::dsl::ConditionOp::" + std::string(op_name(c.op)) + ", "
+                    + literal(c.name) + ", " + value(c.value) + ", " + std::to_string(c.qty) + ", " + std::to_string(first) + ", "
+                    + std::to_string(c.operands.size()) + " }";
+                for (std::size_t i = 0; i < c.operands.size(); ++i) condition(first + i, c.operands[i]);
+            }
+
+            // Fills stmts_[slot]; child ranges are appended after the parent's run.
+            void top_level(std::size_t slot, const dsl::StmtAst& s) {
+                if (const auto* tb = std::get_if<dsl::TextBlockAst>(&s)) {
+                    const std::size_t first = lines_.size();
+                    for (const auto& line : tb->lines) lines_.push_back(literal(line));
+                    stmts_[slot] = stmt(tb->pos, EmbeddedStmtKind::Text, {}, "{}", 0, first, tb->lines.size(),
+                        "tale_engine::runtime::kNoEmbeddedCondition");
+                }
+                else if (const auto* ch = std::get_if<dsl::ChoiceAst>(&s)) {
+                    std::string cond = "tale_engine::runtime::kNoEmbeddedCondition";
+                    if (ch->condition) {
+                        const std::size_t root = conditions_.size();
+                        conditions_.emplace_back();
+                        condition(root, *ch->condition);
+                        cond = std::to_string(root);
+                    }
+                    const std::size_t first = stmts_.size();
+                    stmts_.resize(first + ch->body.size());
+                    for (std::size_t i = 0; i < ch->body.size(); ++i) {
+                        if (const auto* g = std::get_if<dsl::GotoStmtAst>(&ch->body[i])) stmts_[first + i] = goto_stmt(*g);
+                        else stmts_[first + i] = effect(std::get<dsl::EffectStmtAst>(ch->body[i]));
+                    }
+                    stmts_[slot] = stmt(ch->pos, EmbeddedStmtKind::Choice, ch->label, "{}", 0, first, ch->body.size(), cond);
+                }
+                else if (const auto* g = std::get_if<dsl::GotoStmtAst>(&s)) {
+                    stmts_[slot] = goto_stmt(*g);
+                }
+                else {
+                    stmts_[slot] = effect(std::get<dsl::EffectStmtAst>(s));
+                }
+            }
+
+        private:
+            std::vector<std::string> files_;
+            std::unordered_map<std::string, std::uint32_t> file_index_;
+            std::vector<std::string> scenes_;
+            std::vector<std::string> stmts_;
+            std::vector<std::string> lines_;
+            std::vector<std::string> conditions_;
+            std::vector<std::string> args_;
+        };
+
+    } // namespace
+
+    void write_embedded_story(std::ostream& header, std::ostream& source, const dsl::FileAst& ast,
+        std::string_view name, std::string_view header_name) {
+        header << "// Generated by tale_embed. Do not edit.\n"
+            << "#pragma once\n"
+            << "#include \"tale_engine/runtime/embedded_story.h\"\n\n"
+            << "namespace tale_embedded {\n\n"
+            << "    extern const tale_engine::runtime::EmbeddedStory " << name << ";\n\n"
+            << "} // namespace tale_embedded\n";
+
+        TableWriter tables;
+        tables.file(ast);
+
+        source << "// Generated by tale_embed. Do not edit.\n"
+            << "#include \"" << header_name << "\"\n\n"
+            << "#include <string_view>\n\n"
+            << "namespace {\n\n"
+            << "    using namespace std::string_view_literals;\n\n";
+        tables.write(source);
+        source << "} // namespace\n\n"
+            << "namespace tale_embedded {\n\n"
+            << "    constexpr tale_engine::runtime::EmbeddedStory " << name << "{\n";
+        tables.write_spans(source);
+        source << "        0x" << std::hex << runtime::content_hash(ast) << std::dec << "ull,\n"
+            << "    };\n\n"
+            << "} // namespace tale_embedded\n";
+    }
+
+} // namespace tale_engine::compile
@@ -0,0 +1,103 @@
+#include "tale_engine/compile/layout.h"
+
+#include <algorithm>
+#include <queue>
+
+#include "tale_engine/compile/ast_codec.h"
+#include "tale_engine/profile.h"
+
+namespace tale_engine::compile {
+
+    namespace {
+
+        using analysis::SceneGraph;
+        using analysis::SceneIndex;
+
+        struct Candidate {
+            std::uint64_t visits;
+            std::uint32_t seen; // discovery order, breaks ties
+            SceneIndex scene;
+
+            bool operator<(const Candidate& o) const {
+                if (visits != o.visits) return visits < o.visits;
+                return seen > o.seen;
+            }
+        };
+
+    } // namespace
+
+    std::vector<std::uint32_t> plan_layout(const SceneGraph& graph, std::span<const std::uint64_t> visits) {
+        TALE_PROFILE_SCOPE("compile::plan_layout");
+        const std::size_t n = graph.scene_count();
+        std::vector<std::uint32_t> order;
+        order.reserve(n);
+        if (n == 0) return order;
+
+        auto weight = [&](SceneIndex s) -> std::uint64_t { return s < visits.size() ? visits[s] : 0; };
+
+        // Duplicates are never reached by id; they are appended at the end.
+        std::vector<bool> placed(n, false);
+        for (const SceneIndex d : graph.duplicate_scenes()) placed[d] = true;
+
+        std::priority_queue<Candidate> frontier;
+        std::uint32_t seen = 0;
+
+        SceneIndex cur = 0;
+        while (true) {
+            placed[cur] = true;
+            order.push_back(cur);
+
+            // Continue the chain with the hottest unplaced successor; the
+            // rest wait in the frontier.
+            SceneIndex next = analysis::kNoScene;
+            for (const SceneIndex s : graph.successors(cur)) {
+                if (placed[s]) continue;
+                frontier.push(Candidate{ weight(s), seen++, s });
+                if (next == analysis::kNoScene || weight(s) > weight(next)) next = s;
+            }
+            while (next == analysis::kNoScene && !frontier.empty()) {
+                const SceneIndex s = frontier.top().scene;
+                frontier.pop();
+                if (!placed[s]) next = s;
+            }
+            if (next == analysis::kNoScene) break;
+            cur = next;
+        }
+
+        // Unreachable scenes, then duplicates (scene 0 is never a duplicate).
+        for (SceneIndex s = 0; s < n; ++s) {
+            if (!placed[s]) order.push_back(s);
+        }
+        for (const SceneIndex d : graph.duplicate_scenes()) order.push_back(d);
+        return order;
+    }
+
+    std::size_t pages_touched(std::string_view bytes, std::span<const std::uint32_t> trace) {
+        SceneTable table;
+        if (!read_scene_table(bytes, table)) return 0;
+
+        std::vector<const SceneTableEntry*> by_source(table.scenes.size(), nullptr);
+        for (const auto& e : table.scenes) by_source[e.source_index] = &e;
+
+        std::vector<bool> touched((bytes.size() + kLayoutPageSize - 1) / kLayoutPageSize, false);
+        std::size_t count = 0;
+        auto touch = [&](std::uint64_t begin, std::uint64_t end) {
+            if (begin == end) return;
+            for (std::uint64_t p = begin / kLayoutPageSize; p <= (end - 1) / kLayoutPageSize; ++p) {
+                if (!touched[p]) {
+                    touched[p] = true;
+                    count++;
+                }
+            }
+        };
+
+        touch(0, table.records_offset);
+        for (const std::uint32_t s : trace) {
+            if (s >= by_source.size() || !by_source[s]) continue;
+            const std::uint64_t begin = table.records_offset + by_source[s]->offset;
+            touch(begin, begin + by_source[s]->length);
+        }
+        return count;
+    }
+
+} // namespace tale_engine::compile
@@ -0,0 +1,135 @@
+#include "tale_engine/compile/localization.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "tale_engine/binary_io.h"
+#include "tale_engine/hash.h"
+#include "tale_engine/json.h"
+#include "tale_engine/runtime/string_table.h"
+
+namespace tale_engine::compile {
+
+    std::vector<LocalizedString> extract_strings(const dsl::FileAst& ast) {
+        std::vector<LocalizedString> out;
+        std::unordered_set<std::string_view> seen;
+        for (const auto& scene : ast.scenes) {
+            if (!seen.insert(scene.id).second) continue;
+            std::uint32_t line = 0;
+            std::uint32_t choice = 0;
+            for (const auto& stmt : scene.body) {
+                if (const auto* tb = std::get_if<dsl::TextBlockAst>(&stmt)) {
+                    for (const auto& text : tb->lines) {
+                        out.push_back(LocalizedString{ runtime::text_key(scene.id, line++), text, tb->pos });
+                    }
+                }
+                else if (const auto* ch = std::get_if<dsl::ChoiceAst>(&stmt)) {
+                    out.push_back(LocalizedString{ runtime::label_key(scene.id, choice++), ch->label, ch->pos });
+                }
+            }
+        }
+        return out;
+    }
+
+    void write_catalog(std::ostream& out, std::string_view locale, std::span<const LocalizedString> strings) {
+        out << "{\"locale\":";
+        write_json_string(out, locale);
+        out << ",\"strings\":[";
+        for (std::size_t i = 0; i < strings.size(); ++i) {
+            const auto& s = strings[i];
+            out << (i ? ",\n" : "\n") << "{\"key\":";
+            write_json_string(out, s.key);
+            out << ",\"text\":";
+            write_json_string(out, s.text);
+            out << ",\"file\":";
+            write_json_string(out, s.pos.file);
+            out << ",\"line\":" << s.pos.line << '}';
+        }
+        out << "]}\n";
+    }
+
+    bool read_catalog(std::string_view json, const std::string& path, std::string& locale,
+        std::vector<LocalizedString>& out, Diagnostics& diagnostics) {
+        out.clear();
+        JsonValue doc;
+        if (!parse_json(json, doc) || doc.kind() != JsonValue::Kind::Object) {
+            diagnostics.error(SourcePos{ path, 1, 1 }, "String catalog is not a JSON object.");
+            return false;
+        }
+        locale = doc["locale"].as_string();
+        if (doc["strings"].kind() != JsonValue::Kind::Array) {
+            diagnostics.error(SourcePos{ path, 1, 1 }, "String catalog has no \"strings\" array.");
+            return false;
+        }
+
+        bool ok = true;
+        std::unordered_set<std::string_view> keys;
+        const auto& items = doc["strings"].items();
+        out.reserve(items.size());
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            const auto& item = items[i];
+            const std::string entry = "String catalog entry " + std::to_string(i);
+            if (!item["key"].is_string() || item["key"].as_string().empty() || !item["text"].is_string()) {
+                diagnostics.error(SourcePos{ path, 1, 1 }, entry + " needs a \"key\" and a \"text\" string.");
+                ok = false;
+                continue;
+            }
+            if (!keys.insert(item["key"].as_string()).second) {
+                diagnostics.error(SourcePos{ path, 1, 1 }, entry + " repeats key: " + item["key"].as_string());
+                ok = false;
+                continue;
+            }
+            out.push_back(LocalizedString{ item["key"].as_string(), item["text"].as_string(), SourcePos{ path, 1, 1 } });
+        }
+        return ok;
+    }
+
+    std::string encode_string_table(std::string_view locale, std::span<const LocalizedString> strings,
+        Diagnostics& diagnostics) {
+        struct Entry {
+            std::uint64_t hash;
+            const LocalizedString* s;
+        };
+        std::vector<Entry> entries;
+        entries.reserve(strings.size());
+        for (const auto& s : strings) entries.push_back(Entry{ fnv1a64(s.key), &s });
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.hash != b.hash ? a.hash < b.hash : a.s->key < b.s->key;
+        });
+
+        bool ok = true;
+        for (std::size_t i = 1; i < entries.size(); ++i) {
+            if (entries[i].hash != entries[i - 1].hash) continue;
+            const auto& a = *entries[i - 1].s;
+            const auto& b = *entries[i].s;
+            diagnostics.error(b.pos, a.key == b.key ? "Repeated string key: " + b.key
+                                                    : "String keys collide in the table hash: " + a.key + ", " + b.key);
+            ok = false;
+        }
+        if (!ok) return {};
+
+        ByteWriter w;
+        w.raw(runtime::kStringTableMagic);
+        w.u32(runtime::kStringTableVersion);
+        w.u32(static_cast<std::uint32_t>(entries.size()));
+        w.u32(static_cast<std::uint32_t>(locale.size()));
+        w.raw(locale);
+        while (w.size() % 8 != 0) w.u8(0);
+
+        // Identical texts are stored once.
+        std::string blob;
+        std::unordered_map<std::string_view, std::uint32_t> offsets;
+        for (const auto& e : entries) {
+            const std::string& text = e.s->text;
+            auto [it, inserted] = offsets.try_emplace(text, static_cast<std::uint32_t>(blob.size()));
+            if (inserted) blob += text;
+            w.u64(e.hash);
+            w.u32(it->second);
+            w.u32(static_cast<std::uint32_t>(text.size()));
+        }
+        w.raw(blob);
+        return w.take();
+    }
+
+} // namespace tale_engine::compile
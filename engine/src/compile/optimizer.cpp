@@ -0,0 +1,322 @@
+#include "tale_engine/compile/optimizer.h"
+
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "tale_engine/analysis/scene_graph.h"
+#include "tale_engine/profile.h"
+
+namespace tale_engine::compile {
+
+    namespace {
+
+        using analysis::SceneGraph;
+        using analysis::SceneIndex;
+        using analysis::kNoScene;
+
+        std::size_t count_statements(const dsl::FileAst& ast) {
+            std::size_t n = 0;
+            for (const auto& scene : ast.scenes) {
+                n += scene.body.size();
+                for (const auto& stmt : scene.body) {
+                    if (const auto* ch = std::get_if<dsl::ChoiceAst>(&stmt)) n += ch->body.size();
+                }
+            }
+            return n;
+        }
+
+        std::size_t merge_text(dsl::SceneAst& scene) {
+            std::size_t merged = 0;
+            std::vector<dsl::StmtAst> body;
+            body.reserve(scene.body.size());
+            for (auto& stmt : scene.body) {
+                if (auto* tb = std::get_if<dsl::TextBlockAst>(&stmt)) {
+                    if (tb->lines.empty()) {
+                        merged++;
+                        continue;
+                    }
+                    if (!body.empty()) {
+                        if (auto* prev = std::get_if<dsl::TextBlockAst>(&body.back())) {
+                            for (auto& line : tb->lines) prev->lines.push_back(std::move(line));
+                            merged++;
+                            continue;
+                        }
+                    }
+                }
+                body.push_back(std::move(stmt));
+            }
+            scene.body = std::move(body);
+            return merged;
+        }
+
+        // Coalesces one run of effects that execute back to back. `run` holds
+        // the positions of the effects in `body`; removed ones are cleared in
+        // `keep`.
+        template <typename Body>
+        std::size_t coalesce_run(Body& body, const std::vector<std::size_t>& run, std::vector<bool>& keep) {
+            auto effect_at = [&](std::size_t i) -> dsl::EffectStmtAst& { return std::get<dsl::EffectStmtAst>(body[i]); };
+            std::size_t removed = 0;
+            auto drop = [&](std::size_t i) {
+                keep[i] = false;
+                removed++;
+            };
+
+            // Nothing in a run reads flags, so only the last set_flag per flag
+            // matters. (Native effects may read anything; they end runs.)
+            std::unordered_map<std::string_view, bool> flag_set_later;
+            for (auto it = run.rbegin(); it != run.rend(); ++it) {
+                if (const auto* s = std::get_if<dsl::EffectSetFlagAst>(&effect_at(*it).call)) {
+                    if (!flag_set_later.try_emplace(s->name, true).second) drop(*it);
+                }
+            }
+
+            std::unordered_map<std::string_view, dsl::EffectGiveItemAst*> open_give;
+            for (const std::size_t i : run) {
+                if (!keep[i]) continue;
+                auto& call = effect_at(i).call;
+                if (auto* g = std::get_if<dsl::EffectGiveItemAst>(&call)) {
+                    if (g->qty <= 0) {
+                        drop(i);
+                        continue;
+                    }
+                    auto [it, inserted] = open_give.try_emplace(g->item_id, g);
+                    if (!inserted) {
+                        if (it->second->qty <= std::numeric_limits<int>::max() - g->qty) {
+                            it->second->qty += g->qty;
+                            drop(i);
+                        }
+                        else {
+                            it->second = g;
+                        }
+                    }
+                }
+                else if (const auto* t = std::get_if<dsl::EffectTakeItemAst>(&call)) {
+                    if (t->qty <= 0) {
+                        drop(i);
+                        continue;
+                    }
+                    open_give.erase(t->item_id);
+                }
+            }
+            return removed;
+        }
+
+        template <typename Body>
+        std::size_t filter(Body& body, const std::vector<bool>& keep) {
+            std::size_t out = 0;
+            for (std::size_t i = 0; i < body.size(); ++i) {
+                if (keep[i]) {
+                    if (out != i) body[out] = std::move(body[i]);
+                    out++;
+                }
+            }
+            const std::size_t removed = body.size() - out;
+            body.erase(body.begin() + static_cast<std::ptrdiff_t>(out), body.end());
+            return removed;
+        }
+
+        // Built-in effect that can be coalesced with its neighbours.
+        template <typename Stmt>
+        bool is_builtin_effect(const Stmt& stmt) {
+            const auto* e = std::get_if<dsl::EffectStmtAst>(&stmt);
+            return e && !std::holds_alternative<dsl::EffectNativeAst>(e->call);
+        }
+
+        // Coalesces each run of built-in effects in `body`. Statements for
+        // which `ends_run` is false are skipped over without ending the run.
+        // Returns the number of effects removed.
+        template <typename Body, typename EndsRun>
+        std::size_t coalesce_runs(Body& body, EndsRun ends_run) {
+            std::vector<bool> keep(body.size(), true);
+            std::vector<std::size_t> run;
+            std::size_t dropped = 0;
+            for (std::size_t i = 0; i <= body.size(); ++i) {
+                if (i < body.size()) {
+                    if (is_builtin_effect(body[i])) {
+                        run.push_back(i);
+                        continue;
+                    }
+                    if (!ends_run(body[i])) continue;
+                }
+                if (!run.empty()) dropped += coalesce_run(body, run, keep);
+                run.clear();
+            }
+            return dropped != 0 ? filter(body, keep) : 0;
+        }
+
+        std::size_t coalesce_effects(dsl::SceneAst& scene) {
+            std::size_t removed = 0;
+
+            // Choice bodies: every effect runs before the goto, so only native
+            // effects split the body.
+            for (auto& stmt : scene.body) {
+                if (auto* ch = std::get_if<dsl::ChoiceAst>(&stmt)) {
+                    removed += coalesce_runs(ch->body, [](const auto& s) { return std::holds_alternative<dsl::EffectStmtAst>(s); });
+                }
+            }
+
+            // Scene body: runs of consecutive effect statements.
+            removed += coalesce_runs(scene.body, [](const auto&) { return true; });
+            return removed;
+        }
+
+        // Scene whose body is exactly one top-level goto.
+        const dsl::GotoStmtAst* forwarding_goto(const dsl::SceneAst& scene) {
+            if (scene.body.size() != 1) return nullptr;
+            return std::get_if<dsl::GotoStmtAst>(&scene.body.front());
+        }
+
+        class GotoCollapser {
+        public:
+            GotoCollapser(dsl::FileAst& ast, const SceneGraph& graph)
+                : ast_(ast), graph_(graph), final_(ast.scenes.size(), kUnknown), hops_(ast.scenes.size(), 0),
+                  on_path_(ast.scenes.size(), false) {}
+
+            void rewrite(dsl::GotoStmtAst& g, OptimizeReport& report) {
+                const SceneIndex target = graph_.index_of(g.target_scene_id);
+                if (target == kNoScene) return;
+                resolve(target);
+                if (final_[target] == target) return;
+                g.target_scene_id = ast_.scenes[final_[target]].id;
+                report.gotos_redirected++;
+                report.goto_hops_removed += hops_[target];
+            }
+
+        private:
+            static constexpr SceneIndex kUnknown = kNoScene - 1;
+
+            // Follows forwarding scenes from `start`. Chains that run into a
+            // missing scene stop before it; chains that end in a cycle are
+            // left untouched.
+            void resolve(SceneIndex start) {
+                if (final_[start] != kUnknown) return;
+
+                path_.clear();
+                SceneIndex cur = start;
+                SceneIndex end = kNoScene;
+                std::size_t tail_hops = 0;
+                while (true) {
+                    if (final_[cur] != kUnknown) {
+                        end = final_[cur];
+                        tail_hops = hops_[cur];
+                        break;
+                    }
+                    const auto* fwd = forwarding_goto(ast_.scenes[cur]);
+                    if (!fwd) {
+                        end = cur;
+                        break;
+                    }
+                    if (on_path_[cur]) {
+                        end = kNoScene; // cycle
+                        break;
+                    }
+                    const SceneIndex next = graph_.index_of(fwd->target_scene_id);
+                    if (next == kNoScene) {
+                        end = cur;
+                        break;
+                    }
+                    on_path_[cur] = true;
+                    path_.push_back(cur);
+                    cur = next;
+                }
+
+                for (std::size_t i = 0; i < path_.size(); ++i) {
+                    const SceneIndex s = path_[i];
+                    on_path_[s] = false;
+                    if (end == kNoScene || (end == s)) {
+                        final_[s] = s;
+                        hops_[s] = 0;
+                    }
+                    else {
+                        final_[s] = end;
+                        hops_[s] = (path_.size() - i) + tail_hops;
+                    }
+                }
+                if (final_[start] == kUnknown) final_[start] = start;
+            }
+
+        private:
+            dsl::FileAst& ast_;
+            const SceneGraph& graph_;
+            std::vector<SceneIndex> final_;
+            std::vector<std::size_t> hops_;
+            std::vector<bool> on_path_;
+            std::vector<SceneIndex> path_;
+        };
+
+        void collapse_gotos(dsl::FileAst& ast, OptimizeReport& report) {
+            // Gotos only change targets, never scene ids, so the graph's id
+            // table stays valid while we rewrite.
+            const SceneGraph graph(ast);
+            GotoCollapser collapser(ast, graph);
+            for (auto& scene : ast.scenes) {
+                for (auto& stmt : scene.body) {
+                    if (auto* g = std::get_if<dsl::GotoStmtAst>(&stmt)) {
+                        collapser.rewrite(*g, report);
+                    }
+                    else if (auto* ch = std::get_if<dsl::ChoiceAst>(&stmt)) {
+                        for (auto& cs : ch->body) {
+                            if (auto* cg = std::get_if<dsl::GotoStmtAst>(&cs)) collapser.rewrite(*cg, report);
+                        }
+                    }
+                }
+            }
+        }
+
+        void eliminate_dead_scenes(dsl::FileAst& ast, const std::vector<std::string>& entries, OptimizeReport& report) {
+            if (ast.scenes.empty()) return;
+
+            std::vector<bool> live;
+            {
+                const SceneGraph graph(ast);
+                live = graph.reachable_from(0);
+                for (const auto& entry : entries) {
+                    const SceneIndex s = graph.index_of(entry);
+                    if (s == kNoScene || live[s]) continue;
+                    const auto more = graph.reachable_from(s);
+                    for (std::size_t i = 0; i < live.size(); ++i) live[i] = live[i] || more[i];
+                }
+            }
+
+            std::size_t out = 0;
+            for (std::size_t i = 0; i < ast.scenes.size(); ++i) {
+                if (!live[i]) continue;
+                if (out != i) ast.scenes[out] = std::move(ast.scenes[i]);
+                out++;
+            }
+            report.scenes_removed += ast.scenes.size() - out;
+            ast.scenes.resize(out);
+        }
+
+    } // namespace
+
+    OptimizeReport optimize(dsl::FileAst& ast, const OptimizeOptions& options) {
+        TALE_PROFILE_SCOPE("compile::optimize");
+        OptimizeReport report;
+        report.scenes_before = ast.scenes.size();
+        report.statements_before = count_statements(ast);
+
+        for (auto& scene : ast.scenes) {
+            if (options.merge_text) report.text_blocks_merged += merge_text(scene);
+            if (options.coalesce_effects) report.effects_removed += coalesce_effects(scene);
+        }
+        if (options.collapse_gotos) collapse_gotos(ast, report);
+        if (options.eliminate_dead_scenes) eliminate_dead_scenes(ast, options.entry_scenes, report);
+
+        report.scenes_after = ast.scenes.size();
+        report.statements_after = count_statements(ast);
+        return report;
+    }
+
+    void write_report(std::ostream& out, const OptimizeReport& r) {
+        out << "optimize: scenes " << r.scenes_before << " -> " << r.scenes_after
+            << ", statements " << r.statements_before << " -> " << r.statements_after << "\n"
+            << "  gotos redirected:    " << r.gotos_redirected << " (" << r.goto_hops_removed << " transfer step(s) saved)\n"
+            << "  text blocks merged:  " << r.text_blocks_merged << "\n"
+            << "  effects removed:     " << r.effects_removed << "\n"
+            << "  dead scenes removed: " << r.scenes_removed << "\n";
+    }
+
+} // namespace tale_engine::compile
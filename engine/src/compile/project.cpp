@@ -0,0 +1,95 @@
+#include "tale_engine/compile/project.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include "tale_engine/compile/build_cache.h"
+#include "tale_engine/profile.h"
+
+namespace tale_engine::compile {
+
+    std::string read_file(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return {};
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    static CompiledUnit load_or_compile(const std::string& path, const BuildCache* cache, const dsl::EffectTable& effects) {
+        TALE_PROFILE_SCOPE("compile::load_or_compile");
+        const std::string source = read_file(path);
+        if (source.empty()) {
+            CompiledUnit unit;
+            unit.path = path;
+            unit.diagnostics.push_back(Diagnostic{ Severity::Error, SourcePos{ path, 1, 1 }, "File is empty or cannot be read." });
+            return unit;
+        }
+
+        std::string key;
+        if (cache) {
+            key = BuildCache::key_for(path, source, effects);
+            CompiledUnit cached;
+            cached.path = path;
+            if (cache->load(key, cached)) {
+                TALE_PROFILE_COUNT("compile.cache_hits", 1);
+                return cached;
+            }
+        }
+
+        CompiledUnit unit = compile_source(path, source, effects);
+        if (cache) cache->store(key, unit);
+        return unit;
+    }
+
+    ProjectBuild build_project(const std::vector<std::string>& paths,
+        const ProjectOptions& options,
+        Diagnostics& diagnostics) {
+
+        std::unique_ptr<BuildCache> cache;
+        if (!options.cache_dir.empty()) cache = std::make_unique<BuildCache>(options.cache_dir);
+        const dsl::EffectTable& effects = options.effects ? *options.effects : dsl::EffectTable::builtins();
+
+        // Each worker writes only its own slots, so no locking is needed and the
+        // final order is the input order regardless of scheduling. Diagnostics
+        // go to a child buffer per unit, merged into `diagnostics` in input
+        // order while linking.
+        std::vector<CompiledUnit> units(paths.size());
+        std::vector<Diagnostics> unit_diagnostics(paths.size(), diagnostics.child());
+        std::atomic<std::size_t> next{ 0 };
+        auto worker = [&]() {
+            for (std::size_t i = next++; i < paths.size(); i = next++) {
+                units[i] = load_or_compile(paths[i], cache.get(), effects);
+                for (auto& d : units[i].diagnostics) unit_diagnostics[i].add(std::move(d));
+                units[i].diagnostics.clear();
+            }
+        };
+
+        unsigned jobs = options.jobs ? options.jobs : std::thread::hardware_concurrency();
+        jobs = std::max(1u, std::min<unsigned>(jobs, static_cast<unsigned>(paths.size())));
+
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < jobs; ++t) threads.emplace_back(worker);
+        worker();
+        for (auto& t : threads) t.join();
+
+        // Link
+        ProjectBuild build;
+        for (std::size_t i = 0; i < units.size(); ++i) {
+            CompiledUnit& unit = units[i];
+            if (unit.from_cache) build.cache_hits++;
+            else build.compiled++;
+
+            diagnostics.merge(std::move(unit_diagnostics[i]));
+            if (options.references) options.references->update_file(unit.path, unit.ast);
+            for (auto& scene : unit.ast.scenes) build.linked.scenes.push_back(std::move(scene));
+        }
+        return build;
+    }
+
+} // namespace tale_engine::compile
@@ -0,0 +1,69 @@
+#include "tale_engine/compile/scene_reader.h"
+
+#include "tale_engine/profile.h"
+
+namespace tale_engine::compile {
+
+    SceneReader::SceneReader(std::size_t cache_bytes) : cache_bytes_(cache_bytes) {
+    }
+
+    bool SceneReader::open(std::string_view bytes) {
+        bytes_ = {};
+        by_id_.clear();
+        blocks_.clear();
+        stats_ = CacheStats{};
+        if (!read_scene_table(bytes, table_)) return false;
+
+        bytes_ = bytes;
+        by_id_.reserve(table_.scenes.size());
+        for (std::size_t i = 0; i < table_.scenes.size(); ++i) {
+            const auto& e = table_.scenes[i];
+            // First declaration in source order wins, as in validation.
+            auto [it, inserted] = by_id_.try_emplace(e.id, i);
+            if (!inserted && e.source_index < table_.scenes[it->second].source_index) it->second = i;
+        }
+        return true;
+    }
+
+    std::size_t SceneReader::find(std::string_view id) const {
+        auto it = by_id_.find(id);
+        return it == by_id_.end() ? table_.scenes.size() : it->second;
+    }
+
+    const SceneReader::Block* SceneReader::fetch(std::size_t stored_index) {
+        auto it = blocks_.find(stored_index);
+        if (it != blocks_.end()) {
+            stats_.hits++;
+            it->second.last_use = ++clock_;
+            return &it->second;
+        }
+        stats_.misses++;
+
+        Block block;
+        if (!read_record(bytes_, table_, stored_index, block.data)) return nullptr;
+        block.last_use = ++clock_;
+
+        // Evict least recently used blocks; the new one stays even if it
+        // alone exceeds the budget.
+        while (!blocks_.empty() && stats_.bytes + block.data.size() > cache_bytes_) {
+            auto oldest = blocks_.begin();
+            for (auto b = blocks_.begin(); b != blocks_.end(); ++b) {
+                if (b->second.last_use < oldest->second.last_use) oldest = b;
+            }
+            stats_.bytes -= oldest->second.data.size();
+            blocks_.erase(oldest);
+        }
+        stats_.bytes += block.data.size();
+        return &blocks_.emplace(stored_index, std::move(block)).first->second;
+    }
+
+    bool SceneReader::decode(std::size_t stored_index, dsl::SceneAst& out) {
+        TALE_PROFILE_SCOPE("SceneReader::decode");
+        if (stored_index >= table_.scenes.size()) return false;
+        if (!table_.compressed) return decode_scene(bytes_, table_, stored_index, out);
+
+        const Block* block = fetch(stored_index);
+        return block && decode_record(block->data, table_, stored_index, out);
+    }
+
+} // namespace tale_engine::compile
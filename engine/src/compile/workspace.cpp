@@ -0,0 +1,429 @@
+#include "tale_engine/compile/workspace.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+#include "tale_engine/compile/build_cache.h"
+#include "tale_engine/hash.h"
+#include "tale_engine/profile.h"
+
+namespace tale_engine::compile {
+
+    namespace {
+
+        bool is_ident_char(char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        }
+
+        bool same(const std::vector<Diagnostic>& a, const std::vector<Diagnostic>& b) {
+            return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Diagnostic& x, const Diagnostic& y) {
+                return x.severity == y.severity && x.pos.line == y.pos.line && x.pos.column == y.pos.column &&
+                    x.pos.file == y.pos.file && x.message == y.message;
+            });
+        }
+
+        std::uint64_t hash_diagnostics(const std::vector<Diagnostic>& diags) {
+            std::uint64_t h = kFnvOffset64;
+            for (const auto& d : diags) {
+                h = hash_combine(h, static_cast<std::uint64_t>(d.severity));
+                h = hash_combine(h, static_cast<std::uint64_t>(d.pos.line));
+                h = hash_combine(h, static_cast<std::uint64_t>(d.pos.column));
+                h = hash_combine(h, fnv1a64(d.message));
+            }
+            return hash_combine(h, diags.size());
+        }
+
+        // Line `line` (1-based) of `text`, without its line break.
+        std::string_view line_of(std::string_view text, int line) {
+            std::size_t start = 0;
+            for (int i = 1; i < line; ++i) {
+                start = text.find('\n', start);
+                if (start == std::string_view::npos) return {};
+                start++;
+            }
+            std::size_t end = text.find('\n', start);
+            if (end == std::string_view::npos) end = text.size();
+            if (end > start && text[end - 1] == '\r') end--;
+            return text.substr(start, end - start);
+        }
+
+    } // namespace
+
+    struct Workspace::Document {
+        struct ChoiceNode {
+            std::uint32_t scene;
+            const dsl::ChoiceAst* choice;
+        };
+
+        std::string path;
+        std::string text;
+        std::uint64_t serial = 0; // link order
+
+        dsl::FileAst ast;
+        std::vector<SceneNode> scenes; // parallel to ast.scenes
+        std::vector<Edge> edges;
+        std::vector<ChoiceNode> choices_without_goto;
+
+        std::vector<Diagnostic> parse_diagnostics;
+        std::vector<Issue> issues;     // project checks, as of the last update
+        std::vector<Diagnostic> lints; // reference lints located here
+        std::vector<Diagnostic> diagnostics;
+        std::uint64_t diagnostics_hash = 0;
+        std::uint64_t shape = 0; // hash of scene names and goto targets; 0 before the first parse
+
+        bool dirty = true;   // text changed since the last update
+        bool removed = false;
+        bool rebuild = true; // diagnostics must be rebuilt
+    };
+
+    Workspace::Workspace(analysis::ValidateOptions options, const dsl::EffectTable& effects)
+        : options_(std::move(options)), effects_(&effects) {
+    }
+
+    Workspace::~Workspace() = default;
+
+    Workspace::Document* Workspace::find(std::string_view path) {
+        auto it = by_path_.find(path);
+        return it == by_path_.end() ? nullptr : it->second;
+    }
+
+    const Workspace::Document* Workspace::find(std::string_view path) const {
+        auto it = by_path_.find(path);
+        return it == by_path_.end() ? nullptr : it->second;
+    }
+
+    bool Workspace::set_document(const std::string& path, std::string text) {
+        Document* doc = find(path);
+        if (!doc) {
+            documents_.push_back(std::make_unique<Document>());
+            doc = documents_.back().get();
+            doc->path = path;
+            doc->serial = next_serial_++;
+            by_path_.emplace(path, doc);
+        }
+        else if (!doc->removed && doc->text == text) {
+            return false;
+        }
+        doc->text = std::move(text);
+        doc->removed = false;
+        doc->dirty = true;
+        return true;
+    }
+
+    bool Workspace::remove_document(const std::string& path) {
+        Document* doc = find(path);
+        if (!doc || doc->removed) return false;
+        doc->text.clear();
+        doc->removed = true;
+        doc->dirty = true;
+        return true;
+    }
+
+    const std::string* Workspace::text(std::string_view path) const {
+        const Document* doc = find(path);
+        return doc && !doc->removed ? &doc->text : nullptr;
+    }
+
+    std::size_t Workspace::scene_count() const {
+        std::size_t n = 0;
+        for (const auto& doc : documents_) n += doc->scenes.size();
+        return n;
+    }
+
+    std::span<const Diagnostic> Workspace::diagnostics(std::string_view path) const {
+        const Document* doc = find(path);
+        return doc ? std::span<const Diagnostic>(doc->diagnostics) : std::span<const Diagnostic>();
+    }
+
+    Workspace::NameId Workspace::intern(std::string_view name) {
+        auto it = name_ids_.find(name);
+        if (it != name_ids_.end()) return it->second;
+        const auto id = static_cast<NameId>(names_.size());
+        it = name_ids_.emplace(std::string(name), id).first;
+        names_.push_back(it->first);
+        definitions_.emplace_back();
+        first_.push_back(Definition{ nullptr, 0 });
+        return id;
+    }
+
+    // Drops the document's scenes from the definition lists.
+    void Workspace::unregister(Document& doc) {
+        for (const auto& scene : doc.scenes) {
+            auto& defs = definitions_[scene.name];
+            std::erase_if(defs, [&](const Definition& d) { return d.doc == &doc; });
+            first_[scene.name] = defs.empty() ? Definition{ nullptr, 0 } : defs.front();
+        }
+        doc.scenes.clear();
+        doc.edges.clear();
+        doc.choices_without_goto.clear();
+    }
+
+    void Workspace::parse(Document& doc) {
+        CompiledUnit unit = compile_source(doc.path, doc.text, *effects_);
+        references_.update_file(doc.path, unit.ast);
+        doc.ast = std::move(unit.ast);
+        doc.parse_diagnostics = std::move(unit.diagnostics);
+
+        // Same edges as analysis::SceneGraph: every goto in the body, top
+        // level and inside choices, in source order.
+        doc.scenes.reserve(doc.ast.scenes.size());
+        for (std::uint32_t i = 0; i < doc.ast.scenes.size(); ++i) {
+            const auto& scene = doc.ast.scenes[i];
+            SceneNode node{ intern(scene.id), static_cast<std::uint32_t>(doc.edges.size()), 0 };
+            for (const auto& stmt : scene.body) {
+                if (const auto* g = std::get_if<dsl::GotoStmtAst>(&stmt)) {
+                    doc.edges.push_back(Edge{ intern(g->target_scene_id), g });
+                }
+                else if (const auto* ch = std::get_if<dsl::ChoiceAst>(&stmt)) {
+                    bool has_goto = false;
+                    for (const auto& cs : ch->body) {
+                        if (const auto* cg = std::get_if<dsl::GotoStmtAst>(&cs)) {
+                            doc.edges.push_back(Edge{ intern(cg->target_scene_id), cg });
+                            has_goto = true;
+                        }
+                    }
+                    if (!has_goto) doc.choices_without_goto.push_back(Document::ChoiceNode{ i, ch });
+                }
+            }
+            node.edge_count = static_cast<std::uint32_t>(doc.edges.size()) - node.first_edge;
+            doc.scenes.push_back(node);
+
+            // Keep definitions in link order: by document, then by scene.
+            auto& defs = definitions_[node.name];
+            const auto at = std::upper_bound(defs.begin(), defs.end(), doc.serial,
+                [](std::uint64_t serial, const Definition& d) { return serial < d.doc->serial; });
+            defs.insert(at, Definition{ &doc, i });
+            first_[node.name] = defs.front();
+        }
+
+        std::uint64_t shape = hash_combine(kFnvOffset64, doc.scenes.size());
+        for (const auto& scene : doc.scenes) shape = hash_combine(hash_combine(shape, scene.name), scene.edge_count);
+        for (const auto& edge : doc.edges) shape = hash_combine(shape, edge.target);
+        doc.shape = shape | 1;
+    }
+
+    std::vector<std::string> Workspace::update() {
+        TALE_PROFILE_SCOPE("Workspace::update");
+        std::vector<std::string> changed;
+
+        bool any = false;
+        bool reshaped = false;
+        for (auto& doc : documents_) {
+            if (!doc->dirty) continue;
+            any = true;
+            doc->dirty = false;
+            doc->rebuild = true;
+            const std::uint64_t shape = doc->shape;
+            unregister(*doc);
+            doc->ast.scenes.clear();
+            doc->parse_diagnostics.clear();
+            if (doc->removed) references_.remove_file(doc->path);
+            else parse(*doc);
+            reshaped = reshaped || doc->removed || doc->shape != shape;
+        }
+        if (!any) return changed;
+
+        for (const auto& doc : documents_) {
+            if (!doc->removed) continue;
+            if (!doc->diagnostics.empty()) changed.push_back(doc->path);
+            by_path_.erase(doc->path);
+        }
+        std::erase_if(documents_, [](const auto& doc) { return doc->removed; });
+
+        check_project(reshaped);
+
+        for (auto& doc : documents_) {
+            if (!doc->rebuild) continue;
+            doc->rebuild = false;
+            build_diagnostics(*doc);
+            const std::uint64_t h = hash_diagnostics(doc->diagnostics);
+            if (h != doc->diagnostics_hash) changed.push_back(doc->path);
+            doc->diagnostics_hash = h;
+        }
+        return changed;
+    }
+
+    // Mirrors analysis::validate() followed by lint_references() on the
+    // linked project, with the validator's own check selection and
+    // diagnostics. Marks documents whose results changed for rebuild.
+    //
+    // Unless some document's scene graph shape changed, reachability and
+    // every other document's checks are as before, so only the documents
+    // parsed in this update (those marked for rebuild) are checked again.
+    void Workspace::check_project(bool reshaped) {
+        TALE_PROFILE_SCOPE("Workspace::check_project");
+
+        bool start_changed = false;
+        if (reshaped) {
+            std::vector<Diagnostic> project;
+
+            // Start scene: the first scene in link order unless configured.
+            NameId start = kNoName;
+            for (const auto& doc : documents_) {
+                if (doc->scenes.empty()) continue;
+                start = doc->scenes.front().name;
+                break;
+            }
+            const bool has_scenes = start != kNoName;
+            if (!has_scenes) {
+                if (!documents_.empty()) project.push_back(analysis::no_scenes_error());
+            }
+            else if (!options_.start_scene.empty()) {
+                auto it = name_ids_.find(options_.start_scene);
+                start = it != name_ids_.end() && first_[it->second].doc ? it->second : kNoName;
+                if (start == kNoName) project.push_back(analysis::missing_start_error(options_.start_scene));
+            }
+            start_changed = start != start_;
+            start_ = start;
+
+            // Breadth-first search over scene names; a name's edges are those
+            // of its first definition.
+            checks_ = analysis::enabled_checks(options_, has_scenes, start_ != kNoName);
+            reached_.clear();
+            if (checks_.unreachable) {
+                reached_.assign(names_.size(), 0);
+                std::vector<NameId> queue;
+                queue.reserve(names_.size());
+                queue.push_back(start_);
+                reached_[start_] = 1;
+                for (std::size_t head = 0; head < queue.size(); ++head) {
+                    const Definition& def = first_[queue[head]];
+                    const SceneNode& node = def.doc->scenes[def.scene];
+                    for (std::uint32_t e = node.first_edge; e < node.first_edge + node.edge_count; ++e) {
+                        const NameId target = def.doc->edges[e].target;
+                        if (!reached_[target] && first_[target].doc) {
+                            reached_[target] = 1;
+                            queue.push_back(target);
+                        }
+                    }
+                }
+            }
+
+            const Document* project_doc = documents_.empty() ? nullptr : documents_.front().get();
+            if (!same(project, project_diagnostics_) || project_doc != project_doc_) {
+                project_diagnostics_ = std::move(project);
+                project_doc_ = project_doc;
+                if (!documents_.empty()) documents_.front()->rebuild = true;
+            }
+        }
+
+        std::vector<Issue> issues;
+        for (auto& doc : documents_) {
+            if (!reshaped && !doc->rebuild) continue;
+            issues.clear();
+            if (checks_.scene_ids) {
+                for (std::uint32_t i = 0; i < doc->scenes.size(); ++i) {
+                    const Definition& first = first_[doc->scenes[i].name];
+                    if (first.doc != doc.get() || first.scene != i) issues.push_back(Issue{ IssueKind::Duplicate, i });
+                }
+                for (std::uint32_t e = 0; e < doc->edges.size(); ++e) {
+                    if (!first_[doc->edges[e].target].doc) issues.push_back(Issue{ IssueKind::Unresolved, e });
+                }
+            }
+            if (checks_.unreachable) {
+                for (std::uint32_t i = 0; i < doc->scenes.size(); ++i) {
+                    const Definition& first = first_[doc->scenes[i].name];
+                    const bool duplicate = first.doc != doc.get() || first.scene != i;
+                    if (analysis::reports_unreachable(reached_[doc->scenes[i].name] != 0, duplicate)) {
+                        issues.push_back(Issue{ IssueKind::Unreachable, i });
+                    }
+                }
+            }
+            if (checks_.choices_without_goto) {
+                for (std::uint32_t c = 0; c < doc->choices_without_goto.size(); ++c) issues.push_back(Issue{ IssueKind::NoGoto, c });
+            }
+            if (checks_.dead_ends) {
+                for (std::uint32_t i = 0; i < doc->scenes.size(); ++i) {
+                    const SceneNode& node = doc->scenes[i];
+                    bool resolved = false;
+                    for (std::uint32_t e = node.first_edge; !resolved && e < node.first_edge + node.edge_count; ++e) {
+                        resolved = first_[doc->edges[e].target].doc != nullptr;
+                    }
+                    if (!resolved) issues.push_back(Issue{ IssueKind::DeadEnd, i });
+                }
+            }
+
+            // Unreachable messages name the start scene.
+            const bool names_start = start_changed &&
+                std::any_of(issues.begin(), issues.end(), [](const Issue& is) { return is.kind == IssueKind::Unreachable; });
+            if (issues != doc->issues || names_start) {
+                doc->issues = issues;
+                doc->rebuild = true;
+            }
+        }
+
+        // Reference lints depend on every file; they are cheap to rerun from
+        // the index and only documents whose lints differ are rebuilt.
+        Diagnostics lint;
+        analysis::lint_references(references_, lint);
+        std::unordered_map<const Document*, std::vector<Diagnostic>> lints;
+        for (const auto& d : lint.all()) {
+            if (const Document* doc = find(d.pos.file)) lints[doc].push_back(d);
+        }
+        for (auto& doc : documents_) {
+            auto it = lints.find(doc.get());
+            std::vector<Diagnostic> mine = it != lints.end() ? std::move(it->second) : std::vector<Diagnostic>();
+            if (!same(mine, doc->lints)) {
+                doc->lints = std::move(mine);
+                doc->rebuild = true;
+            }
+        }
+    }
+
+    void Workspace::build_diagnostics(Document& doc) const {
+        doc.diagnostics = doc.parse_diagnostics;
+        if (&doc == project_doc_) doc.diagnostics.insert(doc.diagnostics.end(), project_diagnostics_.begin(), project_diagnostics_.end());
+
+        const auto& scenes = doc.ast.scenes;
+        for (const Issue& issue : doc.issues) {
+            switch (issue.kind) {
+            case IssueKind::Duplicate:
+                doc.diagnostics.push_back(analysis::duplicate_scene_error(scenes[issue.at]));
+                break;
+            case IssueKind::Unresolved:
+                doc.diagnostics.push_back(analysis::unresolved_goto_error(*doc.edges[issue.at].stmt));
+                break;
+            case IssueKind::Unreachable:
+                doc.diagnostics.push_back(analysis::unreachable_scene_warning(scenes[issue.at], names_[start_]));
+                break;
+            case IssueKind::NoGoto: {
+                const auto& c = doc.choices_without_goto[issue.at];
+                doc.diagnostics.push_back(analysis::choice_without_goto_warning(*c.choice, scenes[c.scene].id));
+                break;
+            }
+            case IssueKind::DeadEnd:
+                doc.diagnostics.push_back(analysis::dead_end_warning(scenes[issue.at]));
+                break;
+            }
+        }
+        doc.diagnostics.insert(doc.diagnostics.end(), doc.lints.begin(), doc.lints.end());
+    }
+
+    std::optional<Workspace::Symbol> Workspace::symbol_at(std::string_view path, int line, int column) const {
+        const Document* doc = find(path);
+        if (!doc || doc->removed || line < 1 || column < 1) return std::nullopt;
+
+        const std::string_view text = line_of(doc->text, line);
+        std::size_t begin = std::min(static_cast<std::size_t>(column - 1), text.size());
+        std::size_t end = begin;
+        while (begin > 0 && is_ident_char(text[begin - 1])) begin--;
+        while (end < text.size() && is_ident_char(text[end])) end++;
+        if (begin == end) return std::nullopt;
+        const std::string_view name = text.substr(begin, end - begin);
+
+        // {flag} and {#item} placeholders; their sites are the text block.
+        if (end < text.size() && text[end] == '}') {
+            if (begin >= 2 && text[begin - 1] == '#' && text[begin - 2] == '{') return Symbol{ analysis::SymbolKind::Item, std::string(name) };
+            if (begin >= 1 && text[begin - 1] == '{') return Symbol{ analysis::SymbolKind::Flag, std::string(name) };
+        }
+
+        for (const auto kind : { analysis::SymbolKind::Scene, analysis::SymbolKind::Flag, analysis::SymbolKind::Item, analysis::SymbolKind::Stat }) {
+            for (const auto& site : references_.find(kind, name)) {
+                if (site.line == line && references_.file_name(site.file) == path) return Symbol{ kind, std::string(name) };
+            }
+        }
+        return std::nullopt;
+    }
+
+} // namespace tale_engine::compile
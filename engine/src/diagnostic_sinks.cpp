@@ -0,0 +1,73 @@
+#include "tale_engine/diagnostic_sinks.h"
+
+#include <utility>
+
+#include "tale_engine/json.h"
+#include "tale_engine/version.h"
+
+namespace tale_engine {
+
+    void TextSink::write(const Diagnostic& d) {
+        out_ << d.pos.file << ":" << d.pos.line << ":" << d.pos.column
+            << " " << to_string(d.severity) << ": " << d.message << "\n";
+    }
+
+    void JsonLinesSink::write(const Diagnostic& d) {
+        out_ << "{\"severity\":\"" << to_string(d.severity) << "\",\"file\":";
+        write_json_string(out_, d.pos.file);
+        out_ << ",\"line\":" << d.pos.line << ",\"column\":" << d.pos.column << ",\"message\":";
+        write_json_string(out_, d.message);
+        out_ << "}\n";
+        out_.flush();
+    }
+
+    SarifSink::SarifSink(std::ostream& out, std::string tool_name)
+        : out_(out), tool_name_(std::move(tool_name)) {
+    }
+
+    SarifSink::~SarifSink() {
+        finish();
+    }
+
+    void SarifSink::begin() {
+        if (started_) return;
+        started_ = true;
+        out_ << "{\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\",\"version\":\"2.1.0\","
+            << "\"runs\":[{\"tool\":{\"driver\":{\"name\":";
+        write_json_string(out_, tool_name_);
+        out_ << ",\"version\":\"" << kVersionMajor << "." << kVersionMinor << "." << kVersionPatch << "\"}},"
+            << "\"results\":[\n";
+    }
+
+    void SarifSink::write(const Diagnostic& d) {
+        begin();
+
+        // SARIF levels: error / warning / note.
+        const char* level = d.severity == Severity::Error ? "error"
+            : d.severity == Severity::Warning ? "warning" : "note";
+
+        if (!first_) out_ << ",\n";
+        first_ = false;
+        out_ << "{\"level\":\"" << level << "\",\"message\":{\"text\":";
+        write_json_string(out_, d.message);
+        out_ << "},\"locations\":[{\"physicalLocation\":{\"artifactLocation\":{\"uri\":";
+        write_json_string(out_, d.pos.file);
+        out_ << "},\"region\":{\"startLine\":" << d.pos.line << ",\"startColumn\":" << d.pos.column << "}}}]}";
+    }
+
+    void SarifSink::finish() {
+        if (finished_) return;
+        finished_ = true;
+        begin(); // an empty run is still a valid log
+        out_ << "\n]}]}\n";
+        out_.flush();
+    }
+
+    std::unique_ptr<DiagnosticSink> make_sink(std::string_view format, std::ostream& out, std::string tool_name) {
+        if (format == "text") return std::make_unique<TextSink>(out);
+        if (format == "jsonl") return std::make_unique<JsonLinesSink>(out);
+        if (format == "sarif") return std::make_unique<SarifSink>(out, std::move(tool_name));
+        return nullptr;
+    }
+
+} // namespace tale_engine
@@ -1,26 +1,72 @@
 #include "tale_engine/diagnostics.h"
 
+#include <utility>
+
+#include "tale_engine/hash.h"
+
 namespace tale_engine {
 
+    Diagnostics::Diagnostics(DiagnosticsOptions options) : options_(options) {
+    }
+
     void Diagnostics::error(SourcePos pos, std::string message) {
-        diags_.push_back(Diagnostic{ Severity::Error, std::move(pos), std::move(message) });
+        add(Diagnostic{ Severity::Error, std::move(pos), std::move(message) });
     }
 
     void Diagnostics::warning(SourcePos pos, std::string message) {
-        diags_.push_back(Diagnostic{ Severity::Warning, std::move(pos), std::move(message) });
+        add(Diagnostic{ Severity::Warning, std::move(pos), std::move(message) });
+    }
+
+    void Diagnostics::info(SourcePos pos, std::string message) {
+        add(Diagnostic{ Severity::Info, std::move(pos), std::move(message) });
+    }
+
+    std::size_t Diagnostics::SeenKeyHash::operator()(const SeenKey& key) const {
+        std::uint64_t h = fnv1a64(key.message);
+        h = hash_combine(h, fnv1a64(key.file));
+        h = hash_combine(h, static_cast<std::uint64_t>(key.line));
+        h = hash_combine(h, static_cast<std::uint64_t>(key.column));
+        h = hash_combine(h, static_cast<std::uint64_t>(key.severity));
+        return static_cast<std::size_t>(h);
     }
 
-    bool Diagnostics::has_errors() const {
-        for (const auto& d : diags_) {
-            if (d.severity == Severity::Error) return true;
+    void Diagnostics::add(Diagnostic diagnostic) {
+        if (options_.deduplicate) {
+            SeenKey key{ diagnostic.severity, diagnostic.pos.file, diagnostic.pos.line, diagnostic.pos.column,
+                         diagnostic.message };
+            if (!seen_.insert(std::move(key)).second) return;
         }
-        return false;
+
+        const auto sev = static_cast<std::size_t>(diagnostic.severity);
+        counts_[sev]++;
+
+        if (options_.max_per_severity != 0 && kept_[sev] >= options_.max_per_severity) {
+            suppressed_++;
+            return;
+        }
+        kept_[sev]++;
+
+        if (sink_) sink_->write(diagnostic);
+        if (options_.retain) diags_.push_back(std::move(diagnostic));
     }
 
     const std::vector<Diagnostic>& Diagnostics::all() const {
         return diags_;
     }
 
+    Diagnostics Diagnostics::child() const {
+        DiagnosticsOptions opts = options_;
+        // Children must keep everything so the parent can filter on merge.
+        opts.retain = true;
+        opts.max_per_severity = 0;
+        return Diagnostics(opts);
+    }
+
+    void Diagnostics::merge(Diagnostics&& other) {
+        for (auto& d : other.diags_) add(std::move(d));
+        other.diags_.clear();
+    }
+
     std::string to_string(Severity s) {
         switch (s) {
         case Severity::Error: return "error";
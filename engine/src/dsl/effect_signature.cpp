@@ -0,0 +1,41 @@
+#include "tale_engine/dsl/effect_signature.h"
+
+namespace tale_engine::dsl {
+
+    static_assert(kBuiltinEffectTable.slots[effect_hash::hash("set_flag", kBuiltinEffectTable.seed) & (BuiltinEffectTable::kSlots - 1)] == SetFlag);
+    static_assert(kBuiltinEffectTable.slots[effect_hash::hash("give_item", kBuiltinEffectTable.seed) & (BuiltinEffectTable::kSlots - 1)] == GiveItem);
+    static_assert(kBuiltinEffectTable.slots[effect_hash::hash("take_item", kBuiltinEffectTable.seed) & (BuiltinEffectTable::kSlots - 1)] == TakeItem);
+
+    EffectTable::EffectTable()
+        : sigs_(kBuiltinEffects.begin(), kBuiltinEffects.end()),
+          slots_(kBuiltinEffectTable.slots.begin(), kBuiltinEffectTable.slots.end()),
+          seed_(kBuiltinEffectTable.seed) {}
+
+    EffectId EffectTable::add(const EffectSignature& sig) {
+        if (sig.arity > kMaxEffectArgs || find(sig.name) != kNoEffect) return kNoEffect;
+        sigs_.push_back(sig);
+
+        std::vector<EffectId> slots(effect_hash::table_size(sigs_.size()));
+        std::uint64_t seed = 0;
+        while (!effect_hash::place(sigs_, seed, slots)) seed++;
+        slots_ = std::move(slots);
+        seed_ = seed;
+        return static_cast<EffectId>(sigs_.size() - 1);
+    }
+
+    std::uint64_t EffectTable::fingerprint() const {
+        std::uint64_t h = kFnvOffset64;
+        for (const auto& sig : sigs_) {
+            h = fnv1a64(sig.name, h);
+            h = hash_combine(h, sig.arity);
+            for (std::size_t i = 0; i < sig.arity; ++i) h = hash_combine(h, static_cast<std::uint64_t>(sig.args[i]));
+        }
+        return h;
+    }
+
+    const EffectTable& EffectTable::builtins() {
+        static const EffectTable table;
+        return table;
+    }
+
+} // namespace tale_engine::dsl
@@ -3,10 +3,13 @@
 #include <cctype>
 #include <utility>
 
+#include "tale_engine/profile.h"
+
 namespace tale_engine::dsl {
 
-    Lexer::Lexer(std::string_view source, std::string filename, Diagnostics& diagnostics)
-        : source_(source), filename_(std::move(filename)), diagnostics_(diagnostics) {
+    Lexer::Lexer(std::string_view source, std::string filename, Diagnostics& diagnostics,
+        std::pmr::memory_resource* resource)
+        : source_(source), filename_(std::move(filename)), diagnostics_(diagnostics), tokens_(resource) {
     }
 
     char Lexer::peek() const {
@@ -271,7 +274,8 @@ namespace tale_engine::dsl {
         }
     }
 
-    std::vector<Token> Lexer::lex() {
+    TokenList Lexer::lex() {
+        TALE_PROFILE_SCOPE("Lexer::lex");
         tokens_.clear();
 
         // Handle indentation at the very beginning (top-of-file)
@@ -313,7 +317,7 @@ namespace tale_engine::dsl {
         }
 
         tokens_.push_back(Token{ TokenType::EndOfFile, "", SourcePos{ filename_, line_, column_ } });
-        return tokens_;
+        return std::move(tokens_);
     }
 
 } // namespace tale_engine::dsl
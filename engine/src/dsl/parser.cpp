@@ -3,10 +3,13 @@
 #include <string>
 #include <utility>
 
+#include "tale_engine/dsl/text_template.h"
+#include "tale_engine/profile.h"
+
 namespace tale_engine::dsl {
 
-    Parser::Parser(std::vector<Token> tokens, Diagnostics& diagnostics)
-        : tokens_(std::move(tokens)), diagnostics_(diagnostics) {
+    Parser::Parser(TokenList tokens, Diagnostics& diagnostics, const EffectTable& effects)
+        : tokens_(std::move(tokens)), diagnostics_(diagnostics), effects_(&effects) {
     }
 
     const Token& Parser::peek() const { return tokens_[current_]; }
@@ -57,6 +60,7 @@ namespace tale_engine::dsl {
     }
 
     FileAst Parser::parse_file() {
+        TALE_PROFILE_SCOPE("Parser::parse_file");
         FileAst file;
         skip_newlines();
 
@@ -127,6 +131,11 @@ namespace tale_engine::dsl {
         skip_newlines();
         while (!check(TokenType::Dedent) && !is_at_end()) {
             const Token& line = consume(TokenType::String, "Expected string line inside text block.");
+            if (!is_plain_text(line.lexeme)) {
+                if (const auto parse = parse_template(line.lexeme); parse.error) {
+                    diagnostics_.error(line.pos, parse.error);
+                }
+            }
             tb.lines.push_back(line.lexeme);
             consume(TokenType::Newline, "Expected newline after text line.");
             skip_newlines();
@@ -138,14 +147,19 @@ namespace tale_engine::dsl {
 
     ChoiceAst Parser::parse_choice_block(const Token& kw) {
         const Token& label = consume(TokenType::String, "Expected choice label string.");
-        consume(TokenType::Colon, "Expected ':' after choice label.");
-        consume(TokenType::Newline, "Expected newline after choice header.");
-        consume(TokenType::Indent, "Expected an indented choice body.");
 
         ChoiceAst ch;
         ch.pos = kw.pos;
         ch.label = label.lexeme;
 
+        if (match_ident("if")) {
+            ch.condition = parse_condition();
+        }
+
+        consume(TokenType::Colon, "Expected ':' after choice label.");
+        consume(TokenType::Newline, "Expected newline after choice header.");
+        consume(TokenType::Indent, "Expected an indented choice body.");
+
         skip_newlines();
         while (!check(TokenType::Dedent) && !is_at_end()) {
             if (match_ident("goto")) {
@@ -196,46 +210,183 @@ namespace tale_engine::dsl {
         return s;
     }
 
-    EffectCallAst Parser::parse_effect_call(const Token& nameTok) {
-        if (nameTok.lexeme == "set_flag") {
-            const Token& flag = consume(TokenType::Identifier, "Expected flag name (identifier).");
+    // condition := and_cond ("or" and_cond)*
+    // and_cond  := unary ("and" unary)*
+    // unary     := "not" unary | "(" condition ")" | call
+    ConditionAst Parser::parse_condition() {
+        ConditionAst first = parse_condition_and();
+        if (!check_ident("or")) return first;
+
+        ConditionAst c;
+        c.pos = first.pos;
+        c.op = ConditionOp::Or;
+        c.operands.push_back(std::move(first));
+        while (match_ident("or")) {
+            c.operands.push_back(parse_condition_and());
+        }
+        return c;
+    }
+
+    ConditionAst Parser::parse_condition_and() {
+        ConditionAst first = parse_condition_unary();
+        if (!check_ident("and")) return first;
+
+        ConditionAst c;
+        c.pos = first.pos;
+        c.op = ConditionOp::And;
+        c.operands.push_back(std::move(first));
+        while (match_ident("and")) {
+            c.operands.push_back(parse_condition_unary());
+        }
+        return c;
+    }
+
+    ConditionAst Parser::parse_condition_unary() {
+        if (match_ident("not")) {
+            ConditionAst c;
+            c.pos = previous().pos;
+            c.op = ConditionOp::Not;
+            c.operands.push_back(parse_condition_unary());
+            return c;
+        }
+
+        if (match(TokenType::LParen)) {
+            ConditionAst inner = parse_condition();
+            consume(TokenType::RParen, "Expected ')' after condition.");
+            return inner;
+        }
+
+        if (peek().type == TokenType::Identifier) {
+            const Token& nameTok = tokens_[current_++];
+            consume(TokenType::LParen, "Expected '(' after condition name.");
+            ConditionAst c = parse_condition_call(nameTok);
+            consume(TokenType::RParen, "Expected ')' after condition arguments.");
+            return c;
+        }
+
+        diagnostics_.error(peek().pos, "Expected condition.");
+        ConditionAst c;
+        c.pos = peek().pos;
+        return c;
+    }
+
+    ConditionAst Parser::parse_condition_call(const Token& nameTok) {
+        ConditionAst c;
+        c.pos = nameTok.pos;
+
+        if (nameTok.lexeme == "has_flag") {
+            c.op = ConditionOp::HasFlag;
+            c.name = consume(TokenType::Identifier, "Expected flag name (identifier).").lexeme;
+            return c;
+        }
+
+        if (nameTok.lexeme == "flag_is") {
+            c.op = ConditionOp::FlagEquals;
+            c.name = consume(TokenType::Identifier, "Expected flag name (identifier).").lexeme;
             consume(TokenType::Comma, "Expected ',' after flag name.");
-            ValueAst v = parse_value();
+            c.value = parse_value();
+            return c;
+        }
 
-            EffectSetFlagAst e;
-            e.pos = nameTok.pos;
-            e.name = flag.lexeme;
-            e.value = std::move(v);
-            return e;
+        if (nameTok.lexeme == "has_item") {
+            c.op = ConditionOp::HasItem;
+            c.name = consume(TokenType::Identifier, "Expected item id (identifier).").lexeme;
+            if (match(TokenType::Comma)) {
+                c.qty = parse_int(consume(TokenType::Integer, "Expected quantity (integer)."));
+            }
+            return c;
         }
 
-        if (nameTok.lexeme == "give_item") {
-            const Token& item = consume(TokenType::Identifier, "Expected item id (identifier).");
-            consume(TokenType::Comma, "Expected ',' after item id.");
-            const Token& qtyTok = consume(TokenType::Integer, "Expected quantity (integer).");
+        if (nameTok.lexeme == "stat_at_least") {
+            c.op = ConditionOp::StatAtLeast;
+            c.name = consume(TokenType::Identifier, "Expected stat name (identifier).").lexeme;
+            consume(TokenType::Comma, "Expected ',' after stat name.");
+            const Token& tok = consume(TokenType::Integer, "Expected minimum value (integer).");
+            c.qty = tok.type == TokenType::Integer ? parse_int(tok) : 0;
+            return c;
+        }
 
-            EffectGiveItemAst e;
-            e.pos = nameTok.pos;
-            e.item_id = item.lexeme;
-            e.qty = parse_int(qtyTok);
-            return e;
+        diagnostics_.error(nameTok.pos, "Unknown condition function.");
+        // Recovery: skip to the closing ')'.
+        while (!check(TokenType::RParen) && !check(TokenType::Newline) && !is_at_end()) current_++;
+        return c;
+    }
+
+    // Arguments are parsed by the effect's signature; the built-ins then get
+    // their dedicated nodes, everything else an EffectNativeAst.
+    EffectCallAst Parser::parse_effect_call(const Token& nameTok) {
+        const EffectId id = effects_->find(nameTok.lexeme);
+        if (id == kNoEffect) {
+            diagnostics_.error(nameTok.pos, "Unknown effect function.");
+            // Recovery: skip to the closing ')'.
+            while (!check(TokenType::RParen) && !check(TokenType::Newline) && !is_at_end()) current_++;
+            return EffectGiveItemAst{ nameTok.pos, "", 0 };
         }
 
-        if (nameTok.lexeme == "take_item") {
-            const Token& item = consume(TokenType::Identifier, "Expected item id (identifier).");
-            consume(TokenType::Comma, "Expected ',' after item id.");
-            const Token& qtyTok = consume(TokenType::Integer, "Expected quantity (integer).");
+        const EffectSignature& sig = effects_->signature(id);
+        std::vector<ValueAst> args;
+        args.reserve(sig.arity);
+        for (std::size_t i = 0; i < sig.arity; ++i) {
+            if (i > 0) {
+                switch (sig.args[i - 1]) {
+                case EffectArg::Flag: consume(TokenType::Comma, "Expected ',' after flag name."); break;
+                case EffectArg::Item: consume(TokenType::Comma, "Expected ',' after item id."); break;
+                case EffectArg::Stat: consume(TokenType::Comma, "Expected ',' after stat name."); break;
+                default: consume(TokenType::Comma, "Expected ',' between effect arguments."); break;
+                }
+            }
+            args.push_back(parse_effect_arg(sig.args[i]));
+        }
+        if (check(TokenType::Comma)) {
+            diagnostics_.error(peek().pos, "Too many arguments for effect '" + nameTok.lexeme + "'.");
+            while (!check(TokenType::RParen) && !check(TokenType::Newline) && !is_at_end()) current_++;
+        }
 
-            EffectTakeItemAst e;
+        auto name_arg = [&](std::size_t i) { return std::get<std::string>(std::move(args[i].value)); };
+        auto int_arg = [&](std::size_t i) { return std::get<int>(args[i].value); };
+        switch (id) {
+        case SetFlag:
+            return EffectSetFlagAst{ nameTok.pos, name_arg(0), std::move(args[1]) };
+        case GiveItem:
+            return EffectGiveItemAst{ nameTok.pos, name_arg(0), int_arg(1) };
+        case TakeItem:
+            return EffectTakeItemAst{ nameTok.pos, name_arg(0), int_arg(1) };
+        default: {
+            EffectNativeAst e;
             e.pos = nameTok.pos;
-            e.item_id = item.lexeme;
-            e.qty = parse_int(qtyTok);
+            e.name = nameTok.lexeme;
+            e.arg_kinds.assign(sig.args.begin(), sig.args.begin() + sig.arity);
+            e.args = std::move(args);
             return e;
         }
+        }
+    }
 
-        diagnostics_.error(nameTok.pos, "Unknown effect function.");
-        // Best-effort recovery: parse a value and ignore until ')'
-        return EffectGiveItemAst{ nameTok.pos, "", 0 };
+    ValueAst Parser::parse_effect_arg(EffectArg kind) {
+        ValueAst v;
+        v.pos = peek().pos;
+        switch (kind) {
+        case EffectArg::Flag:
+            v.value = consume(TokenType::Identifier, "Expected flag name (identifier).").lexeme;
+            return v;
+        case EffectArg::Item:
+            v.value = consume(TokenType::Identifier, "Expected item id (identifier).").lexeme;
+            return v;
+        case EffectArg::Stat:
+            v.value = consume(TokenType::Identifier, "Expected stat name (identifier).").lexeme;
+            return v;
+        case EffectArg::Pack:
+            v.value = consume(TokenType::Identifier, "Expected enemy pack id (identifier).").lexeme;
+            return v;
+        case EffectArg::Int: {
+            const Token& tok = consume(TokenType::Integer, "Expected quantity (integer).");
+            v.value = tok.type == TokenType::Integer ? parse_int(tok) : 0;
+            return v;
+        }
+        case EffectArg::Value:
+            break;
+        }
+        return parse_value();
     }
 
     ValueAst Parser::parse_value() {
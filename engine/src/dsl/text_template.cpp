@@ -0,0 +1,86 @@
+#include "tale_engine/dsl/text_template.h"
+
+#include <cctype>
+
+namespace tale_engine::dsl {
+
+    namespace {
+        bool is_identifier(std::string_view s) {
+            if (s.empty()) return false;
+            if (!std::isalpha(static_cast<unsigned char>(s[0])) && s[0] != '_') return false;
+            for (const char c : s) {
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+            }
+            return true;
+        }
+    }
+
+    TemplateParse parse_template(std::string_view line) {
+        TemplateParse r;
+        std::size_t literal_start = 0;
+        std::size_t i = 0;
+
+        auto flush = [&](std::size_t end) {
+            if (end > literal_start) {
+                r.parts.push_back(TemplatePart{ TemplatePartKind::Literal, line.substr(literal_start, end - literal_start) });
+            }
+        };
+
+        while (i < line.size()) {
+            const char c = line[i];
+            if (c != '{' && c != '}') {
+                ++i;
+                continue;
+            }
+
+            // Escaped brace: keep the first one as literal text, drop the second.
+            if (i + 1 < line.size() && line[i + 1] == c) {
+                flush(i + 1);
+                i += 2;
+                literal_start = i;
+                continue;
+            }
+
+            if (c == '}') {
+                r.error = "Unmatched '}' in text; write '}}' for a literal brace.";
+                r.error_offset = i;
+                return r;
+            }
+
+            const std::size_t close = line.find('}', i + 1);
+            if (close == std::string_view::npos) {
+                r.error = "Unclosed '{' in text; write '{{' for a literal brace.";
+                r.error_offset = i;
+                return r;
+            }
+
+            std::string_view name = line.substr(i + 1, close - i - 1);
+            TemplatePartKind kind = TemplatePartKind::Flag;
+            if (!name.empty() && name.front() == '#') {
+                kind = TemplatePartKind::Item;
+                name.remove_prefix(1);
+            }
+            if (!is_identifier(name)) {
+                r.error = "Text placeholder must be {flag} or {#item} with an identifier name.";
+                r.error_offset = i;
+                return r;
+            }
+
+            flush(i);
+            r.parts.push_back(TemplatePart{ kind, name });
+            i = close + 1;
+            literal_start = i;
+        }
+        flush(line.size());
+        return r;
+    }
+
+    bool has_placeholders(std::string_view line) {
+        if (is_plain_text(line)) return false;
+        for (const auto& part : parse_template(line).parts) {
+            if (part.kind != TemplatePartKind::Literal) return true;
+        }
+        return false;
+    }
+
+} // namespace tale_engine::dsl
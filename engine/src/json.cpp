@@ -0,0 +1,267 @@
+#include "tale_engine/json.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace tale_engine {
+
+    namespace {
+        const JsonValue kNull;
+        constexpr int kMaxDepth = 256;
+
+        void append_utf8(std::string& out, std::uint32_t cp) {
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            }
+            else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+            else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+            else {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+    } // namespace
+
+    // Recursive descent over the input; every method returns false on
+    // malformed input.
+    class JsonReader {
+    public:
+        explicit JsonReader(std::string_view text) : text_(text) {}
+
+        bool document(JsonValue& out) {
+            if (!value(out, 0)) return false;
+            skip_ws();
+            return pos_ == text_.size();
+        }
+
+    private:
+        void skip_ws() {
+            while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) pos_++;
+        }
+
+        bool literal(std::string_view word) {
+            if (text_.substr(pos_, word.size()) != word) return false;
+            pos_ += word.size();
+            return true;
+        }
+
+        bool value(JsonValue& out, int depth) {
+            if (depth > kMaxDepth) return false;
+            skip_ws();
+            if (pos_ >= text_.size()) return false;
+            switch (text_[pos_]) {
+            case '{': return object(out, depth);
+            case '[': return array(out, depth);
+            case '"':
+                out.kind_ = JsonValue::Kind::String;
+                return string(out.string_);
+            case 't':
+                out.kind_ = JsonValue::Kind::Bool;
+                out.bool_ = true;
+                return literal("true");
+            case 'f':
+                out.kind_ = JsonValue::Kind::Bool;
+                return literal("false");
+            case 'n':
+                return literal("null");
+            default:
+                return number(out);
+            }
+        }
+
+        bool object(JsonValue& out, int depth) {
+            out.kind_ = JsonValue::Kind::Object;
+            pos_++; // '{'
+            skip_ws();
+            if (pos_ < text_.size() && text_[pos_] == '}') {
+                pos_++;
+                return true;
+            }
+            while (true) {
+                skip_ws();
+                std::string key;
+                if (pos_ >= text_.size() || text_[pos_] != '"' || !string(key)) return false;
+                skip_ws();
+                if (pos_ >= text_.size() || text_[pos_] != ':') return false;
+                pos_++;
+                out.members_.emplace_back(std::move(key), JsonValue());
+                if (!value(out.members_.back().second, depth + 1)) return false;
+                skip_ws();
+                if (pos_ >= text_.size()) return false;
+                if (text_[pos_] == '}') {
+                    pos_++;
+                    return true;
+                }
+                if (text_[pos_++] != ',') return false;
+            }
+        }
+
+        bool array(JsonValue& out, int depth) {
+            out.kind_ = JsonValue::Kind::Array;
+            pos_++; // '['
+            skip_ws();
+            if (pos_ < text_.size() && text_[pos_] == ']') {
+                pos_++;
+                return true;
+            }
+            while (true) {
+                out.items_.emplace_back();
+                if (!value(out.items_.back(), depth + 1)) return false;
+                skip_ws();
+                if (pos_ >= text_.size()) return false;
+                if (text_[pos_] == ']') {
+                    pos_++;
+                    return true;
+                }
+                if (text_[pos_++] != ',') return false;
+            }
+        }
+
+        bool hex4(std::uint32_t& out) {
+            if (pos_ + 4 > text_.size()) return false;
+            out = 0;
+            for (int i = 0; i < 4; ++i) {
+                const char c = text_[pos_++];
+                out <<= 4;
+                if (c >= '0' && c <= '9') out |= static_cast<std::uint32_t>(c - '0');
+                else if (c >= 'a' && c <= 'f') out |= static_cast<std::uint32_t>(c - 'a' + 10);
+                else if (c >= 'A' && c <= 'F') out |= static_cast<std::uint32_t>(c - 'A' + 10);
+                else return false;
+            }
+            return true;
+        }
+
+        bool string(std::string& out) {
+            pos_++; // '"'
+            while (pos_ < text_.size()) {
+                const char c = text_[pos_++];
+                if (c == '"') return true;
+                if (static_cast<unsigned char>(c) < 0x20) return false;
+                if (c != '\\') {
+                    out.push_back(c);
+                    continue;
+                }
+                if (pos_ >= text_.size()) return false;
+                switch (text_[pos_++]) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    std::uint32_t cp = 0;
+                    if (!hex4(cp)) return false;
+                    // Surrogate pair; a lone surrogate becomes U+FFFD.
+                    if (cp >= 0xD800 && cp < 0xDC00 && text_.substr(pos_, 2) == "\\u") {
+                        const std::size_t high_end = pos_;
+                        pos_ += 2;
+                        std::uint32_t low = 0;
+                        if (!hex4(low)) return false;
+                        if (low >= 0xDC00 && low < 0xE000) cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        else pos_ = high_end; // the next escape stands on its own
+                    }
+                    if (cp >= 0xD800 && cp < 0xE000) cp = 0xFFFD;
+                    append_utf8(out, cp);
+                    break;
+                }
+                default: return false;
+                }
+            }
+            return false;
+        }
+
+        bool number(JsonValue& out) {
+            const std::size_t start = pos_;
+            if (pos_ < text_.size() && text_[pos_] == '-') pos_++;
+            auto digits = [&]() {
+                const std::size_t from = pos_;
+                while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') pos_++;
+                return pos_ > from;
+            };
+            if (!digits()) return false;
+            if (pos_ < text_.size() && text_[pos_] == '.') {
+                pos_++;
+                if (!digits()) return false;
+            }
+            if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+                pos_++;
+                if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) pos_++;
+                if (!digits()) return false;
+            }
+            out.kind_ = JsonValue::Kind::Number;
+            out.number_ = std::strtod(std::string(text_.substr(start, pos_ - start)).c_str(), nullptr);
+            return true;
+        }
+
+    private:
+        std::string_view text_;
+        std::size_t pos_ = 0;
+    };
+
+    const JsonValue& JsonValue::operator[](std::string_view key) const {
+        for (const auto& [k, v] : members_) {
+            if (k == key) return v;
+        }
+        return kNull;
+    }
+
+    bool parse_json(std::string_view text, JsonValue& out) {
+        out = JsonValue();
+        if (JsonReader(text).document(out)) return true;
+        out = JsonValue();
+        return false;
+    }
+
+    void write_json(std::ostream& out, const JsonValue& value) {
+        switch (value.kind()) {
+        case JsonValue::Kind::Null: out << "null"; break;
+        case JsonValue::Kind::Bool: out << (value.as_bool() ? "true" : "false"); break;
+        case JsonValue::Kind::Number: {
+            const double n = value.as_number();
+            char buf[32];
+            if (std::nearbyint(n) == n && std::fabs(n) < 1e15) std::snprintf(buf, sizeof(buf), "%.0f", n);
+            else std::snprintf(buf, sizeof(buf), "%.17g", n);
+            out << buf;
+            break;
+        }
+        case JsonValue::Kind::String: write_json_string(out, value.as_string()); break;
+        case JsonValue::Kind::Array: {
+            out.put('[');
+            bool first = true;
+            for (const auto& item : value.items()) {
+                if (!first) out.put(',');
+                first = false;
+                write_json(out, item);
+            }
+            out.put(']');
+            break;
+        }
+        case JsonValue::Kind::Object: {
+            out.put('{');
+            bool first = true;
+            for (const auto& [k, v] : value.members()) {
+                if (!first) out.put(',');
+                first = false;
+                write_json_string(out, k);
+                out.put(':');
+                write_json(out, v);
+            }
+            out.put('}');
+            break;
+        }
+        }
+    }
+
+} // namespace tale_engine
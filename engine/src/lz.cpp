@@ -0,0 +1,261 @@
+#include "tale_engine/lz.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "tale_engine/hash.h"
+
+namespace tale_engine::lz {
+
+    namespace {
+        constexpr int kHashBits = 15;
+        constexpr int kMaxChain = 32; // candidates tried per position
+
+        std::string_view window(std::string_view dictionary) {
+            return dictionary.size() > kMaxOffset ? dictionary.substr(dictionary.size() - kMaxOffset) : dictionary;
+        }
+
+        // Loads are little-endian so output never depends on the platform.
+        std::uint64_t load(const char* p, std::size_t n) {
+            std::uint64_t v = 0;
+            for (std::size_t i = 0; i < n; ++i) v |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(p[i])) << (8 * i);
+            return v;
+        }
+
+        std::uint32_t hash4(const char* p) {
+            return (static_cast<std::uint32_t>(load(p, 4)) * 2654435761u) >> (32 - kHashBits);
+        }
+
+        void put_length(std::string& out, std::size_t v) {
+            while (v >= 255) {
+                out.push_back(static_cast<char>(255));
+                v -= 255;
+            }
+            out.push_back(static_cast<char>(v));
+        }
+
+        void put_sequence(std::string& out, std::string_view literals, std::size_t offset, std::size_t match) {
+            const std::size_t ml = match ? match - kMinMatch : 0;
+            out.push_back(static_cast<char>((std::min<std::size_t>(literals.size(), 15) << 4) | std::min<std::size_t>(ml, 15)));
+            if (literals.size() >= 15) put_length(out, literals.size() - 15);
+            out.append(literals);
+            if (!match) return;
+            out.push_back(static_cast<char>(offset & 0xff));
+            out.push_back(static_cast<char>(offset >> 8));
+            if (ml >= 15) put_length(out, ml - 15);
+        }
+
+        bool get_length(const unsigned char*& ip, const unsigned char* end, std::size_t limit, std::size_t& v) {
+            for (;;) {
+                if (ip == end) return false;
+                const unsigned b = *ip++;
+                v += b;
+                if (v > limit) return false;
+                if (b != 255) return true;
+            }
+        }
+    }
+
+    Compressor::Compressor(std::string_view dictionary)
+        : buf_(window(dictionary)), base_(buf_.size()), dict_head_(std::size_t{ 1 } << kHashBits, -1), dict_prev_(base_, -1),
+          block_head_(std::size_t{ 1 } << kHashBits, 0), block_stamp_(std::size_t{ 1 } << kHashBits, 0) {
+        for (std::size_t i = 0; i + kMinMatch <= base_; ++i) {
+            const std::uint32_t h = hash4(buf_.data() + i);
+            dict_prev_[i] = dict_head_[h];
+            dict_head_[h] = static_cast<std::int32_t>(i);
+        }
+    }
+
+    void Compressor::compress(std::string_view src, std::string& out) {
+        buf_.resize(base_);
+        buf_.append(src);
+        const std::size_t n = buf_.size();
+        block_prev_.assign(src.size(), 0);
+        if (++stamp_ == 0) { // wrapped: forget every stamp
+            std::fill(block_stamp_.begin(), block_stamp_.end(), 0);
+            stamp_ = 1;
+        }
+
+        // Block positions chain through block_prev_ (0 ends a chain, so they
+        // are stored + 1); older candidates come from the dictionary chains.
+        auto insert = [&](std::size_t i) {
+            const std::uint32_t h = hash4(buf_.data() + i);
+            block_prev_[i - base_] = block_stamp_[h] == stamp_ ? block_head_[h] : 0;
+            block_head_[h] = static_cast<std::uint32_t>(i - base_ + 1);
+            block_stamp_[h] = stamp_;
+        };
+
+        std::size_t anchor = base_;
+        std::size_t pos = base_;
+        while (pos + kMinMatch <= n) {
+            std::size_t best = 0;
+            std::size_t best_offset = 0;
+            int depth = 0;
+            auto consider = [&](std::size_t cand) {
+                const char* a = buf_.data() + cand;
+                const char* b = buf_.data() + pos;
+                std::size_t len = 0;
+                while (pos + len < n && a[len] == b[len]) len++;
+                if (len > best) {
+                    best = len;
+                    best_offset = pos - cand;
+                }
+            };
+
+            const std::uint32_t h = hash4(buf_.data() + pos);
+            for (std::uint32_t c = block_stamp_[h] == stamp_ ? block_head_[h] : 0;
+                 c != 0 && pos - (base_ + c - 1) <= kMaxOffset && depth < kMaxChain; c = block_prev_[c - 1], ++depth) {
+                consider(base_ + c - 1);
+            }
+            for (std::int32_t c = dict_head_[h];
+                 c >= 0 && pos - static_cast<std::size_t>(c) <= kMaxOffset && depth < kMaxChain;
+                 c = dict_prev_[static_cast<std::size_t>(c)], ++depth) {
+                consider(static_cast<std::size_t>(c));
+            }
+
+            if (best < kMinMatch) {
+                insert(pos++);
+                continue;
+            }
+            put_sequence(out, std::string_view(buf_).substr(anchor, pos - anchor), best_offset, best);
+            for (const std::size_t end = pos + best; pos < end; ++pos) {
+                if (pos + kMinMatch <= n) insert(pos);
+            }
+            anchor = pos;
+        }
+        put_sequence(out, std::string_view(buf_).substr(anchor), 0, 0);
+    }
+
+    void compress(std::string_view src, std::string_view dictionary, std::string& out) {
+        Compressor(dictionary).compress(src, out);
+    }
+
+    bool decompress(std::string_view src, std::string_view dictionary, char* out, std::size_t size) {
+        dictionary = window(dictionary);
+        const auto* ip = reinterpret_cast<const unsigned char*>(src.data());
+        const auto* end = ip + src.size();
+        std::size_t op = 0;
+
+        for (;;) {
+            if (ip == end) return false;
+            const unsigned token = *ip++;
+
+            std::size_t literals = token >> 4;
+            if (literals == 15 && !get_length(ip, end, size, literals)) return false;
+            if (literals > static_cast<std::size_t>(end - ip) || literals > size - op) return false;
+            std::memcpy(out + op, ip, literals);
+            ip += literals;
+            op += literals;
+            if (ip == end) return op == size;
+
+            if (end - ip < 2) return false;
+            const std::size_t offset = ip[0] | static_cast<std::size_t>(ip[1]) << 8;
+            ip += 2;
+            std::size_t match = token & 15;
+            if (match == 15 && !get_length(ip, end, size, match)) return false;
+            match += kMinMatch;
+            if (offset == 0 || offset > op + dictionary.size() || match > size - op) return false;
+
+            if (offset > op) {
+                // Starts in the dictionary; may run on into the block.
+                const std::size_t back = offset - op;
+                const std::size_t n = std::min(back, match);
+                std::memcpy(out + op, dictionary.data() + dictionary.size() - back, n);
+                op += n;
+                match -= n;
+            }
+            char* dst = out + op;
+            const char* from = dst - offset;
+            if (offset >= match) std::memcpy(dst, from, match);
+            else for (std::size_t i = 0; i < match; ++i) dst[i] = from[i]; // overlapping run
+            op += match;
+        }
+    }
+
+    // A simplified COVER: score 64-byte segments by how many other samples
+    // share their 8-byte substrings, pick greedily, and stop counting a
+    // substring once a picked segment holds it.
+    std::string train_dictionary(std::span<const std::string_view> samples, std::size_t max_size) {
+        constexpr std::size_t kGram = 8;
+        constexpr std::size_t kSegment = 64;
+        constexpr std::size_t kStride = 16;
+        if (max_size == 0 || samples.empty()) return {};
+
+        // Bound training time: look at every step-th sample, ~100x max_size bytes.
+        std::size_t total = 0;
+        for (const auto s : samples) total += s.size();
+        const std::size_t step = std::max<std::size_t>(1, total / (max_size * 100));
+
+        auto gram = [](const char* p) { return mix64(load(p, kGram)); };
+
+        std::unordered_map<std::uint64_t, std::uint32_t> freq; // samples containing each gram
+        std::vector<std::uint64_t> grams;
+        for (std::size_t i = 0; i < samples.size(); i += step) {
+            const auto s = samples[i];
+            grams.clear();
+            for (std::size_t p = 0; p + kGram <= s.size(); ++p) grams.push_back(gram(s.data() + p));
+            std::sort(grams.begin(), grams.end());
+            grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+            for (const auto g : grams) freq[g]++;
+        }
+
+        struct Candidate {
+            std::uint64_t score;
+            std::uint32_t sample;
+            std::uint32_t start;
+            bool operator<(const Candidate& o) const {
+                return score != o.score ? score < o.score : (sample != o.sample ? sample > o.sample : start > o.start);
+            }
+        };
+        auto score = [&](std::string_view seg) {
+            std::uint64_t sum = 0;
+            for (std::size_t p = 0; p + kGram <= seg.size(); ++p) {
+                auto it = freq.find(gram(seg.data() + p));
+                if (it != freq.end() && it->second > 1) sum += it->second - 1;
+            }
+            return sum;
+        };
+        auto segment = [&](const Candidate& c) {
+            const auto s = samples[c.sample];
+            return s.substr(c.start, std::min(kSegment, s.size() - c.start));
+        };
+
+        std::priority_queue<Candidate> queue;
+        for (std::size_t i = 0; i < samples.size(); i += step) {
+            for (std::size_t start = 0; start + kGram <= samples[i].size(); start += kStride) {
+                Candidate c{ 0, static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(start) };
+                c.score = score(segment(c));
+                if (c.score > 0) queue.push(c);
+            }
+        }
+
+        std::vector<std::string_view> picked;
+        std::size_t size = 0;
+        while (!queue.empty() && size < max_size) {
+            Candidate c = queue.top();
+            queue.pop();
+            const std::string_view seg = segment(c);
+            const std::uint64_t now = score(seg);
+            if (now == 0) continue;
+            if (now < c.score && !queue.empty() && now < queue.top().score) {
+                c.score = now; // lazy greedy: re-queue with its current score
+                queue.push(c);
+                continue;
+            }
+            const std::string_view fit = seg.substr(0, std::min(seg.size(), max_size - size));
+            picked.push_back(fit);
+            size += fit.size();
+            for (std::size_t p = 0; p + kGram <= seg.size(); ++p) freq.erase(gram(seg.data() + p));
+        }
+
+        std::string dictionary;
+        dictionary.reserve(size);
+        for (auto it = picked.rbegin(); it != picked.rend(); ++it) dictionary.append(*it);
+        return dictionary;
+    }
+
+} // namespace tale_engine::lz
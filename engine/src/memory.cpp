@@ -0,0 +1,80 @@
+#include "tale_engine/memory.h"
+
+#include <cstdio>
+#include <new>
+
+namespace tale_engine::memory {
+
+    const char* subsystem_name(Subsystem subsystem) {
+        switch (subsystem) {
+        case Subsystem::Lexer: return "lexer";
+        case Subsystem::Interpreter: return "interpreter";
+        case Subsystem::State: return "state";
+        case Subsystem::kCount: break;
+        }
+        return "?";
+    }
+
+    AccountingResource::AccountingResource(std::pmr::memory_resource* upstream, std::size_t limit)
+        : upstream_(upstream), limit_(limit) {
+    }
+
+    void* AccountingResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+        // The limit may have been lowered below what is already live.
+        if (limit_ != 0 && (stats_.live_bytes >= limit_ || bytes > limit_ - stats_.live_bytes)) {
+            stats_.failures++;
+            throw std::bad_alloc();
+        }
+        void* p = nullptr;
+        try {
+            p = upstream_->allocate(bytes, alignment);
+        }
+        catch (...) {
+            stats_.failures++;
+            throw;
+        }
+        stats_.allocations++;
+        stats_.live_bytes += bytes;
+        if (stats_.live_bytes > stats_.peak_bytes) stats_.peak_bytes = stats_.live_bytes;
+        return p;
+    }
+
+    void AccountingResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+        upstream_->deallocate(p, bytes, alignment);
+        stats_.deallocations++;
+        stats_.live_bytes -= bytes;
+    }
+
+    bool AccountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+
+    static_assert(static_cast<std::size_t>(Subsystem::kCount) == 3, "update MemoryAccounting::subsystems_");
+
+    MemoryAccounting::MemoryAccounting(std::size_t session_limit, std::pmr::memory_resource* upstream)
+        : session_(upstream, session_limit),
+          subsystems_{ { AccountingResource(&session_), AccountingResource(&session_), AccountingResource(&session_) } } {
+    }
+
+    void MemoryAccounting::write_report(std::ostream& out) const {
+        char line[256];
+        auto row = [&](const char* name, const MemoryStats& s) {
+            std::snprintf(line, sizeof(line), "%-16s %12zu %12zu %12llu %12llu %8llu\n", name, s.live_bytes, s.peak_bytes,
+                static_cast<unsigned long long>(s.allocations),
+                static_cast<unsigned long long>(s.deallocations),
+                static_cast<unsigned long long>(s.failures));
+            out << line;
+        };
+
+        std::snprintf(line, sizeof(line), "%-16s %12s %12s %12s %12s %8s\n", "subsystem", "live bytes", "peak bytes",
+            "allocs", "frees", "refused");
+        out << line;
+        for (std::size_t i = 0; i < subsystems_.size(); ++i) {
+            row(subsystem_name(static_cast<Subsystem>(i)), subsystems_[i].stats());
+        }
+        row("total", session_.stats());
+        if (session_.limit() != 0) out << "session limit: " << session_.limit() << " bytes of accounted memory\n";
+        out << "not accounted: parsing (AST, parser, token strings), compiled conditions and templates\n";
+    }
+
+} // namespace tale_engine::memory
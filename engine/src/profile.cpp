@@ -0,0 +1,269 @@
+#include "tale_engine/profile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "tale_engine/json.h"
+
+namespace tale_engine::profile {
+
+    namespace detail {
+        std::atomic<bool> g_enabled{ false };
+
+        std::uint64_t now_ns() {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+    }
+
+    namespace {
+        constexpr std::size_t kRingCapacity = std::size_t{ 1 } << 15;
+
+        struct Event {
+            std::uint32_t site;
+            std::uint64_t start_ns;
+            std::uint64_t dur_ns;
+        };
+
+        struct Aggregate {
+            std::uint64_t calls = 0;
+            std::uint64_t total_ns = 0;
+            std::uint64_t max_ns = 0;
+            std::int64_t value = 0; // counters
+        };
+
+        struct ThreadBuffer {
+            std::uint32_t tid = 0;
+            std::vector<Event> ring = std::vector<Event>(kRingCapacity);
+            std::uint64_t written = 0;
+            std::vector<Aggregate> aggregates; // indexed by site id
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<const char*> names;
+            std::vector<SiteKind> kinds;
+            // Buffers outlive their threads so short-lived workers still export.
+            std::vector<std::unique_ptr<ThreadBuffer>> threads;
+            std::uint64_t epoch_ns = detail::now_ns();
+        };
+
+        Registry& registry() {
+            static Registry r;
+            return r;
+        }
+
+        ThreadBuffer& local_buffer() {
+            thread_local ThreadBuffer* buffer = nullptr;
+            if (!buffer) {
+                auto& reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                auto owned = std::make_unique<ThreadBuffer>();
+                owned->tid = static_cast<std::uint32_t>(reg.threads.size());
+                buffer = owned.get();
+                reg.threads.push_back(std::move(owned));
+            }
+            return *buffer;
+        }
+
+        Aggregate& aggregate(ThreadBuffer& tb, std::uint32_t site) {
+            if (site >= tb.aggregates.size()) tb.aggregates.resize(site + 1);
+            return tb.aggregates[site];
+        }
+
+        double to_us(std::uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+    }
+
+    Site::Site(const char* name, SiteKind kind) : name_(name) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        id_ = static_cast<std::uint32_t>(reg.names.size());
+        reg.names.push_back(name);
+        reg.kinds.push_back(kind);
+    }
+
+    namespace detail {
+        void record_scope(const Site& site, std::uint64_t start_ns, std::uint64_t end_ns) {
+            ThreadBuffer& tb = local_buffer();
+            const std::uint64_t dur = end_ns - start_ns;
+            tb.ring[tb.written++ & (kRingCapacity - 1)] = Event{ site.id(), start_ns, dur };
+
+            Aggregate& a = aggregate(tb, site.id());
+            a.calls++;
+            a.total_ns += dur;
+            a.max_ns = std::max(a.max_ns, dur);
+        }
+
+        void record_count(const Site& site, std::int64_t delta) {
+            Aggregate& a = aggregate(local_buffer(), site.id());
+            a.calls++;
+            a.value += delta;
+        }
+    }
+
+    void set_enabled(bool on) {
+        detail::g_enabled.store(on, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (auto& tb : reg.threads) {
+            tb->written = 0;
+            tb->aggregates.clear();
+        }
+        reg.epoch_ns = detail::now_ns();
+    }
+
+    Session::Session(std::string trace_path, std::ostream& summary)
+        : trace_path_(std::move(trace_path)), summary_(summary) {
+        if (trace_path_.empty()) return;
+        if (!kCompiledIn) {
+            summary_ << "warning: profiling was compiled out (TALE_ENGINE_ENABLE_PROFILING=OFF); "
+                << trace_path_ << " will be empty\n";
+        }
+        reset();
+        set_enabled(true);
+    }
+
+    Session::~Session() {
+        if (trace_path_.empty()) return;
+        set_enabled(false);
+
+        std::ofstream out(trace_path_, std::ios::binary | std::ios::trunc);
+        write_chrome_trace(out);
+        if (!out) summary_ << "warning: cannot write profile: " << trace_path_ << "\n";
+        write_summary(summary_);
+    }
+
+    void write_chrome_trace(std::ostream& out) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        bool first = true;
+        auto sep = [&]() {
+            if (!first) out << ",\n";
+            first = false;
+        };
+
+        char ts[64];
+        std::uint64_t last_ns = reg.epoch_ns;
+        for (const auto& tb : reg.threads) {
+            sep();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tb->tid
+                << ",\"args\":{\"name\":\"thread " << tb->tid << "\"}}";
+
+            const std::uint64_t count = std::min<std::uint64_t>(tb->written, kRingCapacity);
+            for (std::uint64_t i = tb->written - count; i < tb->written; ++i) {
+                const Event& e = tb->ring[i & (kRingCapacity - 1)];
+                if (e.start_ns < reg.epoch_ns) continue;
+                last_ns = std::max(last_ns, e.start_ns + e.dur_ns);
+
+                sep();
+                out << "{\"name\":";
+                write_json_string(out, reg.names[e.site]);
+                std::snprintf(ts, sizeof(ts), "%.3f,\"dur\":%.3f", to_us(e.start_ns - reg.epoch_ns), to_us(e.dur_ns));
+                out << ",\"cat\":\"tale\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tb->tid << ",\"ts\":" << ts << "}";
+            }
+        }
+
+        // Counter totals as one sample at the end of the trace.
+        std::snprintf(ts, sizeof(ts), "%.3f", to_us(last_ns - reg.epoch_ns));
+        for (std::size_t site = 0; site < reg.names.size(); ++site) {
+            if (reg.kinds[site] != SiteKind::Counter) continue;
+            std::int64_t total = 0;
+            bool seen = false;
+            for (const auto& tb : reg.threads) {
+                if (site < tb->aggregates.size() && tb->aggregates[site].calls) {
+                    total += tb->aggregates[site].value;
+                    seen = true;
+                }
+            }
+            if (!seen) continue;
+            sep();
+            out << "{\"name\":";
+            write_json_string(out, reg.names[site]);
+            out << ",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":" << ts << ",\"args\":{\"value\":" << total << "}}";
+        }
+        out << "\n]}\n";
+    }
+
+    void write_summary(std::ostream& out) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        struct Row {
+            const char* name;
+            SiteKind kind;
+            Aggregate agg;
+        };
+        std::vector<Row> rows;
+
+        // Sites with the same name (e.g. one macro expanded in several
+        // translation units) are reported together.
+        for (std::size_t site = 0; site < reg.names.size(); ++site) {
+            Aggregate sum;
+            for (const auto& tb : reg.threads) {
+                if (site >= tb->aggregates.size()) continue;
+                const Aggregate& a = tb->aggregates[site];
+                sum.calls += a.calls;
+                sum.total_ns += a.total_ns;
+                sum.max_ns = std::max(sum.max_ns, a.max_ns);
+                sum.value += a.value;
+            }
+            if (sum.calls == 0) continue;
+
+            auto same = std::find_if(rows.begin(), rows.end(), [&](const Row& r) {
+                return r.kind == reg.kinds[site] && std::strcmp(r.name, reg.names[site]) == 0;
+            });
+            if (same == rows.end()) {
+                rows.push_back(Row{ reg.names[site], reg.kinds[site], sum });
+                continue;
+            }
+            same->agg.calls += sum.calls;
+            same->agg.total_ns += sum.total_ns;
+            same->agg.max_ns = std::max(same->agg.max_ns, sum.max_ns);
+            same->agg.value += sum.value;
+        }
+
+        std::stable_sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+            if (a.kind != b.kind) return a.kind < b.kind;
+            return a.agg.total_ns > b.agg.total_ns;
+        });
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-32s %12s %12s %12s %12s\n", "scope", "calls", "total ms", "avg us", "max us");
+        out << line;
+        for (const auto& r : rows) {
+            if (r.kind != SiteKind::Scope) continue;
+            std::snprintf(line, sizeof(line), "%-32s %12llu %12.3f %12.3f %12.3f\n", r.name,
+                static_cast<unsigned long long>(r.agg.calls),
+                static_cast<double>(r.agg.total_ns) / 1e6,
+                to_us(r.agg.total_ns) / static_cast<double>(r.agg.calls),
+                to_us(r.agg.max_ns));
+            out << line;
+        }
+
+        bool header = false;
+        for (const auto& r : rows) {
+            if (r.kind != SiteKind::Counter) continue;
+            if (!header) {
+                std::snprintf(line, sizeof(line), "\n%-32s %12s %12s\n", "counter", "updates", "total");
+                out << line;
+                header = true;
+            }
+            std::snprintf(line, sizeof(line), "%-32s %12llu %12lld\n", r.name,
+                static_cast<unsigned long long>(r.agg.calls), static_cast<long long>(r.agg.value));
+            out << line;
+        }
+    }
+
+} // namespace tale_engine::profile
@@ -0,0 +1,150 @@
+#include "tale_engine/runtime/analytics.h"
+
+#include <string_view>
+
+#include "tale_engine/json.h"
+
+namespace tale_engine::runtime {
+
+    namespace {
+
+        std::string_view effect_name(const dsl::EffectStmtAst& eff) {
+            if (std::holds_alternative<dsl::EffectSetFlagAst>(eff.call)) return dsl::kBuiltinEffects[dsl::SetFlag].name;
+            if (std::holds_alternative<dsl::EffectGiveItemAst>(eff.call)) return dsl::kBuiltinEffects[dsl::GiveItem].name;
+            if (std::holds_alternative<dsl::EffectTakeItemAst>(eff.call)) return dsl::kBuiltinEffects[dsl::TakeItem].name;
+            return std::get<dsl::EffectNativeAst>(eff.call).name;
+        }
+
+        // RFC 4180: quote fields containing separators, quotes or line breaks.
+        void write_csv_field(std::ostream& out, std::string_view s) {
+            if (s.find_first_of(",\"\r\n") == std::string_view::npos) {
+                out << s;
+                return;
+            }
+            out.put('"');
+            for (const char c : s) {
+                if (c == '"') out.put('"');
+                out.put(c);
+            }
+            out.put('"');
+        }
+
+        void sum_into(std::vector<std::uint64_t>& total, const std::vector<std::atomic<std::uint64_t>>& counters) {
+            for (std::size_t i = 0; i < counters.size(); ++i) total[i] += counters[i].load(std::memory_order_relaxed);
+        }
+
+    } // namespace
+
+    Analytics::Analytics(const dsl::FileAst& ast) : ast_(ast) {
+        for (std::size_t s = 0; s < ast_.scenes.size(); ++s) {
+            const auto scene = static_cast<std::uint32_t>(s);
+            for (const auto& stmt : ast_.scenes[s].body) {
+                const auto statement = static_cast<std::uint32_t>(statement_count_++);
+                if (const auto* eff = std::get_if<dsl::EffectStmtAst>(&stmt)) {
+                    effects_.push_back(EffectSite{ eff, scene });
+                }
+                else if (const auto* ch = std::get_if<dsl::ChoiceAst>(&stmt)) {
+                    choices_.push_back(ChoiceSite{ ch, scene, statement });
+                    for (const auto& cs : ch->body) {
+                        if (const auto* ceff = std::get_if<dsl::EffectStmtAst>(&cs)) effects_.push_back(EffectSite{ ceff, scene });
+                    }
+                }
+            }
+        }
+    }
+
+    AnalyticsShard& Analytics::make_shard() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shards_.push_back(std::unique_ptr<AnalyticsShard>(
+            new AnalyticsShard(ast_.scenes.size(), statement_count_, effects_.size())));
+        return *shards_.back();
+    }
+
+    AnalyticsSnapshot Analytics::snapshot() const {
+        AnalyticsSnapshot snap;
+        snap.scene_visits.assign(ast_.scenes.size(), 0);
+        snap.effect_runs.assign(effects_.size(), 0);
+        snap.effect_failures.assign(effects_.size(), 0);
+        std::vector<std::uint64_t> statements(statement_count_, 0);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& shard : shards_) {
+                sum_into(snap.scene_visits, shard->scenes_);
+                sum_into(statements, shard->statements_);
+                sum_into(snap.effect_runs, shard->effects_);
+                sum_into(snap.effect_failures, shard->failures_);
+            }
+        }
+
+        snap.choice_selections.reserve(choices_.size());
+        for (const auto& c : choices_) snap.choice_selections.push_back(statements[c.statement]);
+        return snap;
+    }
+
+    void Analytics::write_csv(std::ostream& out, const AnalyticsSnapshot& snapshot) const {
+        out << "kind,id,scene,label,file,line,count,failures\n";
+        auto row = [&](const char* kind, std::size_t id, std::uint32_t scene, std::string_view label, const SourcePos& pos,
+                       std::uint64_t count) {
+            out << kind << ',' << id << ',';
+            write_csv_field(out, ast_.scenes[scene].id);
+            out << ',';
+            write_csv_field(out, label);
+            out << ',';
+            write_csv_field(out, pos.file);
+            out << ',' << pos.line << ',' << count << ',';
+        };
+
+        for (std::size_t i = 0; i < ast_.scenes.size(); ++i) {
+            row("scene", i, static_cast<std::uint32_t>(i), {}, ast_.scenes[i].pos, snapshot.scene_visits[i]);
+            out << '\n';
+        }
+        for (std::size_t i = 0; i < choices_.size(); ++i) {
+            const auto& c = choices_[i];
+            row("choice", i, c.scene, c.choice->label, c.choice->pos, snapshot.choice_selections[i]);
+            out << '\n';
+        }
+        for (std::size_t i = 0; i < effects_.size(); ++i) {
+            const auto& e = effects_[i];
+            row("effect", i, e.scene, effect_name(*e.effect), e.effect->pos, snapshot.effect_runs[i]);
+            out << snapshot.effect_failures[i] << '\n';
+        }
+    }
+
+    void Analytics::write_json(std::ostream& out, const AnalyticsSnapshot& snapshot) const {
+        auto site = [&](std::uint32_t scene, const SourcePos& pos) {
+            out << "\"scene\":";
+            write_json_string(out, ast_.scenes[scene].id);
+            out << ",\"file\":";
+            write_json_string(out, pos.file);
+            out << ",\"line\":" << pos.line;
+        };
+
+        out << "{\"scenes\":[";
+        for (std::size_t i = 0; i < ast_.scenes.size(); ++i) {
+            out << (i ? ",\n" : "\n") << "{\"id\":" << i << ',';
+            site(static_cast<std::uint32_t>(i), ast_.scenes[i].pos);
+            out << ",\"visits\":" << snapshot.scene_visits[i] << '}';
+        }
+        out << "],\"choices\":[";
+        for (std::size_t i = 0; i < choices_.size(); ++i) {
+            const auto& c = choices_[i];
+            out << (i ? ",\n" : "\n") << "{\"id\":" << i << ',';
+            site(c.scene, c.choice->pos);
+            out << ",\"label\":";
+            write_json_string(out, c.choice->label);
+            out << ",\"selections\":" << snapshot.choice_selections[i] << '}';
+        }
+        out << "],\"effects\":[";
+        for (std::size_t i = 0; i < effects_.size(); ++i) {
+            const auto& e = effects_[i];
+            out << (i ? ",\n" : "\n") << "{\"id\":" << i << ',';
+            site(e.scene, e.effect->pos);
+            out << ",\"effect\":";
+            write_json_string(out, effect_name(*e.effect));
+            out << ",\"runs\":" << snapshot.effect_runs[i] << ",\"failures\":" << snapshot.effect_failures[i] << '}';
+        }
+        out << "]}\n";
+    }
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,619 @@
+#include "tale_engine/runtime/combat.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <ostream>
+#include <thread>
+
+#include "tale_engine/hash.h"
+#include "tale_engine/json.h"
+#include "tale_engine/profile.h"
+#include "tale_engine/runtime/effects.h"
+#include "tale_engine/runtime/rng.h"
+
+namespace tale_engine::runtime {
+
+    namespace {
+        constexpr int kMaxScale = 100000; // damage scaling caps at 1000x
+
+        // Integer CombatantDef fields by their catalog (and stat) names.
+        struct CombatField {
+            std::string_view name;
+            int CombatantDef::*field;
+        };
+        constexpr CombatField kCombatFields[] = {
+            { "max_hp", &CombatantDef::max_hp },
+            { "accuracy", &CombatantDef::accuracy },
+            { "evasion", &CombatantDef::evasion },
+            { "damage_min", &CombatantDef::damage_min },
+            { "damage_max", &CombatantDef::damage_max },
+            { "power", &CombatantDef::power },
+            { "scaling", &CombatantDef::scaling },
+            { "armor", &CombatantDef::armor },
+            { "dexterity", &CombatantDef::dexterity },
+            { "on_hit_chance", &CombatantDef::on_hit_chance },
+            { "on_hit_power", &CombatantDef::on_hit_power },
+            { "on_hit_turns", &CombatantDef::on_hit_turns },
+            { "heals", &CombatantDef::heals },
+            { "heal_amount", &CombatantDef::heal_amount },
+            { "heal_below", &CombatantDef::heal_below },
+        };
+
+        constexpr std::string_view kStatusNames[] = { "none", "poison", "bleed", "stun" };
+
+        int clamp_value(int v) { return std::clamp(v, 0, kMaxCombatValue); }
+
+        // High word of x * bound: uniform in [0, bound) up to a bias below
+        // bound / 2^32, which keeps the kernels free of rejection loops.
+        std::uint32_t scale_to(std::uint32_t x, std::uint32_t bound) {
+            return static_cast<std::uint32_t>((static_cast<std::uint64_t>(x) * bound) >> 32);
+        }
+
+        int percent_roll(std::uint32_t x) { return static_cast<int>(scale_to(x, 100)); }
+
+        // Random blocks of an encounter: round 0 holds the initiative rolls,
+        // round r >= 1 one block per turn slot.
+        std::uint64_t block_index(std::uint32_t round, std::uint32_t slot) {
+            return static_cast<std::uint64_t>(round) * kMaxCombatants + slot;
+        }
+    }
+
+    CombatantId CombatCatalog::add_combatant(CombatantDef def) {
+        const auto id = static_cast<CombatantId>(combatants_.size());
+        if (!combatant_index_.try_emplace(def.id, id).second) return kNoCombatant;
+        combatants_.push_back(std::move(def));
+        return id;
+    }
+
+    PackId CombatCatalog::add_pack(std::string_view id, std::vector<CombatantId> members) {
+        if (members.empty() || members.size() >= kMaxCombatants) return kNoPack;
+        const auto pack = static_cast<PackId>(packs_.size());
+        if (!pack_index_.try_emplace(std::string(id), pack).second) return kNoPack;
+        packs_.push_back(EnemyPack{ std::string(id), std::move(members) });
+        return pack;
+    }
+
+    CombatantId CombatCatalog::find_combatant(std::string_view id) const {
+        auto it = combatant_index_.find(std::string(id));
+        return it == combatant_index_.end() ? kNoCombatant : it->second;
+    }
+
+    PackId CombatCatalog::find_pack(std::string_view id) const {
+        auto it = pack_index_.find(std::string(id));
+        return it == pack_index_.end() ? kNoPack : it->second;
+    }
+
+    bool read_combat_catalog(std::string_view json, const std::string& path, CombatCatalog& out, Diagnostics& diagnostics) {
+        JsonValue doc;
+        if (!parse_json(json, doc) || doc.kind() != JsonValue::Kind::Object) {
+            diagnostics.error(SourcePos{ path, 1, 1 }, "Combat catalog is not a JSON object.");
+            return false;
+        }
+        if (doc["combatants"].kind() != JsonValue::Kind::Array) {
+            diagnostics.error(SourcePos{ path, 1, 1 }, "Combat catalog has no \"combatants\" array.");
+            return false;
+        }
+
+        bool ok = true;
+        const auto& combatants = doc["combatants"].items();
+        for (std::size_t i = 0; i < combatants.size(); ++i) {
+            const auto& entry = combatants[i];
+            const std::string where = "Combatant " + std::to_string(i);
+            auto fail = [&](const std::string& message) {
+                diagnostics.error(SourcePos{ path, 1, 1 }, where + " " + message);
+                ok = false;
+            };
+
+            CombatantDef def;
+            def.id = entry["id"].as_string();
+            if (def.id.empty()) {
+                fail("needs an \"id\" string.");
+                continue;
+            }
+            bool fields_ok = true;
+            for (const auto& f : kCombatFields) {
+                const auto& v = entry[f.name];
+                if (v.is_null()) continue;
+                const double n = v.as_number();
+                if (v.kind() != JsonValue::Kind::Number || n < 0 || n > kMaxCombatValue || std::floor(n) != n) {
+                    fail("has an invalid \"" + std::string(f.name) + "\" (expected an integer from 0 to " +
+                         std::to_string(kMaxCombatValue) + "): " + def.id);
+                    fields_ok = false;
+                    break;
+                }
+                def.*f.field = static_cast<int>(n);
+            }
+            if (!fields_ok) continue;
+            if (def.damage_max < def.damage_min) {
+                fail("has \"damage_max\" below \"damage_min\": " + def.id);
+                continue;
+            }
+            if (def.max_hp == 0) {
+                fail("needs a \"max_hp\" of at least 1: " + def.id);
+                continue;
+            }
+            const auto& on_hit = entry["on_hit"];
+            if (!on_hit.is_null()) {
+                const auto* name = std::find(std::begin(kStatusNames), std::end(kStatusNames), on_hit.as_string());
+                if (!on_hit.is_string() || name == std::end(kStatusNames)) {
+                    fail("has an invalid \"on_hit\" (expected \"poison\", \"bleed\" or \"stun\"): " + def.id);
+                    continue;
+                }
+                def.on_hit = static_cast<StatusKind>(name - std::begin(kStatusNames));
+            }
+
+            const std::string id = def.id;
+            if (out.add_combatant(std::move(def)) == kNoCombatant) fail("repeats combatant id: " + id);
+        }
+
+        const auto& packs = doc["packs"];
+        if (!packs.is_null() && packs.kind() != JsonValue::Kind::Array) {
+            diagnostics.error(SourcePos{ path, 1, 1 }, "Combat catalog \"packs\" is not an array.");
+            return false;
+        }
+        for (std::size_t i = 0; i < packs.items().size(); ++i) {
+            const auto& entry = packs.items()[i];
+            const std::string where = "Enemy pack " + std::to_string(i);
+            auto fail = [&](const std::string& message) {
+                diagnostics.error(SourcePos{ path, 1, 1 }, where + " " + message);
+                ok = false;
+            };
+
+            const std::string& id = entry["id"].as_string();
+            if (id.empty()) {
+                fail("needs an \"id\" string.");
+                continue;
+            }
+            std::vector<CombatantId> members;
+            bool members_ok = entry["members"].kind() == JsonValue::Kind::Array;
+            for (const auto& m : entry["members"].items()) {
+                const CombatantId member = out.find_combatant(m.as_string());
+                if (!m.is_string() || member == kNoCombatant) {
+                    fail("names an unknown combatant: " + id);
+                    members_ok = false;
+                    break;
+                }
+                members.push_back(member);
+            }
+            if (!members_ok) {
+                if (entry["members"].kind() != JsonValue::Kind::Array) fail("needs a \"members\" list: " + id);
+                continue;
+            }
+            if (members.empty() || members.size() >= kMaxCombatants) {
+                fail("needs 1 to " + std::to_string(kMaxCombatants - 1) + " members: " + id);
+                continue;
+            }
+            if (out.add_pack(id, std::move(members)) == kNoPack) fail("repeats pack id: " + id);
+        }
+        return ok;
+    }
+
+    void write_combat_log(std::ostream& out, std::span<const CombatEvent> events, std::uint32_t encounter,
+                          std::span<const std::string_view> names) {
+        auto name = [&](std::uint8_t i) -> std::ostream& {
+            if (i < names.size()) return out << names[i];
+            return out << '#' << static_cast<int>(i);
+        };
+        for (const auto& ev : events) {
+            if (ev.encounter != encounter) continue;
+            out << "round " << ev.round << ": ";
+            name(ev.actor);
+            const std::string_view status = kStatusNames[static_cast<std::size_t>(ev.status)];
+            switch (ev.kind) {
+            case CombatEventKind::Initiative: out << " rolls initiative " << ev.amount; break;
+            case CombatEventKind::Hit:
+                out << " hits ";
+                name(ev.target) << " for " << ev.amount;
+                break;
+            case CombatEventKind::Miss:
+                out << " misses ";
+                name(ev.target);
+                break;
+            case CombatEventKind::Status:
+                out << " inflicts " << status << " on ";
+                name(ev.target) << " for " << ev.amount << " turn(s)";
+                break;
+            case CombatEventKind::Tick: out << " takes " << ev.amount << " " << status << " damage"; break;
+            case CombatEventKind::Stunned: out << " is stunned"; break;
+            case CombatEventKind::Heal: out << " heals " << ev.amount; break;
+            case CombatEventKind::Death: out << " dies"; break;
+            }
+            out << "\n";
+        }
+    }
+
+    CombatBatch::CombatBatch(std::uint64_t seed) : seed_(seed) {
+    }
+
+    std::uint32_t CombatBatch::add(std::span<const CombatantDef> party, std::span<const CombatantDef> enemies, std::uint64_t id) {
+        assert(!party.empty() && !enemies.empty() && party.size() + enemies.size() <= kMaxCombatants);
+        const auto e = static_cast<std::uint32_t>(first_.size());
+        const auto first = static_cast<std::uint32_t>(hp_.size());
+        std::uint8_t alive[2] = { 0, 0 };
+
+        auto push = [&](const CombatantDef& def, std::uint8_t side) {
+            const int max_hp = std::max(1, clamp_value(def.max_hp));
+            const int hp = def.hp < 0 ? max_hp : std::min(def.hp, max_hp);
+            const int damage_min = clamp_value(def.damage_min);
+            const int damage_max = std::max(damage_min, clamp_value(def.damage_max));
+            hp_.push_back(hp);
+            max_hp_.push_back(max_hp);
+            accuracy_.push_back(clamp_value(def.accuracy));
+            evasion_.push_back(clamp_value(def.evasion));
+            damage_min_.push_back(damage_min);
+            damage_span_.push_back(damage_max - damage_min + 1);
+            scale_.push_back(std::min(100 + clamp_value(def.power) * clamp_value(def.scaling), kMaxScale));
+            armor_.push_back(clamp_value(def.armor));
+            dexterity_.push_back(clamp_value(def.dexterity));
+            initiative_.push_back(0);
+            on_hit_.push_back(def.on_hit);
+            on_hit_chance_.push_back(def.on_hit == StatusKind::None ? 0 : clamp_value(def.on_hit_chance));
+            on_hit_power_.push_back(clamp_value(def.on_hit_power));
+            on_hit_turns_.push_back(clamp_value(def.on_hit_turns));
+            heals_.push_back(clamp_value(def.heals));
+            heal_amount_.push_back(clamp_value(def.heal_amount));
+            heal_below_.push_back(clamp_value(def.heal_below));
+            side_.push_back(side);
+            poison_turns_.push_back(0);
+            poison_power_.push_back(0);
+            bleed_turns_.push_back(0);
+            bleed_power_.push_back(0);
+            stun_turns_.push_back(0);
+            order_.push_back(static_cast<std::uint8_t>(hp_.size() - 1 - first));
+            if (hp > 0) alive[side]++;
+        };
+        for (const auto& def : party) push(def, 0);
+        for (const auto& def : enemies) push(def, 1);
+
+        first_.push_back(first);
+        count_.push_back(static_cast<std::uint8_t>(party.size() + enemies.size()));
+        alive_party_.push_back(alive[0]);
+        alive_enemies_.push_back(alive[1]);
+        stream_.push_back(Rng(seed_).split(RngStream::Combat).split(id).stream());
+        results_.emplace_back();
+        // A side that starts without a living fighter has already lost.
+        done_.push_back(alive[0] == 0 || alive[1] == 0);
+        if (done_.back()) results_.back().outcome = alive[0] == 0 ? CombatOutcome::Lost : CombatOutcome::Won;
+        return e;
+    }
+
+    void CombatBatch::clear() {
+        for (auto* v : { &hp_, &max_hp_, &accuracy_, &evasion_, &damage_min_, &damage_span_, &scale_, &armor_, &dexterity_,
+                         &initiative_, &on_hit_chance_, &on_hit_power_, &on_hit_turns_, &heals_, &heal_amount_, &heal_below_,
+                         &poison_turns_, &poison_power_, &bleed_turns_, &bleed_power_, &stun_turns_ }) {
+            v->clear();
+        }
+        on_hit_.clear();
+        side_.clear();
+        order_.clear();
+        first_.clear();
+        count_.clear();
+        alive_party_.clear();
+        alive_enemies_.clear();
+        stream_.clear();
+        done_.clear();
+        results_.clear();
+        started_ = 0;
+    }
+
+    void CombatBatch::log(std::uint32_t e, std::uint32_t round, std::uint32_t actor, std::uint32_t target,
+                          CombatEventKind kind, StatusKind status, int amount) {
+        log_->push_back(CombatEvent{ e, round, static_cast<std::uint8_t>(actor - first_[e]),
+                                     static_cast<std::uint8_t>(target - first_[e]), kind, status, amount });
+    }
+
+    void CombatBatch::roll_initiative() {
+        act_stream_.clear();
+        act_block_.clear();
+        for (std::uint32_t e = started_; e < size(); ++e) {
+            for (std::uint32_t i = 0; i < count_[e]; ++i) {
+                act_stream_.push_back(stream_[e]);
+                act_block_.push_back(block_index(0, i));
+            }
+        }
+        act_random_.resize(act_block_.size() * 4);
+        philox_blocks(seed_, act_stream_, act_block_, act_random_.data());
+
+        const std::uint32_t begin = started_ == size() ? static_cast<std::uint32_t>(hp_.size()) : first_[started_];
+        const std::uint32_t* r = act_random_.data();
+        for (std::size_t c = begin, i = 0; c < hp_.size(); ++c, ++i) {
+            initiative_[c] = dexterity_[c] + static_cast<int>(scale_to(r[i * 4], 20)) + 1;
+        }
+
+        // Highest initiative first; ties go to the lower index.
+        for (std::uint32_t e = started_; e < size(); ++e) {
+            std::uint8_t* order = order_.data() + first_[e];
+            const int* init = initiative_.data() + first_[e];
+            std::stable_sort(order, order + count_[e], [&](std::uint8_t a, std::uint8_t b) { return init[a] > init[b]; });
+            if (log_) {
+                for (std::uint32_t i = 0; i < count_[e]; ++i) {
+                    const std::uint32_t c = first_[e] + order[i];
+                    log(e, 0, c, c, CombatEventKind::Initiative, StatusKind::None, initiative_[c]);
+                }
+            }
+        }
+    }
+
+    void CombatBatch::damage(std::uint32_t e, std::uint32_t c, int amount, std::uint32_t round) {
+        const bool was_alive = hp_[c] > 0;
+        hp_[c] -= amount;
+        if (!was_alive || hp_[c] > 0) return;
+
+        if (log_) log(e, round, c, c, CombatEventKind::Death, StatusKind::None, 0);
+        std::uint8_t& alive = side_[c] == 0 ? alive_party_[e] : alive_enemies_[e];
+        if (--alive == 0) {
+            done_[e] = 1;
+            results_[e].outcome = side_[c] == 0 ? CombatOutcome::Lost : CombatOutcome::Won;
+            results_[e].rounds = round;
+        }
+    }
+
+    // Upkeep and AI for one combatant's turn. Attacks are queued for the
+    // batched kernels; everything else resolves here.
+    void CombatBatch::take_turn(std::uint32_t e, std::uint32_t c, std::uint32_t round, std::uint32_t slot) {
+        if (hp_[c] <= 0) return;
+
+        if (poison_turns_[c] > 0) {
+            poison_turns_[c]--;
+            if (log_) log(e, round, c, c, CombatEventKind::Tick, StatusKind::Poison, poison_power_[c]);
+            damage(e, c, poison_power_[c], round);
+            if (hp_[c] <= 0) return;
+        }
+        if (bleed_turns_[c] > 0) {
+            const int amount = bleed_power_[c];
+            if (--bleed_turns_[c] == 0) bleed_power_[c] = 0;
+            if (log_) log(e, round, c, c, CombatEventKind::Tick, StatusKind::Bleed, amount);
+            damage(e, c, amount, round);
+            if (hp_[c] <= 0) return;
+        }
+        if (stun_turns_[c] > 0) {
+            stun_turns_[c]--;
+            if (log_) log(e, round, c, c, CombatEventKind::Stunned, StatusKind::Stun, 0);
+            return;
+        }
+        if (heals_[c] > 0 && hp_[c] * 100 < max_hp_[c] * heal_below_[c]) {
+            const int healed = std::min(heal_amount_[c], max_hp_[c] - hp_[c]);
+            heals_[c]--;
+            hp_[c] += healed;
+            if (log_) log(e, round, c, c, CombatEventKind::Heal, StatusKind::None, healed);
+            return;
+        }
+
+        std::uint32_t target = 0;
+        int target_hp = 0;
+        for (std::uint32_t i = first_[e]; i < first_[e] + count_[e]; ++i) {
+            if (side_[i] != side_[c] && hp_[i] > 0 && (target_hp == 0 || hp_[i] < target_hp)) {
+                target = i;
+                target_hp = hp_[i];
+            }
+        }
+
+        act_encounter_.push_back(e);
+        act_attacker_.push_back(c);
+        act_target_.push_back(target);
+        act_stream_.push_back(stream_[e]);
+        act_block_.push_back(block_index(round, slot));
+        act_accuracy_.push_back(accuracy_[c]);
+        act_evasion_.push_back(evasion_[target]);
+        act_damage_min_.push_back(damage_min_[c]);
+        act_damage_span_.push_back(damage_span_[c]);
+        act_scale_.push_back(scale_[c]);
+        act_armor_.push_back(armor_[target]);
+        act_on_hit_chance_.push_back(on_hit_chance_[c]);
+    }
+
+    // The attack pipeline over the gathered attacks of one turn slot. Each
+    // step is a straight loop over contiguous arrays. Words 0-2 of an
+    // attack's block drive the hit, damage and on-hit rolls; word 3 is
+    // spare.
+    void CombatBatch::resolve_attacks() {
+        const std::size_t n = act_encounter_.size();
+        act_random_.resize(n * 4);
+        act_hit_.resize(n);
+        act_damage_.resize(n);
+        act_inflict_.resize(n);
+        philox_blocks(seed_, act_stream_, act_block_, act_random_.data());
+
+        const std::uint32_t* random = act_random_.data();
+        const int* accuracy = act_accuracy_.data();
+        const int* evasion = act_evasion_.data();
+        const int* damage_min = act_damage_min_.data();
+        const int* damage_span = act_damage_span_.data();
+        const int* scale = act_scale_.data();
+        const int* armor = act_armor_.data();
+        const int* on_hit_chance = act_on_hit_chance_.data();
+        std::uint8_t* hit = act_hit_.data();
+        int* dmg = act_damage_.data();
+        std::uint8_t* inflict = act_inflict_.data();
+
+        // Hit roll.
+        for (std::size_t i = 0; i < n; ++i) {
+            const int chance = std::clamp(75 + accuracy[i] - evasion[i], 5, 95);
+            hit[i] = percent_roll(random[i * 4]) < chance;
+        }
+        // Base damage.
+        for (std::size_t i = 0; i < n; ++i) {
+            dmg[i] = damage_min[i] + static_cast<int>(scale_to(random[i * 4 + 1], static_cast<std::uint32_t>(damage_span[i])));
+        }
+        // Scaling; at most kMaxCombatValue * kMaxScale, which fits 32 bits.
+        for (std::size_t i = 0; i < n; ++i) dmg[i] = dmg[i] * scale[i] / 100;
+        // Armor; a hit always deals at least 1, a miss nothing.
+        for (std::size_t i = 0; i < n; ++i) dmg[i] = hit[i] ? std::max(1, dmg[i] - armor[i]) : 0;
+        // On-hit status roll.
+        for (std::size_t i = 0; i < n; ++i) inflict[i] = hit[i] & (percent_roll(random[i * 4 + 2]) < on_hit_chance[i]);
+    }
+
+    void CombatBatch::apply_attacks(std::uint32_t round) {
+        for (std::size_t i = 0; i < act_encounter_.size(); ++i) {
+            const std::uint32_t e = act_encounter_[i];
+            const std::uint32_t a = act_attacker_[i];
+            const std::uint32_t t = act_target_[i];
+            if (!act_hit_[i]) {
+                if (log_) log(e, round, a, t, CombatEventKind::Miss, StatusKind::None, 0);
+                continue;
+            }
+            if (log_) log(e, round, a, t, CombatEventKind::Hit, StatusKind::None, act_damage_[i]);
+            damage(e, t, act_damage_[i], round);
+            if (!act_inflict_[i] || hp_[t] <= 0) continue;
+
+            const int turns = on_hit_turns_[a];
+            switch (on_hit_[a]) {
+            case StatusKind::Poison:
+                poison_turns_[t] = std::max(poison_turns_[t], turns);
+                poison_power_[t] = std::max(poison_power_[t], on_hit_power_[a]);
+                break;
+            case StatusKind::Bleed:
+                bleed_turns_[t] = std::max(bleed_turns_[t], turns);
+                bleed_power_[t] = std::min(bleed_power_[t] + on_hit_power_[a], kMaxCombatValue);
+                break;
+            case StatusKind::Stun:
+                stun_turns_[t] = std::max(stun_turns_[t], turns);
+                break;
+            case StatusKind::None:
+                break;
+            }
+            if (log_) log(e, round, a, t, CombatEventKind::Status, on_hit_[a], turns);
+        }
+    }
+
+    void CombatBatch::run(std::uint32_t max_rounds) {
+        TALE_PROFILE_SCOPE("CombatBatch::run");
+        const auto begin = started_;
+        const auto end = static_cast<std::uint32_t>(size());
+        roll_initiative();
+
+        active_.clear();
+        std::uint32_t widest = 0;
+        for (std::uint32_t e = begin; e < end; ++e) {
+            if (done_[e]) continue;
+            active_.push_back(e);
+            widest = std::max<std::uint32_t>(widest, count_[e]);
+        }
+
+        for (std::uint32_t round = 1; round <= max_rounds && !active_.empty(); ++round) {
+            for (std::uint32_t slot = 0; slot < widest; ++slot) {
+                for (auto* v : { &act_encounter_, &act_attacker_, &act_target_ }) v->clear();
+                for (auto* v : { &act_accuracy_, &act_evasion_, &act_damage_min_, &act_damage_span_, &act_scale_, &act_armor_,
+                                 &act_on_hit_chance_ }) {
+                    v->clear();
+                }
+                act_stream_.clear();
+                act_block_.clear();
+
+                for (const std::uint32_t e : active_) {
+                    if (!done_[e] && slot < count_[e]) take_turn(e, first_[e] + order_[first_[e] + slot], round, slot);
+                }
+                if (act_encounter_.empty()) continue;
+                TALE_PROFILE_COUNT("combat.attacks", act_encounter_.size());
+                resolve_attacks();
+                apply_attacks(round);
+            }
+            std::erase_if(active_, [&](std::uint32_t e) { return done_[e] != 0; });
+        }
+        for (const std::uint32_t e : active_) {
+            done_[e] = 1;
+            results_[e].outcome = CombatOutcome::Draw;
+            results_[e].rounds = max_rounds;
+        }
+
+        for (std::uint32_t e = begin; e < end; ++e) {
+            for (std::uint32_t c = first_[e]; c < first_[e] + count_[e]; ++c) {
+                (side_[c] == 0 ? results_[e].party_hp : results_[e].enemy_hp) += std::max(0, hp_[c]);
+            }
+        }
+        TALE_PROFILE_COUNT("combat.encounters", end - begin);
+        started_ = end;
+    }
+
+    std::vector<CombatResult> simulate_combat(std::span<const CombatantDef> party, std::span<const CombatantDef> enemies,
+                                              const CombatSimulation& sim) {
+        std::vector<CombatResult> results(sim.count);
+        const std::size_t batch = std::max<std::size_t>(1, sim.batch);
+        const std::size_t chunks = (sim.count + batch - 1) / batch;
+
+        // Each worker writes only the results of its own chunks.
+        std::atomic<std::size_t> next{ 0 };
+        auto worker = [&]() {
+            CombatBatch fights(sim.seed);
+            for (std::size_t chunk = next++; chunk < chunks; chunk = next++) {
+                const std::size_t begin = chunk * batch;
+                const std::size_t end = std::min(sim.count, begin + batch);
+                fights.clear();
+                for (std::size_t i = begin; i < end; ++i) fights.add(party, enemies, sim.first_id + i);
+                fights.run(sim.max_rounds);
+                for (std::size_t i = begin; i < end; ++i) results[i] = fights.result(static_cast<std::uint32_t>(i - begin));
+            }
+        };
+
+        unsigned jobs = sim.threads ? sim.threads : std::thread::hardware_concurrency();
+        jobs = std::max(1u, std::min<unsigned>(jobs, static_cast<unsigned>(std::max<std::size_t>(1, chunks))));
+
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < jobs; ++t) threads.emplace_back(worker);
+        worker();
+        for (auto& t : threads) t.join();
+        return results;
+    }
+
+    namespace {
+        void start_combat(EffectCall& call) {
+            const auto& context = *static_cast<const CombatContext*>(call.user);
+            const CombatCatalog* catalog = context.catalog;
+            const PackId pack = catalog ? catalog->find_pack(call.name(0)) : kNoPack;
+            if (pack == kNoPack) {
+                call.failed = true;
+                call.diagnostics.warning(call.pos, "start_combat names an unknown enemy pack: " + call.name(0));
+                return;
+            }
+
+            CombatantDef player;
+            if (const CombatantId id = catalog->find_combatant("player"); id != kNoCombatant) player = catalog->combatant(id);
+            player.id = "player";
+            const Stats& stats = call.state.stats();
+            for (const auto& f : kCombatFields) {
+                if (const StatId stat = stats.find(f.name); stat != kNoStat) player.*f.field = stats.value(stat);
+            }
+            const StatId hp = stats.find("hp");
+            if (hp != kNoStat) player.hp = std::max(0, stats.value(hp));
+
+            std::vector<CombatantDef> enemies;
+            for (const CombatantId member : catalog->pack(pack).members) enemies.push_back(catalog->combatant(member));
+
+            // Fights started by one choice share its time; the count tells them apart.
+            int count = 0;
+            if (const FlagValue* v = call.state.get_flag("combat_count")) {
+                if (const int* n = std::get_if<int>(&v->data)) count = *n;
+            }
+            call.state.set_flag("combat_count", Value{ call.pos, count + 1 });
+            const std::uint64_t id = hash_combine(call.state.time(), static_cast<std::uint64_t>(static_cast<std::uint32_t>(count)));
+
+            CombatBatch fight(context.seed);
+            std::vector<CombatEvent> events;
+            if (context.log) fight.set_log(&events);
+            fight.add(std::span(&player, 1), enemies, id);
+            const int start_hp = fight.hp(0, 0);
+            fight.run();
+
+            if (context.log) {
+                std::vector<std::string_view> names{ player.id };
+                for (const auto& def : enemies) names.push_back(def.id);
+                write_combat_log(*context.log, events, 0, names);
+            }
+            if (hp != kNoStat) {
+                const SlotId slot = call.state.stat_slot("hp");
+                call.state.set_stat_base(slot, stats.base(slot) + std::max(0, fight.hp(0, 0)) - start_hp);
+            }
+
+            constexpr std::string_view kOutcomes[] = { "won", "lost", "draw" };
+            const auto outcome = static_cast<std::size_t>(fight.result(0).outcome);
+            call.state.set_flag("combat_result", Value{ call.pos, std::string(kOutcomes[outcome]) });
+        }
+    }
+
+    void bind_combat(EffectRegistry& registry, CombatContext& context) {
+        registry.bind(dsl::StartCombat, start_combat, &context);
+    }
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,169 @@
+#include "tale_engine/runtime/conditions.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tale_engine/profile.h"
+
+namespace tale_engine::runtime {
+
+    namespace {
+        constexpr std::uint32_t kNoInput = static_cast<std::uint32_t>(-1);
+
+        std::size_t kind_index(SlotKind kind) { return static_cast<std::size_t>(kind); }
+    }
+
+    std::uint32_t ConditionProgram::input(SlotKind kind, const std::string& name) {
+        auto [it, inserted] = input_index_[kind_index(kind)].try_emplace(name, static_cast<std::uint32_t>(inputs_.size()));
+        if (inserted) inputs_.push_back(Input{ kind, name });
+
+        auto& reads = reads_.back();
+        if (std::find(reads.begin(), reads.end(), it->second) == reads.end()) reads.push_back(it->second);
+        return it->second;
+    }
+
+    void ConditionProgram::emit(const dsl::ConditionAst& c) {
+        switch (c.op) {
+        case dsl::ConditionOp::HasFlag:
+            code_.push_back(Instr{ Op::HasFlag, input(SlotKind::Flag, c.name) });
+            return;
+        case dsl::ConditionOp::FlagEquals:
+            constants_.push_back(c.value.value);
+            code_.push_back(Instr{ Op::FlagEquals, input(SlotKind::Flag, c.name), static_cast<std::int32_t>(constants_.size() - 1) });
+            return;
+        case dsl::ConditionOp::HasItem:
+            code_.push_back(Instr{ Op::HasItem, input(SlotKind::Item, c.name), c.qty });
+            return;
+        case dsl::ConditionOp::StatAtLeast:
+            code_.push_back(Instr{ Op::StatAtLeast, input(SlotKind::Stat, c.name), c.qty });
+            return;
+        case dsl::ConditionOp::Not:
+        case dsl::ConditionOp::And:
+        case dsl::ConditionOp::Or:
+            for (const auto& o : c.operands) emit(o);
+            if (c.op == dsl::ConditionOp::Not) code_.push_back(Instr{ Op::Not });
+            else code_.push_back(Instr{ c.op == dsl::ConditionOp::And ? Op::And : Op::Or, static_cast<std::uint32_t>(c.operands.size()) });
+            return;
+        }
+    }
+
+    ConditionId ConditionProgram::add(const dsl::ConditionAst& condition) {
+        if (code_offsets_.empty()) code_offsets_.push_back(0);
+        reads_.emplace_back();
+        emit(condition);
+        code_offsets_.push_back(static_cast<std::uint32_t>(code_.size()));
+        return static_cast<ConditionId>(code_offsets_.size() - 2);
+    }
+
+    void ConditionProgram::finalize() {
+        // Invert condition -> inputs into CSR input -> dependent conditions.
+        deps_offsets_.assign(inputs_.size() + 1, 0);
+        for (const auto& reads : reads_) {
+            for (const auto in : reads) deps_offsets_[in + 1]++;
+        }
+        for (std::size_t i = 0; i < inputs_.size(); ++i) deps_offsets_[i + 1] += deps_offsets_[i];
+
+        dependents_.resize(deps_offsets_.back());
+        std::vector<std::uint32_t> fill(deps_offsets_.begin(), deps_offsets_.end() - 1);
+        for (std::size_t c = 0; c < reads_.size(); ++c) {
+            for (const auto in : reads_[c]) dependents_[fill[in]++] = static_cast<ConditionId>(c);
+        }
+
+        reads_.clear();
+        reads_.shrink_to_fit();
+        for (auto& index : input_index_) index.clear();
+    }
+
+    ConditionCache::ConditionCache(const ConditionProgram& program)
+        : program_(program), dirty_(program.size(), 1), result_(program.size(), 0) {
+    }
+
+    void ConditionCache::sync(State& state) {
+        if (state.journal_epoch() != epoch_) {
+            // New State (or its journal restarted): resolve inputs, drop all results.
+            const auto& inputs = program_.inputs();
+            slot_of_input_.resize(inputs.size());
+            for (auto& map : input_of_slot_) map.clear();
+            for (std::uint32_t i = 0; i < inputs.size(); ++i) {
+                SlotId slot = 0;
+                switch (inputs[i].kind) {
+                case SlotKind::Flag: slot = state.flag_slot(inputs[i].name); break;
+                case SlotKind::Item: slot = state.item_slot(inputs[i].name); break;
+                case SlotKind::Stat: slot = state.stat_slot(inputs[i].name); break;
+                }
+                slot_of_input_[i] = slot;
+
+                auto& map = input_of_slot_[kind_index(inputs[i].kind)];
+                if (map.size() <= slot) map.resize(slot + 1, kNoInput);
+                map[slot] = i;
+            }
+            std::fill(dirty_.begin(), dirty_.end(), 1);
+            epoch_ = state.journal_epoch();
+            cursor_ = state.journal_size();
+            return;
+        }
+
+        for (const StateChange& change : state.changes_since(cursor_)) {
+            const auto& map = input_of_slot_[kind_index(change.kind)];
+            if (change.slot >= map.size() || map[change.slot] == kNoInput) continue;
+
+            const std::uint32_t in = map[change.slot];
+            for (std::uint32_t d = program_.deps_offsets_[in]; d < program_.deps_offsets_[in + 1]; ++d) {
+                dirty_[program_.dependents_[d]] = 1;
+            }
+        }
+        cursor_ = state.journal_size();
+    }
+
+    bool ConditionCache::value(const State& state, ConditionId id) {
+        if (dirty_[id]) {
+            result_[id] = evaluate(state, id) ? 1 : 0;
+            dirty_[id] = 0;
+        }
+        return result_[id] != 0;
+    }
+
+    bool ConditionCache::evaluate(const State& state, ConditionId id) {
+        TALE_PROFILE_COUNT("conditions.evaluated", 1);
+        using Op = ConditionProgram::Op;
+
+        stack_.clear();
+        for (std::uint32_t pc = program_.code_offsets_[id]; pc < program_.code_offsets_[id + 1]; ++pc) {
+            const auto& in = program_.code_[pc];
+            switch (in.op) {
+            case Op::HasFlag:
+                stack_.push_back(state.flag_at(slot_of_input_[in.a]) != nullptr);
+                break;
+            case Op::FlagEquals: {
+                const FlagValue* v = state.flag_at(slot_of_input_[in.a]);
+                stack_.push_back(v && equals(*v, program_.constants_[static_cast<std::size_t>(in.b)]));
+                break;
+            }
+            case Op::HasItem:
+                stack_.push_back(state.item_qty_at(slot_of_input_[in.a]) >= in.b);
+                break;
+            case Op::StatAtLeast:
+                stack_.push_back(state.stat_at(slot_of_input_[in.a]) >= in.b);
+                break;
+            case Op::Not:
+                if (stack_.empty()) return false;
+                stack_.back() = !stack_.back();
+                break;
+            case Op::And:
+            case Op::Or: {
+                // Malformed code (e.g. decoded from a damaged file) evaluates to false.
+                if (in.a == 0 || stack_.size() < in.a) return false;
+                const auto first = stack_.end() - in.a;
+                const bool r = in.op == Op::And
+                    ? std::all_of(first, stack_.end(), [](std::uint8_t x) { return x != 0; })
+                    : std::any_of(first, stack_.end(), [](std::uint8_t x) { return x != 0; });
+                stack_.erase(first, stack_.end());
+                stack_.push_back(r);
+                break;
+            }
+            }
+        }
+        return !stack_.empty() && stack_.back() != 0;
+    }
+
+} // namespace tale_engine::runtime
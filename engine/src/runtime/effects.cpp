@@ -0,0 +1,106 @@
+#include "tale_engine/runtime/effects.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+#include "tale_engine/profile.h"
+
+namespace tale_engine::runtime {
+
+    namespace {
+
+        void set_flag(EffectCall& call) {
+            call.state.set_flag(call.name(0), call.args[1]);
+        }
+
+        void give_item(EffectCall& call) {
+            call.state.give_item(call.name(0), call.integer(1));
+        }
+
+        void take_item(EffectCall& call) {
+            if (!call.state.take_item(call.name(0), call.integer(1))) {
+                call.failed = true;
+                TALE_PROFILE_COUNT("runtime.take_item_failed", 1);
+                call.diagnostics.warning(call.pos, "take_item failed due to insufficient quantity: " + call.name(0));
+            }
+        }
+
+        // Adds `delta` to a stat's base, saturating at the int range instead
+        // of overflowing.
+        void shift_stat_base(EffectCall& call, std::int64_t delta) {
+            const SlotId stat = call.state.stat_slot(call.name(0));
+            const std::int64_t v = std::clamp<std::int64_t>(call.state.stats().base(stat) + delta, INT_MIN, INT_MAX);
+            call.state.set_stat_base(stat, static_cast<int>(v));
+        }
+
+        void add_stat(EffectCall& call) {
+            shift_stat_base(call, call.integer(1));
+        }
+
+        void reduce_stat(EffectCall& call) {
+            shift_stat_base(call, -static_cast<std::int64_t>(call.integer(1)));
+        }
+
+        // Timed additive modifier; the duration counts applied choices.
+        void buff_stat(EffectCall& call) {
+            Modifier m;
+            m.stat = call.state.stat_slot(call.name(0));
+            m.amount = call.integer(1);
+            m.duration = static_cast<std::uint32_t>(call.integer(2));
+            if (m.duration == 0) {
+                call.failed = true;
+                call.diagnostics.warning(call.pos, "buff_stat needs a duration of at least one turn: " + call.name(0));
+                return;
+            }
+            call.state.add_stat_modifier(m);
+        }
+
+        // Equips the most recently given instance of the item.
+        void equip(EffectCall& call) {
+            const Inventory& inventory = call.state.inventory();
+            const ItemId item = inventory.find(call.name(0));
+            const InstanceId instance = item == kNoItem ? kNoInstance : inventory.first_instance(item);
+            if (instance == kNoInstance || !call.state.equip(instance)) {
+                call.failed = true;
+                call.diagnostics.warning(call.pos, "equip failed: item not held or has no equipment slot: " + call.name(0));
+            }
+        }
+
+        // Placeholder until the host binds a combat catalog (bind_combat()).
+        void start_combat(EffectCall& call) {
+            call.failed = true;
+            call.diagnostics.warning(call.pos, "start_combat has no combat catalog to fight with: " + call.name(0));
+        }
+
+        // Indexed by dsl::BuiltinEffect.
+        constexpr EffectHandler kBuiltinHandlers[] = { set_flag, give_item, take_item, add_stat, reduce_stat, buff_stat, equip,
+                                                       start_combat };
+        static_assert(std::size(kBuiltinHandlers) == dsl::kBuiltinEffectCount);
+
+    } // namespace
+
+    EffectRegistry::EffectRegistry() {
+        entries_.reserve(dsl::kBuiltinEffectCount);
+        for (const EffectHandler h : kBuiltinHandlers) entries_.push_back(Entry{ h, nullptr });
+    }
+
+    dsl::EffectId EffectRegistry::add(const dsl::EffectSignature& sig, EffectHandler handler, void* user) {
+        if (!handler) return dsl::kNoEffect;
+        const dsl::EffectId id = table_.add(sig);
+        if (id != dsl::kNoEffect) entries_.push_back(Entry{ handler, user });
+        return id;
+    }
+
+    bool EffectRegistry::bind(dsl::EffectId id, EffectHandler handler, void* user) {
+        if (!handler || id >= entries_.size()) return false;
+        entries_[id] = Entry{ handler, user };
+        return true;
+    }
+
+    const EffectRegistry& EffectRegistry::builtins() {
+        static const EffectRegistry registry;
+        return registry;
+    }
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,144 @@
+#include "tale_engine/runtime/embedded_story.h"
+
+#include "tale_engine/profile.h"
+
+namespace tale_engine::runtime {
+
+    namespace {
+        std::variant<std::string, int, bool> value_data(const EmbeddedValue& v) {
+            switch (v.kind) {
+            case EmbeddedValueKind::String: return std::string(v.text);
+            case EmbeddedValueKind::Int: return v.number;
+            case EmbeddedValueKind::Bool: break;
+            }
+            return v.number != 0;
+        }
+
+        dsl::ValueAst value_ast(const EmbeddedStory& story, const EmbeddedValue& v) {
+            return dsl::ValueAst{ to_source_pos(story, v.pos), value_data(v) };
+        }
+    }
+
+    SourcePos to_source_pos(const EmbeddedStory& story, const EmbeddedPos& pos) {
+        return SourcePos{ std::string(story.files[pos.file]), pos.line, pos.column };
+    }
+
+    Value to_value(const EmbeddedStory& story, const EmbeddedValue& value) {
+        return Value{ to_source_pos(story, value.pos), value_data(value) };
+    }
+
+    dsl::ConditionAst to_condition_ast(const EmbeddedStory& story, const EmbeddedCondition& condition) {
+        dsl::ConditionAst out;
+        out.pos = to_source_pos(story, condition.pos);
+        out.op = condition.op;
+        out.name = condition.name;
+        out.value = value_ast(story, condition.value);
+        out.qty = condition.qty;
+        out.operands.reserve(condition.count);
+        for (const auto& operand : story.conditions.subspan(condition.first, condition.count)) {
+            out.operands.push_back(to_condition_ast(story, operand));
+        }
+        return out;
+    }
+
+    namespace {
+
+        class AstBuilder {
+        public:
+            explicit AstBuilder(const EmbeddedStory& story) : story_(story) {}
+
+            dsl::FileAst file() {
+                dsl::FileAst ast;
+                ast.scenes.reserve(story_.scenes.size());
+                for (const auto& s : story_.scenes) {
+                    dsl::SceneAst scene;
+                    scene.pos = pos(s.pos);
+                    scene.id = s.id;
+                    scene.body.reserve(s.count);
+                    for (const auto& stmt : story_.stmts.subspan(s.first, s.count)) scene.body.push_back(top_level(stmt));
+                    ast.scenes.push_back(std::move(scene));
+                }
+                return ast;
+            }
+
+        private:
+            SourcePos pos(const EmbeddedPos& p) const { return to_source_pos(story_, p); }
+            dsl::ValueAst value(const EmbeddedValue& v) const { return value_ast(story_, v); }
+            dsl::ConditionAst condition(const EmbeddedCondition& c) const { return to_condition_ast(story_, c); }
+
+            dsl::GotoStmtAst goto_stmt(const EmbeddedStmt& s) const {
+                dsl::GotoStmtAst g;
+                g.pos = pos(s.pos);
+                g.target_scene_id = s.name;
+                return g;
+            }
+
+            // The parser gives an effect statement and its call the same position.
+            dsl::EffectStmtAst effect(const EmbeddedStmt& s) const {
+                dsl::EffectStmtAst e;
+                e.pos = pos(s.pos);
+                switch (s.kind) {
+                case EmbeddedStmtKind::SetFlag:
+                    e.call = dsl::EffectSetFlagAst{ e.pos, std::string(s.name), value(s.value) };
+                    break;
+                case EmbeddedStmtKind::GiveItem:
+                    e.call = dsl::EffectGiveItemAst{ e.pos, std::string(s.name), s.qty };
+                    break;
+                case EmbeddedStmtKind::TakeItem:
+                    e.call = dsl::EffectTakeItemAst{ e.pos, std::string(s.name), s.qty };
+                    break;
+                default: {
+                    dsl::EffectNativeAst n;
+                    n.pos = e.pos;
+                    n.name = s.name;
+                    for (const auto& arg : story_.args.subspan(s.first, s.count)) {
+                        n.arg_kinds.push_back(arg.kind);
+                        n.args.push_back(value(arg.value));
+                    }
+                    e.call = std::move(n);
+                    break;
+                }
+                }
+                return e;
+            }
+
+            dsl::StmtAst top_level(const EmbeddedStmt& s) const {
+                switch (s.kind) {
+                case EmbeddedStmtKind::Text: {
+                    dsl::TextBlockAst tb;
+                    tb.pos = pos(s.pos);
+                    tb.lines.reserve(s.count);
+                    for (const auto line : story_.lines.subspan(s.first, s.count)) tb.lines.emplace_back(line);
+                    return tb;
+                }
+                case EmbeddedStmtKind::Choice: {
+                    dsl::ChoiceAst ch;
+                    ch.pos = pos(s.pos);
+                    ch.label = s.name;
+                    if (s.condition != kNoEmbeddedCondition) ch.condition = condition(story_.conditions[s.condition]);
+                    ch.body.reserve(s.count);
+                    for (const auto& b : story_.stmts.subspan(s.first, s.count)) {
+                        if (b.kind == EmbeddedStmtKind::Goto) ch.body.push_back(goto_stmt(b));
+                        else ch.body.push_back(effect(b));
+                    }
+                    return ch;
+                }
+                case EmbeddedStmtKind::Goto:
+                    return goto_stmt(s);
+                default:
+                    return effect(s);
+                }
+            }
+
+        private:
+            const EmbeddedStory& story_;
+        };
+
+    } // namespace
+
+    dsl::FileAst to_ast(const EmbeddedStory& story) {
+        TALE_PROFILE_SCOPE("runtime::to_ast");
+        return AstBuilder(story).file();
+    }
+
+} // namespace tale_engine::runtime
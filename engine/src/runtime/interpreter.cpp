@@ -2,27 +2,248 @@
 
 #include <utility>
 
+#include "tale_engine/profile.h"
+
 namespace tale_engine::runtime {
 
-    Interpreter::Interpreter(const dsl::FileAst& ast, Diagnostics& diagnostics)
-        : ast_(ast), diags_(diagnostics) {
+    namespace {
+        // Conditions are numbered by scene, then by statement order.
+        ConditionProgram compile_conditions(const dsl::FileAst& ast) {
+            ConditionProgram program;
+            for (const auto& scene : ast.scenes) {
+                for (const auto& stmt : scene.body) {
+                    const auto* ch = std::get_if<dsl::ChoiceAst>(&stmt);
+                    if (ch && ch->condition) program.add(*ch->condition);
+                }
+            }
+            program.finalize();
+            return program;
+        }
+
+        ConditionProgram compile_conditions(const EmbeddedStory& story) {
+            ConditionProgram program;
+            for (const auto& scene : story.scenes) {
+                for (const auto& stmt : story.stmts.subspan(scene.first, scene.count)) {
+                    if (stmt.kind == EmbeddedStmtKind::Choice && stmt.condition != kNoEmbeddedCondition) {
+                        program.add(to_condition_ast(story, story.conditions[stmt.condition]));
+                    }
+                }
+            }
+            program.finalize();
+            return program;
+        }
+    }
+
+    Interpreter::Interpreter(const dsl::FileAst& ast, Diagnostics& diagnostics, const EffectRegistry& effects,
+        std::pmr::memory_resource* resource)
+        : diags_(diagnostics), entries_(resource), scenes_(resource), stmts_(resource), lines_(resource), positions_(resource),
+          effect_names_(resource), conditions_(compile_conditions(ast)), condition_cache_(conditions_), effects_(resource),
+          effect_args_(resource), stmt_effects_(resource), labels_(resource), memos_(ast.scenes.size(), resource),
+          scratch_(resource) {
+        entries_.reserve(ast.scenes.size());
+        for (const auto& s : ast.scenes) {
+            add_scene(s.id);
+            for (const auto& stmt : s.body) {
+                const auto first_effect = static_cast<std::uint32_t>(effects_.size());
+                Stmt st;
+                if (const auto* tb = std::get_if<dsl::TextBlockAst>(&stmt)) {
+                    st.kind = StmtKind::Text;
+                    st.count = static_cast<std::uint32_t>(tb->lines.size());
+                    for (const auto& line : tb->lines) add_line(line);
+                }
+                else if (const auto* eff = std::get_if<dsl::EffectStmtAst>(&stmt)) {
+                    st.kind = StmtKind::Effect;
+                    compile_effect(effects, *eff);
+                }
+                else if (const auto* g = std::get_if<dsl::GotoStmtAst>(&stmt)) {
+                    st.kind = StmtKind::Goto;
+                    st.target = g->target_scene_id;
+                }
+                else {
+                    const auto& ch = std::get<dsl::ChoiceAst>(stmt);
+                    st.kind = StmtKind::Choice;
+                    st.conditional = ch.condition.has_value();
+                    st.label = ch.label;
+                    st.pos = &ch.pos;
+                    for (const auto& cs : ch.body) {
+                        if (const auto* ceff = std::get_if<dsl::EffectStmtAst>(&cs)) {
+                            compile_effect(effects, *ceff);
+                            st.count++;
+                        }
+                        else if (!st.has_goto) {
+                            st.has_goto = true;
+                            st.target = std::get<dsl::GotoStmtAst>(cs).target_scene_id;
+                        }
+                    }
+                }
+                add_stmt(st, first_effect);
+            }
+        }
+        index_scenes();
+    }
+
+    Interpreter::Interpreter(const EmbeddedStory& story, Diagnostics& diagnostics, const EffectRegistry& effects,
+        std::pmr::memory_resource* resource)
+        : diags_(diagnostics), entries_(resource), scenes_(resource), stmts_(resource), lines_(resource), positions_(resource),
+          effect_names_(resource), conditions_(compile_conditions(story)), condition_cache_(conditions_), effects_(resource),
+          effect_args_(resource), stmt_effects_(resource), labels_(resource), memos_(story.scenes.size(), resource),
+          scratch_(resource) {
+        TALE_PROFILE_SCOPE("Interpreter::load_embedded");
+        entries_.reserve(story.scenes.size());
+        stmts_.reserve(story.stmts.size());
+        for (const auto& s : story.scenes) {
+            add_scene(s.id);
+            for (const auto& stmt : story.stmts.subspan(s.first, s.count)) {
+                const auto first_effect = static_cast<std::uint32_t>(effects_.size());
+                Stmt st;
+                switch (stmt.kind) {
+                case EmbeddedStmtKind::Text:
+                    st.kind = StmtKind::Text;
+                    st.count = stmt.count;
+                    for (const auto line : story.lines.subspan(stmt.first, stmt.count)) add_line(line);
+                    break;
+                case EmbeddedStmtKind::Goto:
+                    st.kind = StmtKind::Goto;
+                    st.target = stmt.name;
+                    break;
+                case EmbeddedStmtKind::Choice:
+                    st.kind = StmtKind::Choice;
+                    st.conditional = stmt.condition != kNoEmbeddedCondition;
+                    st.label = stmt.name;
+                    st.pos = &positions_.emplace_back(to_source_pos(story, stmt.pos));
+                    for (const auto& cs : story.stmts.subspan(stmt.first, stmt.count)) {
+                        if (cs.kind != EmbeddedStmtKind::Goto) {
+                            compile_effect(effects, story, cs);
+                            st.count++;
+                        }
+                        else if (!st.has_goto) {
+                            st.has_goto = true;
+                            st.target = cs.name;
+                        }
+                    }
+                    break;
+                default:
+                    st.kind = StmtKind::Effect;
+                    compile_effect(effects, story, stmt);
+                    break;
+                }
+                add_stmt(st, first_effect);
+            }
+        }
+        index_scenes();
+    }
+
+    void Interpreter::add_scene(std::string_view id) {
+        entries_.push_back(SceneEntry{ id, static_cast<std::uint32_t>(entries_.size()), StepDependency::Full, 0, 0,
+                                       static_cast<TextLineId>(text_.size()), static_cast<std::uint32_t>(stmts_.size()), 0 });
+    }
+
+    void Interpreter::add_line(std::string_view line) {
+        text_.add(line);
+        lines_.push_back(line);
     }
 
-    const dsl::SceneAst* Interpreter::find_scene(const std::string& id) const {
-        for (const auto& s : ast_.scenes) {
-            if (s.id == id) return &s;
+    void Interpreter::add_stmt(const Stmt& stmt, std::uint32_t first_effect) {
+        stmts_.push_back(stmt);
+        stmt_effects_.push_back(first_effect);
+        entries_.back().stmt_count++;
+    }
+
+    // Numbers conditions and builds the lookup once every scene is in.
+    void Interpreter::index_scenes() {
+        scenes_.reserve(entries_.size());
+        ConditionId next = 0;
+        for (auto& entry : entries_) {
+            entry.first_condition = next;
+            entry.dependency = classify(entry, entry.step_conditions);
+            for (std::uint32_t i = 0; i < entry.stmt_count; ++i) {
+                const Stmt& st = stmts_[entry.first_stmt + i];
+                if (st.kind == StmtKind::Choice && st.conditional) next++;
+            }
+            scenes_.try_emplace(entry.id, entry.index);
+        }
+    }
+
+    // Walks a scene body the way step() does: Full if step() would run an
+    // effect or render a placeholder (in the text now in use), otherwise by
+    // the conditional choices in the choice run it would offer.
+    StepDependency Interpreter::classify(const SceneEntry& entry, std::uint32_t& step_conditions) const {
+        step_conditions = 0;
+        TextLineId line = entry.first_line;
+        for (std::uint32_t i = 0; i < entry.stmt_count; ++i) {
+            const Stmt& st = stmts_[entry.first_stmt + i];
+            switch (st.kind) {
+            case StmtKind::Effect:
+                return StepDependency::Full;
+            case StmtKind::Text:
+                for (TextLineId id = line; id < line + st.count; ++id) {
+                    if (text_.is_dynamic(id)) return StepDependency::Full;
+                }
+                line += st.count;
+                break;
+            case StmtKind::Goto:
+                return StepDependency::None;
+            case StmtKind::Choice:
+                for (std::uint32_t j = i; j < entry.stmt_count && stmts_[entry.first_stmt + j].kind == StmtKind::Choice; ++j) {
+                    if (stmts_[entry.first_stmt + j].conditional) step_conditions++;
+                }
+                if (step_conditions > kMaxMemoConditions) return StepDependency::Full;
+                return step_conditions == 0 ? StepDependency::None : StepDependency::Conditions;
+            }
+        }
+        return StepDependency::None;
+    }
+
+    void Interpreter::set_strings(const StringTable* strings) {
+        TALE_PROFILE_SCOPE("Interpreter::set_strings");
+        text_ = TextTemplates();
+        labels_.clear();
+        if (strings) labels_.resize(stmt_effects_.size());
+
+        // Same numbering as the constructor: text lines and statements run
+        // on across all scenes, duplicates included.
+        for (auto& entry : entries_) {
+            TextLineId id = entry.first_line;
+            std::uint32_t line = 0;
+            std::uint32_t choice = 0;
+            for (std::uint32_t i = 0; i < entry.stmt_count; ++i) {
+                const Stmt& st = stmts_[entry.first_stmt + i];
+                if (st.kind == StmtKind::Text) {
+                    for (std::uint32_t k = 0; k < st.count; ++k, ++id, ++line) {
+                        const auto text = strings ? strings->find(text_key_hash(entry.id, line)) : std::nullopt;
+                        text_.add(text ? *text : lines_[id]);
+                    }
+                }
+                else if (st.kind == StmtKind::Choice) {
+                    if (strings) {
+                        const auto label = strings->find(label_key_hash(entry.id, choice));
+                        labels_[entry.first_stmt + i] = label ? *label : st.label;
+                    }
+                    choice++;
+                }
+            }
+
+            // A translation may add placeholders the source line lacks, so
+            // memoization is decided again from the text now in use.
+            entry.dependency = classify(entry, entry.step_conditions);
         }
-        return nullptr;
+
+        for (auto& variants : memos_) variants.clear();
+    }
+
+    const Interpreter::SceneEntry* Interpreter::find_entry(std::string_view id) const {
+        auto it = scenes_.find(id);
+        return it == scenes_.end() ? nullptr : &entries_[it->second];
     }
 
     bool Interpreter::start(State& state, const std::string& start_scene_id) {
-        if (ast_.scenes.empty()) {
+        if (entries_.empty()) {
             diags_.error(SourcePos{ "<runtime>", 1, 1 }, "No scenes available to start.");
             return false;
         }
 
         if (!start_scene_id.empty()) {
-            if (!find_scene(start_scene_id)) {
+            if (!find_entry(start_scene_id)) {
                 diags_.error(SourcePos{ "<runtime>", 1, 1 }, "Start scene does not exist: " + start_scene_id);
                 return false;
             }
@@ -30,7 +251,7 @@ namespace tale_engine::runtime {
             return true;
         }
 
-        state.set_current_scene(ast_.scenes.front().id);
+        state.set_current_scene(entries_.front().id);
         return true;
     }
 
@@ -50,124 +271,250 @@ namespace tale_engine::runtime {
         return rv;
     }
 
-    void Interpreter::apply_effect(State& state, const dsl::EffectStmtAst& eff) {
-        const auto& call = eff.call;
-
-        if (const auto* s = std::get_if<dsl::EffectSetFlagAst>(&call)) {
-            state.set_flag(s->name, to_runtime_value(s->value));
-            return;
+    namespace {
+        // Handler for native effects the registry does not know; `user` is
+        // the effect's std::string_view in effect_names_.
+        void unregistered_effect(EffectCall& call) {
+            call.diagnostics.warning(call.pos,
+                "Effect is not registered: " + std::string(*static_cast<const std::string_view*>(call.user)));
         }
+    }
 
-        if (const auto* g = std::get_if<dsl::EffectGiveItemAst>(&call)) {
-            state.give_item(g->item_id, g->qty);
-            return;
+    void Interpreter::compile_effect(const EffectRegistry& effects, const dsl::EffectStmtAst& eff) {
+        const auto first_arg = static_cast<std::uint32_t>(effect_args_.size());
+        auto name_arg = [&](const SourcePos& pos, const std::string& name) { effect_args_.push_back(Value{ pos, name }); };
+        auto int_arg = [&](const SourcePos& pos, int n) { effect_args_.push_back(Value{ pos, n }); };
+
+        if (const auto* s = std::get_if<dsl::EffectSetFlagAst>(&eff.call)) {
+            name_arg(s->pos, s->name);
+            effect_args_.push_back(to_runtime_value(s->value));
+            resolve_effect(effects, dsl::SetFlag, {}, {}, &eff.pos, first_arg);
         }
+        else if (const auto* g = std::get_if<dsl::EffectGiveItemAst>(&eff.call)) {
+            name_arg(g->pos, g->item_id);
+            int_arg(g->pos, g->qty);
+            resolve_effect(effects, dsl::GiveItem, {}, {}, &eff.pos, first_arg);
+        }
+        else if (const auto* t = std::get_if<dsl::EffectTakeItemAst>(&eff.call)) {
+            name_arg(t->pos, t->item_id);
+            int_arg(t->pos, t->qty);
+            resolve_effect(effects, dsl::TakeItem, {}, {}, &eff.pos, first_arg);
+        }
+        else {
+            const auto& n = std::get<dsl::EffectNativeAst>(eff.call);
+            for (const auto& arg : n.args) effect_args_.push_back(to_runtime_value(arg));
+            resolve_effect(effects, effects.find(n.name), n.name, n.arg_kinds, &eff.pos, first_arg);
+        }
+    }
 
-        if (const auto* t = std::get_if<dsl::EffectTakeItemAst>(&call)) {
-            const bool ok = state.take_item(t->item_id, t->qty);
-            if (!ok) {
-                diags_.warning(t->pos, "take_item failed due to insufficient quantity: " + t->item_id);
+    void Interpreter::compile_effect(const EffectRegistry& effects, const EmbeddedStory& story, const EmbeddedStmt& eff) {
+        const auto first_arg = static_cast<std::uint32_t>(effect_args_.size());
+        const SourcePos* pos = &positions_.emplace_back(to_source_pos(story, eff.pos));
+        switch (eff.kind) {
+        case EmbeddedStmtKind::SetFlag:
+            effect_args_.push_back(Value{ *pos, std::string(eff.name) });
+            effect_args_.push_back(to_value(story, eff.value));
+            resolve_effect(effects, dsl::SetFlag, {}, {}, pos, first_arg);
+            break;
+        case EmbeddedStmtKind::GiveItem:
+        case EmbeddedStmtKind::TakeItem:
+            effect_args_.push_back(Value{ *pos, std::string(eff.name) });
+            effect_args_.push_back(Value{ *pos, eff.qty });
+            resolve_effect(effects, eff.kind == EmbeddedStmtKind::GiveItem ? dsl::GiveItem : dsl::TakeItem, {}, {}, pos, first_arg);
+            break;
+        default: {
+            std::vector<dsl::EffectArg> kinds;
+            for (const auto& arg : story.args.subspan(eff.first, eff.count)) {
+                kinds.push_back(arg.kind);
+                effect_args_.push_back(to_value(story, arg.value));
             }
-            return;
+            resolve_effect(effects, effects.find(eff.name), eff.name, kinds, pos, first_arg);
+            break;
+        }
         }
     }
 
-    bool Interpreter::try_extract_goto(
-        const std::vector<std::variant<dsl::GotoStmtAst, dsl::EffectStmtAst>>& body,
-        std::string& out_target) const {
-
-        for (const auto& s : body) {
-            if (const auto* g = std::get_if<dsl::GotoStmtAst>(&s)) {
-                out_target = g->target_scene_id;
-                return true;
-            }
+    // Binds the effect whose arguments start at effect_args_[first_arg].
+    // `arg_kinds` are a native call's; built-in statements pass none.
+    void Interpreter::resolve_effect(const EffectRegistry& effects, dsl::EffectId id, std::string_view name,
+        std::span<const dsl::EffectArg> arg_kinds, const SourcePos* pos, std::uint32_t first_arg) {
+        CompiledEffect c{ nullptr, nullptr, pos, first_arg, static_cast<std::uint32_t>(effect_args_.size()) - first_arg };
+        // Content parsed against a different table: only trust the registry
+        // if a native call's arguments still line up.
+        if (id != dsl::kNoEffect && !name.empty()) {
+            const auto& sig = effects.signatures().signature(id);
+            bool match = sig.arity == arg_kinds.size();
+            for (std::size_t i = 0; match && i < arg_kinds.size(); ++i) match = sig.args[i] == arg_kinds[i];
+            if (!match) id = dsl::kNoEffect;
+        }
+        if (id == dsl::kNoEffect) {
+            c.handler = unregistered_effect;
+            c.user = &effect_names_.emplace_back(name);
         }
-        return false;
+        else {
+            c.handler = effects.handler(id);
+            c.user = effects.user(id);
+        }
+        effects_.push_back(c);
+    }
+
+    void Interpreter::run_effect(State& state, std::uint32_t id) {
+        const CompiledEffect& c = effects_[id];
+        EffectCall call{ state, diags_, *c.pos, std::span<const Value>(effect_args_).subspan(c.first_arg, c.arg_count), c.user };
+        c.handler(call);
+        if (analytics_) analytics_->effect_run(id, call.failed);
     }
 
-    StepResult Interpreter::step(State& state) {
-        StepResult r;
+    const StepResult& Interpreter::step_ref(State& state) {
+        TALE_PROFILE_SCOPE("Interpreter::step");
 
-        const auto* scene = find_scene(state.current_scene());
-        if (!scene) {
+        const auto* entry = find_entry(state.current_scene());
+        if (!entry) {
             diags_.error(SourcePos{ "<runtime>", 1, 1 }, "Current scene does not exist: " + state.current_scene());
-            return r;
+            scratch_.text.clear();
+            scratch_.rendered.clear();
+            scratch_.choices.clear();
+            scratch_.next_scene_id = {};
+            return scratch_;
         }
+        if (analytics_) analytics_->scene_visited(entry->index);
 
-        // Execute statements in order until we reach a choice block.
-        for (std::size_t i = 0; i < scene->body.size(); ++i) {
-            const auto& stmt = scene->body[i];
+        if (entry->dependency == StepDependency::Full) {
+            execute(state, *entry, scratch_);
+            return scratch_;
+        }
+
+        // Key: headless flag, then one bit per conditional choice offered.
+        std::uint64_t key = headless_ ? 1 : 0;
+        if (entry->step_conditions > 0) {
+            condition_cache_.sync(state);
+            for (std::uint32_t c = 0; c < entry->step_conditions; ++c) {
+                if (condition_cache_.value(state, entry->first_condition + c)) key |= std::uint64_t{ 2 } << c;
+            }
+        }
+
+        auto& variants = memos_[entry->index];
+        for (const auto& [k, result] : variants) {
+            if (k == key) {
+                TALE_PROFILE_COUNT("Interpreter::step_memo_hits", 1);
+                return result;
+            }
+        }
+
+        execute(state, *entry, scratch_);
+        if (variants.size() < kMaxMemoVariants) {
+            variants.emplace_back(key, scratch_);
+            return variants.back().second;
+        }
+        return scratch_;
+    }
 
-            if (const auto* tb = std::get_if<dsl::TextBlockAst>(&stmt)) {
-                for (const auto& line : tb->lines) r.text.push_back(line);
+    void Interpreter::execute(State& state, const SceneEntry& entry, StepResult& r) {
+        r.text.clear();
+        r.rendered.clear();
+        r.choices.clear();
+        r.next_scene_id = {};
+
+        const Stmt* body = stmts_.data() + entry.first_stmt;
+        TextLineId line_id = entry.first_line;
+
+        // Execute statements in order until we reach a choice block.
+        for (std::uint32_t i = 0; i < entry.stmt_count; ++i) {
+            const Stmt& stmt = body[i];
+
+            if (stmt.kind == StmtKind::Text) {
+                if (!headless_) {
+                    for (TextLineId id = line_id; id < line_id + stmt.count; ++id) {
+                        if (text_.is_plain(id)) {
+                            const std::string_view line = text_.source(id);
+                            r.text.push_back(TextLine{ line.data(), 0, static_cast<std::uint32_t>(line.size()) });
+                            continue;
+                        }
+                        const auto offset = static_cast<std::uint32_t>(r.rendered.size());
+                        text_.render(state, id, r.rendered);
+                        r.text.push_back(TextLine{ nullptr, offset, static_cast<std::uint32_t>(r.rendered.size()) - offset });
+                    }
+                }
+                line_id += stmt.count;
                 continue;
             }
 
-            if (const auto* eff = std::get_if<dsl::EffectStmtAst>(&stmt)) {
-                apply_effect(state, *eff);
+            if (stmt.kind == StmtKind::Effect) {
+                run_effect(state, stmt_effects_[entry.first_stmt + i]);
                 continue;
             }
 
-            if (const auto* g = std::get_if<dsl::GotoStmtAst>(&stmt)) {
+            if (stmt.kind == StmtKind::Goto) {
                 // Immediate transfer.
-                r.next_scene_id = g->target_scene_id;
-                return r;
+                r.next_scene_id = stmt.target;
+                return;
             }
 
-            if (const auto* ch = std::get_if<dsl::ChoiceAst>(&stmt)) {
-                // Emit one choice option for this choice block.
-                r.choices.push_back(ChoiceOption{ ch->label, i });
-                // v1 behavior: collect consecutive choices too
-                for (std::size_t j = i + 1; j < scene->body.size(); ++j) {
-                    const auto& next = scene->body[j];
-                    if (const auto* ch2 = std::get_if<dsl::ChoiceAst>(&next)) {
-                        r.choices.push_back(ChoiceOption{ ch2->label, j });
-                        continue;
+            // v1 behavior: collect this and all consecutive choices. This is
+            // the scene's first run of choices, so its conditional choices
+            // are numbered from entry.first_condition.
+            ConditionId condition = entry.first_condition;
+            bool synced = false;
+            for (std::uint32_t j = i; j < entry.stmt_count && body[j].kind == StmtKind::Choice; ++j) {
+                const Stmt& ch = body[j];
+                if (ch.conditional) {
+                    if (!synced) {
+                        condition_cache_.sync(state);
+                        synced = true;
                     }
-                    break;
+                    if (!condition_cache_.value(state, condition++)) continue;
                 }
-                return r;
+                if (headless_) r.choices.push_back(ChoiceOption{ {}, j });
+                else if (labels_.empty()) r.choices.push_back(ChoiceOption{ ch.label, j });
+                else r.choices.push_back(ChoiceOption{ labels_[entry.first_stmt + j], j });
             }
+            return;
         }
 
         // Terminal scene: no next scene, no choices.
-        return r;
     }
 
     bool Interpreter::apply_choice(State& state, const StepResult& step, std::size_t choice_index) {
+        TALE_PROFILE_SCOPE("Interpreter::apply_choice");
         if (choice_index >= step.choices.size()) {
             diags_.error(SourcePos{ "<runtime>", 1, 1 }, "Choice index out of range.");
             return false;
         }
 
-        const auto* scene = find_scene(state.current_scene());
-        if (!scene) return false;
+        const auto* entry = find_entry(state.current_scene());
+        if (!entry) return false;
 
         const auto choice_stmt_index = step.choices[choice_index].choice_stmt_index;
-        if (choice_stmt_index >= scene->body.size()) return false;
+        if (choice_stmt_index >= entry->stmt_count) return false;
 
-        const auto* ch = std::get_if<dsl::ChoiceAst>(&scene->body[choice_stmt_index]);
-        if (!ch) return false;
+        const auto stmt = entry->first_stmt + static_cast<std::uint32_t>(choice_stmt_index);
+        const Stmt& ch = stmts_[stmt];
+        if (ch.kind != StmtKind::Choice) return false;
 
-        // Apply effects in the choice body, then goto (first goto wins).
-        std::string target;
-        for (const auto& s : ch->body) {
-            if (const auto* eff = std::get_if<dsl::EffectStmtAst>(&s)) {
-                apply_effect(state, *eff);
-            }
+        if (analytics_) analytics_->choice_selected(stmt);
+        state.advance_time(1);
+        if (triggers_) {
+            TriggerArgs args{ &state, kAnyEntity, static_cast<int>(choice_index) };
+            triggers_->fire(TriggerEvent::ChoiceSelected, kPlayerEntity, args);
         }
 
-        if (!try_extract_goto(ch->body, target)) {
-            diags_.warning(ch->pos, "Choice has no goto; staying in current scene.");
+        // Apply effects in the choice body, then goto (first goto wins).
+        const std::uint32_t first_effect = stmt_effects_[stmt];
+        for (std::uint32_t k = 0; k < ch.count; ++k) run_effect(state, first_effect + k);
+
+        if (!ch.has_goto) {
+            diags_.warning(*ch.pos, "Choice has no goto; staying in current scene.");
+            if (recorder_) recorder_->on_choice(static_cast<std::uint32_t>(choice_index), state);
             return true;
         }
 
-        if (!find_scene(target)) {
-            diags_.error(ch->pos, "Choice goto target does not exist: " + target);
+        if (!find_entry(ch.target)) {
+            diags_.error(*ch.pos, "Choice goto target does not exist: " + std::string(ch.target));
             return false;
         }
 
-        state.set_current_scene(target);
+        state.set_current_scene(ch.target);
+        if (recorder_) recorder_->on_choice(static_cast<std::uint32_t>(choice_index), state);
         return true;
     }
 
@@ -0,0 +1,316 @@
+#include "tale_engine/runtime/inventory.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "tale_engine/hash.h"
+#include "tale_engine/json.h"
+#include "tale_engine/profile.h"
+
+namespace tale_engine::runtime {
+
+    namespace {
+        // Quantities hash exactly as State hashed them before items moved
+        // here, so recorded sessions keep their hashes.
+        enum class HashTag : std::uint64_t { Item = 2, Equip = 7 };
+
+        std::uint64_t entry_hash(HashTag tag, std::string_view key, std::uint64_t value) {
+            return mix64(hash_combine(hash_combine(static_cast<std::uint64_t>(tag), fnv1a64(key)), value));
+        }
+
+        // Items with quantity 0 hash like absent items.
+        std::uint64_t item_hash(std::string_view item, int qty) {
+            return qty == 0 ? 0 : entry_hash(HashTag::Item, item, static_cast<std::uint64_t>(qty));
+        }
+
+        template <typename Map>
+        std::uint32_t intern_name(Map& index, std::vector<std::string>& names, std::string_view name) {
+            auto [it, inserted] = index.try_emplace(std::string(name), static_cast<std::uint32_t>(names.size()));
+            if (inserted) names.emplace_back(name);
+            return it->second;
+        }
+    }
+
+    ItemId ItemCatalog::add(std::string_view id, int weight, bool unique, std::string_view slot, std::span<const std::string> tags) {
+        if (!slot.empty() && !unique) return kNoItem;
+        const auto item = static_cast<ItemId>(defs_.size());
+        if (!index_.try_emplace(std::string(id), item).second) return kNoItem;
+
+        ItemDef def{ std::string(id), weight, unique, kNoEquipSlot, static_cast<std::uint32_t>(tags_.size()), 0 };
+        if (!slot.empty()) def.slot = intern_name(slot_index_, slot_names_, slot);
+        for (const auto& name : tags) {
+            const TagId tag = intern_name(tag_index_, tag_names_, name);
+            // A tag listed twice still counts once per unit.
+            if (std::find(tags_.begin() + def.first_tag, tags_.end(), tag) == tags_.end()) tags_.push_back(tag);
+        }
+        def.tag_count = static_cast<std::uint32_t>(tags_.size()) - def.first_tag;
+        defs_.push_back(std::move(def));
+        return item;
+    }
+
+    ItemId ItemCatalog::find(std::string_view id) const {
+        auto it = index_.find(std::string(id));
+        return it == index_.end() ? kNoItem : it->second;
+    }
+
+    TagId ItemCatalog::find_tag(std::string_view name) const {
+        auto it = tag_index_.find(std::string(name));
+        return it == tag_index_.end() ? static_cast<TagId>(-1) : it->second;
+    }
+
+    EquipSlot ItemCatalog::find_slot(std::string_view name) const {
+        auto it = slot_index_.find(std::string(name));
+        return it == slot_index_.end() ? kNoEquipSlot : it->second;
+    }
+
+    bool read_item_catalog(std::string_view json, const std::string& path, ItemCatalog& out, Diagnostics& diagnostics) {
+        JsonValue doc;
+        if (!parse_json(json, doc) || doc.kind() != JsonValue::Kind::Object) {
+            diagnostics.error(SourcePos{ path, 1, 1 }, "Item catalog is not a JSON object.");
+            return false;
+        }
+        if (doc["items"].kind() != JsonValue::Kind::Array) {
+            diagnostics.error(SourcePos{ path, 1, 1 }, "Item catalog has no \"items\" array.");
+            return false;
+        }
+
+        bool ok = true;
+        const auto& items = doc["items"].items();
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            const auto& item = items[i];
+            const std::string entry = "Item catalog entry " + std::to_string(i);
+            auto fail = [&](const std::string& message) {
+                diagnostics.error(SourcePos{ path, 1, 1 }, entry + " " + message);
+                ok = false;
+            };
+
+            const std::string& id = item["id"].as_string();
+            if (id.empty()) {
+                fail("needs an \"id\" string.");
+                continue;
+            }
+            const auto& weight = item["weight"];
+            const double w = weight.as_number();
+            if (!weight.is_null() && (weight.kind() != JsonValue::Kind::Number || w < 0 || w > INT32_MAX || std::floor(w) != w)) {
+                fail("has an invalid \"weight\" (expected a non-negative integer): " + id);
+                continue;
+            }
+            const auto& slot = item["slot"];
+            if (!slot.is_null() && (!slot.is_string() || slot.as_string().empty())) {
+                fail("has an invalid \"slot\" (expected a name): " + id);
+                continue;
+            }
+            std::vector<std::string> tags;
+            bool tags_ok = item["tags"].is_null() || item["tags"].kind() == JsonValue::Kind::Array;
+            for (const auto& tag : item["tags"].items()) {
+                tags_ok = tags_ok && tag.is_string() && !tag.as_string().empty();
+                tags.push_back(tag.as_string());
+            }
+            if (!tags_ok) {
+                fail("has invalid \"tags\" (expected a list of names): " + id);
+                continue;
+            }
+
+            const bool unique = item["unique"].as_bool();
+            if (!slot.is_null() && !unique) {
+                fail("names a slot but is not unique; only unique items can be equipped: " + id);
+                continue;
+            }
+            if (out.add(id, static_cast<int>(w), unique, slot.as_string(), tags) == kNoItem) {
+                fail("repeats item id: " + id);
+            }
+        }
+        return ok;
+    }
+
+    Inventory::Inventory(std::pmr::memory_resource* resource)
+        : names_(resource), index_(resource), qty_(resource), head_(resource), inst_item_(resource), inst_next_(resource),
+          inst_prev_(resource), inst_equipped_(resource), equipped_(resource), tag_counts_(resource) {
+    }
+
+    void Inventory::assign(const Inventory& other) {
+        if (this == &other) return;
+        // Copy assignment of pmr containers keeps this object's resource.
+        catalog_ = other.catalog_;
+        names_ = other.names_;
+        index_ = other.index_;
+        qty_ = other.qty_;
+        head_ = other.head_;
+        inst_item_ = other.inst_item_;
+        inst_next_ = other.inst_next_;
+        inst_prev_ = other.inst_prev_;
+        inst_equipped_ = other.inst_equipped_;
+        free_ = other.free_;
+        equipped_ = other.equipped_;
+        tag_counts_ = other.tag_counts_;
+        total_weight_ = other.total_weight_;
+        hash_ = other.hash_;
+    }
+
+    void Inventory::reset(const ItemCatalog* catalog) {
+        catalog_ = catalog;
+        names_.clear();
+        index_.clear();
+        qty_.clear();
+        head_.clear();
+        inst_item_.clear();
+        inst_next_.clear();
+        inst_prev_.clear();
+        inst_equipped_.clear();
+        free_ = kNoInstance;
+        equipped_.clear();
+        tag_counts_.clear();
+        total_weight_ = 0;
+        hash_ = 0;
+
+        if (!catalog_) return;
+        equipped_.assign(catalog_->slot_count(), kNoInstance);
+        tag_counts_.assign(catalog_->tag_count(), 0);
+        for (ItemId id = 0; id < catalog_->size(); ++id) append(catalog_->def(id).id);
+    }
+
+    ItemId Inventory::append(std::string_view name) {
+        const auto id = static_cast<ItemId>(names_.size());
+        names_.emplace_back(name);
+        index_.emplace(names_.back(), id);
+        qty_.push_back(0);
+        head_.push_back(kNoInstance);
+        return id;
+    }
+
+    ItemId Inventory::find(std::string_view name) const {
+        auto it = index_.find(name);
+        return it == index_.end() ? kNoItem : it->second;
+    }
+
+    ItemId Inventory::intern(std::string_view name) {
+        const ItemId id = find(name);
+        return id != kNoItem ? id : append(name);
+    }
+
+    void Inventory::set_qty(ItemId id, int qty) {
+        hash_ -= item_hash(names_[id], qty_[id]);
+        qty_[id] = qty;
+        hash_ += item_hash(names_[id], qty_[id]);
+    }
+
+    void Inventory::add_units(ItemId id, int qty) {
+        if (!catalog_ || id >= catalog_->size()) return; // undefined items weigh nothing
+        total_weight_ += static_cast<std::int64_t>(catalog_->def(id).weight) * qty;
+        for (const TagId tag : catalog_->tags(id)) tag_counts_[tag] += qty;
+    }
+
+    std::uint64_t Inventory::equip_hash(EquipSlot slot) const {
+        const InstanceId occupant = equipped_[slot];
+        return occupant == kNoInstance
+            ? 0
+            : entry_hash(HashTag::Equip, catalog_->slot_name(slot), fnv1a64(names_[inst_item_[occupant]]));
+    }
+
+    InstanceId Inventory::allocate(ItemId id) {
+        InstanceId instance = free_;
+        if (instance != kNoInstance) {
+            free_ = inst_next_[instance];
+        }
+        else {
+            instance = static_cast<InstanceId>(inst_item_.size());
+            inst_item_.push_back(kNoItem);
+            inst_next_.push_back(kNoInstance);
+            inst_prev_.push_back(kNoInstance);
+            inst_equipped_.push_back(kNoEquipSlot);
+        }
+        inst_item_[instance] = id;
+        inst_equipped_[instance] = kNoEquipSlot;
+        inst_prev_[instance] = kNoInstance;
+        inst_next_[instance] = head_[id];
+        if (head_[id] != kNoInstance) inst_prev_[head_[id]] = instance;
+        head_[id] = instance;
+        return instance;
+    }
+
+    void Inventory::release(InstanceId instance) {
+        const ItemId id = inst_item_[instance];
+        if (inst_equipped_[instance] != kNoEquipSlot) unequip(inst_equipped_[instance]);
+
+        const InstanceId next = inst_next_[instance];
+        const InstanceId prev = inst_prev_[instance];
+        if (next != kNoInstance) inst_prev_[next] = prev;
+        if (prev != kNoInstance) inst_next_[prev] = next;
+        else head_[id] = next;
+
+        inst_item_[instance] = kNoItem;
+        inst_next_[instance] = free_;
+        free_ = instance;
+    }
+
+    void Inventory::give(ItemId id, int qty) {
+        // Quantities saturate at the int range; the excess is not given, so
+        // weight, tags and instances stay in step with the quantity.
+        qty = std::min(qty, INT_MAX - qty_[id]);
+        if (qty <= 0) return;
+        set_qty(id, qty_[id] + qty);
+        add_units(id, qty);
+        if (catalog_ && id < catalog_->size() && catalog_->def(id).unique) {
+            TALE_PROFILE_COUNT("inventory.instances_created", qty);
+            for (int i = 0; i < qty; ++i) allocate(id);
+        }
+    }
+
+    bool Inventory::take(ItemId id, int qty) {
+        if (qty <= 0) return true;
+        if (qty_[id] < qty) return false;
+        set_qty(id, qty_[id] - qty);
+        add_units(id, -qty);
+
+        // Unequipped instances go first. An item fits one slot, so at most
+        // one instance is skipped.
+        int left = head_[id] == kNoInstance ? 0 : qty;
+        for (InstanceId i = head_[id]; i != kNoInstance && left > 0;) {
+            const InstanceId next = inst_next_[i];
+            if (inst_equipped_[i] == kNoEquipSlot) {
+                release(i);
+                left--;
+            }
+            i = next;
+        }
+        while (left > 0 && head_[id] != kNoInstance) {
+            release(head_[id]);
+            left--;
+        }
+        return true;
+    }
+
+    bool Inventory::equip(InstanceId instance) {
+        if (instance >= inst_item_.size() || inst_item_[instance] == kNoItem) return false;
+        const ItemId id = inst_item_[instance];
+        if (!catalog_ || id >= catalog_->size()) return false;
+        const EquipSlot slot = catalog_->def(id).slot;
+        if (slot == kNoEquipSlot) return false;
+        if (equipped_[slot] == instance) return true;
+
+        hash_ -= equip_hash(slot);
+        if (equipped_[slot] != kNoInstance) inst_equipped_[equipped_[slot]] = kNoEquipSlot;
+        equipped_[slot] = instance;
+        inst_equipped_[instance] = slot;
+        hash_ += equip_hash(slot);
+        return true;
+    }
+
+    InstanceId Inventory::unequip(EquipSlot slot) {
+        if (slot >= equipped_.size() || equipped_[slot] == kNoInstance) return kNoInstance;
+        const InstanceId instance = equipped_[slot];
+        hash_ -= equip_hash(slot);
+        inst_equipped_[instance] = kNoEquipSlot;
+        equipped_[slot] = kNoInstance;
+        return instance;
+    }
+
+    std::uint64_t Inventory::compute_hash() const {
+        std::uint64_t h = 0;
+        for (ItemId id = 0; id < size(); ++id) h += item_hash(names_[id], qty_[id]);
+        for (EquipSlot slot = 0; slot < equipped_.size(); ++slot) h += equip_hash(slot);
+        return h;
+    }
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,203 @@
+#include "tale_engine/runtime/rng.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "tale_engine/hash.h"
+
+namespace tale_engine::runtime {
+
+    // Known-answer vectors from the Random123 distribution (kat_vectors).
+    // Evaluated at compile time, so a compiler that miscompiles the round
+    // function fails the build instead of silently changing sequences.
+    static_assert(philox4x32_10({ 0, 0, 0, 0 }, { 0, 0 }) ==
+                  std::array<std::uint32_t, 4>{ 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u });
+    static_assert(philox4x32_10({ 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu }, { 0xffffffffu, 0xffffffffu }) ==
+                  std::array<std::uint32_t, 4>{ 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu });
+
+    namespace {
+        constexpr std::uint64_t kSplitTag = 0x73706c6974ull; // "split"
+
+        std::uint32_t lo32(std::uint64_t v) { return static_cast<std::uint32_t>(v); }
+        std::uint32_t hi32(std::uint64_t v) { return static_cast<std::uint32_t>(v >> 32); }
+
+        std::array<std::uint32_t, 4> block_at(std::uint64_t seed, std::uint64_t stream, std::uint64_t block) {
+            return philox4x32_10({ lo32(block), hi32(block), lo32(stream), hi32(stream) }, { lo32(seed), hi32(seed) });
+        }
+
+        // Writes `count` Philox blocks into out[0 .. 4 * count); block i uses
+        // the counter (block, stream) that counter(i) returns. Lanes are kept
+        // in separate arrays and every round is a branch-free loop over them,
+        // so the compiler can map the 32x32->64 multiplies onto SIMD lanes.
+        // Results are bit-identical to block_at().
+        template <typename Counter>
+        void generate_lanes(std::uint64_t seed, Counter&& counter, std::uint32_t* out, std::size_t count) {
+            constexpr std::size_t kLanes = 8;
+            std::size_t b = 0;
+            for (; b + kLanes <= count; b += kLanes) {
+                std::uint32_t c0[kLanes], c1[kLanes], c2[kLanes], c3[kLanes];
+                for (std::size_t l = 0; l < kLanes; ++l) {
+                    const auto [block, stream] = counter(b + l);
+                    c0[l] = lo32(block);
+                    c1[l] = hi32(block);
+                    c2[l] = lo32(stream);
+                    c3[l] = hi32(stream);
+                }
+
+                std::uint32_t k0 = lo32(seed);
+                std::uint32_t k1 = hi32(seed);
+                for (int round = 0; round < philox::kRounds; ++round) {
+                    for (std::size_t l = 0; l < kLanes; ++l) {
+                        const std::uint64_t p0 = static_cast<std::uint64_t>(philox::kMul0) * c0[l];
+                        const std::uint64_t p1 = static_cast<std::uint64_t>(philox::kMul1) * c2[l];
+                        const std::uint32_t n0 = hi32(p1) ^ c1[l] ^ k0;
+                        const std::uint32_t n2 = hi32(p0) ^ c3[l] ^ k1;
+                        c0[l] = n0;
+                        c1[l] = lo32(p1);
+                        c2[l] = n2;
+                        c3[l] = lo32(p0);
+                    }
+                    k0 += philox::kWeyl0;
+                    k1 += philox::kWeyl1;
+                }
+
+                std::uint32_t* dst = out + b * 4;
+                for (std::size_t l = 0; l < kLanes; ++l) {
+                    dst[l * 4 + 0] = c0[l];
+                    dst[l * 4 + 1] = c1[l];
+                    dst[l * 4 + 2] = c2[l];
+                    dst[l * 4 + 3] = c3[l];
+                }
+            }
+            for (; b < count; ++b) {
+                const auto [block, stream] = counter(b);
+                const auto r = block_at(seed, stream, block);
+                std::copy(r.begin(), r.end(), out + b * 4);
+            }
+        }
+
+        // `count` consecutive blocks of one stream, starting at `first`.
+        void generate_blocks(std::uint64_t seed, std::uint64_t stream, std::uint64_t first,
+                             std::uint32_t* out, std::size_t count) {
+            generate_lanes(seed, [&](std::size_t i) { return std::pair{ first + i, stream }; }, out, count);
+        }
+
+        // Lemire's nearly-divisionless bounded integer: the high word of x * bound
+        // is uniform once the low word clears the rejection threshold.
+        template <typename Next>
+        std::uint32_t bounded(std::uint32_t x, std::uint32_t bound, Next&& next) {
+            std::uint64_t m = static_cast<std::uint64_t>(x) * bound;
+            if (lo32(m) < bound) {
+                const std::uint32_t threshold = (0u - bound) % bound;
+                while (lo32(m) < threshold) {
+                    m = static_cast<std::uint64_t>(next()) * bound;
+                }
+            }
+            return hi32(m);
+        }
+    }
+
+    void philox_blocks(std::uint64_t seed, std::span<const std::uint64_t> streams, std::span<const std::uint64_t> blocks,
+                       std::uint32_t* out) {
+        assert(streams.size() == blocks.size());
+        generate_lanes(seed, [&](std::size_t i) { return std::pair{ blocks[i], streams[i] }; }, out, blocks.size());
+    }
+
+    Rng::Rng(std::uint64_t seed, std::uint64_t stream) : seed_(seed), stream_(stream) {
+    }
+
+    Rng Rng::split(std::uint64_t id) const {
+        return Rng(seed_, mix64(hash_combine(hash_combine(kSplitTag, stream_), id)));
+    }
+
+    void Rng::seek(std::uint64_t position) {
+        block_ = position / 4;
+        index_ = 4;
+        if (const auto r = static_cast<std::uint32_t>(position % 4); r != 0) {
+            refill();
+            index_ = r;
+        }
+    }
+
+    void Rng::refill() {
+        buffer_ = block_at(seed_, stream_, block_++);
+        index_ = 0;
+    }
+
+    std::uint32_t Rng::uniform(std::uint32_t bound) {
+        if (bound == 0) return 0;
+        return bounded(next_u32(), bound, [this] { return next_u32(); });
+    }
+
+    std::int32_t Rng::range(std::int32_t lo, std::int32_t hi) {
+        assert(lo <= hi);
+        const std::uint64_t span = static_cast<std::uint64_t>(static_cast<std::int64_t>(hi) - lo) + 1;
+        const std::uint32_t offset = span > 0xffffffffull ? next_u32() : uniform(static_cast<std::uint32_t>(span));
+        return static_cast<std::int32_t>(static_cast<std::int64_t>(lo) + offset);
+    }
+
+    std::int32_t Rng::roll(std::int32_t count, std::int32_t sides) {
+        if (count <= 0 || sides <= 0) return 0;
+        std::int32_t total = 0;
+        for (std::int32_t i = 0; i < count; ++i) {
+            total += static_cast<std::int32_t>(uniform(static_cast<std::uint32_t>(sides))) + 1;
+        }
+        return total;
+    }
+
+    void Rng::fill(std::span<std::uint32_t> out) {
+        std::size_t i = 0;
+        while (i < out.size() && index_ < 4) out[i++] = buffer_[index_++];
+
+        const std::size_t blocks = (out.size() - i) / 4;
+        generate_blocks(seed_, stream_, block_, out.data() + i, blocks);
+        block_ += blocks;
+        i += blocks * 4;
+
+        while (i < out.size()) out[i++] = next_u32();
+    }
+
+    void Rng::fill_uniform(std::span<std::uint32_t> out, std::uint32_t bound) {
+        if (bound == 0) {
+            std::fill(out.begin(), out.end(), 0u);
+            return;
+        }
+        // Raw words are generated in bulk; the rare rejected word is replaced
+        // from the stream in order, which keeps the result deterministic
+        // (though not identical to calling uniform() out.size() times).
+        fill(out);
+        for (auto& x : out) x = bounded(x, bound, [this] { return next_u32(); });
+    }
+
+    void Rng::fill_rolls(std::span<std::int32_t> out, std::int32_t count, std::int32_t sides) {
+        if (count <= 0 || sides <= 0) {
+            std::fill(out.begin(), out.end(), 0);
+            return;
+        }
+
+        constexpr std::size_t kChunk = 1024;
+        std::uint32_t faces[kChunk];
+        const auto dice = static_cast<std::size_t>(count);
+        const std::size_t rolls_per_chunk = std::max<std::size_t>(1, kChunk / dice);
+
+        std::size_t done = 0;
+        while (done < out.size()) {
+            const std::size_t rolls = std::min(rolls_per_chunk, out.size() - done);
+            if (rolls * dice > kChunk) {
+                // More dice per roll than fit a chunk; fall back to scalar rolls.
+                out[done++] = roll(count, sides);
+                continue;
+            }
+            const std::span<std::uint32_t> chunk(faces, rolls * dice);
+            fill_uniform(chunk, static_cast<std::uint32_t>(sides));
+            for (std::size_t r = 0; r < rolls; ++r) {
+                std::int32_t total = count;
+                for (std::size_t d = 0; d < dice; ++d) total += static_cast<std::int32_t>(chunk[r * dice + d]);
+                out[done + r] = total;
+            }
+            done += rolls;
+        }
+    }
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,141 @@
+#include "tale_engine/runtime/session_log.h"
+
+#include <utility>
+
+#include "tale_engine/binary_io.h"
+#include "tale_engine/compile/ast_codec.h"
+#include "tale_engine/hash.h"
+#include "tale_engine/profile.h"
+#include "tale_engine/runtime/interpreter.h"
+
+namespace tale_engine::runtime {
+
+    namespace {
+        constexpr std::string_view kSessionMagic = "TALESES\1";
+        constexpr std::uint32_t kSessionVersion = 1;
+
+        constexpr std::uint8_t kFlagHashes = 1;
+
+        // Upper bound on consecutive top-level gotos, so a goto cycle in
+        // content makes replay fail instead of spinning forever.
+        constexpr std::size_t kMaxTransfersPerStep = 1u << 16;
+    }
+
+    std::string encode_session(const SessionLog& log) {
+        ByteWriter w;
+        w.raw(kSessionMagic);
+        w.u32(kSessionVersion);
+        w.str(log.start_scene);
+        w.u64(log.seed);
+        w.u64(log.content_hash);
+        w.u8(log.has_hashes ? kFlagHashes : 0);
+        w.varint(log.choices.size());
+        for (std::size_t i = 0; i < log.choices.size(); ++i) {
+            w.varint(log.choices[i]);
+            if (log.has_hashes) w.u64(log.hashes[i]);
+        }
+        return w.take();
+    }
+
+    bool decode_session(std::string_view bytes, SessionLog& out) {
+        ByteReader r(bytes);
+        if (r.raw(kSessionMagic.size()) != kSessionMagic) return false;
+        if (r.u32() != kSessionVersion) return false;
+
+        SessionLog log;
+        log.start_scene = r.str();
+        log.seed = r.u64();
+        log.content_hash = r.u64();
+        log.has_hashes = (r.u8() & kFlagHashes) != 0;
+
+        const std::uint64_t n = r.varint();
+        if (!r.ok() || n > bytes.size()) return false; // each step takes >= 1 byte
+        log.choices.reserve(static_cast<std::size_t>(n));
+        if (log.has_hashes) log.hashes.reserve(static_cast<std::size_t>(n));
+        for (std::uint64_t i = 0; i < n && r.ok(); ++i) {
+            log.choices.push_back(static_cast<std::uint32_t>(r.varint()));
+            if (log.has_hashes) log.hashes.push_back(r.u64());
+        }
+        if (!r.ok() || !r.at_end()) return false;
+
+        out = std::move(log);
+        return true;
+    }
+
+    std::uint64_t content_hash(const dsl::FileAst& ast) {
+        return mix64(fnv1a64(compile::encode_file(ast)));
+    }
+
+    SessionRecorder::SessionRecorder(std::string start_scene, std::uint64_t seed, bool record_hashes) {
+        log_.start_scene = std::move(start_scene);
+        log_.seed = seed;
+        log_.has_hashes = record_hashes;
+    }
+
+    void SessionRecorder::on_choice(std::uint32_t choice_index, const State& state_after) {
+        log_.choices.push_back(choice_index);
+        if (log_.has_hashes) log_.hashes.push_back(state_after.hash());
+    }
+
+    ReplayResult replay(Interpreter& interpreter, State& state, const SessionLog& log,
+                        std::vector<std::string>* scene_trace) {
+        TALE_PROFILE_SCOPE("runtime::replay");
+        ReplayResult r;
+
+        const bool was_headless = interpreter.headless();
+        interpreter.set_headless(true);
+        struct Restore {
+            Interpreter& interp;
+            bool headless;
+            ~Restore() { interp.set_headless(headless); }
+        } restore{ interpreter, was_headless };
+
+        if (!interpreter.start(state, log.start_scene)) {
+            r.message = "Cannot start replay at scene '" + log.start_scene + "'.";
+            return r;
+        }
+
+        std::size_t transfers = 0;
+        while (r.steps < log.choices.size()) {
+            if (scene_trace) scene_trace->push_back(state.current_scene());
+            const StepResult& step = interpreter.step_ref(state);
+
+            if (!step.next_scene_id.empty()) {
+                if (++transfers > kMaxTransfersPerStep) {
+                    r.message = "Replay stuck in a goto cycle at scene '" + state.current_scene() + "'.";
+                    return r;
+                }
+                state.set_current_scene(step.next_scene_id);
+                continue;
+            }
+            transfers = 0;
+
+            if (step.choices.empty()) {
+                r.message = "Session reached terminal scene '" + state.current_scene() + "' before the log ended.";
+                return r;
+            }
+
+            const std::uint32_t choice = log.choices[r.steps];
+            if (!interpreter.apply_choice(state, step, choice)) {
+                r.message = "Choice " + std::to_string(choice) + " could not be applied in scene '" + state.current_scene() + "'.";
+                return r;
+            }
+
+            if (log.has_hashes) {
+                const std::uint64_t actual = state.hash();
+                if (actual != log.hashes[r.steps]) {
+                    r.diverged_at = r.steps;
+                    r.expected_hash = log.hashes[r.steps];
+                    r.actual_hash = actual;
+                    r.message = "State diverged at step " + std::to_string(r.steps) + ".";
+                    return r;
+                }
+            }
+            r.steps++;
+        }
+
+        r.ok = true;
+        return r;
+    }
+
+} // namespace tale_engine::runtime
@@ -1,49 +1,275 @@
 #include "tale_engine/runtime/state.h"
 
+#include <atomic>
 #include <utility>
 
+#include "tale_engine/hash.h"
+#include "tale_engine/profile.h"
+
 namespace tale_engine::runtime {
 
-	void State::set_flag(std::string name, Value v) {
-		flags_[std::move(name)] = std::move(v);
+	namespace {
+		// Zobrist-style hashing: each (key, value) entry maps to a pseudo-random
+		// 64-bit word and the state hash is their sum. Addition is commutative
+		// and invertible, so a mutation subtracts the old entry and adds the new
+		// one without touching the rest of the state.
+		// Items (2) are hashed by Inventory.
+		enum class HashTag : std::uint64_t { Flag = 1, Scene = 3 };
+
+		std::uint64_t value_hash(const FlagValue& v) {
+			if (const auto* s = std::get_if<std::pmr::string>(&v.data)) return hash_combine(1, fnv1a64(*s));
+			if (const auto* i = std::get_if<int>(&v.data)) return hash_combine(2, static_cast<std::uint64_t>(static_cast<std::int64_t>(*i)));
+			return hash_combine(3, std::get<bool>(v.data) ? 1 : 0);
+		}
+
+		std::uint64_t entry_hash(HashTag tag, std::string_view key, std::uint64_t value) {
+			return mix64(hash_combine(hash_combine(static_cast<std::uint64_t>(tag), fnv1a64(key)), value));
+		}
+
+		// Journal entries kept before the journal restarts under a new epoch.
+		constexpr std::size_t kJournalLimit = 4096;
+
+		std::uint64_t next_epoch() {
+			static std::atomic<std::uint64_t> counter{ 0 };
+			return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+	}
+
+	State::State(std::pmr::memory_resource* resource)
+		: flags_(resource), flag_index_(resource), inventory_(resource), stats_(resource),
+		  hash_(entry_hash(HashTag::Scene, current_scene_, 0)), journal_(resource), epoch_(next_epoch()) {
+	}
+
+	State::State(const State& other)
+		: flags_(other.resource()), flag_index_(other.resource()), inventory_(other.resource()),
+		  stats_(other.resource()), current_scene_(other.current_scene_), hash_(other.hash_), journal_(other.resource()), epoch_(next_epoch()) {
+		copy_slots(other);
+	}
+
+	State::State(State&& other) noexcept
+		: flags_(std::move(other.flags_)), flag_index_(std::move(other.flag_index_)), inventory_(std::move(other.inventory_)),
+		  stats_(std::move(other.stats_)), current_scene_(std::move(other.current_scene_)), hash_(other.hash_),
+		  journal_(other.resource()), epoch_(next_epoch()) {
+		other.restart_journal();
+	}
+
+	State& State::operator=(const State& other) {
+		if (this != &other) {
+			copy_slots(other);
+			current_scene_ = other.current_scene_;
+			hash_ = other.hash_;
+			restart_journal();
+		}
+		return *this;
+	}
+
+	State& State::operator=(State&& other) {
+		if (this != &other) {
+			// Moving slots allocated from another resource would leave their
+			// names pointing into it.
+			if (resource()->is_equal(*other.resource())) {
+				flags_ = std::move(other.flags_);
+				flag_index_ = std::move(other.flag_index_);
+				inventory_ = std::move(other.inventory_);
+				stats_ = std::move(other.stats_);
+			}
+			else {
+				copy_slots(other);
+			}
+			current_scene_ = std::move(other.current_scene_);
+			hash_ = other.hash_;
+			restart_journal();
+			other.restart_journal();
+		}
+		return *this;
+	}
+
+	void State::copy_slots(const State& other) {
+		std::pmr::memory_resource* const res = resource();
+		flags_.clear();
+		flag_index_.clear();
+		flags_.reserve(other.flags_.size());
+		flag_index_.reserve(other.flags_.size());
+		for (const auto& f : other.flags_) {
+			flag_index_.emplace(f.name, static_cast<SlotId>(flags_.size()));
+			FlagSlot slot{ std::pmr::string(f.name, res), FlagValue{ std::pmr::string(res) }, f.set };
+			if (const auto* s = std::get_if<std::pmr::string>(&f.value.data)) std::get<std::pmr::string>(slot.value.data) = *s;
+			else slot.value = f.value;
+			flags_.push_back(std::move(slot));
+		}
+		inventory_.assign(other.inventory_);
+		stats_.assign(other.stats_);
+	}
+
+	void State::restart_journal() {
+		journal_.clear();
+		epoch_ = next_epoch();
+	}
+
+	void State::record(SlotKind kind, SlotId slot) {
+		if (journal_.size() >= kJournalLimit) restart_journal();
+		journal_.push_back(StateChange{ kind, slot });
+	}
+
+	SlotId State::intern_flag(std::string_view name) {
+		auto it = flag_index_.find(name);
+		if (it != flag_index_.end()) return it->second;
+		const auto id = static_cast<SlotId>(flags_.size());
+		// The empty string placeholder must be on this resource too, as
+		// set_flag() reuses it.
+		flags_.push_back(FlagSlot{ std::pmr::string(name, resource()), FlagValue{ std::pmr::string(resource()) }, false });
+		flag_index_.emplace(name, id);
+		return id;
+	}
+
+	SlotId State::flag_slot(std::string_view name) {
+		return intern_flag(name);
+	}
+
+	SlotId State::item_slot(std::string_view name) {
+		return inventory_.intern(name);
+	}
+
+	const FlagValue* State::flag_at(SlotId slot) const {
+		const auto& f = flags_[slot];
+		return f.set ? &f.value : nullptr;
+	}
+
+	int State::item_qty_at(SlotId slot) const {
+		return inventory_.qty(slot);
+	}
+
+	SlotId State::stat_slot(std::string_view name) {
+		return stats_.intern(name);
+	}
+
+	void State::set_flag(std::string name, const Value& v) {
+		TALE_PROFILE_COUNT("State::set_flag", 1);
+		const SlotId slot = intern_flag(name);
+		auto& f = flags_[slot];
+		if (f.set) hash_ -= entry_hash(HashTag::Flag, f.name, value_hash(f.value));
+		if (const auto* s = std::get_if<std::string>(&v.data)) {
+			// Reuses the held string's capacity; it is on this state's resource.
+			if (auto* held = std::get_if<std::pmr::string>(&f.value.data)) held->assign(*s);
+			else f.value.data.emplace<std::pmr::string>(*s, resource());
+		}
+		else if (const auto* n = std::get_if<int>(&v.data)) {
+			f.value.data = *n;
+		}
+		else {
+			f.value.data = std::get<bool>(v.data);
+		}
+		f.set = true;
+		hash_ += entry_hash(HashTag::Flag, f.name, value_hash(f.value));
+		record(SlotKind::Flag, slot);
 	}
 
 	bool State::has_flag(const std::string& name) const {
-		return flags_.find(name) != flags_.end();
+		auto it = flag_index_.find(name);
+		return it != flag_index_.end() && flags_[it->second].set;
 	}
 
-	const Value* State::get_flag(const std::string& name) const {
-		auto it = flags_.find(name);
-		if (it == flags_.end()) return nullptr;
-		return &it->second;
+	const FlagValue* State::get_flag(const std::string& name) const {
+		auto it = flag_index_.find(name);
+		if (it == flag_index_.end()) return nullptr;
+		return flag_at(it->second);
 	}
 
 	void State::give_item(std::string item_id, int qty) {
+		TALE_PROFILE_COUNT("State::give_item", 1);
 		if (qty <= 0) return;
-		inventory_[std::move(item_id)] += qty;
+		const SlotId slot = inventory_.intern(item_id);
+		inventory_.give(slot, qty);
+		record(SlotKind::Item, slot);
 	}
 
 	bool State::take_item(const std::string& item_id, int qty) {
+		TALE_PROFILE_COUNT("State::take_item", 1);
 		if (qty <= 0) return true;
-		auto it = inventory_.find(item_id);
-		if (it == inventory_.end()) return false;
-		if (it->second < qty) return false;
-		it->second -= qty;
+		const ItemId slot = inventory_.find(item_id);
+		if (slot == kNoItem || !inventory_.take(slot, qty)) return false;
+		record(SlotKind::Item, slot);
 		return true;
 	}
 
 	int State::get_item_qty(const std::string& item_id) const {
-		auto it = inventory_.find(item_id);
-		if (it == inventory_.end()) return 0;
-		return it->second;
+		const ItemId slot = inventory_.find(item_id);
+		return slot == kNoItem ? 0 : inventory_.qty(slot);
+	}
+
+	void State::set_item_catalog(const ItemCatalog* catalog) {
+		inventory_.reset(catalog);
+		restart_journal();
+	}
+
+	// Equipment is not journaled: no condition or text reads it.
+	bool State::equip(InstanceId instance) {
+		return inventory_.equip(instance);
+	}
+
+	InstanceId State::unequip(EquipSlot slot) {
+		return inventory_.unequip(slot);
+	}
+
+	void State::record_stats() {
+		for (const StatId id : stats_.changed()) record(SlotKind::Stat, id);
+	}
+
+	void State::set_stat_schema(const StatSchema* schema) {
+		stats_.reset(schema);
+		restart_journal();
 	}
 
-	void State::set_current_scene(std::string id) {
-		current_scene_ = std::move(id);
+	int State::get_stat(std::string_view name) const {
+		const StatId id = stats_.find(name);
+		return id == kNoStat ? 0 : stats_.value(id);
+	}
+
+	void State::set_stat_base(SlotId slot, int base) {
+		TALE_PROFILE_COUNT("State::set_stat_base", 1);
+		stats_.set_base(slot, base);
+		record_stats();
+	}
+
+	ModifierId State::add_stat_modifier(const Modifier& modifier) {
+		TALE_PROFILE_COUNT("State::add_stat_modifier", 1);
+		const ModifierId id = stats_.add_modifier(modifier);
+		record_stats();
+		return id;
+	}
+
+	bool State::remove_stat_modifier(ModifierId id) {
+		const bool removed = stats_.remove_modifier(id);
+		record_stats();
+		return removed;
+	}
+
+	void State::advance_time(std::uint64_t ticks) {
+		stats_.advance(ticks);
+		record_stats();
+	}
+
+	void State::set_current_scene(std::string_view id) {
+		TALE_PROFILE_COUNT("State::set_current_scene", 1);
+		hash_ -= entry_hash(HashTag::Scene, current_scene_, 0);
+		current_scene_ = id;
+		hash_ += entry_hash(HashTag::Scene, current_scene_, 0);
 	}
 
 	const std::string& State::current_scene() const {
 		return current_scene_;
 	}
 
+	std::uint64_t State::hash() const {
+		return hash_ + inventory_.hash() + stats_.hash();
+	}
+
+	std::uint64_t State::compute_hash() const {
+		std::uint64_t h = entry_hash(HashTag::Scene, current_scene_, 0) + inventory_.compute_hash() + stats_.compute_hash();
+		for (const auto& f : flags_) {
+			if (f.set) h += entry_hash(HashTag::Flag, f.name, value_hash(f.value));
+		}
+		return h;
+	}
+
 } // namespace tale_engine::runtime
@@ -0,0 +1,343 @@
+#include "tale_engine/runtime/stats.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "tale_engine/hash.h"
+#include "tale_engine/profile.h"
+
+namespace tale_engine::runtime {
+
+    namespace {
+        // Same Zobrist-style scheme as State: entries are summed, so each
+        // mutation subtracts the old entry and adds the new one.
+        enum class HashTag : std::uint64_t { Base = 4, Modifier = 5, Clock = 6 };
+
+        std::uint64_t entry_hash(HashTag tag, std::string_view key, std::uint64_t value) {
+            return mix64(hash_combine(hash_combine(static_cast<std::uint64_t>(tag), fnv1a64(key)), value));
+        }
+
+        std::uint64_t clock_hash(std::uint64_t now) {
+            return entry_hash(HashTag::Clock, {}, now);
+        }
+
+        // Heap order for expiries: earliest first.
+        constexpr auto later = [](const auto& a, const auto& b) { return a.at > b.at; };
+
+        // Stale expiries (of modifiers removed early) tolerated before the
+        // heap is rebuilt.
+        constexpr std::size_t kExpirySlack = 64;
+    }
+
+    StatId StatSchema::add_base(std::string_view name, int base, int min, int max) {
+        return add_derived(name, {}, base, min, max);
+    }
+
+    StatId StatSchema::add_derived(std::string_view name, std::span<const StatTerm> terms, int base, int min, int max) {
+        const auto id = static_cast<StatId>(defs_.size());
+        for (const auto& t : terms) {
+            if (t.source >= id) return kNoStat;
+        }
+        if (!index_.try_emplace(std::string(name), id).second) return kNoStat;
+
+        defs_.push_back(StatDef{ std::string(name), base, min, max, static_cast<std::uint32_t>(terms_.size()),
+            static_cast<std::uint32_t>(terms.size()) });
+        terms_.insert(terms_.end(), terms.begin(), terms.end());
+        return id;
+    }
+
+    void StatSchema::finalize() {
+        // Invert stat -> sources into CSR source -> dependent stats.
+        deps_offsets_.assign(defs_.size() + 1, 0);
+        for (const auto& t : terms_) deps_offsets_[t.source + 1]++;
+        for (std::size_t i = 0; i < defs_.size(); ++i) deps_offsets_[i + 1] += deps_offsets_[i];
+
+        dependents_.resize(deps_offsets_.back());
+        std::vector<std::uint32_t> fill(deps_offsets_.begin(), deps_offsets_.end() - 1);
+        for (std::size_t s = 0; s < defs_.size(); ++s) {
+            for (const auto& t : terms(static_cast<StatId>(s))) dependents_[fill[t.source]++] = static_cast<StatId>(s);
+        }
+    }
+
+    StatId StatSchema::find(std::string_view name) const {
+        auto it = index_.find(std::string(name));
+        return it == index_.end() ? kNoStat : it->second;
+    }
+
+    Stats::Stats(std::pmr::memory_resource* resource)
+        : names_(resource), index_(resource), value_(resource), base_(resource), min_(resource), max_(resource),
+          add_sum_(resource), mul_sum_(resource), cap_(resource), caps_(resource), dirty_(resource),
+          mod_id_(resource), mod_stat_(resource), mod_kind_(resource), mod_amount_(resource), mod_expires_(resource),
+          mod_index_(resource), expiries_(resource), pending_(resource), changed_(resource) {
+    }
+
+    void Stats::assign(const Stats& other) {
+        if (this == &other) return;
+        // Copy assignment of pmr containers keeps this object's resource.
+        schema_ = other.schema_;
+        names_ = other.names_;
+        index_ = other.index_;
+        value_ = other.value_;
+        base_ = other.base_;
+        min_ = other.min_;
+        max_ = other.max_;
+        add_sum_ = other.add_sum_;
+        mul_sum_ = other.mul_sum_;
+        cap_ = other.cap_;
+        caps_ = other.caps_;
+        dirty_ = other.dirty_;
+        mod_id_ = other.mod_id_;
+        mod_stat_ = other.mod_stat_;
+        mod_kind_ = other.mod_kind_;
+        mod_amount_ = other.mod_amount_;
+        mod_expires_ = other.mod_expires_;
+        mod_index_ = other.mod_index_;
+        next_modifier_ = other.next_modifier_;
+        expiries_ = other.expiries_;
+        now_ = other.now_;
+        timed_ = other.timed_;
+        pending_.clear();
+        changed_.clear();
+        hash_ = other.hash_;
+    }
+
+    void Stats::reset(const StatSchema* schema) {
+        schema_ = schema;
+        names_.clear();
+        index_.clear();
+        value_.clear();
+        base_.clear();
+        min_.clear();
+        max_.clear();
+        add_sum_.clear();
+        mul_sum_.clear();
+        cap_.clear();
+        caps_.clear();
+        dirty_.clear();
+        mod_id_.clear();
+        mod_stat_.clear();
+        mod_kind_.clear();
+        mod_amount_.clear();
+        mod_expires_.clear();
+        mod_index_.clear();
+        next_modifier_ = 1;
+        expiries_.clear();
+        now_ = 0;
+        timed_ = 0;
+        pending_.clear();
+        changed_.clear();
+        hash_ = 0;
+
+        if (!schema_) return;
+        for (StatId id = 0; id < schema_->size(); ++id) {
+            const StatDef& def = schema_->def(id);
+            append(def.name, def.base, def.min, def.max);
+        }
+    }
+
+    StatId Stats::append(std::string_view name, int base, int min, int max) {
+        const auto id = static_cast<StatId>(names_.size());
+        names_.emplace_back(name);
+        index_.emplace(names_.back(), id);
+        value_.push_back(0);
+        base_.push_back(base);
+        min_.push_back(min);
+        max_.push_back(max);
+        add_sum_.push_back(0);
+        mul_sum_.push_back(0);
+        cap_.push_back(0);
+        caps_.emplace_back();
+        dirty_.push_back(0);
+        // Sources have lower ids, so they already hold their values.
+        value_[id] = compute(id);
+        return id;
+    }
+
+    StatId Stats::find(std::string_view name) const {
+        auto it = index_.find(name);
+        return it == index_.end() ? kNoStat : it->second;
+    }
+
+    StatId Stats::intern(std::string_view name) {
+        const StatId id = find(name);
+        return id != kNoStat ? id : append(name, 0, INT_MIN, INT_MAX);
+    }
+
+    int Stats::default_base(StatId id) const {
+        return schema_ && id < schema_->size() ? schema_->def(id).base : 0;
+    }
+
+    std::uint64_t Stats::base_hash(StatId id) const {
+        return base_[id] == default_base(id)
+            ? 0
+            : entry_hash(HashTag::Base, names_[id], static_cast<std::uint64_t>(static_cast<std::int64_t>(base_[id])));
+    }
+
+    std::uint64_t Stats::modifier_hash(std::size_t index) const {
+        std::uint64_t v = static_cast<std::uint64_t>(mod_kind_[index]);
+        v = hash_combine(v, static_cast<std::uint64_t>(static_cast<std::int64_t>(mod_amount_[index])));
+        v = hash_combine(v, mod_expires_[index]);
+        return entry_hash(HashTag::Modifier, names_[mod_stat_[index]], v);
+    }
+
+    int Stats::compute(StatId id) const {
+        std::int64_t v = base_[id];
+        if (schema_ && id < schema_->size()) {
+            std::int64_t sum = 0;
+            for (const auto& t : schema_->terms(id)) sum += static_cast<std::int64_t>(value_[t.source]) * t.percent;
+            v += sum / 100;
+        }
+        v = std::clamp<std::int64_t>(v + add_sum_[id], INT_MIN, INT_MAX);
+        v = v * std::clamp<std::int64_t>(100 + mul_sum_[id], 0, INT_MAX) / 100;
+        if (!caps_[id].empty()) v = std::min<std::int64_t>(v, cap_[id]);
+        return static_cast<int>(std::clamp<std::int64_t>(v, min_[id], max_[id]));
+    }
+
+    void Stats::mark(StatId id) {
+        if (dirty_[id]) return;
+        dirty_[id] = 1;
+        pending_.push_back(id);
+        std::push_heap(pending_.begin(), pending_.end(), std::greater<>{});
+    }
+
+    void Stats::flush() {
+        // Lowest id first: every source of a stat is final before the stat
+        // itself is recomputed, so each dirty stat is computed once.
+        while (!pending_.empty()) {
+            std::pop_heap(pending_.begin(), pending_.end(), std::greater<>{});
+            const StatId id = pending_.back();
+            pending_.pop_back();
+            dirty_[id] = 0;
+
+            TALE_PROFILE_COUNT("stats.recomputed", 1);
+            const int v = compute(id);
+            if (v == value_[id]) continue;
+            value_[id] = v;
+            changed_.push_back(id);
+            if (schema_ && id < schema_->size()) {
+                for (const StatId d : schema_->dependents(id)) mark(d);
+            }
+        }
+    }
+
+    void Stats::set_base(StatId id, int base) {
+        changed_.clear();
+        if (base_[id] == base) return;
+        hash_ -= base_hash(id);
+        base_[id] = base;
+        hash_ += base_hash(id);
+        mark(id);
+        flush();
+    }
+
+    ModifierId Stats::add_modifier(const Modifier& m) {
+        changed_.clear();
+        if (m.stat >= size()) return kNoModifier;
+
+        const ModifierId id = next_modifier_++;
+        const auto index = static_cast<std::uint32_t>(mod_id_.size());
+        mod_id_.push_back(id);
+        mod_stat_.push_back(m.stat);
+        mod_kind_.push_back(m.kind);
+        mod_amount_.push_back(m.amount);
+        mod_expires_.push_back(m.duration ? now_ + m.duration : 0);
+        mod_index_.emplace(id, index);
+
+        switch (m.kind) {
+        case ModifierKind::Add: add_sum_[m.stat] += m.amount; break;
+        case ModifierKind::Multiply: mul_sum_[m.stat] += m.amount; break;
+        case ModifierKind::Cap:
+            cap_[m.stat] = caps_[m.stat].empty() ? m.amount : std::min(cap_[m.stat], m.amount);
+            caps_[m.stat].push_back(m.amount);
+            break;
+        }
+        if (m.duration) {
+            expiries_.push_back(Expiry{ mod_expires_[index], id });
+            std::push_heap(expiries_.begin(), expiries_.end(), later);
+            timed_++;
+        }
+        hash_ += modifier_hash(index);
+
+        mark(m.stat);
+        flush();
+        return id;
+    }
+
+    bool Stats::remove_modifier(ModifierId id) {
+        changed_.clear();
+        auto it = mod_index_.find(id);
+        if (it == mod_index_.end()) return false;
+        remove_at(it->second);
+        flush();
+
+        if (expiries_.size() > 2 * timed_ + kExpirySlack) {
+            std::erase_if(expiries_, [&](const Expiry& e) { return !mod_index_.contains(e.id); });
+            std::make_heap(expiries_.begin(), expiries_.end(), later);
+        }
+        return true;
+    }
+
+    void Stats::remove_at(std::size_t index) {
+        const StatId stat = mod_stat_[index];
+        const int amount = mod_amount_[index];
+        hash_ -= modifier_hash(index);
+        if (mod_expires_[index]) timed_--;
+        mod_index_.erase(mod_id_[index]);
+
+        const std::size_t last = mod_id_.size() - 1;
+        const ModifierKind kind = mod_kind_[index];
+        if (index != last) {
+            mod_id_[index] = mod_id_[last];
+            mod_stat_[index] = mod_stat_[last];
+            mod_kind_[index] = mod_kind_[last];
+            mod_amount_[index] = mod_amount_[last];
+            mod_expires_[index] = mod_expires_[last];
+            mod_index_[mod_id_[index]] = static_cast<std::uint32_t>(index);
+        }
+        mod_id_.pop_back();
+        mod_stat_.pop_back();
+        mod_kind_.pop_back();
+        mod_amount_.pop_back();
+        mod_expires_.pop_back();
+
+        switch (kind) {
+        case ModifierKind::Add: add_sum_[stat] -= amount; break;
+        case ModifierKind::Multiply: mul_sum_[stat] -= amount; break;
+        case ModifierKind::Cap: {
+            // Caps of equal amount are interchangeable, so any one will do.
+            auto& caps = caps_[stat];
+            *std::find(caps.begin(), caps.end(), amount) = caps.back();
+            caps.pop_back();
+            // The lowest cap went away: find the next one among this stat's.
+            if (!caps.empty() && amount == cap_[stat]) cap_[stat] = *std::min_element(caps.begin(), caps.end());
+            break;
+        }
+        }
+        mark(stat);
+    }
+
+    void Stats::advance(std::uint64_t ticks) {
+        changed_.clear();
+        now_ += ticks;
+        while (!expiries_.empty() && expiries_.front().at <= now_) {
+            std::pop_heap(expiries_.begin(), expiries_.end(), later);
+            const Expiry e = expiries_.back();
+            expiries_.pop_back();
+            auto it = mod_index_.find(e.id);
+            if (it != mod_index_.end()) remove_at(it->second);
+        }
+        flush();
+    }
+
+    std::uint64_t Stats::hash() const {
+        return hash_ + (timed_ ? clock_hash(now_) : 0);
+    }
+
+    std::uint64_t Stats::compute_hash() const {
+        std::uint64_t h = timed_ ? clock_hash(now_) : 0;
+        for (StatId id = 0; id < size(); ++id) h += base_hash(id);
+        for (std::size_t i = 0; i < mod_id_.size(); ++i) h += modifier_hash(i);
+        return h;
+    }
+
+} // namespace tale_engine::runtime
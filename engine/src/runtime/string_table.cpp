@@ -0,0 +1,159 @@
+#include "tale_engine/runtime/string_table.h"
+
+#include <charconv>
+#include <fstream>
+#include <sstream>
+
+#include "tale_engine/hash.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TALE_STRING_TABLE_MMAP 1
+#endif
+
+namespace tale_engine::runtime {
+
+    namespace {
+        constexpr std::size_t kHeaderSize = 20; // magic, version, count, locale_size
+        constexpr std::size_t kEntrySize = 16;
+
+        std::uint32_t load_u32(const char* p) {
+            std::uint32_t v = 0;
+            for (int i = 0; i < 4; ++i) v |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(p[i])) << (8 * i);
+            return v;
+        }
+
+        std::uint64_t load_u64(const char* p) {
+            return load_u32(p) | static_cast<std::uint64_t>(load_u32(p + 4)) << 32;
+        }
+
+        std::string make_key(std::string_view scene, std::string_view tag, std::uint32_t n) {
+            char digits[12];
+            const auto res = std::to_chars(digits, digits + sizeof(digits), n);
+            std::string key;
+            key.reserve(scene.size() + tag.size() + static_cast<std::size_t>(res.ptr - digits));
+            key.append(scene).append(tag).append(digits, res.ptr);
+            return key;
+        }
+
+        std::uint64_t hash_key(std::string_view scene, std::string_view tag, std::uint32_t n) {
+            char digits[12];
+            const auto res = std::to_chars(digits, digits + sizeof(digits), n);
+            return fnv1a64(std::string_view(digits, static_cast<std::size_t>(res.ptr - digits)), fnv1a64(tag, fnv1a64(scene)));
+        }
+    }
+
+    std::string text_key(std::string_view scene, std::uint32_t line) { return make_key(scene, ".t", line); }
+    std::string label_key(std::string_view scene, std::uint32_t choice) { return make_key(scene, ".c", choice); }
+    std::uint64_t text_key_hash(std::string_view scene, std::uint32_t line) { return hash_key(scene, ".t", line); }
+    std::uint64_t label_key_hash(std::string_view scene, std::uint32_t choice) { return hash_key(scene, ".c", choice); }
+
+    StringTable::~StringTable() {
+        unmap();
+    }
+
+    void StringTable::unmap() {
+#if defined(TALE_STRING_TABLE_MMAP)
+        if (mapping_) munmap(mapping_, mapping_size_);
+#endif
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+
+    void StringTable::close() {
+        unmap();
+        buffer_.clear();
+        buffer_.shrink_to_fit();
+        bytes_ = {};
+        locale_ = {};
+        index_offset_ = strings_offset_ = 0;
+        count_ = 0;
+    }
+
+    bool StringTable::open(const std::string& path) {
+        close();
+#if defined(TALE_STRING_TABLE_MMAP)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st {};
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            mapped = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        mapping_ = mapped;
+        mapping_size_ = static_cast<std::size_t>(st.st_size);
+        if (load(std::string_view(static_cast<const char*>(mapped), mapping_size_))) return true;
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        std::ostringstream ss;
+        ss << in.rdbuf();
+        buffer_ = ss.str();
+        if (load(buffer_)) return true;
+#endif
+        close();
+        return false;
+    }
+
+    bool StringTable::view(std::string_view bytes) {
+        close();
+        if (load(bytes)) return true;
+        close();
+        return false;
+    }
+
+    // Validates the header and every index entry once, so find() can trust
+    // offsets without further checks.
+    bool StringTable::load(std::string_view bytes) {
+        if (bytes.size() < kHeaderSize || bytes.substr(0, kStringTableMagic.size()) != kStringTableMagic) return false;
+        if (load_u32(bytes.data() + 8) != kStringTableVersion) return false;
+        const std::uint32_t count = load_u32(bytes.data() + 12);
+        const std::uint32_t locale_size = load_u32(bytes.data() + 16);
+        if (locale_size > bytes.size() - kHeaderSize) return false;
+
+        const std::size_t index = (kHeaderSize + locale_size + 7) & ~std::size_t{ 7 };
+        if (index > bytes.size() || count > (bytes.size() - index) / kEntrySize) return false;
+        const std::size_t strings = index + std::size_t{ count } * kEntrySize;
+        const std::size_t strings_size = bytes.size() - strings;
+
+        std::uint64_t previous = 0;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const char* entry = bytes.data() + index + std::size_t{ i } * kEntrySize;
+            const std::uint64_t key = load_u64(entry);
+            const std::uint64_t offset = load_u32(entry + 8);
+            const std::uint64_t size = load_u32(entry + 12);
+            if ((i > 0 && key <= previous) || offset > strings_size || size > strings_size - offset) return false;
+            previous = key;
+        }
+
+        bytes_ = bytes;
+        locale_ = bytes.substr(kHeaderSize, locale_size);
+        index_offset_ = index;
+        strings_offset_ = strings;
+        count_ = count;
+        return true;
+    }
+
+    std::optional<std::string_view> StringTable::find(std::uint64_t key_hash) const {
+        const char* index = bytes_.data() + index_offset_;
+        std::size_t lo = 0;
+        std::size_t hi = count_;
+        while (lo < hi) {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            const char* entry = index + mid * kEntrySize;
+            const std::uint64_t key = load_u64(entry);
+            if (key == key_hash) {
+                return bytes_.substr(strings_offset_ + load_u32(entry + 8), load_u32(entry + 12));
+            }
+            if (key < key_hash) lo = mid + 1;
+            else hi = mid;
+        }
+        return std::nullopt;
+    }
+
+} // namespace tale_engine::runtime
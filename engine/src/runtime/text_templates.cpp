@@ -0,0 +1,90 @@
+#include "tale_engine/runtime/text_templates.h"
+
+#include <charconv>
+
+namespace tale_engine::runtime {
+
+    namespace {
+        void append_int(std::pmr::string& out, long long v) {
+            char buf[24];
+            const auto res = std::to_chars(buf, buf + sizeof(buf), v);
+            out.append(buf, res.ptr);
+        }
+    }
+
+    std::uint32_t TextTemplates::input(SlotKind kind, std::string_view name) {
+        auto [it, inserted] = input_index_[static_cast<std::size_t>(kind)].try_emplace(name, static_cast<std::uint32_t>(inputs_.size()));
+        if (inserted) inputs_.push_back(Input{ kind, name });
+        return it->second;
+    }
+
+    TextLineId TextTemplates::add(std::string_view line) {
+        const auto id = static_cast<TextLineId>(lines_.size());
+        Line l{ line };
+        if (!dsl::is_plain_text(line)) {
+            const auto parse = dsl::parse_template(line);
+            if (!parse.error) {
+                l.plain = false;
+                l.first = static_cast<std::uint32_t>(segments_.size());
+                for (const auto& part : parse.parts) {
+                    Segment seg{ part.kind };
+                    switch (part.kind) {
+                    case dsl::TemplatePartKind::Literal:
+                        seg.text = part.text;
+                        break;
+                    case dsl::TemplatePartKind::Flag:
+                        seg.input = input(SlotKind::Flag, part.text);
+                        l.dynamic = true;
+                        break;
+                    case dsl::TemplatePartKind::Item:
+                        seg.input = input(SlotKind::Item, part.text);
+                        l.dynamic = true;
+                        break;
+                    }
+                    segments_.push_back(seg);
+                }
+                l.count = static_cast<std::uint32_t>(segments_.size()) - l.first;
+            }
+        }
+        lines_.push_back(l);
+        return id;
+    }
+
+    void TextTemplates::bind(State& state) {
+        if (state.journal_epoch() == bound_epoch_) return;
+        slots_.resize(inputs_.size());
+        for (std::size_t i = 0; i < inputs_.size(); ++i) {
+            slots_[i] = inputs_[i].kind == SlotKind::Flag ? state.flag_slot(inputs_[i].name) : state.item_slot(inputs_[i].name);
+        }
+        bound_epoch_ = state.journal_epoch();
+    }
+
+    void TextTemplates::render(State& state, TextLineId id, std::pmr::string& out) {
+        const Line& line = lines_[id];
+        if (line.plain) {
+            out += line.source;
+            return;
+        }
+        if (line.dynamic) bind(state);
+
+        for (std::uint32_t i = line.first; i < line.first + line.count; ++i) {
+            const Segment& seg = segments_[i];
+            switch (seg.kind) {
+            case dsl::TemplatePartKind::Literal:
+                out += seg.text;
+                break;
+            case dsl::TemplatePartKind::Flag:
+                if (const FlagValue* v = state.flag_at(slots_[seg.input])) {
+                    if (const auto* s = std::get_if<std::pmr::string>(&v->data)) out += *s;
+                    else if (const auto* n = std::get_if<int>(&v->data)) append_int(out, *n);
+                    else out += std::get<bool>(v->data) ? "true" : "false";
+                }
+                break;
+            case dsl::TemplatePartKind::Item:
+                append_int(out, state.item_qty_at(slots_[seg.input]));
+                break;
+            }
+        }
+    }
+
+} // namespace tale_engine::runtime
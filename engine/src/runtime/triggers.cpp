@@ -0,0 +1,239 @@
+#include "tale_engine/runtime/triggers.h"
+
+#include <algorithm>
+
+#include "tale_engine/profile.h"
+
+namespace tale_engine::runtime {
+
+    TriggerSystem::TriggerSystem() {
+        any_buckets_.fill(kNoBucket);
+    }
+
+    TriggerKindId TriggerSystem::add_kind(TriggerKind kind) {
+        if (!kind.handler) return kNoTriggerKind;
+        const auto id = static_cast<TriggerKindId>(kinds_.size());
+        if (!kind_index_.try_emplace(kind.name, id).second) return kNoTriggerKind;
+        kind.max_stacks = std::max<std::uint16_t>(1, kind.max_stacks);
+        stacking_index_.push_back(kind.stacking == StackRule::Independent ? kNoIndex : stacking_kinds_++);
+        kinds_.push_back(std::move(kind));
+        return id;
+    }
+
+    TriggerKindId TriggerSystem::find_kind(std::string_view name) const {
+        auto it = kind_index_.find(std::string(name));
+        return it == kind_index_.end() ? kNoTriggerKind : it->second;
+    }
+
+    std::uint32_t TriggerSystem::find_bucket(TriggerEvent event, EntityId entity) const {
+        const auto e = static_cast<std::size_t>(event);
+        if (entity == kAnyEntity) return any_buckets_[e];
+        const auto& table = entity_buckets_[e];
+        return entity < table.size() ? table[entity] : kNoBucket;
+    }
+
+    std::uint32_t TriggerSystem::make_bucket(TriggerEvent event, EntityId entity) {
+        const auto e = static_cast<std::size_t>(event);
+        std::uint32_t* bucket = &any_buckets_[e];
+        if (entity != kAnyEntity) {
+            auto& table = entity_buckets_[e];
+            if (entity >= table.size()) table.resize(static_cast<std::size_t>(entity) + 1, kNoBucket);
+            bucket = &table[entity];
+        }
+        if (*bucket == kNoBucket) {
+            *bucket = static_cast<std::uint32_t>(buckets_.size());
+            buckets_.emplace_back();
+        }
+        return *bucket;
+    }
+
+    TriggerHandle TriggerSystem::apply(TriggerKindId kind, TriggerEvent event, EntityId entity, int magnitude,
+                                       std::uint16_t charges, EntityId source) {
+        if (kind >= kinds_.size()) return {};
+        const TriggerKind& k = kinds_[kind];
+        const std::uint32_t b = make_bucket(event, entity);
+        Bucket& bucket = buckets_[b];
+        auto& slots = bucket.slots;
+
+        const std::uint32_t column = stacking_index_[kind];
+        if (column != kNoIndex) {
+            if (bucket.merge.size() <= column) bucket.merge.resize(stacking_kinds_, kNoIndex);
+            if (const std::uint32_t existing = bucket.merge[column]; existing != kNoIndex) {
+                ActiveTrigger& e = slots[handle_pos_[existing]].effect;
+                switch (k.stacking) {
+                case StackRule::Stack:
+                    e.stacks = static_cast<std::uint16_t>(std::min<int>(e.stacks + 1, k.max_stacks));
+                    e.magnitude = magnitude;
+                    e.charges = charges;
+                    break;
+                case StackRule::Refresh:
+                    e.magnitude = std::max(e.magnitude, magnitude);
+                    e.charges = charges;
+                    break;
+                case StackRule::Replace:
+                    e.magnitude = magnitude;
+                    e.charges = charges;
+                    e.source = source;
+                    break;
+                case StackRule::Independent:
+                    break;
+                }
+                TALE_PROFILE_COUNT("triggers.merged", 1);
+                return TriggerHandle{ existing, handle_generation_[existing] };
+            }
+        }
+
+        std::uint32_t handle;
+        if (!free_handles_.empty()) {
+            handle = free_handles_.back();
+            free_handles_.pop_back();
+        }
+        else {
+            handle = static_cast<std::uint32_t>(handle_bucket_.size());
+            handle_bucket_.push_back(kNoBucket);
+            handle_pos_.push_back(0);
+            handle_generation_.push_back(0);
+        }
+        handle_bucket_[handle] = b;
+        handle_pos_[handle] = static_cast<std::uint32_t>(slots.size());
+        slots.push_back(Slot{ ActiveTrigger{ kind, source, magnitude, 1, charges }, handle });
+        if (column != kNoIndex) bucket.merge[column] = handle;
+        live_++;
+        return TriggerHandle{ handle, handle_generation_[handle] };
+    }
+
+    bool TriggerSystem::contains(TriggerHandle handle) const {
+        return handle.index < handle_bucket_.size() && handle_generation_[handle.index] == handle.generation &&
+               handle_bucket_[handle.index] != kNoBucket;
+    }
+
+    const ActiveTrigger* TriggerSystem::get(TriggerHandle handle) const {
+        if (!contains(handle)) return nullptr;
+        return &buckets_[handle_bucket_[handle.index]].slots[handle_pos_[handle.index]].effect;
+    }
+
+    bool TriggerSystem::remove(TriggerHandle handle) {
+        if (!contains(handle)) return false;
+        remove_at(handle_bucket_[handle.index], handle_pos_[handle.index]);
+        return true;
+    }
+
+    void TriggerSystem::remove_at(std::uint32_t bucket, std::uint32_t pos) {
+        Bucket& b = buckets_[bucket];
+        const std::uint32_t handle = b.slots[pos].handle;
+        if (const std::uint32_t column = stacking_index_[b.slots[pos].effect.kind]; column != kNoIndex) b.merge[column] = kNoIndex;
+        handle_bucket_[handle] = kNoBucket;
+        handle_generation_[handle]++;
+        live_--;
+
+        // A fire() may be walking this bucket; leave the slot in place. Its
+        // handle index stays out of use until compact() drops the slot, so a
+        // slot never names an index another effect holds.
+        if (firing_ > 0) {
+            released_handles_.push_back(handle);
+            b.slots[pos].effect.kind = kNoTriggerKind;
+            if (!b.dirty) {
+                b.dirty = true;
+                dirty_.push_back(bucket);
+            }
+            return;
+        }
+        free_handles_.push_back(handle);
+        if (pos + 1 != b.slots.size()) {
+            b.slots[pos] = b.slots.back();
+            handle_pos_[b.slots[pos].handle] = pos;
+        }
+        b.slots.pop_back();
+    }
+
+    void TriggerSystem::compact() {
+        for (const std::uint32_t bucket : dirty_) {
+            Bucket& b = buckets_[bucket];
+            auto& slots = b.slots;
+            for (std::uint32_t pos = 0; pos < slots.size(); ++pos) {
+                if (slots[pos].effect.kind != kNoTriggerKind) continue;
+                // Fill the hole from the back, so only live slots move.
+                while (!slots.empty() && slots.back().effect.kind == kNoTriggerKind) slots.pop_back();
+                if (pos >= slots.size()) break;
+                slots[pos] = slots.back();
+                handle_pos_[slots[pos].handle] = pos;
+                slots.pop_back();
+            }
+            b.dirty = false;
+        }
+        dirty_.clear();
+        free_handles_.insert(free_handles_.end(), released_handles_.begin(), released_handles_.end());
+        released_handles_.clear();
+    }
+
+    std::size_t TriggerSystem::dispel(EntityId entity, std::uint32_t tags, std::size_t max_stacks) {
+        std::size_t removed = 0;
+        for (std::size_t event = 0; event < kTriggerEventCount && removed < max_stacks; ++event) {
+            const std::uint32_t bucket = find_bucket(static_cast<TriggerEvent>(event), entity);
+            if (bucket == kNoBucket) continue;
+            // From the back, so an effect moved into a hole was already seen.
+            for (std::size_t pos = buckets_[bucket].slots.size(); pos-- > 0 && removed < max_stacks;) {
+                ActiveTrigger& e = buckets_[bucket].slots[pos].effect;
+                if (e.kind == kNoTriggerKind || (kinds_[e.kind].dispel_tags & tags) == 0) continue;
+                const std::size_t take = std::min<std::size_t>(e.stacks, max_stacks - removed);
+                removed += take;
+                if (take == e.stacks) remove_at(bucket, static_cast<std::uint32_t>(pos));
+                else e.stacks = static_cast<std::uint16_t>(e.stacks - take);
+            }
+        }
+        TALE_PROFILE_COUNT("triggers.dispelled", removed);
+        return removed;
+    }
+
+    std::size_t TriggerSystem::clear_entity(EntityId entity) {
+        std::size_t removed = 0;
+        for (std::size_t event = 0; event < kTriggerEventCount; ++event) {
+            const std::uint32_t bucket = find_bucket(static_cast<TriggerEvent>(event), entity);
+            if (bucket == kNoBucket) continue;
+            for (std::size_t pos = buckets_[bucket].slots.size(); pos-- > 0;) {
+                if (buckets_[bucket].slots[pos].effect.kind == kNoTriggerKind) continue;
+                remove_at(bucket, static_cast<std::uint32_t>(pos));
+                removed++;
+            }
+        }
+        return removed;
+    }
+
+    std::size_t TriggerSystem::fire_bucket(std::uint32_t bucket, std::size_t end, TriggerEvent event, EntityId entity,
+                                           TriggerArgs& args) {
+        std::size_t ran = 0;
+        // Handlers may append to this bucket (or create others), so slots
+        // are re-indexed every iteration and the walk stops at `end`.
+        for (std::size_t pos = 0; pos < end; ++pos) {
+            Slot& slot = buckets_[bucket].slots[pos];
+            if (slot.effect.kind == kNoTriggerKind) continue;
+            bool spent = false;
+            if (slot.effect.charges > 0) spent = --slot.effect.charges == 0;
+
+            const TriggerHandle handle{ slot.handle, handle_generation_[slot.handle] };
+            const TriggerKind& k = kinds_[slot.effect.kind];
+            TriggerCall call{ *this, event, entity, handle, slot.effect, args, k.user };
+            k.handler(call);
+            ran++;
+            if (spent) remove(handle);
+        }
+        return ran;
+    }
+
+    std::size_t TriggerSystem::fire(TriggerEvent event, EntityId entity, TriggerArgs& args) {
+        // Both ends are read before any handler runs, so effects applied
+        // by this event's handlers, in either bucket, wait for the next one.
+        const std::uint32_t own = find_bucket(event, entity);
+        const std::uint32_t any = entity != kAnyEntity ? find_bucket(event, kAnyEntity) : kNoBucket;
+        const std::size_t own_end = own != kNoBucket ? buckets_[own].slots.size() : 0;
+        const std::size_t any_end = any != kNoBucket ? buckets_[any].slots.size() : 0;
+
+        firing_++;
+        std::size_t ran = fire_bucket(own, own_end, event, entity, args);
+        ran += fire_bucket(any, any_end, event, entity, args);
+        if (--firing_ == 0 && !dirty_.empty()) compact();
+        TALE_PROFILE_COUNT("triggers.handlers_run", ran);
+        return ran;
+    }
+
+} // namespace tale_engine::runtime
@@ -0,0 +1,28 @@
+#pragma once
+#include <iostream>
+
+// Minimal checks for the test executables: a failed CHECK prints where and
+// what, and the test keeps going; main() returns tale_test::exit_code().
+namespace tale_test {
+
+	inline int& failures() {
+		static int n = 0;
+		return n;
+	}
+
+	inline bool check(bool ok, const char* expr, const char* file, int line) {
+		if (!ok) {
+			std::cerr << file << ":" << line << ": check failed: " << expr << "\n";
+			failures()++;
+		}
+		return ok;
+	}
+
+	inline int exit_code() {
+		if (failures() != 0) std::cerr << failures() << " check(s) failed\n";
+		return failures() == 0 ? 0 : 1;
+	}
+
+} // namespace tale_test
+
+#define CHECK(expr) ::tale_test::check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
@@ -0,0 +1,121 @@
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "check.h"
+#include "tale_engine/runtime/combat.h"
+#include "tale_engine/runtime/effects.h"
+
+using namespace tale_engine;
+using namespace tale_engine::runtime;
+
+namespace {
+
+    CombatantDef fighter(std::string id, int hp, int damage_max, int dexterity) {
+        CombatantDef def;
+        def.id = std::move(id);
+        def.max_hp = hp;
+        def.accuracy = 5;
+        def.evasion = 5;
+        def.damage_min = 1;
+        def.damage_max = damage_max;
+        def.dexterity = dexterity;
+        return def;
+    }
+
+    bool same(const CombatResult& a, const CombatResult& b) {
+        return a.outcome == b.outcome && a.rounds == b.rounds && a.party_hp == b.party_hp && a.enemy_hp == b.enemy_hp;
+    }
+
+    // Results must not depend on how encounters are split into batches or
+    // shared out to threads.
+    void check_simulation() {
+        std::vector<CombatantDef> party{ fighter("knight", 40, 8, 4), fighter("archer", 25, 6, 9) };
+        party[1].on_hit = StatusKind::Bleed;
+        party[1].on_hit_chance = 30;
+        party[1].on_hit_power = 1;
+        party[1].on_hit_turns = 3;
+        std::vector<CombatantDef> enemies{ fighter("wolf", 18, 5, 6), fighter("wolf", 18, 5, 6), fighter("troll", 60, 9, 1) };
+        enemies[2].heals = 2;
+        enemies[2].heal_amount = 10;
+        enemies[2].heal_below = 40;
+
+        CombatSimulation sim;
+        sim.seed = 42;
+        sim.first_id = 1000;
+        sim.count = 700;
+        sim.threads = 1;
+        sim.batch = sim.count;
+        const std::vector<CombatResult> expected = simulate_combat(party, enemies, sim);
+        if (!CHECK(expected.size() == sim.count)) return;
+
+        for (const unsigned threads : { 1u, 3u, 8u }) {
+            for (const std::size_t batch : { std::size_t{ 1 }, std::size_t{ 7 }, std::size_t{ 64 }, std::size_t{ 1024 } }) {
+                sim.threads = threads;
+                sim.batch = batch;
+                const std::vector<CombatResult> results = simulate_combat(party, enemies, sim);
+                if (!CHECK(results.size() == expected.size())) continue;
+                std::size_t mismatches = 0;
+                for (std::size_t i = 0; i < results.size(); ++i) mismatches += same(results[i], expected[i]) ? 0 : 1;
+                if (!CHECK(mismatches == 0)) std::cerr << "  threads " << threads << ", batch " << batch << "\n";
+            }
+        }
+
+        // An encounter's result depends on its id, not on its place in the run.
+        sim.first_id = 1100;
+        sim.count = 100;
+        const std::vector<CombatResult> tail = simulate_combat(party, enemies, sim);
+        for (std::size_t i = 0; i < tail.size(); ++i) CHECK(same(tail[i], expected[100 + i]));
+    }
+
+    // Two fights started by one choice happen at the same time but must not
+    // replay the same stream.
+    void check_start_combat() {
+        CombatCatalog catalog;
+        catalog.add_combatant(fighter("player", 30, 6, 5));
+        const CombatantId wolf = catalog.add_combatant(fighter("wolf", 20, 5, 5));
+        catalog.add_pack("wolves", { wolf, wolf });
+
+        EffectRegistry registry;
+        CombatContext context;
+        context.catalog = &catalog;
+        context.seed = 7;
+        bind_combat(registry, context);
+        const EffectHandler handler = registry.handler(dsl::StartCombat);
+
+        State state;
+        Diagnostics diagnostics;
+        const SourcePos pos;
+        const Value args[] = { Value{ pos, std::string("wolves") } };
+        auto fight = [&] {
+            std::ostringstream log;
+            context.log = &log;
+            EffectCall call{ state, diagnostics, pos, args, registry.user(dsl::StartCombat) };
+            handler(call);
+            CHECK(!call.failed);
+            return log.str();
+        };
+
+        const std::string first = fight();
+        const std::string second = fight();
+        CHECK(!first.empty());
+        CHECK(first != second);
+        const FlagValue* count = state.get_flag("combat_count");
+        CHECK(count && std::get<int>(count->data) == 2);
+
+        // The same choice replayed from the same state fights the same fights.
+        State replayed;
+        std::swap(state, replayed);
+        CHECK(fight() == first);
+        CHECK(fight() == second);
+    }
+
+}
+
+int main() {
+    check_simulation();
+    check_start_combat();
+    return tale_test::exit_code();
+}
@@ -0,0 +1,65 @@
+#include <cstddef>
+#include <random>
+#include <string>
+
+#include "check.h"
+#include "embedded.h"
+#include "tale_engine/compile/project.h"
+#include "tale_engine/runtime/embedded_story.h"
+#include "tale_engine/runtime/interpreter.h"
+#include "tale_engine/runtime/session_log.h"
+
+using namespace tale_engine;
+
+// Plays the story compiled in by tale_embed_story() and the same file
+// parsed at runtime side by side: every step must show the same text and
+// choices and leave the same state.
+int main() {
+    const runtime::EmbeddedStory& story = tale_embedded::embedded;
+
+    Diagnostics parse_diags;
+    const auto build = compile::build_project({ TALE_TEST_DATA_DIR "/embedded.tale" }, {}, parse_diags);
+    if (!CHECK(!parse_diags.has_errors())) return tale_test::exit_code();
+    CHECK(story.content_hash == runtime::content_hash(build.linked));
+    CHECK(runtime::content_hash(runtime::to_ast(story)) == story.content_hash);
+
+    Diagnostics embedded_diags;
+    Diagnostics parsed_diags;
+    runtime::Interpreter embedded(story, embedded_diags);
+    runtime::Interpreter parsed(build.linked, parsed_diags);
+
+    runtime::State a;
+    runtime::State b;
+    CHECK(embedded.start(a));
+    CHECK(parsed.start(b));
+
+    std::mt19937 rng(1);
+    bool reached_well = false;
+    for (std::size_t step = 0; step < 200; ++step) {
+        reached_well = reached_well || a.current_scene() == "well";
+        const runtime::StepResult& ra = embedded.step_ref(a);
+        const runtime::StepResult& rb = parsed.step_ref(b);
+        if (!CHECK(ra.text.size() == rb.text.size() && ra.choices.size() == rb.choices.size())) break;
+        for (std::size_t i = 0; i < ra.text.size(); ++i) CHECK(ra.line(i) == rb.line(i));
+        for (std::size_t i = 0; i < ra.choices.size(); ++i) CHECK(ra.choices[i].label == rb.choices[i].label);
+        CHECK(ra.next_scene_id == rb.next_scene_id);
+
+        if (!ra.next_scene_id.empty()) {
+            a.set_current_scene(ra.next_scene_id);
+            b.set_current_scene(rb.next_scene_id);
+        }
+        else if (!ra.choices.empty()) {
+            const std::size_t pick = rng() % ra.choices.size();
+            CHECK(embedded.apply_choice(a, ra, pick));
+            CHECK(parsed.apply_choice(b, rb, pick));
+        }
+        else {
+            break;
+        }
+        if (!CHECK(a.hash() == b.hash())) break;
+    }
+    CHECK(reached_well);
+    CHECK(a.current_scene() == b.current_scene());
+    CHECK(embedded_diags.all().size() == parsed_diags.all().size());
+    return tale_test::exit_code();
+}
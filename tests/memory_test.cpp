@@ -0,0 +1,89 @@
+#include <cstddef>
+#include <new>
+#include <string>
+
+#include "check.h"
+#include "tale_engine/compile/project.h"
+#include "tale_engine/memory.h"
+#include "tale_engine/runtime/interpreter.h"
+
+using namespace tale_engine;
+using namespace tale_engine::memory;
+
+namespace {
+
+    std::size_t live(const MemoryAccounting& accounting, Subsystem s) {
+        return accounting.subsystem(s).stats().live_bytes;
+    }
+
+    // A limit lowered below what is live refuses every further request.
+    void check_lowered_limit() {
+        AccountingResource resource;
+        void* p = resource.allocate(256);
+        resource.set_limit(128);
+        bool refused = false;
+        try {
+            void* q = resource.allocate(8);
+            resource.deallocate(q, 8);
+        }
+        catch (const std::bad_alloc&) {
+            refused = true;
+        }
+        CHECK(refused);
+        CHECK(resource.stats().failures == 1);
+        resource.deallocate(p, 256);
+        CHECK(resource.stats().live_bytes == 0);
+    }
+
+    // Flag strings grow with play, so they must count against the session.
+    void check_flag_strings() {
+        MemoryAccounting accounting;
+        runtime::State state(accounting.resource(Subsystem::State));
+        state.set_flag("name", runtime::Value{ {}, std::string("short") });
+        const std::size_t before = live(accounting, Subsystem::State);
+        state.set_flag("name", runtime::Value{ {}, std::string(4096, 'x') });
+        CHECK(live(accounting, Subsystem::State) >= before + 4096);
+
+        // Copies stay on the source's resource.
+        const runtime::State copy(state);
+        CHECK(live(accounting, Subsystem::State) >= before + 2 * 4096);
+        CHECK(copy.hash() == state.hash());
+
+        state.set_flag("name", runtime::Value{ {}, 3 });
+        CHECK(live(accounting, Subsystem::State) < before + 2 * 4096);
+        const runtime::FlagValue* v = state.get_flag("name");
+        CHECK(v && runtime::equals(*v, 3) && !runtime::equals(*v, std::string("3")));
+    }
+
+    // Rendered text and memoized step results live on the interpreter's
+    // resource, so a session limit covers them.
+    void check_step_results() {
+        Diagnostics diagnostics;
+        const auto build = compile::build_project({ TALE_TEST_DATA_DIR "/embedded.tale" }, {}, diagnostics);
+        if (!CHECK(!diagnostics.has_errors())) return;
+
+        MemoryAccounting accounting;
+        runtime::State state(accounting.resource(Subsystem::State));
+        runtime::Interpreter interpreter(build.linked, diagnostics, runtime::EffectRegistry::builtins(),
+            accounting.resource(Subsystem::Interpreter));
+        CHECK(interpreter.start(state));
+        const std::size_t before = live(accounting, Subsystem::Interpreter);
+        const runtime::StepResult& step = interpreter.step_ref(state);
+        CHECK(step.text.size() == 1 && step.line(0) == "The gate is shut. You carry 0 coins.");
+        CHECK(step.choices.size() == 3);
+        CHECK(live(accounting, Subsystem::Interpreter) > before);
+
+        // Copies the host keeps are its own.
+        const runtime::StepResult copy = step;
+        CHECK(copy.choices.get_allocator().resource() == std::pmr::get_default_resource());
+        CHECK(copy.line(0) == step.line(0));
+    }
+
+}
+
+int main() {
+    check_lowered_limit();
+    check_flag_strings();
+    check_step_results();
+    return tale_test::exit_code();
+}
@@ -0,0 +1,161 @@
+#include <climits>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "tale_engine/runtime/state.h"
+
+using namespace tale_engine::runtime;
+
+namespace {
+
+    struct World {
+        ItemCatalog items;
+        StatSchema stats;
+
+        World() {
+            const std::vector<std::string> metal{ "metal" };
+            const std::vector<std::string> none;
+            items.add("sword", 30, true, "hand", metal);
+            items.add("axe", 40, true, "hand", metal);
+            items.add("helm", 20, true, "head", metal);
+            items.add("arrow", 1, false, "", none);
+            items.add("coin", 0, false, "", none);
+
+            const StatId str = stats.add_base("strength", 10, 0, 100);
+            const StatId dex = stats.add_base("dexterity", 5);
+            const StatTerm terms[] = { { str, 200 }, { dex, 50 } };
+            stats.add_derived("attack", terms, 1);
+            stats.add_base("hp", 20, 0, 50);
+            stats.finalize();
+        }
+    };
+
+    const char* const kFlags[] = { "met_guard", "door", "mood", "gold_seen" };
+    const char* const kItems[] = { "sword", "axe", "helm", "arrow", "coin", "mystery" };
+    const char* const kStats[] = { "strength", "dexterity", "attack", "hp", "luck" };
+    const char* const kScenes[] = { "start", "hall", "cellar" };
+
+    // Applies `steps` random mutations of every kind and checks after each
+    // one that the incremental hash matches the one computed from scratch.
+    // Returns false at the first mismatch.
+    bool run(std::uint32_t seed, int steps, const World& world) {
+        std::mt19937 rng(seed);
+        auto pick = [&](int n) { return static_cast<int>(rng() % static_cast<std::uint32_t>(n)); };
+
+        State state;
+        state.set_item_catalog(&world.items);
+        state.set_stat_schema(&world.stats);
+        std::vector<ModifierId> modifiers;
+
+        for (int step = 0; step < steps; ++step) {
+            switch (pick(12)) {
+            case 0: {
+                Value v;
+                switch (pick(3)) {
+                case 0: v.data = pick(5); break;
+                case 1: v.data = pick(2) == 0; break;
+                default: v.data = std::string(kScenes[pick(3)]); break;
+                }
+                state.set_flag(kFlags[pick(4)], v);
+                break;
+            }
+            case 1: state.give_item(kItems[pick(6)], 1 + pick(3)); break;
+            case 2: state.take_item(kItems[pick(6)], 1 + pick(3)); break;
+            case 3: {
+                const Inventory& inv = state.inventory();
+                const ItemId item = inv.find(kItems[pick(3)]);
+                if (item != kNoItem && inv.first_instance(item) != kNoInstance) state.equip(inv.first_instance(item));
+                break;
+            }
+            case 4: state.unequip(static_cast<EquipSlot>(pick(2))); break;
+            case 5: state.set_stat_base(state.stat_slot(kStats[pick(5)]), pick(40) - 10); break;
+            case 6:
+            case 7: {
+                Modifier m;
+                m.stat = state.stat_slot(kStats[pick(5)]);
+                m.kind = static_cast<ModifierKind>(pick(3));
+                m.amount = pick(60) - 20;
+                m.duration = pick(2) == 0 ? 0 : static_cast<std::uint32_t>(1 + pick(4));
+                modifiers.push_back(state.add_stat_modifier(m));
+                break;
+            }
+            case 8:
+                if (!modifiers.empty()) {
+                    const std::size_t i = static_cast<std::size_t>(pick(static_cast<int>(modifiers.size())));
+                    state.remove_stat_modifier(modifiers[i]);
+                    modifiers[i] = modifiers.back();
+                    modifiers.pop_back();
+                }
+                break;
+            case 9: state.advance_time(static_cast<std::uint64_t>(pick(3))); break;
+            case 10: state.set_current_scene(kScenes[pick(3)]); break;
+            default: {
+                // Copies must carry the hash over exactly.
+                State copy(state);
+                if (!CHECK(copy.hash() == state.hash())) return false;
+                state = std::move(copy);
+                break;
+            }
+            }
+            if (!CHECK(state.hash() == state.compute_hash())) {
+                std::cerr << "  seed " << seed << ", step " << step << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The hash describes what is observable, not the order it came about in.
+    void check_order_independence(const World& world) {
+        State a;
+        a.set_item_catalog(&world.items);
+        a.set_flag("door", Value{ {}, 1 });
+        a.give_item("arrow", 3);
+        a.give_item("mystery", 1);
+
+        State b;
+        b.set_item_catalog(&world.items);
+        b.give_item("mystery", 1);
+        b.give_item("arrow", 5);
+        b.take_item("arrow", 2);
+        b.set_flag("door", Value{ {}, 1 });
+        CHECK(a.hash() == b.hash());
+
+        // Quantities back at zero hash like items never held.
+        b.give_item("coin", 2);
+        b.take_item("coin", 2);
+        CHECK(a.hash() == b.hash());
+    }
+
+    // Giving past INT_MAX saturates the quantity and everything derived
+    // from it instead of overflowing.
+    void check_saturation(const World& world) {
+        State state;
+        state.set_item_catalog(&world.items);
+        state.give_item("arrow", INT_MAX - 1);
+        state.give_item("arrow", 5);
+        state.give_item("arrow", INT_MAX);
+        CHECK(state.get_item_qty("arrow") == INT_MAX);
+        CHECK(state.inventory().total_weight() == INT_MAX);
+        CHECK(state.hash() == state.compute_hash());
+
+        CHECK(state.take_item("arrow", INT_MAX));
+        CHECK(state.get_item_qty("arrow") == 0);
+        CHECK(state.inventory().total_weight() == 0);
+        CHECK(state.hash() == State().hash());
+    }
+
+}
+
+int main() {
+    const World world;
+    for (std::uint32_t seed = 1; seed <= 100; ++seed) {
+        if (!run(seed, 2000, world)) break;
+    }
+    check_order_independence(world);
+    check_saturation(world);
+    return tale_test::exit_code();
+}
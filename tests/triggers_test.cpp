@@ -0,0 +1,234 @@
+#include <cstdint>
+#include <vector>
+
+#include "check.h"
+#include "tale_engine/runtime/triggers.h"
+
+using namespace tale_engine::runtime;
+
+namespace {
+
+    void noop(TriggerCall&) {}
+
+    TriggerKindId add(TriggerSystem& triggers, const char* name, StackRule stacking = StackRule::Independent,
+                      std::uint16_t max_stacks = 1, std::uint32_t dispel_tags = 0, TriggerHandler handler = noop,
+                      void* user = nullptr) {
+        TriggerKind kind;
+        kind.name = name;
+        kind.handler = handler;
+        kind.user = user;
+        kind.stacking = stacking;
+        kind.max_stacks = max_stacks;
+        kind.dispel_tags = dispel_tags;
+        return triggers.add_kind(kind);
+    }
+
+    void check_handles() {
+        TriggerSystem triggers;
+        const TriggerKindId burn = add(triggers, "burn");
+        CHECK(add(triggers, "burn") == kNoTriggerKind);
+        CHECK(triggers.find_kind("burn") == burn);
+
+        const TriggerHandle a = triggers.apply(burn, TriggerEvent::Hit, 1, 4);
+        const TriggerHandle b = triggers.apply(burn, TriggerEvent::Hit, 1, 5);
+        CHECK(triggers.size() == 2);
+        CHECK(triggers.remove(a));
+        CHECK(!triggers.remove(a));
+        CHECK(!triggers.contains(a));
+        CHECK(triggers.get(a) == nullptr);
+        CHECK(triggers.get(b) && triggers.get(b)->magnitude == 5);
+
+        // The freed index comes back under a new generation; the old handle
+        // must not name the new effect.
+        const TriggerHandle c = triggers.apply(burn, TriggerEvent::Crit, 2, 6);
+        CHECK(c.index == a.index);
+        CHECK(c != a);
+        CHECK(!triggers.contains(a));
+        CHECK(!triggers.remove(a));
+        CHECK(triggers.get(c) && triggers.get(c)->magnitude == 6);
+        CHECK(triggers.size() == 2);
+
+        CHECK(!triggers.contains(triggers.apply(kNoTriggerKind, TriggerEvent::Hit, 1)));
+    }
+
+    // A handler that removes an effect of its own bucket and applies one
+    // elsewhere, while another effect of the bucket spends its last charge.
+    struct Reentry {
+        TriggerHandle victim;
+        TriggerKindId apply_kind = kNoTriggerKind;
+        TriggerHandle applied;
+    };
+
+    void remove_then_apply(TriggerCall& call) {
+        auto& r = *static_cast<Reentry*>(call.user);
+        call.triggers.remove(r.victim);
+        r.applied = call.triggers.apply(r.apply_kind, TriggerEvent::Hit, 2, 77);
+    }
+
+    void check_reentrant_removal() {
+        TriggerSystem triggers;
+        Reentry reentry;
+        const TriggerKindId plain = add(triggers, "plain");
+        const TriggerKindId remover = add(triggers, "remover", StackRule::Independent, 1, 0, remove_then_apply, &reentry);
+        reentry.apply_kind = plain;
+
+        // Entity 2's bucket already holds an effect, so the applied one does
+        // not sit at position 0.
+        const TriggerHandle other = triggers.apply(plain, TriggerEvent::Hit, 2, 11);
+        // Entity 1's bucket: [one-charge effect, remover, victim].
+        const TriggerHandle once = triggers.apply(plain, TriggerEvent::Hit, 1, 1, 1);
+        const TriggerHandle handler = triggers.apply(remover, TriggerEvent::Hit, 1);
+        reentry.victim = triggers.apply(plain, TriggerEvent::Hit, 1, 3);
+
+        TriggerArgs args;
+        CHECK(triggers.fire(TriggerEvent::Hit, 1, args) == 2);
+        CHECK(!triggers.contains(once));
+        CHECK(!triggers.contains(reentry.victim));
+        CHECK(triggers.contains(handler));
+        CHECK(triggers.size() == 3);
+        CHECK(triggers.get(other) && triggers.get(other)->magnitude == 11);
+        CHECK(triggers.get(reentry.applied) && triggers.get(reentry.applied)->magnitude == 77);
+
+        // Every handle still finds its own effect after further churn.
+        const TriggerHandle later = triggers.apply(plain, TriggerEvent::Hit, 2, 88);
+        CHECK(triggers.remove(other));
+        CHECK(triggers.get(reentry.applied) && triggers.get(reentry.applied)->magnitude == 77);
+        CHECK(triggers.get(later) && triggers.get(later)->magnitude == 88);
+        CHECK(triggers.fire(TriggerEvent::Hit, 2, args) == 2);
+    }
+
+    // An entity's handler subscribing a watcher for every entity to the
+    // event being fired: the watcher waits for the next fire.
+    void apply_watcher(TriggerCall& call) {
+        auto& r = *static_cast<Reentry*>(call.user);
+        r.applied = call.triggers.apply(r.apply_kind, call.event, kAnyEntity, 5);
+    }
+
+    void check_any_entity_reentry() {
+        TriggerSystem triggers;
+        Reentry reentry;
+        const TriggerKindId watcher = add(triggers, "watcher");
+        const TriggerKindId once = add(triggers, "once", StackRule::Independent, 1, 0, apply_watcher, &reentry);
+        reentry.apply_kind = watcher;
+        triggers.apply(once, TriggerEvent::Hit, 1, 0, 1);
+
+        // No kAnyEntity bucket exists when the fire starts.
+        TriggerArgs args;
+        CHECK(triggers.fire(TriggerEvent::Hit, 1, args) == 1);
+        CHECK(triggers.get(reentry.applied) && triggers.get(reentry.applied)->magnitude == 5);
+        CHECK(triggers.fire(TriggerEvent::Hit, 1, args) == 1);
+
+        // Nor does an existing bucket's new effect run early.
+        const TriggerHandle first = reentry.applied;
+        triggers.apply(once, TriggerEvent::Hit, 2, 0, 1);
+        CHECK(triggers.fire(TriggerEvent::Hit, 2, args) == 2);
+        CHECK(triggers.contains(first) && triggers.contains(reentry.applied) && reentry.applied != first);
+        CHECK(triggers.fire(TriggerEvent::Hit, 2, args) == 2);
+    }
+
+    void reapply_self(TriggerCall& call) {
+        call.triggers.remove(call.handle);
+        *static_cast<TriggerHandle*>(call.user) = call.triggers.apply(call.effect.kind, TriggerEvent::Hit, call.entity, 9);
+    }
+
+    void check_stacking() {
+        TriggerSystem triggers;
+        const TriggerKindId stack = add(triggers, "stack", StackRule::Stack, 3);
+        const TriggerKindId refresh = add(triggers, "refresh", StackRule::Refresh);
+        const TriggerKindId replace = add(triggers, "replace", StackRule::Replace);
+        const TriggerKindId deep = add(triggers, "deep", StackRule::Stack, 65535);
+
+        const TriggerHandle s = triggers.apply(stack, TriggerEvent::Hit, 1, 1, 2);
+        for (int i = 2; i <= 5; ++i) CHECK(triggers.apply(stack, TriggerEvent::Hit, 1, i, 4) == s);
+        CHECK(triggers.get(s)->stacks == 3);
+        CHECK(triggers.get(s)->magnitude == 5);
+        CHECK(triggers.get(s)->charges == 4);
+
+        // Other events and entities get their own effect.
+        CHECK(triggers.apply(stack, TriggerEvent::Crit, 1) != s);
+        CHECK(triggers.apply(stack, TriggerEvent::Hit, 2) != s);
+        CHECK(triggers.size() == 3);
+
+        const TriggerHandle r = triggers.apply(refresh, TriggerEvent::Hit, 1, 8, 1);
+        CHECK(triggers.apply(refresh, TriggerEvent::Hit, 1, 3, 5) == r);
+        CHECK(triggers.get(r)->magnitude == 8);
+        CHECK(triggers.get(r)->charges == 5);
+
+        const TriggerHandle p = triggers.apply(replace, TriggerEvent::Hit, 1, 8, 1, 4);
+        CHECK(triggers.apply(replace, TriggerEvent::Hit, 1, 3, 2, 6) == p);
+        CHECK(triggers.get(p)->magnitude == 3);
+        CHECK(triggers.get(p)->source == 6);
+
+        // Merging keeps finding the effect after others moved around it.
+        CHECK(triggers.remove(s));
+        const TriggerHandle s2 = triggers.apply(stack, TriggerEvent::Hit, 1, 7);
+        CHECK(s2 != s);
+        CHECK(triggers.get(s2)->stacks == 1);
+        CHECK(triggers.apply(stack, TriggerEvent::Hit, 1) == s2);
+        CHECK(triggers.apply(refresh, TriggerEvent::Hit, 1) == r);
+        CHECK(triggers.get(s2)->stacks == 2);
+
+        // Stacks saturate at max_stacks instead of wrapping.
+        const TriggerHandle d = triggers.apply(deep, TriggerEvent::Hit, 3);
+        for (int i = 0; i < 70000; ++i) triggers.apply(deep, TriggerEvent::Hit, 3);
+        CHECK(triggers.get(d)->stacks == 65535);
+
+        // A stacking effect removed during a fire is not merged into; the
+        // kind applies afresh.
+        TriggerSystem nested;
+        TriggerHandle fresh;
+        const TriggerKindId self = add(nested, "self", StackRule::Stack, 5, 0, reapply_self, &fresh);
+        const TriggerHandle first = nested.apply(self, TriggerEvent::Hit, 1);
+        nested.apply(self, TriggerEvent::Hit, 1);
+        TriggerArgs args;
+        CHECK(nested.fire(TriggerEvent::Hit, 1, args) == 1);
+        CHECK(!nested.contains(first));
+        CHECK(nested.get(fresh) && nested.get(fresh)->stacks == 1 && nested.get(fresh)->magnitude == 9);
+        CHECK(nested.size() == 1);
+        CHECK(nested.apply(self, TriggerEvent::Hit, 1) == fresh);
+    }
+
+    void check_dispel() {
+        constexpr std::uint32_t kMagic = 1;
+        constexpr std::uint32_t kCurse = 2;
+        TriggerSystem triggers;
+        const TriggerKindId poison = add(triggers, "poison", StackRule::Stack, 10, kMagic);
+        const TriggerKindId hex = add(triggers, "hex", StackRule::Independent, 1, kMagic | kCurse);
+        const TriggerKindId armor = add(triggers, "armor");
+
+        const TriggerHandle p = triggers.apply(poison, TriggerEvent::TurnStart, 1);
+        for (int i = 0; i < 4; ++i) triggers.apply(poison, TriggerEvent::TurnStart, 1);
+        const TriggerHandle h1 = triggers.apply(hex, TriggerEvent::Hit, 1);
+        const TriggerHandle h2 = triggers.apply(hex, TriggerEvent::Hit, 1);
+        const TriggerHandle a = triggers.apply(armor, TriggerEvent::Hit, 1);
+        const TriggerHandle elsewhere = triggers.apply(hex, TriggerEvent::Hit, 2);
+
+        CHECK(triggers.dispel(1, kCurse) == 2);
+        CHECK(!triggers.contains(h1) && !triggers.contains(h2));
+        CHECK(triggers.contains(a) && triggers.contains(elsewhere));
+
+        // Stacks go before the effect does.
+        CHECK(triggers.dispel(1, kMagic, 3) == 3);
+        CHECK(triggers.get(p) && triggers.get(p)->stacks == 2);
+        CHECK(triggers.dispel(1, kMagic) == 2);
+        CHECK(!triggers.contains(p));
+        CHECK(triggers.dispel(1, kMagic | kCurse) == 0);
+        CHECK(triggers.contains(a));
+
+        // Dispelled stacking effects no longer take merges.
+        const TriggerHandle p2 = triggers.apply(poison, TriggerEvent::TurnStart, 1);
+        CHECK(p2 != p && triggers.get(p2)->stacks == 1);
+        CHECK(triggers.clear_entity(1) == 2);
+        CHECK(triggers.size() == 1);
+    }
+
+}
+
+int main() {
+    check_handles();
+    check_reentrant_removal();
+    check_any_entity_reentry();
+    check_stacking();
+    check_dispel();
+    return tale_test::exit_code();
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "check.h"
+#include "tale_engine/analysis/reference_index.h"
+#include "tale_engine/analysis/scene_graph.h"
+#include "tale_engine/analysis/validator.h"
+#include "tale_engine/compile/build_cache.h"
+#include "tale_engine/compile/workspace.h"
+
+using namespace tale_engine;
+
+namespace {
+
+    using Files = std::vector<std::pair<std::string, std::string>>;
+
+    const char* const kStart =
+        "scene start:\n"
+        "  text:\n"
+        "    \"Hello {mood}.\"\n"
+        "  choice \"Go\":\n"
+        "    goto hall\n"
+        "  choice \"Stay\":\n"
+        "    set_flag(stayed, true)\n"
+        "  choice \"Pay\" if has_item(coin, 1):\n"
+        "    take_item(coin, 1)\n"
+        "    goto vault\n"
+        "scene hall:\n"
+        "  goto start\n";
+
+    const char* const kMore =
+        "scene hall:\n"
+        "  text:\n"
+        "    \"Again.\"\n"
+        "scene lonely:\n"
+        "  text:\n"
+        "    \"Nobody comes here.\"\n";
+
+    const char* const kFixed =
+        "scene vault:\n"
+        "  text:\n"
+        "    \"Gold.\"\n"
+        "scene lonely:\n"
+        "  goto vault\n";
+
+    using Key = std::tuple<std::string, int, int, Severity, std::string>;
+
+    std::vector<Key> sorted(const std::vector<Diagnostic>& diagnostics) {
+        std::vector<Key> keys;
+        for (const auto& d : diagnostics) keys.emplace_back(d.pos.file, d.pos.line, d.pos.column, d.severity, d.message);
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    // What tale_build and tale_validate report for the linked project.
+    std::vector<Key> expected(const Files& files, const analysis::ValidateOptions& options) {
+        Diagnostics diagnostics;
+        dsl::FileAst linked;
+        analysis::ReferenceIndex references;
+        for (const auto& [path, text] : files) {
+            compile::CompiledUnit unit = compile::compile_source(path, text);
+            for (auto& d : unit.diagnostics) diagnostics.add(std::move(d));
+            references.update_file(path, unit.ast);
+            for (auto& scene : unit.ast.scenes) linked.scenes.push_back(std::move(scene));
+        }
+        const analysis::SceneGraph graph(linked);
+        analysis::validate(linked, graph, diagnostics, options);
+        analysis::lint_references(references, diagnostics);
+        return sorted(diagnostics.all());
+    }
+
+    std::vector<Key> reported(const compile::Workspace& workspace, const Files& files) {
+        std::vector<Diagnostic> all;
+        for (const auto& [path, text] : files) {
+            const auto diagnostics = workspace.diagnostics(path);
+            all.insert(all.end(), diagnostics.begin(), diagnostics.end());
+        }
+        return sorted(all);
+    }
+
+    void check_options(const analysis::ValidateOptions& options, const char* what) {
+        Files files{ { "start.tale", kStart }, { "more.tale", kMore } };
+        compile::Workspace workspace(options);
+        for (const auto& [path, text] : files) workspace.set_document(path, text);
+        workspace.update();
+        const std::vector<Key> want = expected(files, options);
+        CHECK(!want.empty());
+        if (!CHECK(reported(workspace, files) == want)) std::cerr << "  " << what << "\n";
+
+        // Edited incrementally, the workspace still agrees.
+        files[1].second = kFixed;
+        workspace.set_document(files[1].first, files[1].second);
+        workspace.update();
+        if (!CHECK(reported(workspace, files) == expected(files, options))) std::cerr << "  " << what << ", after an edit\n";
+
+        files.pop_back();
+        workspace.remove_document("more.tale");
+        workspace.update();
+        if (!CHECK(reported(workspace, files) == expected(files, options))) std::cerr << "  " << what << ", after a removal\n";
+    }
+
+}
+
+int main() {
+    analysis::ValidateOptions options;
+    check_options(options, "defaults");
+
+    options.warn_dead_ends = true;
+    check_options(options, "dead ends");
+
+    options.start_scene = "hall";
+    check_options(options, "start scene");
+
+    options.start_scene = "nowhere";
+    check_options(options, "missing start scene");
+
+    options = {};
+    options.warn_unreachable = false;
+    options.warn_choice_without_goto = false;
+    check_options(options, "warnings off");
+    return tale_test::exit_code();
+}
@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/dsl/ast.h"
+#include "tale_engine/runtime/analytics.h"
+#include "tale_engine/runtime/interpreter.h"
+#include "tale_engine/runtime/rng.h"
+#include "tale_engine/runtime/state.h"
+#include "tale_engine/runtime/triggers.h"
+#include "tale_engine/version.h"
+
+// Every heap allocation in the process goes through here, so the benchmark
+// can report allocations per step. The bench is single-threaded.
+static std::uint64_t g_allocations = 0;
+
+void* operator new(std::size_t size) {
+    g_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+    using namespace tale_engine;
+
+    struct BenchConfig {
+        std::string name = "default";
+        std::size_t scenes = 1000;
+        std::size_t fanout = 3;        // choices per scene
+        std::size_t effects = 2;       // top-level effects per scene
+        std::size_t choice_effects = 1; // effects inside each choice body
+        std::size_t flags = 64;        // distinct flag names
+        std::size_t items = 16;        // distinct item ids
+        std::size_t conditional = 0;   // percent of choices with a condition
+        bool templates = false;        // text lines interpolate a flag and an item
+        bool headless = true;
+        bool analytics = false;        // record visit analytics while walking
+        std::size_t triggers = 0;      // live trigger effects, spread over kTriggerEntities entities
+        std::string policy = "uniform"; // uniform | first | sticky
+        std::uint64_t seed = 1;
+        std::size_t steps = 200000;
+    };
+
+    // Synthetic story with the shape described by `cfg`. Every scene keeps
+    // at least one unconditional choice, so walks never dead-end.
+    //
+    // Effects draw from a stream of their own, so the scene graph (choices,
+    // conditions, goto targets) is the same with and without them.
+    dsl::FileAst generate_story(const BenchConfig& cfg, bool with_effects) {
+        runtime::Rng rng = runtime::Rng(cfg.seed).split(runtime::RngStream::Simulation);
+        runtime::Rng effect_rng = rng.split(1);
+        const SourcePos pos{ "<bench>", 1, 1 };
+        auto flag = [&](std::size_t i) { return "f" + std::to_string(i % cfg.flags); };
+        auto item = [&](std::size_t i) { return "i" + std::to_string(i % cfg.items); };
+
+        std::size_t next_effect = 0;
+        auto effect = [&]() {
+            dsl::EffectStmtAst e;
+            e.pos = pos;
+            const std::size_t n = next_effect++;
+            const auto pick = effect_rng.uniform(static_cast<std::uint32_t>(std::max<std::size_t>(cfg.flags, cfg.items)));
+            switch (n % 3) {
+            case 0: e.call = dsl::EffectSetFlagAst{ pos, flag(pick), dsl::ValueAst{ pos, static_cast<int>(n & 0xff) } }; break;
+            case 1: e.call = dsl::EffectGiveItemAst{ pos, item(pick), 2 }; break;
+            default: e.call = dsl::EffectTakeItemAst{ pos, item(pick), 1 }; break;
+            }
+            return e;
+        };
+
+        dsl::FileAst ast;
+        ast.scenes.reserve(cfg.scenes);
+        for (std::size_t s = 0; s < cfg.scenes; ++s) {
+            dsl::SceneAst scene;
+            scene.pos = pos;
+            scene.id = "s" + std::to_string(s);
+
+            dsl::TextBlockAst tb;
+            tb.pos = pos;
+            tb.lines.push_back("Scene " + std::to_string(s) + " sets the stage for what comes next.");
+            if (cfg.templates) tb.lines.push_back("You hold {#" + item(s) + "} of them; the mark reads {" + flag(s) + "}.");
+            scene.body.push_back(std::move(tb));
+
+            if (with_effects) {
+                for (std::size_t e = 0; e < cfg.effects; ++e) scene.body.push_back(effect());
+            }
+
+            for (std::size_t c = 0; c < cfg.fanout; ++c) {
+                dsl::ChoiceAst ch;
+                ch.pos = pos;
+                ch.label = "Option " + std::to_string(c);
+                if (c > 0 && rng.uniform(100) < cfg.conditional) {
+                    dsl::ConditionAst cond;
+                    cond.pos = pos;
+                    cond.op = dsl::ConditionOp::HasFlag;
+                    cond.name = flag(rng.uniform(static_cast<std::uint32_t>(cfg.flags)));
+                    ch.condition = std::move(cond);
+                }
+                if (with_effects) {
+                    for (std::size_t e = 0; e < cfg.choice_effects; ++e) ch.body.push_back(effect());
+                }
+                ch.body.push_back(dsl::GotoStmtAst{ pos, "s" + std::to_string(rng.uniform(static_cast<std::uint32_t>(cfg.scenes))) });
+                scene.body.push_back(std::move(ch));
+            }
+            ast.scenes.push_back(std::move(scene));
+        }
+        return ast;
+    }
+
+    // Hardware cache-miss counters where the kernel allows them.
+    class PerfCounters {
+    public:
+        PerfCounters() {
+#if defined(__linux__)
+            l1d_ = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+            llc_ = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+        }
+
+        ~PerfCounters() {
+#if defined(__linux__)
+            if (l1d_ >= 0) close(l1d_);
+            if (llc_ >= 0) close(llc_);
+#endif
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        void start() {
+#if defined(__linux__)
+            for (const int fd : { l1d_, llc_ }) {
+                if (fd < 0) continue;
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        // Returns -1 for counters that are unavailable.
+        void stop(std::int64_t& l1d_misses, std::int64_t& llc_misses) {
+            l1d_misses = read(l1d_);
+            llc_misses = read(llc_);
+        }
+
+    private:
+#if defined(__linux__)
+        static int open(std::uint32_t type, std::uint64_t config) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+
+        std::int64_t read(int fd) {
+#if defined(__linux__)
+            if (fd < 0) return -1;
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t value = 0;
+            if (::read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) return -1;
+            return static_cast<std::int64_t>(value);
+#else
+            (void)fd;
+            return -1;
+#endif
+        }
+
+        int l1d_ = -1;
+        int llc_ = -1;
+    };
+
+    constexpr std::size_t kTriggerEntities = 1024;
+
+    void count_trigger(runtime::TriggerCall& call) {
+        ++*static_cast<std::uint64_t*>(call.user);
+    }
+
+    // cfg.triggers effects on random (event, entity) pairs; about one in
+    // kTriggerEntities * kTriggerEventCount lands on the player's
+    // onChoiceSelected. One in four uses a stacking kind and may merge, so
+    // the live count ends up somewhat below cfg.triggers.
+    std::vector<runtime::TriggerHandle> seed_triggers(const BenchConfig& cfg, runtime::TriggerSystem& triggers,
+        std::uint64_t& fired) {
+        using runtime::StackRule;
+        const StackRule rules[] = { StackRule::Independent, StackRule::Stack, StackRule::Refresh, StackRule::Replace };
+        for (const StackRule rule : rules) {
+            triggers.add_kind(runtime::TriggerKind{ "k" + std::to_string(static_cast<int>(rule)), count_trigger,
+                &fired, rule, 5, 1u << static_cast<int>(rule) });
+        }
+        runtime::Rng rng = runtime::Rng(cfg.seed).split(runtime::RngStream::Simulation).split(1);
+        std::vector<runtime::TriggerHandle> handles;
+        handles.reserve(cfg.triggers);
+        for (std::size_t i = 0; i < cfg.triggers; ++i) {
+            const auto event = static_cast<runtime::TriggerEvent>(rng.uniform(runtime::kTriggerEventCount));
+            const auto entity = static_cast<runtime::EntityId>(rng.uniform(kTriggerEntities));
+            const runtime::TriggerKindId kind = rng.uniform(4) == 0 ? 1 + rng.uniform(3) : 0;
+            handles.push_back(triggers.apply(kind, event, entity, 1));
+        }
+        return handles;
+    }
+
+    struct RunStats {
+        std::size_t steps = 0;        // step() calls
+        std::size_t choices = 0;      // apply_choice() calls
+        std::size_t effects = 0;      // effects executed (static count per step/choice)
+        std::size_t live_triggers = 0;
+        std::uint64_t triggers_fired = 0;
+        double seconds = 0;
+        std::uint64_t allocations = 0;
+        std::int64_t l1d_misses = -1;
+        std::int64_t llc_misses = -1;
+    };
+
+    std::size_t count_effects(const dsl::SceneAst& scene) {
+        std::size_t n = 0;
+        for (const auto& stmt : scene.body) n += std::holds_alternative<dsl::EffectStmtAst>(stmt);
+        return n;
+    }
+
+    std::size_t count_effects(const dsl::ChoiceAst& ch) {
+        std::size_t n = 0;
+        for (const auto& stmt : ch.body) n += std::holds_alternative<dsl::EffectStmtAst>(stmt);
+        return n;
+    }
+
+    // Walks the story for cfg.steps steps. The policy only ever sees the
+    // offered choices, so runs with and without effects take the same path
+    // as long as no choice is conditional.
+    RunStats run(const BenchConfig& cfg, const dsl::FileAst& ast, bool measure) {
+        Diagnostics diags(DiagnosticsOptions{ .retain = false });
+        runtime::Interpreter interp(ast, diags);
+        interp.set_headless(cfg.headless);
+        runtime::Analytics analytics(ast);
+        if (cfg.analytics) interp.set_analytics(&analytics.make_shard());
+        runtime::TriggerSystem triggers;
+        std::uint64_t fired = 0;
+        std::vector<runtime::TriggerHandle> trigger_handles;
+        if (cfg.triggers) {
+            trigger_handles = seed_triggers(cfg, triggers, fired);
+            interp.set_triggers(&triggers);
+        }
+        runtime::State state;
+        interp.start(state);
+        runtime::Rng rng = runtime::Rng(cfg.seed).split(runtime::RngStream::Checks);
+
+        std::vector<std::size_t> scene_effects(ast.scenes.size());
+        for (std::size_t i = 0; i < ast.scenes.size(); ++i) scene_effects[i] = count_effects(ast.scenes[i]);
+
+        RunStats r;
+        PerfCounters counters;
+        if (measure) counters.start();
+        const std::uint64_t allocations = g_allocations;
+        const auto t0 = std::chrono::steady_clock::now();
+
+        std::size_t sticky = 0;
+        while (r.steps < cfg.steps) {
+            const runtime::StepResult& step = interp.step_ref(state);
+            r.steps++;
+            // Scene ids are "s<index>".
+            const std::size_t index = std::strtoul(state.current_scene().c_str() + 1, nullptr, 10);
+            r.effects += scene_effects[index];
+
+            if (!step.next_scene_id.empty()) {
+                state.set_current_scene(step.next_scene_id);
+                continue;
+            }
+            if (step.choices.empty()) {
+                interp.start(state);
+                continue;
+            }
+
+            std::size_t pick = 0;
+            if (cfg.policy == "uniform") pick = rng.uniform(static_cast<std::uint32_t>(step.choices.size()));
+            else if (cfg.policy == "sticky") pick = sticky++ % step.choices.size();
+            const auto& ch = std::get<dsl::ChoiceAst>(ast.scenes[index].body[step.choices[pick].choice_stmt_index]);
+            r.effects += count_effects(ch);
+            interp.apply_choice(state, step, pick);
+            r.choices++;
+            if (!trigger_handles.empty()) {
+                // Churn: one effect ends and another starts every choice.
+                const std::size_t i = r.choices % trigger_handles.size();
+                triggers.remove(trigger_handles[i]);
+                trigger_handles[i] = triggers.apply(0,
+                    static_cast<runtime::TriggerEvent>(i % runtime::kTriggerEventCount),
+                    static_cast<runtime::EntityId>(r.choices % kTriggerEntities), 1);
+            }
+        }
+
+        const auto t1 = std::chrono::steady_clock::now();
+        r.allocations = g_allocations - allocations;
+        r.live_triggers = triggers.size();
+        r.triggers_fired = fired;
+        if (measure) counters.stop(r.l1d_misses, r.llc_misses);
+        r.seconds = std::chrono::duration<double>(t1 - t0).count();
+        return r;
+    }
+
+    void write_number_or_null(std::ostream& out, std::int64_t v) {
+        if (v < 0) out << "null";
+        else out << v;
+    }
+
+    void write_result(std::ostream& out, const BenchConfig& cfg, const RunStats& full, const RunStats& bare) {
+        const double ns_per_step = full.seconds * 1e9 / static_cast<double>(full.steps);
+        // Effect cost: time the effects add over the same walk without them.
+        const double effect_ns = full.effects == 0 ? 0.0
+            : std::max(0.0, (full.seconds - bare.seconds) * 1e9 / static_cast<double>(full.effects));
+
+        out << "    {\n"
+            << "      \"name\": \"" << cfg.name << "\",\n"
+            << "      \"config\": { \"scenes\": " << cfg.scenes << ", \"fanout\": " << cfg.fanout
+            << ", \"effects\": " << cfg.effects << ", \"choice_effects\": " << cfg.choice_effects
+            << ", \"flags\": " << cfg.flags << ", \"items\": " << cfg.items
+            << ", \"conditional_percent\": " << cfg.conditional << ", \"templates\": " << (cfg.templates ? "true" : "false")
+            << ", \"headless\": " << (cfg.headless ? "true" : "false")
+            << ", \"analytics\": " << (cfg.analytics ? "true" : "false") << ", \"triggers\": " << cfg.triggers
+            << ", \"policy\": \"" << cfg.policy
+            << "\", \"seed\": " << cfg.seed << ", \"steps\": " << cfg.steps << " },\n"
+            << "      \"steps\": " << full.steps << ",\n"
+            << "      \"choices\": " << full.choices << ",\n"
+            << "      \"effects\": " << full.effects << ",\n"
+            << "      \"live_triggers\": " << full.live_triggers << ",\n"
+            << "      \"triggers_fired\": " << full.triggers_fired << ",\n"
+            << "      \"seconds\": " << full.seconds << ",\n"
+            << "      \"steps_per_sec\": " << static_cast<double>(full.steps) / full.seconds << ",\n"
+            << "      \"ns_per_step\": " << ns_per_step << ",\n"
+            << "      \"ns_per_effect\": " << effect_ns << ",\n"
+            << "      \"allocations_per_step\": " << static_cast<double>(full.allocations) / static_cast<double>(full.steps) << ",\n"
+            << "      \"l1d_misses_per_step\": ";
+        if (full.l1d_misses < 0) out << "null";
+        else out << static_cast<double>(full.l1d_misses) / static_cast<double>(full.steps);
+        out << ",\n      \"llc_misses_per_step\": ";
+        if (full.llc_misses < 0) out << "null";
+        else out << static_cast<double>(full.llc_misses) / static_cast<double>(full.steps);
+        out << ",\n      \"l1d_misses\": ";
+        write_number_or_null(out, full.l1d_misses);
+        out << ",\n      \"llc_misses\": ";
+        write_number_or_null(out, full.llc_misses);
+        out << "\n    }";
+    }
+
+    // Fixed matrix for regression gating: scene count, fan-out, effect
+    // density and state cardinality varied one at a time.
+    std::vector<BenchConfig> sweep(const BenchConfig& base) {
+        std::vector<BenchConfig> out;
+        auto add = [&](std::string name, auto&& edit) {
+            BenchConfig c = base;
+            c.name = std::move(name);
+            edit(c);
+            out.push_back(std::move(c));
+        };
+        add("small_graph", [](BenchConfig& c) { c.scenes = 100; });
+        add("large_graph", [](BenchConfig& c) { c.scenes = 100000; });
+        add("wide_fanout", [](BenchConfig& c) { c.fanout = 12; });
+        add("no_effects", [](BenchConfig& c) { c.effects = 0; c.choice_effects = 0; });
+        add("dense_effects", [](BenchConfig& c) { c.effects = 16; c.choice_effects = 4; });
+        add("large_state", [](BenchConfig& c) { c.flags = 10000; c.items = 10000; });
+        add("conditional", [](BenchConfig& c) { c.conditional = 50; });
+        add("templated_text", [](BenchConfig& c) { c.templates = true; c.headless = false; });
+        add("many_triggers", [](BenchConfig& c) { c.triggers = 50000; });
+        return out;
+    }
+
+    void print_usage() {
+        std::cerr << "Usage: tale_bench [--sweep] [--name <name>] [--scenes <n>] [--fanout <n>] [--effects <n>]\n"
+            << "                  [--choice-effects <n>] [--flags <n>] [--items <n>] [--conditional <percent>]\n"
+            << "                  [--templates] [--text] [--analytics] [--triggers <n>] [--policy uniform|first|sticky] [--seed <n>]\n"
+            << "                  [--steps <n>] [-o <out.json>]\n";
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig base;
+    bool do_sweep = false;
+    std::string out_path;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto number = [&]() { return static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10)); };
+        const bool has_value = i + 1 < argc;
+        if (arg == "--sweep") do_sweep = true;
+        else if (arg == "--templates") base.templates = true;
+        else if (arg == "--text") base.headless = false;
+        else if (arg == "--analytics") base.analytics = true;
+        else if (arg == "--triggers" && has_value) base.triggers = number();
+        else if (arg == "--name" && has_value) base.name = argv[++i];
+        else if (arg == "--scenes" && has_value) base.scenes = std::max<std::size_t>(1, number());
+        else if (arg == "--fanout" && has_value) base.fanout = std::max<std::size_t>(1, number());
+        else if (arg == "--effects" && has_value) base.effects = number();
+        else if (arg == "--choice-effects" && has_value) base.choice_effects = number();
+        else if (arg == "--flags" && has_value) base.flags = std::max<std::size_t>(1, number());
+        else if (arg == "--items" && has_value) base.items = std::max<std::size_t>(1, number());
+        else if (arg == "--conditional" && has_value) base.conditional = number();
+        else if (arg == "--policy" && has_value) base.policy = argv[++i];
+        else if (arg == "--seed" && has_value) base.seed = number();
+        else if (arg == "--steps" && has_value) base.steps = std::max<std::size_t>(1, number());
+        else if (arg == "-o" && has_value) out_path = argv[++i];
+        else {
+            std::cerr << tale_engine::kProductName << " bench\n";
+            print_usage();
+            return 2;
+        }
+    }
+    if (base.policy != "uniform" && base.policy != "first" && base.policy != "sticky") {
+        std::cerr << "Unknown policy: " << base.policy << "\n";
+        return 2;
+    }
+
+    const std::vector<BenchConfig> configs = do_sweep ? sweep(base) : std::vector<BenchConfig>{ base };
+
+    std::ostringstream json;
+    json << "{\n  \"engine\": \"" << tale_engine::kVersionMajor << "." << tale_engine::kVersionMinor << "."
+        << tale_engine::kVersionPatch << "\",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < configs.size(); ++i) {
+        const auto& cfg = configs[i];
+        std::cerr << "running " << cfg.name << "...\n";
+        const auto full_story = generate_story(cfg, true);
+        const auto bare_story = generate_story(cfg, false);
+
+        BenchConfig warmup = cfg;
+        warmup.steps = std::min<std::size_t>(cfg.steps, 10000);
+        run(warmup, full_story, false);
+        const RunStats full = run(cfg, full_story, true);
+        const RunStats bare = run(cfg, bare_story, false);
+
+        write_result(json, cfg, full, bare);
+        json << (i + 1 < configs.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    if (out_path.empty()) {
+        std::cout << json.str();
+        return 0;
+    }
+    std::ofstream out(out_path, std::ios::trunc);
+    out << json.str();
+    if (!out) {
+        std::cerr << "Cannot write output: " << out_path << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "tale_engine/analysis/reference_index.h"
+#include "tale_engine/analysis/scene_graph.h"
+#include "tale_engine/analysis/validator.h"
+#include "tale_engine/compile/ast_codec.h"
+#include "tale_engine/compile/layout.h"
+#include "tale_engine/compile/optimizer.h"
+#include "tale_engine/compile/project.h"
+#include "tale_engine/diagnostic_sinks.h"
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/runtime/interpreter.h"
+#include "tale_engine/runtime/session_log.h"
+#include "tale_engine/version.h"
+
+static void print_usage() {
+    std::cerr << "Usage: tale_build [--cache-dir <dir>] [-j <jobs>] [--diag-format text|jsonl|sarif]\n"
+        << "                  [--max-diagnostics <n>] [-O [--entry <scene>]...]\n"
+        << "                  [--layout] [--layout-profile <session.bin>]... [--compress [--dictionary-size <bytes>]]\n"
+        << "                  -o <out.talec> <file.tale>...\n";
+}
+
+// Ids of the scenes stepped while replaying `paths` against the unoptimized
+// content; failed or mismatched replays still contribute what they reached.
+static std::vector<std::string> collect_profile(const tale_engine::dsl::FileAst& ast,
+    const std::vector<std::string>& paths) {
+    using namespace tale_engine;
+
+    std::vector<std::string> trace;
+    Diagnostics runtime_diags;
+    runtime::Interpreter interp(ast, runtime_diags);
+    const std::uint64_t hash = runtime::content_hash(ast);
+    for (const auto& path : paths) {
+        runtime::SessionLog log;
+        if (!runtime::decode_session(compile::read_file(path), log)) {
+            std::cerr << "warning: cannot read session log: " << path << "\n";
+            continue;
+        }
+        if (log.content_hash != 0 && log.content_hash != hash) {
+            std::cerr << "warning: " << path << " was recorded against different content\n";
+        }
+        runtime::State state;
+        const auto result = runtime::replay(interp, state, log, &trace);
+        if (!result.ok) std::cerr << "warning: " << path << ": " << result.message << "\n";
+    }
+    return trace;
+}
+
+// Without a profile, cold start is estimated as the first scenes a player
+// can reach, in breadth-first order from the default start.
+static std::vector<std::uint32_t> static_cold_start(const tale_engine::analysis::SceneGraph& graph, std::size_t limit) {
+    std::vector<std::uint32_t> trace;
+    if (graph.scene_count() == 0) return trace;
+    std::vector<bool> seen(graph.scene_count(), false);
+    std::queue<std::uint32_t> queue;
+    queue.push(0);
+    seen[0] = true;
+    while (!queue.empty() && trace.size() < limit) {
+        const std::uint32_t s = queue.front();
+        queue.pop();
+        trace.push_back(s);
+        for (const auto next : graph.successors(s)) {
+            if (!seen[next]) {
+                seen[next] = true;
+                queue.push(next);
+            }
+        }
+    }
+    return trace;
+}
+
+// Mean time to decompress and decode one scene record, over every scene.
+static double average_decode_us(std::string_view bytes, const tale_engine::compile::SceneTable& table) {
+    if (table.scenes.empty()) return 0;
+    tale_engine::dsl::SceneAst scene;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < table.scenes.size(); ++i) tale_engine::compile::decode_scene(bytes, table, i, scene);
+    const auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(t1 - t0).count() / static_cast<double>(table.scenes.size());
+}
+
+int main(int argc, char** argv) {
+    using namespace tale_engine;
+
+    compile::ProjectOptions options;
+    std::string out_path;
+    std::vector<std::string> inputs;
+    std::string diag_format = "text";
+    bool optimize = false;
+    compile::OptimizeOptions optimize_options;
+    bool layout = false;
+    std::vector<std::string> layout_profiles;
+    compile::EncodeOptions encode_options;
+    DiagnosticsOptions diag_options;
+    diag_options.retain = false;
+    diag_options.deduplicate = true;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--cache-dir" && i + 1 < argc) {
+            options.cache_dir = argv[++i];
+        }
+        else if (arg == "-j" && i + 1 < argc) {
+            options.jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--diag-format" && i + 1 < argc) {
+            diag_format = argv[++i];
+        }
+        else if (arg == "--max-diagnostics" && i + 1 < argc) {
+            diag_options.max_per_severity = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-O") {
+            optimize = true;
+        }
+        else if (arg == "--entry" && i + 1 < argc) {
+            optimize_options.entry_scenes.push_back(argv[++i]);
+        }
+        else if (arg == "--layout") {
+            layout = true;
+        }
+        else if (arg == "--layout-profile" && i + 1 < argc) {
+            layout = true;
+            layout_profiles.push_back(argv[++i]);
+        }
+        else if (arg == "--compress") {
+            encode_options.compress = true;
+        }
+        else if (arg == "--dictionary-size" && i + 1 < argc) {
+            encode_options.dictionary_size = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-o" && i + 1 < argc) {
+            out_path = argv[++i];
+        }
+        else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty() || out_path.empty()) {
+        std::cerr << kProductName << " build\n";
+        print_usage();
+        return 2;
+    }
+
+    auto sink = make_sink(diag_format, diag_format == "text" ? std::cerr : std::cout, "tale_build");
+    if (!sink) {
+        std::cerr << "Unknown diagnostic format: " << diag_format << "\n";
+        return 2;
+    }
+
+    Diagnostics diags(diag_options);
+    diags.set_sink(sink.get());
+    analysis::ReferenceIndex references;
+    options.references = &references;
+    auto build = compile::build_project(inputs, options, diags);
+    if (!diags.has_errors()) {
+        const analysis::SceneGraph graph(build.linked);
+        analysis::validate(build.linked, graph, diags);
+        analysis::lint_references(references, diags);
+    }
+
+    sink->finish();
+    if (diags.suppressed() != 0) {
+        std::cerr << diags.suppressed() << " more diagnostic(s) suppressed by --max-diagnostics\n";
+    }
+
+    std::cerr << inputs.size() << " file(s): " << build.cache_hits << " cached, "
+        << build.compiled << " compiled\n";
+
+    if (diags.has_errors()) return 1;
+
+    std::vector<std::string> profile_trace;
+    if (!layout_profiles.empty()) profile_trace = collect_profile(build.linked, layout_profiles);
+
+    if (optimize) {
+        const std::size_t before = compile::encode_file(build.linked).size();
+        const auto report = compile::optimize(build.linked, optimize_options);
+        compile::write_report(std::cerr, report);
+        std::cerr << "  encoded size:        " << before << " -> " << compile::encode_file(build.linked).size() << " bytes\n";
+    }
+
+    std::string bytes = compile::encode_file(build.linked);
+
+    std::vector<std::uint32_t> order;
+    if (layout) {
+        const analysis::SceneGraph graph(build.linked);
+        std::vector<std::uint64_t> visits(graph.scene_count(), 0);
+        std::vector<std::uint32_t> trace;
+        for (const auto& id : profile_trace) {
+            const auto s = graph.index_of(id);
+            if (s == analysis::kNoScene) continue; // removed by -O
+            visits[s]++;
+            trace.push_back(s);
+        }
+        const bool profiled = !trace.empty();
+        if (!profiled) trace = static_cold_start(graph, 64);
+
+        order = compile::plan_layout(graph, profiled ? std::span<const std::uint64_t>(visits) : std::span<const std::uint64_t>{});
+        std::string laid_out = compile::encode_file(build.linked, order);
+        std::cerr << "layout: " << order.size() << " scene(s), "
+            << (profiled ? "profiled" : "static") << ", pages touched by "
+            << (profiled ? "profiled sessions" : "the first 64 reachable scenes") << ": "
+            << compile::pages_touched(bytes, trace) << " -> " << compile::pages_touched(laid_out, trace) << "\n";
+        bytes = std::move(laid_out);
+    }
+
+    if (encode_options.compress) {
+        std::string packed = compile::encode_file(build.linked, order, encode_options);
+        compile::SceneTable table;
+        compile::read_scene_table(packed, table);
+        const double us = average_decode_us(packed, table);
+        std::cerr << "compress: " << bytes.size() << " -> " << packed.size() << " bytes (dictionary "
+            << table.dictionary_length << "), " << us << " us per scene to decode\n";
+        bytes = std::move(packed);
+    }
+    std::ofstream out(out_path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+        std::cerr << "Cannot write output: " << out_path << "\n";
+        return 1;
+    }
+    return 0;
+}
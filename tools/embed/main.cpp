@@ -0,0 +1,111 @@
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tale_engine/analysis/reference_index.h"
+#include "tale_engine/analysis/scene_graph.h"
+#include "tale_engine/analysis/validator.h"
+#include "tale_engine/compile/embed.h"
+#include "tale_engine/compile/optimizer.h"
+#include "tale_engine/compile/project.h"
+#include "tale_engine/diagnostic_sinks.h"
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/version.h"
+
+static void print_usage() {
+    std::cerr << "Usage: tale_embed --name <identifier> --header <out.h> --source <out.cpp>\n"
+        << "                  [--diag-format text|jsonl|sarif] [-O [--entry <scene>]...] <file.tale>...\n";
+}
+
+static bool is_identifier(const std::string& s) {
+    if (s.empty() || std::isdigit(static_cast<unsigned char>(s[0]))) return false;
+    for (const char c : s) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+    }
+    return true;
+}
+
+// Leaves the file untouched when the content is the same, so dependents
+// are not rebuilt.
+static bool write_if_changed(const std::string& path, const std::string& text) {
+    if (tale_engine::compile::read_file(path) == text && std::filesystem::exists(path)) return true;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char** argv) {
+    using namespace tale_engine;
+
+    std::string name;
+    std::string header_path;
+    std::string source_path;
+    std::vector<std::string> inputs;
+    std::string diag_format = "text";
+    bool optimize = false;
+    compile::OptimizeOptions optimize_options;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) name = argv[++i];
+        else if (arg == "--header" && i + 1 < argc) header_path = argv[++i];
+        else if (arg == "--source" && i + 1 < argc) source_path = argv[++i];
+        else if (arg == "--diag-format" && i + 1 < argc) diag_format = argv[++i];
+        else if (arg == "-O") optimize = true;
+        else if (arg == "--entry" && i + 1 < argc) optimize_options.entry_scenes.push_back(argv[++i]);
+        else inputs.push_back(arg);
+    }
+
+    if (inputs.empty() || header_path.empty() || source_path.empty() || name.empty()) {
+        std::cerr << kProductName << " embed\n";
+        print_usage();
+        return 2;
+    }
+    if (!is_identifier(name)) {
+        std::cerr << "--name must be a C++ identifier: " << name << "\n";
+        return 2;
+    }
+
+    auto sink = make_sink(diag_format, diag_format == "text" ? std::cerr : std::cout, "tale_embed");
+    if (!sink) {
+        std::cerr << "Unknown diagnostic format: " << diag_format << "\n";
+        return 2;
+    }
+
+    // Everything tale_validate would report is reported here, so content
+    // errors fail the build instead of surfacing at startup.
+    DiagnosticsOptions diag_options;
+    diag_options.retain = false;
+    diag_options.deduplicate = true;
+    Diagnostics diags(diag_options);
+    diags.set_sink(sink.get());
+    analysis::ReferenceIndex references;
+    compile::ProjectOptions options;
+    options.references = &references;
+    auto build = compile::build_project(inputs, options, diags);
+    if (!diags.has_errors()) {
+        const analysis::SceneGraph graph(build.linked);
+        analysis::validate(build.linked, graph, diags);
+        analysis::lint_references(references, diags);
+    }
+    sink->finish();
+    if (diags.has_errors()) return 1;
+
+    if (optimize) compile::optimize(build.linked, optimize_options);
+
+    std::ostringstream header;
+    std::ostringstream source;
+    compile::write_embedded_story(header, source, build.linked, name,
+        std::filesystem::path(header_path).filename().string());
+
+    if (!write_if_changed(header_path, header.str()) || !write_if_changed(source_path, source.str())) {
+        std::cerr << "Cannot write generated sources for " << name << "\n";
+        return 1;
+    }
+    return 0;
+}
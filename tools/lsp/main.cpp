@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tale_engine/analysis/reference_index.h"
+#include "tale_engine/analysis/validator.h"
+#include "tale_engine/compile/project.h"
+#include "tale_engine/compile/workspace.h"
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/json.h"
+#include "tale_engine/profile.h"
+#include "tale_engine/version.h"
+
+// Language server over stdio (JSON-RPC 2.0 with LSP base-protocol framing).
+//
+// Keeps a compile::Workspace of every .tale file under the workspace root
+// (or the files named on the command line) plus the open editor buffers, and
+// pushes diagnostics for each document whose diagnostics change. Supports
+// full-text document sync, go-to-definition and find-references for scene
+// ids, flags and items. Positions are treated as byte columns, which matches
+// UTF-16 columns for ASCII content.
+
+namespace {
+
+    using namespace tale_engine;
+
+    int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    std::string uri_to_path(std::string_view uri) {
+        constexpr std::string_view kScheme = "file://";
+        if (uri.substr(0, kScheme.size()) == kScheme) uri.remove_prefix(kScheme.size());
+        std::string path;
+        for (std::size_t i = 0; i < uri.size(); ++i) {
+            if (uri[i] == '%' && i + 2 < uri.size() && hex_value(uri[i + 1]) >= 0 && hex_value(uri[i + 2]) >= 0) {
+                path.push_back(static_cast<char>(hex_value(uri[i + 1]) * 16 + hex_value(uri[i + 2])));
+                i += 2;
+            }
+            else {
+                path.push_back(uri[i]);
+            }
+        }
+        // file:///C:/x -> C:/x
+        if (path.size() > 2 && path[0] == '/' && std::isalpha(static_cast<unsigned char>(path[1])) && path[2] == ':') path.erase(0, 1);
+        return path;
+    }
+
+    std::string path_to_uri(std::string_view path) {
+        static constexpr char digits[] = "0123456789ABCDEF";
+        std::string uri = "file://";
+        if (!path.empty() && path[0] != '/') uri.push_back('/');
+        for (const char c : path) {
+            const auto u = static_cast<unsigned char>(c);
+            if (std::isalnum(u) || c == '/' || c == '-' || c == '_' || c == '.' || c == '~' || c == ':') {
+                uri.push_back(c);
+            }
+            else {
+                uri.push_back('%');
+                uri.push_back(digits[u >> 4]);
+                uri.push_back(digits[u & 15]);
+            }
+        }
+        return uri;
+    }
+
+    std::string normalize(const std::filesystem::path& p) {
+        std::error_code ec;
+        const auto abs = std::filesystem::absolute(p, ec);
+        return (ec ? p : abs).lexically_normal().generic_string();
+    }
+
+    // LSP range of the word (identifier or quoted string) starting at
+    // `line`:`column` (1-based), or a one-character range.
+    void write_range(std::ostream& out, const std::string* text, int line, int column) {
+        int length = 1;
+        if (text) {
+            std::size_t start = 0;
+            for (int i = 1; i < line && start != std::string::npos; ++i) {
+                start = text->find('\n', start);
+                if (start != std::string::npos) start++;
+            }
+            if (start != std::string::npos) {
+                std::size_t p = start + static_cast<std::size_t>(column - 1);
+                std::size_t end = p;
+                auto ident = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+                if (p < text->size() && (*text)[p] == '"') {
+                    end = text->find_first_of("\"\n", p + 1);
+                    end = end == std::string::npos ? text->size() : end + ((*text)[end] == '"');
+                }
+                else {
+                    while (end < text->size() && ident((*text)[end])) end++;
+                }
+                if (end > p) length = static_cast<int>(end - p);
+            }
+        }
+        out << "{\"start\":{\"line\":" << line - 1 << ",\"character\":" << column - 1
+            << "},\"end\":{\"line\":" << line - 1 << ",\"character\":" << column - 1 + length << "}}";
+    }
+
+    class Server {
+    public:
+        Server(analysis::ValidateOptions options, std::vector<std::string> files, bool verbose)
+            : workspace_(std::move(options)), files_(std::move(files)), verbose_(verbose) {}
+
+        // Returns the process exit code once the client sends "exit".
+        int run() {
+            std::string body;
+            while (read_message(body)) {
+                JsonValue message;
+                if (!parse_json(body, message)) {
+                    write_error(JsonValue(), -32700, "Parse error");
+                    continue;
+                }
+                const std::string& method = message["method"].as_string();
+                if (method == "exit") return shutdown_ ? 0 : 1;
+                handle(method, message["id"], message["params"]);
+            }
+            return 1; // stdin closed without "exit"
+        }
+
+    private:
+        // Base protocol: "Content-Length: N\r\n" headers, a blank line, N bytes.
+        bool read_message(std::string& body) {
+            std::size_t length = 0;
+            bool have_length = false;
+            std::string header;
+            while (std::getline(std::cin, header)) {
+                if (!header.empty() && header.back() == '\r') header.pop_back();
+                if (header.empty()) {
+                    if (!have_length) continue;
+                    body.resize(length);
+                    return static_cast<bool>(std::cin.read(body.data(), static_cast<std::streamsize>(length)));
+                }
+                constexpr std::string_view kLength = "Content-Length:";
+                if (header.compare(0, kLength.size(), kLength) == 0) {
+                    length = std::strtoull(header.c_str() + kLength.size(), nullptr, 10);
+                    have_length = true;
+                }
+            }
+            return false;
+        }
+
+        void send(const std::string& body) {
+            std::cout << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+            std::cout.flush();
+        }
+
+        void write_result(const JsonValue& id, const std::string& result_json) {
+            std::ostringstream out;
+            out << "{\"jsonrpc\":\"2.0\",\"id\":";
+            write_json(out, id);
+            out << ",\"result\":" << result_json << "}";
+            send(out.str());
+        }
+
+        void write_error(const JsonValue& id, int code, std::string_view message) {
+            std::ostringstream out;
+            out << "{\"jsonrpc\":\"2.0\",\"id\":";
+            write_json(out, id);
+            out << ",\"error\":{\"code\":" << code << ",\"message\":";
+            write_json_string(out, message);
+            out << "}}";
+            send(out.str());
+        }
+
+        void handle(const std::string& method, const JsonValue& id, const JsonValue& params) {
+            if (method == "initialize") {
+                initialize(params);
+                std::ostringstream out;
+                out << "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":1},"
+                    << "\"definitionProvider\":true,\"referencesProvider\":true},"
+                    << "\"serverInfo\":{\"name\":\"tale_lsp\",\"version\":\""
+                    << kVersionMajor << "." << kVersionMinor << "." << kVersionPatch << "\"}}";
+                write_result(id, out.str());
+            }
+            else if (method == "initialized") {
+                revalidate();
+            }
+            else if (method == "shutdown") {
+                shutdown_ = true;
+                write_result(id, "null");
+            }
+            else if (method == "textDocument/didOpen") {
+                const auto& doc = params["textDocument"];
+                if (workspace_.set_document(uri_to_path(doc["uri"].as_string()), doc["text"].as_string())) revalidate();
+            }
+            else if (method == "textDocument/didChange") {
+                // Full sync: the last change holds the whole text.
+                const auto& changes = params["contentChanges"].items();
+                if (!changes.empty() &&
+                    workspace_.set_document(uri_to_path(params["textDocument"]["uri"].as_string()), changes.back()["text"].as_string())) {
+                    revalidate();
+                }
+            }
+            else if (method == "textDocument/didClose") {
+                // A closed file stays part of the project as it is on disk.
+                const std::string path = uri_to_path(params["textDocument"]["uri"].as_string());
+                const std::string disk = compile::read_file(path);
+                const bool changed = disk.empty() && !std::filesystem::exists(path)
+                    ? workspace_.remove_document(path)
+                    : workspace_.set_document(path, disk);
+                if (changed) revalidate();
+            }
+            else if (method == "textDocument/definition" || method == "textDocument/references") {
+                write_result(id, locations(method == "textDocument/references", params));
+            }
+            else if (!id.is_null()) {
+                write_error(id, -32601, "Method not found: " + method);
+            }
+            // Other notifications (didSave, $/cancelRequest, ...) need no action.
+        }
+
+        void initialize(const JsonValue& params) {
+            if (files_.empty()) {
+                std::string root;
+                if (params["rootUri"].is_string()) root = uri_to_path(params["rootUri"].as_string());
+                else if (params["rootPath"].is_string()) root = params["rootPath"].as_string();
+                if (!root.empty()) scan(root);
+            }
+            for (const auto& file : files_) workspace_.set_document(file, compile::read_file(file));
+        }
+
+        // Every .tale file under `root`, skipping hidden directories.
+        void scan(const std::string& root) {
+            std::error_code ec;
+            std::filesystem::recursive_directory_iterator it(root, std::filesystem::directory_options::skip_permission_denied, ec);
+            for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+                const auto name = it->path().filename().string();
+                if (it->is_directory(ec) && !name.empty() && name[0] == '.') {
+                    it.disable_recursion_pending();
+                    continue;
+                }
+                if (it->is_regular_file(ec) && it->path().extension() == ".tale") files_.push_back(normalize(it->path()));
+            }
+            // Link order decides the default start scene; keep it stable.
+            std::sort(files_.begin(), files_.end());
+        }
+
+        void revalidate() {
+            const auto t0 = std::chrono::steady_clock::now();
+            const auto changed = workspace_.update();
+            const auto t1 = std::chrono::steady_clock::now();
+            for (const auto& path : changed) publish(path);
+            if (verbose_) {
+                std::cerr << "tale_lsp: updated " << workspace_.document_count() << " document(s), "
+                    << workspace_.scene_count() << " scene(s) in "
+                    << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms; "
+                    << changed.size() << " diagnostic set(s) changed\n";
+            }
+        }
+
+        void publish(const std::string& path) {
+            const std::string* text = workspace_.text(path);
+            std::ostringstream out;
+            out << "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":";
+            write_json_string(out, path_to_uri(path));
+            out << ",\"diagnostics\":[";
+            bool first = true;
+            for (const auto& d : workspace_.diagnostics(path)) {
+                if (!first) out << ",";
+                first = false;
+                out << "{\"range\":";
+                write_range(out, text, d.pos.line, d.pos.column);
+                // LSP severities: 1 error, 2 warning, 3 information.
+                out << ",\"severity\":" << static_cast<int>(d.severity) + 1 << ",\"source\":\"tale\",\"message\":";
+                write_json_string(out, d.message);
+                out << "}";
+            }
+            out << "]}}";
+            send(out.str());
+        }
+
+        // Definition: the scene declaration, or the sites that write a flag
+        // (set_flag) or item (give_item). References: every site.
+        std::string locations(bool references, const JsonValue& params) {
+            const std::string path = uri_to_path(params["textDocument"]["uri"].as_string());
+            const auto& position = params["position"];
+            // LSP positions are 0-based; INT_MAX cannot name a real position either.
+            auto one_based = [](const JsonValue& v) { return std::min(v.as_int(), INT_MAX - 1) + 1; };
+            const auto symbol = workspace_.symbol_at(path, one_based(position["line"]), one_based(position["character"]));
+            if (!symbol) return "null";
+
+            const bool include_declaration = !references || params["context"]["includeDeclaration"].as_bool();
+            const auto& index = workspace_.references();
+            std::ostringstream out;
+            out << "[";
+            bool first = true;
+            for (const auto& site : index.find(symbol->kind, symbol->name)) {
+                bool wanted = true;
+                if (!references) {
+                    wanted = site.role == analysis::RefRole::Definition || site.role == analysis::RefRole::SetFlag ||
+                        site.role == analysis::RefRole::GiveItem;
+                }
+                else if (site.role == analysis::RefRole::Definition) {
+                    wanted = include_declaration;
+                }
+                if (!wanted) continue;
+
+                const std::string file(index.file_name(site.file));
+                if (!first) out << ",";
+                first = false;
+                out << "{\"uri\":";
+                write_json_string(out, path_to_uri(file));
+                const auto [line, column] = name_position(workspace_.text(file), site, symbol->name);
+                out << ",\"range\":";
+                write_range(out, workspace_.text(file), line, column);
+                out << "}";
+            }
+            out << "]";
+            return out.str();
+        }
+
+        // Sites point at the statement; ranges should cover the name. Text
+        // reads point at their text block, so the block's lines are searched
+        // too. Returns the 1-based (line, column) of the name, or of the site.
+        static std::pair<int, int> name_position(const std::string* text, const analysis::ReferenceSite& site, std::string_view name) {
+            if (!text) return { site.line, site.column };
+            std::size_t start = 0;
+            for (int i = 1; i < site.line && start != std::string::npos; ++i) {
+                start = text->find('\n', start);
+                if (start != std::string::npos) start++;
+            }
+            const bool block = site.role == analysis::RefRole::ReadFlag || site.role == analysis::RefRole::ReadItem;
+            auto ident = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+
+            std::size_t from = start == std::string::npos ? start : start + static_cast<std::size_t>(site.column - 1);
+            for (int line = site.line; start != std::string::npos && start < text->size(); ++line) {
+                const std::size_t end = std::min(text->find('\n', start), text->size());
+                if (line != site.line) {
+                    // Block lines are indented deeper than the block keyword.
+                    const std::size_t indent = text->find_first_not_of(' ', start);
+                    if (!block || indent >= end || indent - start < static_cast<std::size_t>(site.column)) break;
+                }
+                for (std::size_t p = text->find(name, from); p != std::string::npos && p + name.size() <= end; p = text->find(name, p + 1)) {
+                    const bool whole = (p == 0 || !ident((*text)[p - 1])) && (p + name.size() >= text->size() || !ident((*text)[p + name.size()]));
+                    if (whole) return { line, static_cast<int>(p - start) + 1 };
+                }
+                if (!block || end >= text->size()) break;
+                start = from = end + 1;
+            }
+            return { site.line, site.column };
+        }
+
+    private:
+        compile::Workspace workspace_;
+        std::vector<std::string> files_;
+        bool verbose_ = false;
+        bool shutdown_ = false;
+    };
+
+} // namespace
+
+int main(int argc, char** argv) {
+    analysis::ValidateOptions options;
+    std::vector<std::string> files;
+    bool verbose = false;
+    std::string profile_path;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--start" && i + 1 < argc) options.start_scene = argv[++i];
+        else if (arg == "--dead-ends") options.warn_dead_ends = true;
+        else if (arg == "--verbose") verbose = true;
+        else if (arg == "--profile" && i + 1 < argc) profile_path = argv[++i];
+        else if (arg == "--stdio") continue; // the transport editors pass by default
+        else if (arg == "--help" || arg == "-h") {
+            std::cerr << kProductName << " language server\n";
+            std::cerr << "Usage: tale_lsp [--start <scene_id>] [--dead-ends] [--verbose] [--profile <trace.json>] [files.tale...]\n"
+                << "Speaks LSP over stdin/stdout. Without files, the project is every .tale file under the workspace root.\n";
+            return 2;
+        }
+        else files.push_back(normalize(arg));
+    }
+
+    std::ios::sync_with_stdio(false);
+    profile::Session profile_session(profile_path, std::cerr);
+    Server server(std::move(options), std::move(files), verbose);
+    return server.run();
+}
@@ -1,15 +1,28 @@
+#include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <new>
 #include <sstream>
 #include <string>
 
+#include "tale_engine/analysis/scene_graph.h"
+#include "tale_engine/analysis/validator.h"
+#include "tale_engine/compile/ast_codec.h"
 #include "tale_engine/diagnostics.h"
 #include "tale_engine/dsl/lexer.h"
 #include "tale_engine/dsl/parser.h"
+#include "tale_engine/memory.h"
+#include "tale_engine/profile.h"
+#include "tale_engine/runtime/analytics.h"
+#include "tale_engine/runtime/combat.h"
 #include "tale_engine/runtime/interpreter.h"
+#include "tale_engine/runtime/inventory.h"
+#include "tale_engine/runtime/session_log.h"
 #include "tale_engine/runtime/state.h"
+#include "tale_engine/runtime/string_table.h"
 #include "tale_engine/version.h"
-#include <unordered_set>
 
 static std::string read_all_text(const std::string& path) {
     std::ifstream in(path, std::ios::binary);
@@ -26,60 +39,47 @@ static void print_diags(const tale_engine::Diagnostics& diags) {
     }
 }
 
-static bool validate_basic(const tale_engine::dsl::FileAst& ast, tale_engine::Diagnostics& diags) {
-    // Reuse minimal checks (this mirrors validate tool; later we move to engine module).
-    std::unordered_set<std::string> ids;
-    for (const auto& s : ast.scenes) {
-        if (!ids.insert(s.id).second) {
-            diags.error(s.pos, "Duplicate scene id: " + s.id);
+// Opens the string table at `path` and makes it the interpreter's only
+// one; an empty path switches back to the story's own text.
+static bool switch_strings(tale_engine::runtime::Interpreter& interp,
+    std::unique_ptr<tale_engine::runtime::StringTable>& strings,
+    const std::string& path) {
+    std::unique_ptr<tale_engine::runtime::StringTable> next;
+    if (!path.empty()) {
+        next = std::make_unique<tale_engine::runtime::StringTable>();
+        if (!next->open(path)) {
+            std::cerr << "Cannot read string table: " << path << "\n";
+            return false;
         }
     }
-    if (ast.scenes.empty()) {
-        diags.error(tale_engine::SourcePos{ "<input>", 1, 1 }, "No scenes found.");
-    }
-    return !diags.has_errors();
+    interp.set_strings(next.get());
+    strings = std::move(next);
+    return true;
 }
 
-int main(int argc, char** argv) {
-    using namespace tale_engine;
-
-    if (argc < 2) {
-        std::cerr << kProductName << " run\n";
-        std::cerr << "Usage: tale_run <path-to-.tale> [start_scene_id]\n";
-        return 2;
-    }
-
-    const std::string path = argv[1];
-    const std::string start_scene = (argc >= 3) ? argv[2] : "";
-
-    const auto text = read_all_text(path);
-    Diagnostics diags;
-
-    if (text.empty()) {
-        diags.error(SourcePos{ path, 1, 1 }, "File is empty or cannot be read.");
-        print_diags(diags);
-        return 1;
-    }
-
-    dsl::Lexer lexer(text, path, diags);
-    auto tokens = lexer.lex();
-
-    dsl::Parser parser(std::move(tokens), diags);
-    auto ast = parser.parse_file();
-
-    if (!validate_basic(ast, diags) || diags.has_errors()) {
-        print_diags(diags);
-        return 1;
+// Lists held items, then total weight and equipment when a catalog is set.
+static void print_inventory(const tale_engine::runtime::Inventory& inventory) {
+    using namespace tale_engine::runtime;
+    for (ItemId id = 0; id < inventory.size(); ++id) {
+        if (inventory.qty(id) != 0) std::cout << "  " << inventory.name(id) << " x" << inventory.qty(id) << "\n";
     }
-
-    runtime::State state;
-    runtime::Interpreter interp(ast, diags);
-
-    if (!interp.start(state, start_scene)) {
-        print_diags(diags);
-        return 1;
+    const ItemCatalog* catalog = inventory.catalog();
+    if (!catalog) return;
+    std::cout << "  weight: " << inventory.total_weight() << "\n";
+    for (EquipSlot slot = 0; slot < catalog->slot_count(); ++slot) {
+        const InstanceId instance = inventory.equipped(slot);
+        std::cout << "  " << catalog->slot_name(slot) << ": "
+            << (instance == kNoInstance ? std::string_view("-") : inventory.name(inventory.instance_item(instance))) << "\n";
     }
+}
 
+// Interactive loop: prints text and choices, reads choice numbers from stdin.
+// `:locale <table.talestr>` switches language mid-session; `:locale` alone
+// goes back to the story's own text. `:inventory` lists held items.
+static int play(tale_engine::runtime::Interpreter& interp,
+    tale_engine::runtime::State& state,
+    tale_engine::Diagnostics& diags,
+    std::unique_ptr<tale_engine::runtime::StringTable>& strings) {
     while (true) {
         auto step = interp.step(state);
 
@@ -95,8 +95,8 @@ int main(int argc, char** argv) {
         }
 
         // Print text
-        for (const auto& line : step.text) {
-            std::cout << line << "\n";
+        for (std::size_t i = 0; i < step.text.size(); ++i) {
+            std::cout << step.line(i) << "\n";
         }
 
         // Terminal scene
@@ -113,7 +113,25 @@ int main(int argc, char** argv) {
 
         std::cout << "> ";
         std::string input;
-        std::getline(std::cin, input);
+        if (!std::getline(std::cin, input)) {
+            std::cout << "\n";
+            return 0; // end of input ends the session
+        }
+
+        if (input == ":inventory") {
+            print_inventory(state.inventory());
+            std::cout << "\n";
+            continue;
+        }
+
+        if (input.rfind(":locale", 0) == 0) {
+            const auto arg = input.find_first_not_of(' ', 7);
+            if (switch_strings(interp, strings, arg == std::string::npos ? std::string() : input.substr(arg))) {
+                std::cout << "Locale: " << (strings ? std::string(strings->locale()) : std::string("story text")) << "\n";
+            }
+            std::cout << "\n";
+            continue;
+        }
 
         int idx = 0;
         try {
@@ -137,3 +155,233 @@ int main(int argc, char** argv) {
         std::cout << "\n";
     }
 }
+
+static int run_replay(tale_engine::runtime::Interpreter& interp,
+    const tale_engine::dsl::FileAst& ast,
+    tale_engine::Diagnostics& diags,
+    const std::string& log_path,
+    const tale_engine::runtime::ItemCatalog* items,
+    tale_engine::runtime::CombatContext& combat,
+    std::pmr::memory_resource* state_resource) {
+    using namespace tale_engine;
+
+    runtime::SessionLog log;
+    if (!runtime::decode_session(read_all_text(log_path), log)) {
+        std::cerr << "Cannot read session log: " << log_path << "\n";
+        return 1;
+    }
+    if (log.content_hash != 0 && log.content_hash != runtime::content_hash(ast)) {
+        std::cerr << "warning: session was recorded against different content\n";
+    }
+
+    // Fights replay from the recorded seed, without printing their logs.
+    combat.seed = log.seed;
+    combat.log = nullptr;
+
+    runtime::State state(state_resource);
+    state.set_item_catalog(items);
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto result = runtime::replay(interp, state, log);
+    const auto t1 = std::chrono::steady_clock::now();
+    const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    if (!result.ok) {
+        print_diags(diags);
+        std::cerr << "replay failed after " << result.steps << " step(s): " << result.message << "\n";
+        if (result.diverged_at != runtime::ReplayResult::kNoDivergence) {
+            std::cerr << "  expected state hash " << std::hex << result.expected_hash
+                << ", got " << result.actual_hash << std::dec << "\n";
+        }
+        return 1;
+    }
+
+    std::cerr << "replayed " << result.steps << " step(s) in " << ms << " ms"
+        << (log.has_hashes ? ", all state hashes match" : "") << "\n";
+    return 0;
+}
+
+static int play_session(tale_engine::runtime::Interpreter& interp,
+    tale_engine::runtime::State& state,
+    const tale_engine::dsl::FileAst& ast,
+    tale_engine::Diagnostics& diags,
+    const std::string& start_scene,
+    const std::string& record_path,
+    std::uint64_t seed,
+    std::unique_ptr<tale_engine::runtime::StringTable>& strings) {
+    using namespace tale_engine;
+
+    if (!interp.start(state, start_scene)) {
+        print_diags(diags);
+        return 1;
+    }
+
+    std::unique_ptr<runtime::SessionRecorder> recorder;
+    if (!record_path.empty()) {
+        recorder = std::make_unique<runtime::SessionRecorder>(state.current_scene(), seed);
+        recorder->set_content_hash(runtime::content_hash(ast));
+        interp.set_recorder(recorder.get());
+    }
+
+    const int rc = play(interp, state, diags, strings);
+
+    if (recorder) {
+        const std::string bytes = runtime::encode_session(recorder->log());
+        std::ofstream out(record_path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!out) {
+            std::cerr << "Cannot write session log: " << record_path << "\n";
+            return 1;
+        }
+    }
+    return rc;
+}
+
+// CSV unless the path ends in .json.
+static bool write_analytics(const tale_engine::runtime::Analytics& analytics, const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    const auto snapshot = analytics.snapshot();
+    if (path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0) analytics.write_json(out, snapshot);
+    else analytics.write_csv(out, snapshot);
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char** argv) {
+    using namespace tale_engine;
+
+    std::string path;
+    std::string start_scene;
+    std::string profile_path;
+    std::string record_path;
+    std::string replay_path;
+    std::string analytics_path;
+    std::string strings_path;
+    std::string items_path;
+    std::string combat_path;
+    std::uint64_t seed = 0;
+    std::size_t memory_limit = 0;
+    bool memory_report = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--profile" && i + 1 < argc) profile_path = argv[++i];
+        else if (arg == "--record" && i + 1 < argc) record_path = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc) replay_path = argv[++i];
+        else if (arg == "--analytics" && i + 1 < argc) analytics_path = argv[++i];
+        else if (arg == "--strings" && i + 1 < argc) strings_path = argv[++i];
+        else if (arg == "--items" && i + 1 < argc) items_path = argv[++i];
+        else if (arg == "--combat" && i + 1 < argc) combat_path = argv[++i];
+        else if (arg == "--seed" && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--memory-limit" && i + 1 < argc) memory_limit = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--memory-report") memory_report = true;
+        else if (path.empty()) path = arg;
+        else start_scene = arg;
+    }
+
+    if (path.empty()) {
+        std::cerr << kProductName << " run\n";
+        std::cerr << "Usage: tale_run [--profile <trace.json>] [--seed <n>] [--record <session.bin> | --replay <session.bin>]\n"
+            << "                [--analytics <out.csv|out.json>] [--memory-report] [--memory-limit <bytes>]\n"
+            << "                [--strings <table.talestr>] [--items <items.json>] [--combat <combat.json>]\n"
+            << "                <path-to-.tale|.talec> [start_scene_id]\n";
+        return 2;
+    }
+
+    profile::Session profile_session(profile_path, std::cerr);
+
+    // Lexer, interpreter and state allocate from per-subsystem accounting
+    // resources; --memory-limit caps their sum for the whole session. The
+    // parse phase is not accounted (see memory.h).
+    memory::MemoryAccounting accounting(memory_limit);
+    struct Report {
+        const memory::MemoryAccounting& accounting;
+        bool enabled;
+        ~Report() {
+            if (enabled) accounting.write_report(std::cerr);
+        }
+    } report{ accounting, memory_report };
+
+    const auto text = read_all_text(path);
+    // Long sessions and replays hit the same runtime warning many times.
+    DiagnosticsOptions diag_options;
+    diag_options.deduplicate = true;
+    Diagnostics diags(diag_options);
+
+    if (text.empty()) {
+        diags.error(SourcePos{ path, 1, 1 }, "File is empty or cannot be read.");
+        print_diags(diags);
+        return 1;
+    }
+
+    try {
+        dsl::FileAst ast;
+        if (compile::is_compiled(text)) {
+            if (!compile::decode_file(text, ast)) {
+                diags.error(SourcePos{ path, 1, 1 }, "Compiled file is corrupt or was built by another engine version.");
+            }
+        }
+        else {
+            dsl::Lexer lexer(text, path, diags, accounting.resource(memory::Subsystem::Lexer));
+            auto tokens = lexer.lex();
+
+            dsl::Parser parser(std::move(tokens), diags);
+            ast = parser.parse_file();
+        }
+
+        analysis::ValidateOptions vopts;
+        vopts.start_scene = start_scene;
+        const analysis::SceneGraph graph(ast);
+        if (!analysis::validate(ast, graph, diags, vopts) || diags.has_errors()) {
+            print_diags(diags);
+            return 1;
+        }
+
+        runtime::ItemCatalog items;
+        if (!items_path.empty() && !runtime::read_item_catalog(read_all_text(items_path), items_path, items, diags)) {
+            print_diags(diags);
+            return 1;
+        }
+
+        runtime::CombatCatalog combat;
+        if (!combat_path.empty() && !runtime::read_combat_catalog(read_all_text(combat_path), combat_path, combat, diags)) {
+            print_diags(diags);
+            return 1;
+        }
+        runtime::EffectRegistry effects;
+        runtime::CombatContext combat_context{ &combat, seed, &std::cout };
+        if (!combat_path.empty()) runtime::bind_combat(effects, combat_context);
+
+        runtime::State state(accounting.resource(memory::Subsystem::State));
+        if (!items_path.empty()) state.set_item_catalog(&items);
+        runtime::Interpreter interp(ast, diags, effects, accounting.resource(memory::Subsystem::Interpreter));
+
+        std::unique_ptr<runtime::StringTable> strings;
+        if (!strings_path.empty() && !switch_strings(interp, strings, strings_path)) return 1;
+
+        std::unique_ptr<runtime::Analytics> analytics;
+        if (!analytics_path.empty()) {
+            analytics = std::make_unique<runtime::Analytics>(ast);
+            interp.set_analytics(&analytics->make_shard());
+        }
+
+        int rc = 0;
+        if (!replay_path.empty()) {
+            rc = run_replay(interp, ast, diags, replay_path, items_path.empty() ? nullptr : &items, combat_context, accounting.resource(memory::Subsystem::State));
+        }
+        else {
+            rc = play_session(interp, state, ast, diags, start_scene, record_path, seed, strings);
+        }
+
+        if (analytics && !write_analytics(*analytics, analytics_path)) {
+            std::cerr << "Cannot write analytics: " << analytics_path << "\n";
+            return 1;
+        }
+        return rc;
+    }
+    catch (const std::bad_alloc&) {
+        diags.error(SourcePos{ path, 1, 1 }, memory_limit != 0
+            ? "Session exceeded its memory limit (" + std::to_string(memory_limit) + " accounted bytes)."
+            : std::string("Out of memory."));
+        print_diags(diags);
+        return 1;
+    }
+}
@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/runtime/combat.h"
+#include "tale_engine/version.h"
+
+static std::string read_all_text(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return {};
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static void print_diags(const tale_engine::Diagnostics& diags) {
+    for (const auto& d : diags.all()) {
+        std::cerr << d.pos.file << ":" << d.pos.line << ":" << d.pos.column
+            << " " << tale_engine::to_string(d.severity) << ": " << d.message << "\n";
+    }
+}
+
+static void print_usage() {
+    std::cerr << "Usage: tale_sim [--fights <n>] [--seed <n>] [--threads <n>] [--batch <n>] [--max-rounds <n>]\n"
+        << "                [--player <combatant>] [--log <fight-index>]\n"
+        << "                <combat.json> <pack_id>\n";
+}
+
+// Balance simulation: fights one enemy pack many times and reports win
+// rate, fight length and hit points left. Same seed, same numbers,
+// whatever --threads and --batch say.
+int main(int argc, char** argv) {
+    using namespace tale_engine;
+
+    runtime::CombatSimulation sim;
+    sim.count = 100000;
+    std::string player_id = "player";
+    long long log_index = -1;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--fights" && i + 1 < argc) sim.count = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && i + 1 < argc) sim.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && i + 1 < argc) sim.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--batch" && i + 1 < argc) sim.batch = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--max-rounds" && i + 1 < argc) sim.max_rounds = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--player" && i + 1 < argc) player_id = argv[++i];
+        else if (arg == "--log" && i + 1 < argc) log_index = std::strtoll(argv[++i], nullptr, 10);
+        else inputs.push_back(arg);
+    }
+    if (inputs.size() != 2) {
+        std::cerr << kProductName << " sim\n";
+        print_usage();
+        return 2;
+    }
+
+    Diagnostics diags;
+    runtime::CombatCatalog catalog;
+    const bool ok = runtime::read_combat_catalog(read_all_text(inputs[0]), inputs[0], catalog, diags);
+    print_diags(diags);
+    if (!ok) return 1;
+
+    const runtime::PackId pack = catalog.find_pack(inputs[1]);
+    if (pack == runtime::kNoPack) {
+        std::cerr << "Unknown enemy pack: " << inputs[1] << "\n";
+        return 1;
+    }
+    runtime::CombatantDef player;
+    player.id = player_id;
+    if (const auto id = catalog.find_combatant(player_id); id != runtime::kNoCombatant) player = catalog.combatant(id);
+    else std::cerr << "warning: no combatant '" << player_id << "', using default stats\n";
+    std::vector<runtime::CombatantDef> enemies;
+    for (const auto member : catalog.pack(pack).members) enemies.push_back(catalog.combatant(member));
+    const std::span<const runtime::CombatantDef> party(&player, 1);
+
+    // One fight with its log, as encounter `log_index` of the run plays it.
+    if (log_index >= 0) {
+        runtime::CombatBatch fight(sim.seed);
+        std::vector<runtime::CombatEvent> events;
+        fight.set_log(&events);
+        fight.add(party, enemies, sim.first_id + static_cast<std::uint64_t>(log_index));
+        fight.run(sim.max_rounds);
+        std::vector<std::string_view> names{ player.id };
+        for (const auto& def : enemies) names.push_back(def.id);
+        runtime::write_combat_log(std::cout, events, 0, names);
+        return 0;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto results = runtime::simulate_combat(party, enemies, sim);
+    const auto t1 = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(t1 - t0).count();
+
+    std::size_t won = 0, lost = 0, draw = 0;
+    std::uint64_t rounds = 0, hp_left = 0, checksum = 0;
+    for (const auto& r : results) {
+        won += r.outcome == runtime::CombatOutcome::Won;
+        lost += r.outcome == runtime::CombatOutcome::Lost;
+        draw += r.outcome == runtime::CombatOutcome::Draw;
+        rounds += r.rounds;
+        if (r.outcome == runtime::CombatOutcome::Won) hp_left += static_cast<std::uint64_t>(r.party_hp);
+        checksum = checksum * 31 + static_cast<std::uint64_t>(r.outcome) * 1000003 + r.rounds * 7919 +
+            static_cast<std::uint64_t>(r.party_hp) * 131 + static_cast<std::uint64_t>(r.enemy_hp);
+    }
+
+    const double n = results.empty() ? 1.0 : static_cast<double>(results.size());
+    std::cout << "fights:       " << results.size() << "\n"
+        << "won:          " << 100.0 * static_cast<double>(won) / n << "%\n"
+        << "lost:         " << 100.0 * static_cast<double>(lost) / n << "%\n"
+        << "draw:         " << 100.0 * static_cast<double>(draw) / n << "%\n"
+        << "avg rounds:   " << static_cast<double>(rounds) / n << "\n"
+        << "avg hp left:  " << (won ? static_cast<double>(hp_left) / static_cast<double>(won) : 0.0) << " (fights won)\n"
+        << "checksum:     " << std::hex << checksum << std::dec << "\n";
+    std::cerr << "simulated in " << seconds * 1000.0 << " ms (" << static_cast<double>(results.size()) / seconds
+        << " fights/s)\n";
+    return 0;
+}
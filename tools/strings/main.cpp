@@ -0,0 +1,132 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "tale_engine/analysis/scene_graph.h"
+#include "tale_engine/analysis/validator.h"
+#include "tale_engine/compile/localization.h"
+#include "tale_engine/compile/project.h"
+#include "tale_engine/diagnostic_sinks.h"
+#include "tale_engine/diagnostics.h"
+#include "tale_engine/version.h"
+
+static void print_usage() {
+    std::cerr << "Usage: tale_strings extract [--locale <name>] [--diag-format text|jsonl|sarif]\n"
+        << "                            -o <catalog.json> <file.tale>...\n"
+        << "       tale_strings compile [--story <file.tale>]... [--diag-format text|jsonl|sarif]\n"
+        << "                            -o <table.talestr> <catalog.json>\n";
+}
+
+static bool write_bytes(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(out);
+}
+
+// Builds and validates the story, as tale_build would.
+static bool load_story(const std::vector<std::string>& paths, tale_engine::Diagnostics& diags,
+    tale_engine::dsl::FileAst& out) {
+    using namespace tale_engine;
+
+    auto build = compile::build_project(paths, compile::ProjectOptions{}, diags);
+    if (diags.has_errors()) return false;
+    const analysis::SceneGraph graph(build.linked);
+    if (!analysis::validate(build.linked, graph, diags)) return false;
+    out = std::move(build.linked);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    using namespace tale_engine;
+
+    if (argc < 2) {
+        std::cerr << kProductName << " strings\n";
+        print_usage();
+        return 2;
+    }
+    const std::string command = argv[1];
+
+    std::string locale = "source";
+    std::string out_path;
+    std::string diag_format = "text";
+    std::vector<std::string> stories;
+    std::vector<std::string> inputs;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--locale" && i + 1 < argc) locale = argv[++i];
+        else if (arg == "--story" && i + 1 < argc) stories.push_back(argv[++i]);
+        else if (arg == "--diag-format" && i + 1 < argc) diag_format = argv[++i];
+        else if (arg == "-o" && i + 1 < argc) out_path = argv[++i];
+        else inputs.push_back(arg);
+    }
+
+    if ((command != "extract" && command != "compile") || out_path.empty() || inputs.empty() ||
+        (command == "compile" && inputs.size() != 1)) {
+        std::cerr << kProductName << " strings\n";
+        print_usage();
+        return 2;
+    }
+
+    auto sink = make_sink(diag_format, diag_format == "text" ? std::cerr : std::cout, "tale_strings");
+    if (!sink) {
+        std::cerr << "Unknown diagnostic format: " << diag_format << "\n";
+        return 2;
+    }
+    DiagnosticsOptions diag_options;
+    diag_options.retain = false;
+    diag_options.deduplicate = true;
+    Diagnostics diags(diag_options);
+    diags.set_sink(sink.get());
+
+    if (command == "extract") {
+        dsl::FileAst ast;
+        const bool ok = load_story(inputs, diags, ast);
+        sink->finish();
+        if (!ok) return 1;
+
+        const auto strings = compile::extract_strings(ast);
+        std::ofstream out(out_path, std::ios::binary | std::ios::trunc);
+        compile::write_catalog(out, locale, strings);
+        if (!out) {
+            std::cerr << "Cannot write catalog: " << out_path << "\n";
+            return 1;
+        }
+        std::cerr << strings.size() << " string(s) extracted\n";
+        return 0;
+    }
+
+    std::vector<compile::LocalizedString> strings;
+    bool ok = compile::read_catalog(compile::read_file(inputs.front()), inputs.front(), locale, strings, diags);
+
+    // Against the story: keys it no longer has are stale translations;
+    // keys the catalog lacks fall back to the story's text at runtime.
+    std::size_t translated = 0;
+    std::size_t total = 0;
+    if (ok && !stories.empty()) {
+        dsl::FileAst ast;
+        ok = load_story(stories, diags, ast);
+        std::unordered_set<std::string> keys;
+        for (auto& s : compile::extract_strings(ast)) keys.insert(std::move(s.key));
+        total = keys.size();
+        for (const auto& s : strings) {
+            if (keys.count(s.key)) translated++;
+            else diags.warning(s.pos, "String key is not in the story: " + s.key);
+        }
+    }
+
+    std::string bytes;
+    if (ok) bytes = compile::encode_string_table(locale, strings, diags);
+    sink->finish();
+    if (!ok || diags.has_errors()) return 1;
+
+    if (!write_bytes(out_path, bytes)) {
+        std::cerr << "Cannot write string table: " << out_path << "\n";
+        return 1;
+    }
+    std::cerr << "locale '" << locale << "': " << strings.size() << " string(s), " << bytes.size() << " bytes";
+    if (!stories.empty()) std::cerr << "; " << translated << " of " << total << " story string(s) translated";
+    std::cerr << "\n";
+    return 0;
+}
@@ -1,10 +1,16 @@
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <unordered_set>
 
+#include "tale_engine/analysis/reference_index.h"
+#include "tale_engine/analysis/scene_graph.h"
+#include "tale_engine/analysis/validator.h"
+#include "tale_engine/diagnostic_sinks.h"
 #include "tale_engine/diagnostics.h"
+#include "tale_engine/profile.h"
 #include "tale_engine/version.h"
 #include "tale_engine/dsl/lexer.h"
 #include "tale_engine/dsl/parser.h"
@@ -18,61 +24,97 @@ static std::string read_all_text(const std::string& path) {
     return ss.str();
 }
 
-static void validate_ast(const tale_engine::dsl::FileAst& ast,
-    tale_engine::Diagnostics& diags) {
-    using namespace tale_engine;
+static void print_graph_stats(const tale_engine::analysis::SceneGraph& graph,
+    const tale_engine::analysis::ValidateOptions& options) {
+    using namespace tale_engine::analysis;
 
-    // 1) Unique scene ids
-    std::unordered_set<std::string> scene_ids;
-    for (const auto& s : ast.scenes) {
-        if (!scene_ids.insert(s.id).second) {
-            diags.error(s.pos, "Duplicate scene id: " + s.id);
-        }
-    }
+    SceneIndex start = options.start_scene.empty() ? 0 : graph.index_of(options.start_scene);
+    const auto reachable = graph.reachable_from(start);
+    const auto sccs = graph.strongly_connected_components();
 
-    auto scene_exists = [&](const std::string& id) {
-        return scene_ids.count(id) != 0;
-        };
-
-    // 2) Goto targets exist
-    for (const auto& s : ast.scenes) {
-        for (const auto& stmt : s.body) {
-            if (auto g = std::get_if<tale_engine::dsl::GotoStmtAst>(&stmt)) {
-                if (!scene_exists(g->target_scene_id)) {
-                    diags.error(g->pos, "Goto target scene does not exist: " + g->target_scene_id);
-                }
-            }
-            else if (auto ch = std::get_if<tale_engine::dsl::ChoiceAst>(&stmt)) {
-                for (const auto& cstmt : ch->body) {
-                    if (auto cg = std::get_if<tale_engine::dsl::GotoStmtAst>(&cstmt)) {
-                        if (!scene_exists(cg->target_scene_id)) {
-                            diags.error(cg->pos, "Goto target scene does not exist: " + cg->target_scene_id);
-                        }
-                    }
-                }
-            }
-        }
+    std::uint32_t largest = 0;
+    std::size_t cyclic = 0;
+    for (const auto size : sccs.component_size) {
+        largest = std::max(largest, size);
+        if (size > 1) cyclic++;
     }
 
-    // 3) Minimal sanity: require at least one scene
-    if (ast.scenes.empty()) {
-        diags.error(SourcePos{ "<input>", 1, 1 }, "No scenes found. Expected at least one 'scene' block.");
+    std::cerr << "scenes: " << graph.scene_count() << "\n"
+        << "edges: " << graph.edge_count() << "\n"
+        << "reachable: " << std::count(reachable.begin(), reachable.end(), true) << "\n"
+        << "dead ends: " << graph.dead_ends().size() << "\n"
+        << "strongly connected components: " << sccs.count()
+        << " (" << cyclic << " cyclic, largest " << largest << ")\n";
+}
+
+// Prints every site of `query` ("scene:<id>", "flag:<name>", "item:<id>" or "stat:<name>").
+static bool print_references(const tale_engine::analysis::ReferenceIndex& index, const std::string& query) {
+    using namespace tale_engine::analysis;
+
+    const auto colon = query.find(':');
+    if (colon == std::string::npos) return false;
+    const std::string kind = query.substr(0, colon);
+    const std::string name = query.substr(colon + 1);
+
+    SymbolKind k;
+    if (kind == "scene") k = SymbolKind::Scene;
+    else if (kind == "flag") k = SymbolKind::Flag;
+    else if (kind == "item") k = SymbolKind::Item;
+    else if (kind == "stat") k = SymbolKind::Stat;
+    else return false;
+
+    static constexpr const char* kRoleNames[] = { "definition", "goto", "set_flag", "give_item", "take_item", "test_flag", "test_item", "read_flag", "read_item", "effect_arg", "test_stat" };
+    for (const auto& site : index.find(k, name)) {
+        std::cout << index.file_name(site.file) << ":" << site.line << ":" << site.column
+            << " " << kRoleNames[static_cast<int>(site.role)] << "\n";
     }
+    return true;
 }
 
 int main(int argc, char** argv) {
     using namespace tale_engine;
 
-    if (argc < 2) {
+    std::string path;
+    analysis::ValidateOptions options;
+    bool stats = false;
+    std::string refs_query;
+    std::string profile_path;
+    std::string diag_format = "text";
+    DiagnosticsOptions diag_options;
+    diag_options.retain = false;
+    diag_options.deduplicate = true;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--start" && i + 1 < argc) options.start_scene = argv[++i];
+        else if (arg == "--dead-ends") options.warn_dead_ends = true;
+        else if (arg == "--stats") stats = true;
+        else if (arg == "--refs" && i + 1 < argc) refs_query = argv[++i];
+        else if (arg == "--profile" && i + 1 < argc) profile_path = argv[++i];
+        else if (arg == "--diag-format" && i + 1 < argc) diag_format = argv[++i];
+        else if (arg == "--max-diagnostics" && i + 1 < argc) diag_options.max_per_severity = std::strtoul(argv[++i], nullptr, 10);
+        else path = arg;
+    }
+
+    if (path.empty()) {
         std::cerr << kProductName << " validate\n";
-        std::cerr << "Usage: tale_validate <path-to-.tale>\n";
+        std::cerr << "Usage: tale_validate [--start <scene_id>] [--dead-ends] [--stats] [--refs <kind>:<name>]\n"
+            << "                     [--diag-format text|jsonl|sarif] [--max-diagnostics <n>] [--profile <trace.json>] <path-to-.tale>\n";
         return 2;
     }
 
-    const std::string path = argv[1];
+    // Text goes to stderr as before; machine-readable formats go to stdout.
+    auto sink = make_sink(diag_format, diag_format == "text" ? std::cerr : std::cout, "tale_validate");
+    if (!sink) {
+        std::cerr << "Unknown diagnostic format: " << diag_format << "\n";
+        return 2;
+    }
+
+    profile::Session profile_session(profile_path, std::cerr);
     const auto text = read_all_text(path);
 
-    Diagnostics diags;
+    Diagnostics diags(diag_options);
+    diags.set_sink(sink.get());
 
     if (text.empty()) {
         diags.error(SourcePos{ path, 1, 1 }, "File is empty or cannot be read.");
@@ -85,13 +127,23 @@ int main(int argc, char** argv) {
         tale_engine::dsl::Parser parser(std::move(tokens), diags);
         auto ast = parser.parse_file();
 
-        validate_ast(ast, diags);
-    }
+        const analysis::SceneGraph graph(ast);
+        analysis::validate(ast, graph, diags, options);
 
-    for (const auto& d : diags.all()) {
-        std::cerr << d.pos.file << ":" << d.pos.line << ":" << d.pos.column
-            << " " << to_string(d.severity) << ": " << d.message << "\n";
+        analysis::ReferenceIndex references;
+        references.update_file(path, ast);
+        analysis::lint_references(references, diags);
+
+        if (stats) print_graph_stats(graph, options);
+        if (!refs_query.empty() && !print_references(references, refs_query)) {
+            std::cerr << "Invalid --refs query (expected scene:, flag:, item: or stat: prefix): " << refs_query << "\n";
+            return 2;
+        }
     }
 
+    sink->finish();
+    if (diags.suppressed() != 0) {
+        std::cerr << diags.suppressed() << " more diagnostic(s) suppressed by --max-diagnostics\n";
+    }
     return diags.has_errors() ? 1 : 0;
 }